@@ -0,0 +1,91 @@
+// Throughput of GCodeProcessor::process_file() with the serial and the parallel G-code parsing.
+//
+// Usage: gcode_parsing [file.gcode | directory]...
+// Directories are searched for *.gcode files. Without arguments a synthetic G-code file is generated.
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include "libslic3r/libslic3r.h"
+#include "libslic3r/GCode/GCodeProcessor.hpp"
+
+using namespace Slic3r;
+namespace fs = boost::filesystem;
+
+// Perimeter like extrusions with arcs and retractions, roughly the mix of a sliced print.
+static std::string make_synthetic_gcode(size_t size_mb)
+{
+    const fs::path path = fs::temp_directory_path() / fs::unique_path("gcode_parsing_%%%%-%%%%.gcode");
+    boost::nowide::ofstream out(path.string());
+    out << "; generated by gcode_parsing benchmark\nG21\nG90\nM83\n";
+    const size_t target = size_mb << 20;
+    size_t       layer  = 0;
+    for (size_t written = 0; written < target; ++ layer) {
+        char buf[256];
+        int  n = sprintf(buf, ";LAYER_CHANGE\n;Z:%.2f\nG1 Z%.2f F600\n;TYPE:Outer wall\n;WIDTH:0.45\n", 0.2 * (layer + 1), 0.2 * (layer + 1));
+        out << buf;
+        written += n;
+        for (int i = 0; i < 2000; ++ i) {
+            const double x = 100. + 50. * ((i % 40) / 40.), y = 100. + 50. * ((i / 40) % 50 / 50.);
+            if (i % 100 == 0)
+                n = sprintf(buf, "G1 E-0.8 F2100\nG1 X%.3f Y%.3f F12000\nG1 E0.8 F2100\n", x, y);
+            else if (i % 10 == 0)
+                n = sprintf(buf, "G2 X%.3f Y%.3f I1.5 J0.5 E0.04512 F1800\n", x, y);
+            else
+                n = sprintf(buf, "G1 X%.3f Y%.3f E0.03521 F1800\n", x, y);
+            out << buf;
+            written += n;
+        }
+    }
+    return path.string();
+}
+
+static void collect(const fs::path &path, std::vector<std::string> &files)
+{
+    if (fs::is_directory(path)) {
+        for (const fs::directory_entry &entry : fs::recursive_directory_iterator(path))
+            if (fs::is_regular_file(entry.status()) && entry.path().extension() == ".gcode")
+                files.emplace_back(entry.path().string());
+    } else if (fs::is_regular_file(path))
+        files.emplace_back(path.string());
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++ i)
+        collect(argv[i], files);
+    std::string synthetic;
+    if (files.empty()) {
+        synthetic = make_synthetic_gcode(64);
+        files.emplace_back(synthetic);
+    }
+
+    std::cout << "file;size [MB];serial [MB/s];parallel [MB/s];speedup;results match" << std::endl;
+    for (const std::string &file : files) {
+        const double size_mb = double(fs::file_size(file)) / (1024. * 1024.);
+        double       seconds[2];
+        size_t       moves[2];
+        float        print_time[2];
+        for (int parallel = 0; parallel < 2; ++ parallel) {
+            GCodeProcessor processor;
+            processor.enable_parallel_parsing(parallel != 0);
+            const auto start = std::chrono::steady_clock::now();
+            processor.process_file(file);
+            seconds[parallel]    = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            moves[parallel]      = processor.get_result().moves.size();
+            print_time[parallel] = processor.get_result().print_statistics.modes.front().time;
+        }
+        std::cout << file << ";" << size_mb << ";" << size_mb / seconds[0] << ";" << size_mb / seconds[1] << ";"
+                  << seconds[0] / seconds[1] << ";" << (moves[0] == moves[1] && print_time[0] == print_time[1] ? "yes" : "NO") << std::endl;
+    }
+
+    if (! synthetic.empty())
+        fs::remove(synthetic);
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Micro-benchmark of the vectorized G-code scanner used by GCodeReader, CoolingBuffer and PressureEqualizer.
+// Measures the tokenizer alone and GCodeReader::parse_buffer() for each instruction set supported by the CPU.
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "libslic3r/libslic3r.h"
+#include "libslic3r/GCodeReader.hpp"
+#include "libslic3r/GCodeScanner.hpp"
+
+using namespace Slic3r;
+
+static std::string make_gcode(size_t size_mb)
+{
+    std::string gcode;
+    gcode.reserve((size_mb << 20) + 1024);
+    char buf[256];
+    for (size_t i = 0; gcode.size() < (size_mb << 20); ++ i) {
+        if (i % 50 == 0)
+            gcode += ";TYPE:Outer wall\n;WIDTH:0.449999\n; a longer comment, e.g. a label of an object or a custom G-code\n";
+        sprintf(buf, "G1 X%.3f Y%.3f E%.5f F%d\n", 100. + (i % 397) * 0.113, 80. + (i % 211) * 0.071, 0.02 + (i % 13) * 0.0013, 1200 + int(i % 7) * 300);
+        gcode += buf;
+    }
+    return gcode;
+}
+
+template<typename Fn>
+static double throughput(const std::string &gcode, Fn &&fn)
+{
+    const int  repeats = 5;
+    const auto start   = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++ i)
+        fn();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return double(gcode.size()) * repeats / (1024. * 1024.) / seconds;
+}
+
+int main()
+{
+    const std::string gcode = make_gcode(64);
+    const char       *begin = gcode.data();
+    const char       *end   = begin + gcode.size();
+    size_t            sink  = 0;
+
+    std::cout << "implementation;words [MB/s];parse_buffer [MB/s]" << std::endl;
+    for (GCodeScanner::ISA isa : { GCodeScanner::ISA::Scalar, GCodeScanner::ISA::SSE42, GCodeScanner::ISA::AVX2 }) {
+        if (GCodeScanner::set_isa(isa) != isa)
+            continue;
+        // Tokenizer alone: locate the words and the line ends.
+        const double words = throughput(gcode, [&]() {
+            for (const char *ptr = begin; ptr < end;) {
+                const char *code_end = GCodeScanner::for_each_word(ptr, end, [&sink](const char *word) { sink += size_t(*word); });
+                ptr = GCodeScanner::find_end_of_line(code_end, end) + 1;
+            }
+        });
+        GCodeReader  reader;
+        const double parse = throughput(gcode, [&]() {
+            reader.parse_buffer(gcode, [&sink](GCodeReader &, const GCodeReader::GCodeLine &line) { sink += line.has_x(); });
+        });
+        std::cout << GCodeScanner::isa_name(isa) << ";" << words << ";" << parse << std::endl;
+    }
+    // Keep the optimizer from removing the loops.
+    return sink == 0 ? 1 : 0;
+}
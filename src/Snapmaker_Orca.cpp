@@ -20,6 +20,7 @@
 #include <cstdio>
 #include <string>
 #include <cstring>
+#include <chrono>
 #include <iostream>
 #include <math.h>
 
@@ -33,6 +34,16 @@
 using namespace nlohmann;
 #endif
 
+#include "nlohmann/json.hpp"
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
 
 #include "sentry_wrapper/SentryWrapper.hpp"
 
@@ -55,8 +66,13 @@ using namespace nlohmann;
 #include "libslic3r/GCode/PostProcessor.hpp"
 #include "libslic3r/Model.hpp"
 #include "libslic3r/ModelArrange.hpp"
+#include "libslic3r/OutOfCoreSlicer.hpp"
 #include "libslic3r/Platform.hpp"
 #include "libslic3r/Print.hpp"
+#include "libslic3r/PrintProfiler.hpp"
+#include "libslic3r/Timer.hpp"
+#include "libslic3r/SettingsFileCache.hpp"
+#include "libslic3r/SVG.hpp"
 #include "libslic3r/SLAPrint.hpp"
 #include "libslic3r/TriangleMesh.hpp"
 #include "libslic3r/Format/AMF.hpp"
@@ -155,7 +171,11 @@ typedef struct  _sliced_plate_info{
     size_t sliced_time {0};
     size_t sliced_time_with_cache {0};
     size_t triangle_count{0};
+    size_t slice_cache_hits{0};
+    size_t slice_cache_misses{0};
     std::string warning_message;
+    // Steps recorded by PrintProfiler if --profile is enabled.
+    json profile;
 }sliced_plate_info_t;
 
 typedef struct _sliced_info {
@@ -348,6 +368,14 @@ typedef struct _cli_callback_mgr {
             close(m_pipe_fd);
             m_pipe_fd = -1;
         }
+        // Reset the state, the daemon mode starts the manager again for the next job.
+        lck.lock();
+        m_started = false;
+        m_exit = false;
+        m_data_ready = false;
+        m_progress = 0;
+        m_total_progress = 0;
+        lck.unlock();
         BOOST_LOG_TRIVIAL(info) << "cli_callback_mgr_t::stop successfully.";
     }
 }cli_callback_mgr_t;
@@ -431,7 +459,11 @@ void record_exit_reson(std::string outputdir, int code, int plate_id, std::strin
             plate_json["sliced_time"] = sliced_info.sliced_plates[index].sliced_time;
             plate_json["sliced_time_with_cache"] = sliced_info.sliced_plates[index].sliced_time_with_cache;
             plate_json["triangle_count"] = sliced_info.sliced_plates[index].triangle_count;
+            plate_json["slice_cache_hits"] = sliced_info.sliced_plates[index].slice_cache_hits;
+            plate_json["slice_cache_misses"] = sliced_info.sliced_plates[index].slice_cache_misses;
             plate_json["warning_message"] = sliced_info.sliced_plates[index].warning_message;
+            if (!sliced_info.sliced_plates[index].profile.is_null())
+                plate_json["profile"] = sliced_info.sliced_plates[index].profile;
             j["sliced_plates"].push_back(plate_json);
         }
         for (auto& iter: key_values)
@@ -528,6 +560,9 @@ static int load_key_values_from_json(const std::string &file, std::map<std::stri
     return 0;
 }
 
+// Settings files loaded by --load_settings / --load_filaments, kept for the following jobs of the daemon mode.
+static SettingsFileCache g_settings_file_cache;
+
 static std::set<std::string> gcodes_key_set =  {"filament_end_gcode", "filament_start_gcode", "change_filament_gcode", "layer_change_gcode", "machine_end_gcode", "machine_pause_gcode", "machine_start_gcode",
             "template_custom_gcode", "printing_by_object_gcode", "before_layer_change_gcode", "time_lapse_gcode"};
 
@@ -1079,6 +1114,18 @@ int CLI::run(int argc, char **argv)
         return CLI_INVALID_PARAMS;
     }
     BOOST_LOG_TRIVIAL(info) << "finished setup params, argc="<< argc << std::endl;
+
+    const std::string daemon_endpoint = m_config.opt_string("daemon", true);
+    if (!daemon_endpoint.empty()) {
+        if (m_daemon_job) {
+            boost::nowide::cerr << "daemon option is not allowed in a daemon job" << std::endl;
+            return CLI_INVALID_PARAMS;
+        }
+        return this->run_daemon(daemon_endpoint, argv[0]);
+    }
+    // Meshes too large for the Model are sliced out-of-core before anything is loaded.
+    if (const std::string outlines_dir = m_config.opt_string("export_slice_outlines", true); !outlines_dir.empty())
+        return this->export_slice_outlines(outlines_dir);
     std::string temp_path = wxFileName::GetTempDir().utf8_str().data();
     set_temporary_dir(temp_path);
 
@@ -1103,6 +1150,9 @@ int CLI::run(int argc, char **argv)
     float old_max_radius = 0.f, old_height_to_rod = 0.f, old_height_to_lid = 0.f;
     std::vector<double> old_max_layer_height, old_min_layer_height;
     std::string outfile_dir              =  m_config.opt_string("outputdir", true);
+    std::string slice_cache_dir          =  m_config.opt_string("slice_cache_dir", true);
+    if (std::string task_trace_file = m_config.opt_string("task_trace", true); !task_trace_file.empty())
+        Timing::task_trace_start(task_trace_file);
     const std::vector<std::string>              &load_configs               = m_config.option<ConfigOptionStrings>("load_settings", true)->values;
     const std::vector<std::string>              &uptodate_configs          = m_config.option<ConfigOptionStrings>("uptodate_settings", true)->values;
     const std::vector<std::string>              &uptodate_filaments          = m_config.option<ConfigOptionStrings>("uptodate_filaments", true)->values;
@@ -1139,6 +1189,10 @@ int CLI::run(int argc, char **argv)
         downward_check = false;
 
     bool start_gui = m_actions.empty() && !downward_check;
+    if (start_gui && m_daemon_job) {
+        boost::nowide::cerr << "no action in a daemon job" << std::endl;
+        return CLI_INVALID_PARAMS;
+    }
     if (start_gui) {
         BOOST_LOG_TRIVIAL(info) << "no action, start gui directly" << std::endl;
 #ifdef SLIC3R_GUI
@@ -1263,6 +1317,12 @@ int CLI::run(int argc, char **argv)
     if (skip_modified_gcodes_option)
         skip_modified_gcodes = skip_modified_gcodes_option->value;
 
+    std::string profile_trace_file = m_config.opt_string("profile_trace", true);
+    ConfigOptionBool* profile_option = m_config.option<ConfigOptionBool>("profile");
+    bool profile_steps = (profile_option && profile_option->value) || !profile_trace_file.empty();
+    // Chrome trace events of all the sliced plates, one process per plate.
+    json profile_trace_events = json::array();
+
     ConfigOptionBool* skip_useless_picks_option = m_config.option<ConfigOptionBool>("skip_useless_pick");
     if (skip_useless_picks_option)
         skip_useless_pick = skip_useless_picks_option->value;
@@ -1690,7 +1750,7 @@ int CLI::run(int argc, char **argv)
         }
     }
 
-    auto load_config_file = [config_substitution_rule](const std::string& file, DynamicPrintConfig& config, std::string& config_type,
+    auto load_config_file = [this, config_substitution_rule](const std::string& file, DynamicPrintConfig& config, std::string& config_type,
                                 std::string& config_name, std::string& filament_id, std::string& config_from) {
         if (! boost::filesystem::exists(file)) {
             boost::nowide::cerr << __FUNCTION__<< ": can not find setting file: " << file << std::endl;
@@ -1702,10 +1762,17 @@ int CLI::run(int argc, char **argv)
             std::map<std::string, std::string> key_values;
             std::string reason;
 
-            config_substitutions = config.load_from_json(file, config_substitution_rule, key_values, reason);
-            if (!reason.empty()) {
-                BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<<  ":Can not load config from file "<<file<<"\n";
-                return CLI_CONFIG_FILE_ERROR;
+            const bool        cacheable = m_daemon_job && config.empty();
+            const std::string digest    = cacheable ? SettingsFileCache::file_digest(file) : std::string();
+            if (!cacheable || !g_settings_file_cache.load(file, digest, config, key_values)) {
+                config_substitutions = config.load_from_json(file, config_substitution_rule, key_values, reason);
+                if (!reason.empty()) {
+                    BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<<  ":Can not load config from file "<<file<<"\n";
+                    return CLI_CONFIG_FILE_ERROR;
+                }
+                // The substitutions are only logged, files needing them are loaded again to log them again.
+                if (cacheable && config_substitutions.empty())
+                    g_settings_file_cache.store(file, digest, config, key_values);
             }
 
             config_name = key_values[BBL_JSON_KEY_NAME];
@@ -4179,7 +4246,7 @@ int CLI::run(int argc, char **argv)
                                 //skip this object due to be locked in plate
                                 ap.itemid = locked_aps.size();
                                 locked_aps.emplace_back(ap);
-                                boost::nowide::cout <<__FUNCTION__ << boost::format(": skip locked instance, obj_id %1%, instance_id %2%") % oidx % inst_idx;
+                                boost::nowide::cout <<__FUNCTION__ << boost::format(": skip locked instance, obj_id %1%, instance_id %2%") % oidx % inst_idx << std::endl;
                             }
                         }
                     }
@@ -4877,6 +4944,9 @@ int CLI::run(int argc, char **argv)
                         part_plate->get_print(&print, &gcode_result, &print_index);
 
                         print_fff = dynamic_cast<Print *>(print);
+                        // Each plate is processed once, don't keep the results which only speed up processing the same Print again.
+                        if (print_fff)
+                            print_fff->set_keep_reslice_caches(false);
                         /*if (outfile_config.empty())
                         {
                             outfile = "plate_" + std::to_string(index + 1) + ".gcode";
@@ -5060,6 +5130,9 @@ int CLI::run(int argc, char **argv)
                         else {
                             if (pre_check && (partplate_list.get_plate_count() > 1)) //continue to next plate directly
                                 continue;
+                            PrintProfiler plate_profiler;
+                            if (print_fff)
+                                print_fff->set_profiler(profile_steps ? &plate_profiler : nullptr);
                             try {
                                 std::string outfile_final;
                                 BOOST_LOG_TRIVIAL(info) << "start Print::process for partplate "<<index+1 << std::endl;
@@ -5128,8 +5201,16 @@ int CLI::run(int argc, char **argv)
                                     }
                                 }
                                 else {
+                                    if (print_fff) {
+                                        print_fff->set_slice_cache_dir(slice_cache_dir);
+                                        print_fff->set_slice_cache_max_size(size_t(std::max(0, m_config.option<ConfigOptionInt>("slice_cache_max_size", true)->value)) * 1024 * 1024);
+                                    }
                                     print->process(&time_using_cache);
                                     BOOST_LOG_TRIVIAL(info) << "print::process: first time_using_cache is " << time_using_cache << " secs.";
+                                    if (print_fff && !slice_cache_dir.empty()) {
+                                        sliced_plate_info.slice_cache_hits   = print_fff->slice_cache_statistics().hits;
+                                        sliced_plate_info.slice_cache_misses = print_fff->slice_cache_statistics().misses;
+                                    }
                                 }
                                 if (printer_technology == ptFFF) {
                                     std::string conflict_result = print_fff->get_conflict_string();
@@ -5240,8 +5321,19 @@ int CLI::run(int argc, char **argv)
                                         flush_and_exit(CLI_SLICING_TIME_EXCEEDS_LIMIT);
                                     }
                                 }
+                                if (print_fff && profile_steps) {
+                                    print_fff->set_profiler(nullptr);
+                                    sliced_plate_info.profile = plate_profiler.to_json();
+                                    if (!profile_trace_file.empty()) {
+                                        // Saved after every plate, the CLI may exit on an error of a later plate.
+                                        plate_profiler.append_trace_events(profile_trace_events, index + 1, "plate " + std::to_string(index + 1));
+                                        PrintProfiler::save_trace(profile_trace_file, profile_trace_events);
+                                    }
+                                }
                                 sliced_info.sliced_plates.push_back(sliced_plate_info);
                             } catch (const std::exception &ex) {
+                                if (print_fff)
+                                    print_fff->set_profiler(nullptr);
                                 BOOST_LOG_TRIVIAL(error) << "found slicing or export error for partplate "<<index+1 << std::endl;
                                 boost::nowide::cerr << ex.what() << std::endl;
                                 //continue;
@@ -6153,6 +6245,206 @@ bool CLI::setup(int argc, char **argv)
     return true;
 }
 
+// Run one job of the daemon mode. The request is a json object {"id": ..., "args": ["--slice", "0", ..., "model.3mf"]},
+// the arguments are the same as the arguments of a single invocation of the CLI, {"command": "quit"} stops the daemon.
+// Returns the json response {"id": ..., "return_code": ..., "error": ..., "time_ms": ...} as a single line.
+std::string CLI::run_daemon_job(const std::string &request_line, const char *argv0, bool &quit)
+{
+    nlohmann::json response;
+    nlohmann::json request = nlohmann::json::parse(request_line, nullptr, false);
+    auto invalid_request = [&response](const std::string &error) {
+        response["return_code"] = CLI_INVALID_PARAMS;
+        response["error"]       = error;
+        return response.dump();
+    };
+    if (request.is_discarded() || !request.is_object())
+        return invalid_request("invalid json request");
+    if (auto id = request.find("id"); id != request.end())
+        response["id"] = *id;
+    if (auto command = request.find("command"); command != request.end()) {
+        if (*command != "quit")
+            return invalid_request("unknown command");
+        quit = true;
+        response["return_code"] = CLI_SUCCESS;
+        return response.dump();
+    }
+    auto args_it = request.find("args");
+    if (args_it == request.end() || !args_it->is_array())
+        return invalid_request("missing args");
+
+    std::vector<std::string> args{ argv0 };
+    for (const nlohmann::json &arg : *args_it) {
+        if (!arg.is_string())
+            return invalid_request("args must be strings");
+        args.emplace_back(arg.get<std::string>());
+    }
+    std::vector<char*> job_argv;
+    for (std::string &arg : args)
+        job_argv.emplace_back(arg.data());
+    job_argv.emplace_back(nullptr);
+
+    BOOST_LOG_TRIVIAL(warning) << boost::format("daemon: start job %1%") % response.value("id", nlohmann::json()).dump();
+    const auto start = std::chrono::steady_clock::now();
+    int ret = CLI_SUCCESS;
+    try {
+        CLI job;
+        job.m_daemon_job = true;
+        ret = job.run(int(args.size()), job_argv.data());
+    } catch (const std::bad_alloc &) {
+        ret = CLI_OUT_OF_MEMORY;
+    } catch (const std::exception &ex) {
+        ret = CLI_SLICING_ERROR;
+        response["error"] = ex.what();
+    }
+    response["return_code"] = ret;
+    if (ret != CLI_SUCCESS && !response.contains("error")) {
+        auto error_it = cli_errors.find(ret);
+        response["error"] = error_it != cli_errors.end() ? error_it->second : std::string("unknown error");
+    }
+    response["time_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    BOOST_LOG_TRIVIAL(warning) << boost::format("daemon: finished job %1%, return %2%") % response.value("id", nlohmann::json()).dump() % ret;
+    return response.dump();
+}
+
+// Keep the process alive and run the jobs received one per line as json, see run_daemon_job().
+// The jobs are read from stdin if endpoint is "-", otherwise from the clients connecting to the Unix domain socket at endpoint.
+// The jobs run one after another, each one slices its plates in parallel on the shared TBB worker threads.
+int CLI::run_daemon(const std::string &endpoint, const char *argv0)
+{
+    const ConfigOptionInt *opt_loglevel = m_config.opt<ConfigOptionInt>("debug");
+    set_logging_level(opt_loglevel ? opt_loglevel->value : 2);
+    BOOST_LOG_TRIVIAL(warning) << boost::format("daemon mode on %1%, Current Snapmaker_Orca Version %2%") % endpoint % SLIC3R_VERSION;
+
+    bool quit = false;
+    if (endpoint == "-") {
+        // The responses are the only output written to stdout: the jobs print their messages to stdout as well,
+        // thus stdout is pointed to stderr for the lifetime of the daemon and the responses go to a duplicate of the original stdout.
+        boost::nowide::cout.flush();
+        std::fflush(stdout);
+#ifdef _WIN32
+        const int response_fd = ::_dup(::_fileno(stdout));
+        if (response_fd >= 0)
+            ::_dup2(::_fileno(stderr), ::_fileno(stdout));
+#else
+        ::signal(SIGPIPE, SIG_IGN);
+        const int response_fd = ::dup(STDOUT_FILENO);
+        if (response_fd >= 0)
+            ::dup2(STDERR_FILENO, STDOUT_FILENO);
+#endif
+        if (response_fd < 0)
+            BOOST_LOG_TRIVIAL(error) << boost::format("daemon: can not duplicate stdout, errno %1%, reason: %2%") % errno % strerror(errno);
+
+        std::string line;
+        while (!quit && std::getline(boost::nowide::cin, line)) {
+            boost::algorithm::trim(line);
+            if (line.empty())
+                continue;
+            std::string response = this->run_daemon_job(line, argv0, quit) + "\n";
+            boost::nowide::cout.flush();
+            std::fflush(stdout);
+            if (response_fd < 0) {
+                boost::nowide::cout << response << std::flush;
+                continue;
+            }
+            for (size_t written = 0; written < response.size();) {
+#ifdef _WIN32
+                int n = ::_write(response_fd, response.data() + written, unsigned(response.size() - written));
+#else
+                ssize_t n = ::write(response_fd, response.data() + written, response.size() - written);
+#endif
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0) {
+                    // The client closed stdin / stdout.
+                    quit = true;
+                    break;
+                }
+                written += size_t(n);
+            }
+        }
+        if (response_fd >= 0) {
+#ifdef _WIN32
+            ::_dup2(response_fd, ::_fileno(stdout));
+            ::_close(response_fd);
+#else
+            ::dup2(response_fd, STDOUT_FILENO);
+            ::close(response_fd);
+#endif
+        }
+        return CLI_SUCCESS;
+    }
+
+#ifdef _WIN32
+    boost::nowide::cerr << "daemon mode only supports stdin (-) on this platform" << std::endl;
+    return CLI_UNSUPPORTED_OPERATION;
+#else
+    sockaddr_un addr{};
+    if (endpoint.size() >= sizeof(addr.sun_path)) {
+        boost::nowide::cerr << "daemon socket path too long: " << endpoint << std::endl;
+        return CLI_INVALID_PARAMS;
+    }
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, endpoint.c_str(), sizeof(addr.sun_path) - 1);
+
+    // A client closing the connection early must not kill the daemon.
+    ::signal(SIGPIPE, SIG_IGN);
+    int server_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server_fd < 0) {
+        BOOST_LOG_TRIVIAL(error) << boost::format("daemon: socket failed, errno %1%, reason: %2%") % errno % strerror(errno);
+        return CLI_ENVIRONMENT_ERROR;
+    }
+    ::unlink(endpoint.c_str());
+    if (::bind(server_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(server_fd, 8) < 0) {
+        BOOST_LOG_TRIVIAL(error) << boost::format("daemon: can not listen on %1%, errno %2%, reason: %3%") % endpoint % errno % strerror(errno);
+        ::close(server_fd);
+        return CLI_ENVIRONMENT_ERROR;
+    }
+
+    while (!quit) {
+        int fd = ::accept(server_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            BOOST_LOG_TRIVIAL(error) << boost::format("daemon: accept failed, errno %1%, reason: %2%") % errno % strerror(errno);
+            break;
+        }
+        std::string buffer;
+        char        chunk[4096];
+        bool        connected = true;
+        while (connected && !quit) {
+            ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received <= 0)
+                break;
+            buffer.append(chunk, size_t(received));
+            for (size_t pos = buffer.find('\n'); connected && !quit && pos != std::string::npos; pos = buffer.find('\n')) {
+                std::string line = buffer.substr(0, pos);
+                buffer.erase(0, pos + 1);
+                boost::algorithm::trim(line);
+                if (line.empty())
+                    continue;
+                std::string response = this->run_daemon_job(line, argv0, quit) + "\n";
+                for (size_t sent = 0; sent < response.size();) {
+                    ssize_t n = ::send(fd, response.data() + sent, response.size() - sent, 0);
+                    if (n < 0 && errno == EINTR)
+                        continue;
+                    if (n <= 0) {
+                        connected = false;
+                        break;
+                    }
+                    sent += size_t(n);
+                }
+            }
+        }
+        ::close(fd);
+    }
+    ::close(server_fd);
+    ::unlink(endpoint.c_str());
+    return CLI_SUCCESS;
+#endif
+}
+
 void attach_console_on_demand(){
 #ifdef _WIN32
     static bool console_attached = false;
@@ -6271,6 +6563,68 @@ bool CLI::export_models(IO::ExportFormat format, std::string path_dir)
     return true;
 }
 
+int CLI::export_slice_outlines(const std::string &dir)
+{
+    if (m_input_files.empty()) {
+        boost::nowide::cerr << "export_slice_outlines: no input file" << std::endl;
+        return CLI_INVALID_PARAMS;
+    }
+    const ConfigOptionFloat *opt_layer_height       = m_config.option<ConfigOptionFloat>("layer_height");
+    const ConfigOptionFloat *opt_first_layer_height = m_config.option<ConfigOptionFloat>("initial_layer_print_height");
+    const double layer_height       = opt_layer_height != nullptr && opt_layer_height->value > 0. ? opt_layer_height->value : 0.2;
+    const double first_layer_height = opt_first_layer_height != nullptr && opt_first_layer_height->value > 0. ? opt_first_layer_height->value : layer_height;
+
+    OutOfCoreSlicingParams params;
+    params.memory_budget = size_t(std::max(16, m_config.option<ConfigOptionInt>("slice_memory_budget", true)->value)) * 1024 * 1024;
+    params.resolution    = 0.0025;
+
+    boost::system::error_code ec;
+    if (! boost::filesystem::is_directory(dir, ec) && ! boost::filesystem::create_directories(dir, ec)) {
+        boost::nowide::cerr << "export_slice_outlines: can not create directory " << dir << ", reason: " << ec.message() << std::endl;
+        return CLI_EXPORT_CACHE_DIRECTORY_CREATE_FAILED;
+    }
+
+    for (const std::string &file : m_input_files) {
+        try {
+            const TriangleStream triangles = triangle_stream_from_file(file);
+            // The meshes are streamed as placed, thus they are sliced from their lowest point.
+            float min_z = std::numeric_limits<float>::max();
+            float max_z = std::numeric_limits<float>::lowest();
+            triangles([&min_z, &max_z](const stl_vertex *triangle) {
+                for (size_t i = 0; i < 3; ++ i) {
+                    min_z = std::min(min_z, triangle[i].z());
+                    max_z = std::max(max_z, triangle[i].z());
+                }
+            });
+            if (min_z > max_z) {
+                boost::nowide::cerr << "export_slice_outlines: no triangles in " << file << std::endl;
+                return CLI_DATA_FILE_ERROR;
+            }
+            // Sliced in the middle of each layer as PrintObject does.
+            std::vector<float> zs;
+            for (double bottom_z = 0., height = first_layer_height; bottom_z + 0.5 * height < double(max_z - min_z); bottom_z += height, height = layer_height)
+                zs.emplace_back(min_z + float(bottom_z + 0.5 * height));
+
+            const std::string stem = boost::filesystem::path(file).stem().string();
+            size_t num_exported = 0;
+            slice_mesh_out_of_core(triangles, zs, params, [&](size_t layer_id, ExPolygons &&slices) {
+                if (slices.empty())
+                    return;
+                const std::string path = (boost::filesystem::path(dir) / (boost::format("%1%_%2$05d.svg") % stem % layer_id).str()).string();
+                SVG::export_expolygons(path, slices);
+                ++ num_exported;
+            });
+            BOOST_LOG_TRIVIAL(info) << boost::format("export_slice_outlines: %1% layers of %2% exported to %3%") % num_exported % file % dir;
+        } catch (const Slic3r::FileIOError &ex) {
+            boost::nowide::cerr << "export_slice_outlines: " << ex.what() << std::endl;
+            return CLI_DATA_FILE_ERROR;
+        } catch (const std::bad_alloc &) {
+            return CLI_OUT_OF_MEMORY;
+        }
+    }
+    return CLI_SUCCESS;
+}
+
 //BBS: add export_project function
 bool CLI::export_project(Model *model, std::string& path, PlateDataPtrs &partplate_data,
                          std::vector<Preset *> &       project_presets,
@@ -109,14 +109,21 @@ private:
     std::vector<std::string>    m_actions;
     std::vector<std::string>    m_transforms;
     std::vector<Model>          m_models;
+    // Running a job received by run_daemon().
+    bool                        m_daemon_job { false };
 
     bool setup(int argc, char **argv);
+    // Long-lived mode keeping the process alive and running the jobs received on stdin or on a Unix domain socket.
+    int  run_daemon(const std::string &endpoint, const char *argv0);
+    std::string run_daemon_job(const std::string &request_line, const char *argv0, bool &quit);
 
     /// Prints usage of the CLI.
     void print_help(bool include_print_options = false, PrinterTechnology printer_technology = ptAny) const;
 
     /// Exports loaded models to a file of the specified format, according to the options affecting output filename.
     bool export_models(IO::ExportFormat format, std::string path = std::string());
+    /// Slices the input files out-of-core without loading them into a Model, exports the outlines of the layers as SVG into dir.
+    int  export_slice_outlines(const std::string &dir);
     //BBS: add export_project function
     bool export_project(Model *model, std::string& path, PlateDataPtrs &partplate_data, std::vector<Preset*>& project_presets,
                         std::vector<ThumbnailData *> &thumbnails,
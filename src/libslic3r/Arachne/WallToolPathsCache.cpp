@@ -0,0 +1,139 @@
+#include "WallToolPathsCache.hpp"
+
+#include "../BoundingBox.hpp"
+
+#include <algorithm>
+
+#include <boost/functional/hash.hpp>
+
+namespace Slic3r::Arachne
+{
+
+bool WallToolPathsCache::Key::operator==(const Key &rhs) const
+{
+    return bead_width_0 == rhs.bead_width_0 && bead_width_x == rhs.bead_width_x && inset_count == rhs.inset_count &&
+           wall_0_inset == rhs.wall_0_inset && layer_height == rhs.layer_height &&
+           params.min_bead_width == rhs.params.min_bead_width && params.min_feature_size == rhs.params.min_feature_size &&
+           params.min_length_factor == rhs.params.min_length_factor && params.wall_transition_length == rhs.params.wall_transition_length &&
+           params.wall_transition_angle == rhs.params.wall_transition_angle &&
+           params.wall_transition_filter_deviation == rhs.params.wall_transition_filter_deviation &&
+           params.wall_distribution_count == rhs.params.wall_distribution_count &&
+           params.is_top_or_bottom_layer == rhs.params.is_top_or_bottom_layer &&
+           outline == rhs.outline;
+}
+
+size_t WallToolPathsCache::hash(const Key &key)
+{
+    size_t seed = 0;
+    boost::hash_combine(seed, key.bead_width_0);
+    boost::hash_combine(seed, key.bead_width_x);
+    boost::hash_combine(seed, key.inset_count);
+    boost::hash_combine(seed, key.wall_0_inset);
+    boost::hash_combine(seed, key.layer_height);
+    boost::hash_combine(seed, key.params.min_bead_width);
+    boost::hash_combine(seed, key.params.min_feature_size);
+    boost::hash_combine(seed, key.params.min_length_factor);
+    boost::hash_combine(seed, key.params.wall_transition_length);
+    boost::hash_combine(seed, key.params.wall_transition_angle);
+    boost::hash_combine(seed, key.params.wall_transition_filter_deviation);
+    boost::hash_combine(seed, key.params.wall_distribution_count);
+    boost::hash_combine(seed, key.params.is_top_or_bottom_layer);
+    for (const Polygon &polygon : key.outline) {
+        boost::hash_combine(seed, polygon.size());
+        for (const Point &pt : polygon.points) {
+            boost::hash_combine(seed, pt.x());
+            boost::hash_combine(seed, pt.y());
+        }
+    }
+    return seed;
+}
+
+size_t WallToolPathsCache::estimate_memory(const Entry &entry)
+{
+    size_t size = sizeof(Entry);
+    for (const Polygon &polygon : entry.key.outline)
+        size += sizeof(Polygon) + polygon.size() * sizeof(Point);
+    for (const Polygon &polygon : entry.result.inner_contour)
+        size += sizeof(Polygon) + polygon.size() * sizeof(Point);
+    for (const VariableWidthLines &lines : entry.result.toolpaths) {
+        size += sizeof(VariableWidthLines);
+        for (const ExtrusionLine &line : lines)
+            size += sizeof(ExtrusionLine) + line.size() * sizeof(ExtrusionJunction);
+    }
+    return size;
+}
+
+size_t WallToolPathsCache::memory() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_memory;
+}
+
+static void translate(WallToolPathsCache::Result &result, const Point &offset)
+{
+    for (VariableWidthLines &lines : result.toolpaths)
+        for (ExtrusionLine &line : lines)
+            for (ExtrusionJunction &junction : line.junctions)
+                junction.p += offset;
+    for (Polygon &polygon : result.inner_contour)
+        polygon.translate(offset);
+}
+
+WallToolPathsCache::Result WallToolPathsCache::generate(const Polygons &outline, coord_t bead_width_0, coord_t bead_width_x, size_t inset_count,
+                                                        coord_t wall_0_inset, coordf_t layer_height, const WallToolPathsParams &params)
+{
+    const BoundingBox bbox   = get_extents(outline);
+    const Point       offset = bbox.defined ? bbox.min : Point::Zero();
+
+    auto entry = std::make_shared<Entry>();
+    entry->key = { bead_width_0, bead_width_x, inset_count, wall_0_inset, layer_height, params, outline };
+    for (Polygon &polygon : entry->key.outline)
+        polygon.translate(- offset);
+    const size_t key_hash = hash(entry->key);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (auto it = m_entries.find(key_hash); it != m_entries.end())
+            for (const EntryPtr &cached : it->second)
+                if (cached->key == entry->key) {
+                    m_hits.fetch_add(1, std::memory_order_relaxed);
+                    Result result = cached->result;
+                    translate(result, offset);
+                    return result;
+                }
+    }
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+
+    // Generate outside of the lock, other layers are being processed in parallel.
+    WallToolPaths wall_tool_paths(entry->key.outline, bead_width_0, bead_width_x, inset_count, wall_0_inset, layer_height, params);
+    entry->result.toolpaths     = wall_tool_paths.getToolPaths();
+    entry->result.inner_contour = wall_tool_paths.getInnerContour();
+
+    Result result = entry->result;
+    translate(result, offset);
+
+    const size_t entry_memory = estimate_memory(*entry);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_memory + entry_memory <= m_max_memory) {
+            std::vector<EntryPtr> &entries = m_entries[key_hash];
+            // Another thread may have generated the same tool paths in the meantime, keep the one stored first.
+            if (std::none_of(entries.begin(), entries.end(), [&entry](const EntryPtr &cached) { return cached->key == entry->key; })) {
+                entries.emplace_back(std::move(entry));
+                m_memory += entry_memory;
+            }
+        }
+    }
+    return result;
+}
+
+WallToolPathsCache::Result generate_wall_toolpaths(WallToolPathsCache *cache, const Polygons &outline, coord_t bead_width_0, coord_t bead_width_x,
+                                                   size_t inset_count, coord_t wall_0_inset, coordf_t layer_height, const WallToolPathsParams &params)
+{
+    if (cache)
+        return cache->generate(outline, bead_width_0, bead_width_x, inset_count, wall_0_inset, layer_height, params);
+    WallToolPaths wall_tool_paths(outline, bead_width_0, bead_width_x, inset_count, wall_0_inset, layer_height, params);
+    return { wall_tool_paths.getToolPaths(), wall_tool_paths.getInnerContour() };
+}
+
+} // namespace Slic3r::Arachne
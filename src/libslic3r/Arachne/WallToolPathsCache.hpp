@@ -0,0 +1,84 @@
+#ifndef slic3r_Arachne_WallToolPathsCache_hpp_
+#define slic3r_Arachne_WallToolPathsCache_hpp_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <ankerl/unordered_dense.h>
+
+#include "WallToolPaths.hpp"
+
+namespace Slic3r::Arachne
+{
+
+// Tool paths generated by WallToolPaths for an outline, shared by the layers of a PrintObject with the same outline.
+// Prismatic parts produce hundreds of consecutive layers with identical or just translated outlines, for which
+// the Voronoi diagram and the skeletal trapezoidation would be calculated over and over again.
+//
+// The outline is translated to the origin of its bounding box before generating the tool paths, both on a cache miss
+// and on a cache hit, thus the result does not depend on which layer populated the cache first.
+// The cache is thread safe, the same outline may be generated by multiple threads at once, the first result stored wins.
+class WallToolPathsCache
+{
+public:
+    struct Result
+    {
+        std::vector<VariableWidthLines> toolpaths;
+        Polygons                        inner_contour;
+    };
+
+    // The cache stops storing new tool paths once their estimated size exceeds max_memory bytes.
+    explicit WallToolPathsCache(size_t max_memory = size_t(256) * 1024 * 1024) : m_max_memory(max_memory) {}
+
+    // Equivalent to WallToolPaths(outline, bead_width_0, bead_width_x, inset_count, wall_0_inset, layer_height, params)
+    // followed by getToolPaths() and getInnerContour().
+    Result generate(const Polygons &outline, coord_t bead_width_0, coord_t bead_width_x, size_t inset_count, coord_t wall_0_inset,
+                    coordf_t layer_height, const WallToolPathsParams &params);
+
+    size_t hits()   const { return m_hits.load(std::memory_order_relaxed); }
+    size_t misses() const { return m_misses.load(std::memory_order_relaxed); }
+    size_t memory() const;
+
+private:
+    struct Key
+    {
+        coord_t             bead_width_0;
+        coord_t             bead_width_x;
+        size_t              inset_count;
+        coord_t             wall_0_inset;
+        coordf_t            layer_height;
+        WallToolPathsParams params;
+        // Outline translated to the origin of its bounding box.
+        Polygons            outline;
+
+        bool operator==(const Key &rhs) const;
+    };
+
+    struct Entry
+    {
+        Key    key;
+        Result result;
+    };
+    using EntryPtr = std::shared_ptr<const Entry>;
+
+    static size_t hash(const Key &key);
+    static size_t estimate_memory(const Entry &entry);
+
+    size_t                                                      m_max_memory;
+    mutable std::mutex                                          m_mutex;
+    // Entries by the hash of their key, colliding entries share the vector.
+    ankerl::unordered_dense::map<size_t, std::vector<EntryPtr>> m_entries;
+    size_t                                                      m_memory { 0 };
+    std::atomic<size_t>                                         m_hits { 0 };
+    std::atomic<size_t>                                         m_misses { 0 };
+};
+
+// Generate the tool paths through the cache if there is one, otherwise by WallToolPaths directly.
+WallToolPathsCache::Result generate_wall_toolpaths(WallToolPathsCache *cache, const Polygons &outline, coord_t bead_width_0, coord_t bead_width_x,
+                                                   size_t inset_count, coord_t wall_0_inset, coordf_t layer_height, const WallToolPathsParams &params);
+
+} // namespace Slic3r::Arachne
+
+#endif // slic3r_Arachne_WallToolPathsCache_hpp_
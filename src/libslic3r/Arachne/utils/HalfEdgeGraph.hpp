@@ -7,11 +7,13 @@
 
 #include <list>
 #include <cassert>
+#include <memory>
 
 
 
 #include "HalfEdge.hpp"
 #include "HalfEdgeNode.hpp"
+#include "../../MonotonicArena.hpp"
 
 namespace Slic3r::Arachne
 {
@@ -21,8 +23,27 @@ class HalfEdgeGraph
 public:
     using edge_t = derived_edge_t;
     using node_t = derived_node_t;
-    using Edges = std::list<edge_t>;
-    using Nodes = std::list<node_t>;
+    // The nodes and edges are allocated from an arena owned by the graph: a graph is built for a single layer,
+    // mostly in one go from the Voronoi diagram, and freed as a whole. Allocating from the arena saves a system allocation
+    // per node and edge and places the consecutively created edges next to each other in memory.
+    // Erased nodes and edges are not reused, their memory is released together with the graph.
+    using Edges = std::list<edge_t, ArenaAllocator<edge_t>>;
+    using Nodes = std::list<node_t, ArenaAllocator<node_t>>;
+
+    HalfEdgeGraph() :
+        m_arena(std::make_unique<MonotonicArena>(256 * 1024)),
+        edges(ArenaAllocator<edge_t>(*m_arena)),
+        nodes(ArenaAllocator<node_t>(*m_arena))
+    {}
+    // The nodes and edges point to each other, the graph cannot be copied.
+    HalfEdgeGraph(const HalfEdgeGraph &) = delete;
+    HalfEdgeGraph& operator=(const HalfEdgeGraph &) = delete;
+
+private:
+    // Constructed before and destroyed after the lists allocating from it.
+    std::unique_ptr<MonotonicArena> m_arena;
+
+public:
     Edges edges;
     Nodes nodes;
 };
@@ -792,6 +792,31 @@ ConfigSubstitutions ConfigBase::load_from_json(const std::string &file, ForwardC
 int ConfigBase::load_from_json(const std::string &file, ConfigSubstitutionContext& substitution_context, bool load_inherits_to_config, std::map<std::string, std::string>& key_values, std::string& reason)
 {
     json j;
+    try {
+        boost::nowide::ifstream ifs(file);
+        ifs >> j;
+        ifs.close();
+    }
+    catch (const std::ifstream::failure &err)  {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": parse "<<file<<" got a ifstream error, reason = " << err.what();
+        reason = std::string("ifstreamError: ") + err.what();
+        return -1;
+    }
+    catch(nlohmann::detail::parse_error &err) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": parse "<<file<<" got a nlohmann::detail::parse_error, reason = " << err.what();
+        reason = std::string("JsonParseError: ") + err.what();
+        return -1;
+    }
+    catch(std::exception &err) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": parse "<<file<<" got a generic exception, reason = " << err.what();
+        reason = std::string("std::exception: ") + err.what();
+        return -1;
+    }
+    return load_from_json(j, file, substitution_context, load_inherits_to_config, key_values, reason);
+}
+
+int ConfigBase::load_from_json(const json &j, const std::string &file, ConfigSubstitutionContext& substitution_context, bool load_inherits_to_config, std::map<std::string, std::string>& key_values, std::string& reason)
+{
     std::list<std::string> different_settings_append;
     std::string new_support_style;
     std::string is_infill_first;
@@ -801,10 +826,6 @@ int ConfigBase::load_from_json(const std::string &file, ConfigSubstitutionContex
     CNumericLocalesSetter locales_setter;
 
     try {
-        boost::nowide::ifstream ifs(file);
-        ifs >> j;
-        ifs.close();
-
         const ConfigDef* config_def = this->def();
         if (config_def == nullptr) {
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": no config defs!";
@@ -1049,16 +1070,6 @@ int ConfigBase::load_from_json(const std::string &file, ConfigSubstitutionContex
         this->handle_legacy_composite();
         return 0;
     }
-    catch (const std::ifstream::failure &err)  {
-        BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": parse "<<file<<" got a ifstream error, reason = " << err.what();
-        reason = std::string("ifstreamError: ") + err.what();
-        //throw ConfigurationError(format("Failed loading configuration file \"%1%\": %2%", file, e.what()));
-    }
-    catch(nlohmann::detail::parse_error &err) {
-        BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": parse "<<file<<" got a nlohmann::detail::parse_error, reason = " << err.what();
-        reason = std::string("JsonParseError: ") + err.what();
-        //throw ConfigurationError(format("Failed loading configuration file \"%1%\": %2%", file, err.what()));
-    }
     catch(std::exception &err) {
         BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": parse "<<file<<" got a generic exception, reason = " << err.what();
         reason = std::string("std::exception: ") + err.what();
@@ -22,6 +22,8 @@
 #include <boost/functional/hash.hpp>
 #include <boost/property_tree/ptree_fwd.hpp>
 
+#include <nlohmann/json_fwd.hpp>
+
 #include <cereal/access.hpp>
 #include <cereal/types/base_class.hpp>
 
@@ -2173,6 +2175,8 @@ public:
     ConfigSubstitutions load_string_map(std::map<std::string, std::string> &key_values, ForwardCompatibilitySubstitutionRule compatibility_rule);
     //BBS: add json support
     int load_from_json(const std::string &file, ConfigSubstitutionContext& substitutions, bool load_inherits_in_config, std::map<std::string, std::string>& key_values, std::string& reason);
+    // Load from an already parsed json document, file is only used for logging.
+    int load_from_json(const nlohmann::json &j, const std::string &file, ConfigSubstitutionContext& substitutions, bool load_inherits_in_config, std::map<std::string, std::string>& key_values, std::string& reason);
     ConfigSubstitutions load_from_json(const std::string &file, ForwardCompatibilitySubstitutionRule compatibility_rule, std::map<std::string, std::string>& key_values, std::string& reason);
 
     ConfigSubstitutions load_from_ini(const std::string &file, ForwardCompatibilitySubstitutionRule compatibility_rule);
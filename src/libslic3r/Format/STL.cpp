@@ -4,8 +4,22 @@
 
 #include "STL.hpp"
 
+#include <atomic>
+#include <cstring>
 #include <string>
 
+#include <boost/endian/conversion.hpp>
+#include <boost/format.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/convert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <ankerl/unordered_dense.h>
+
 #ifdef _WIN32
 #define DIR_SEPARATOR '\\'
 #else
@@ -14,12 +28,232 @@
 
 namespace Slic3r {
 
+namespace MappedSTL {
+
+// The vertices are deduplicated in shards, each shard by a single thread. The shard is selected by hash bits used neither for the bucket
+// (top bits) nor for the fingerprint (bottom byte) of unordered_dense, otherwise the vertices of a shard would collide in its map.
+static constexpr int      shard_bits          = 6;
+static constexpr size_t   num_shards          = size_t(1) << shard_bits;
+static constexpr uint8_t  first_corner_flag   = 0x80;
+static constexpr size_t   facets_per_block    = 65536;
+static constexpr size_t   facet_size          = SIZEOF_STL_FACET;
+
+// Key of the j-th vertex of a facet record, negative zero is folded to zero.
+static inline VertexKey vertex_key(const char *facet, size_t j)
+{
+    VertexKey key;
+    ::memcpy(key.bits, facet + 12 + 12 * j, sizeof(key.bits));
+    for (uint32_t &b : key.bits)
+        if (b == 0x80000000u)
+            b = 0;
+    return key;
+}
+
+static inline uint8_t shard_of(const VertexKey &key)
+{
+    return uint8_t((VertexKeyHash()(key) >> 8) & (num_shards - 1));
+}
+
+static inline bool is_nan(const VertexKey &key)
+{
+    for (uint32_t b : key.bits)
+        if ((b & 0x7f800000u) == 0x7f800000u && (b & 0x007fffffu) != 0)
+            return true;
+    return false;
+}
+
+} // namespace MappedSTL
+
+bool read_binary_stl_mapped(const char *path, indexed_triangle_set &out, ImportstlProgressFn stlFn, int custom_header_length, bool *canceled)
+{
+    using namespace MappedSTL;
+    if (canceled)
+        *canceled = false;
+    if (boost::endian::order::native != boost::endian::order::little)
+        return false;
+
+    std::unique_ptr<boost::interprocess::mapped_region> region;
+    try {
+#ifdef _WIN32
+        boost::interprocess::file_mapping mapping(boost::nowide::widen(path).c_str(), boost::interprocess::read_only);
+#else
+        boost::interprocess::file_mapping mapping(path, boost::interprocess::read_only);
+#endif
+        region = std::make_unique<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": failed to map %1%: %2%") % path % ex.what();
+        return false;
+    }
+
+    // Same as stl_open(): a header shorter than the standard one is not accepted, it would not fit the header of the mesh
+    // and a negative length would wrap around when used as an offset into the mapping.
+    if (custom_header_length < LABEL_SIZE)
+        custom_header_length = LABEL_SIZE;
+
+    // Same detection of a binary STL as in admesh: a byte above 127 following the header, size matching whole facets.
+    const size_t  file_size   = region->get_size();
+    const size_t  header_size = size_t(custom_header_length) + NUM_FACET_SIZE;
+    const auto   *data        = static_cast<const unsigned char*>(region->get_address());
+    if (file_size < STL_MIN_FILE_SIZE || file_size < header_size + 128 || (file_size - header_size) % facet_size != 0 ||
+        std::none_of(data + header_size, data + header_size + 128, [](unsigned char c) { return c > 127; }))
+        return false;
+    const size_t num_facets  = (file_size - header_size) / facet_size;
+    const size_t num_corners = 3 * num_facets;
+    if (num_corners > size_t(std::numeric_limits<int>::max()))
+        return false;
+    const char  *facets      = reinterpret_cast<const char*>(data + header_size);
+    const size_t num_blocks  = (num_facets + facets_per_block - 1) / facets_per_block;
+
+    // Report the progress the same number of times as admesh.
+    int progress_step = 0;
+    auto progress = [&]() {
+        bool cancel = false;
+        std::string model_id, country_code;
+        if (stlFn)
+            stlFn(int(num_facets * progress_step ++ / 5), int(num_facets), cancel, model_id, country_code);
+        if (cancel && canceled)
+            *canceled = true;
+        return ! cancel;
+    };
+
+    // 1) Hash the vertices of the facets, count the vertices of each block falling into each shard.
+    if (! progress())
+        return false;
+    std::vector<uint8_t>  corner_shard(num_corners);
+    std::vector<uint32_t> block_shard_count(num_blocks * num_shards, 0);
+    std::atomic<bool>     has_nan { false };
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_blocks, 1), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t block = range.begin(); block < range.end(); ++ block) {
+            uint32_t *count = block_shard_count.data() + block * num_shards;
+            for (size_t facet = block * facets_per_block; facet < std::min(num_facets, (block + 1) * facets_per_block); ++ facet)
+                for (size_t j = 0; j < 3; ++ j) {
+                    const VertexKey key   = vertex_key(facets + facet * facet_size, j);
+                    const uint8_t   shard = shard_of(key);
+                    if (is_nan(key))
+                        has_nan = true;
+                    corner_shard[3 * facet + j] = shard;
+                    ++ count[shard];
+                }
+        }
+    });
+    // admesh drops the facets with NaN vertices and repairs the mesh.
+    if (has_nan)
+        return false;
+
+    // 2) Sort the vertices into the shards, keeping the order of the facets.
+    if (! progress())
+        return false;
+    std::vector<size_t> shard_begin(num_shards + 1, 0);
+    {
+        size_t offset = 0;
+        for (size_t shard = 0; shard < num_shards; ++ shard) {
+            shard_begin[shard] = offset;
+            for (size_t block = 0; block < num_blocks; ++ block) {
+                uint32_t &count = block_shard_count[block * num_shards + shard];
+                const uint32_t n = count;
+                // Convert the counts to the offsets of the blocks in the shards.
+                count = uint32_t(offset);
+                offset += n;
+            }
+        }
+        shard_begin[num_shards] = offset;
+    }
+    std::vector<uint32_t> shard_corners(num_corners);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_blocks, 1), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t block = range.begin(); block < range.end(); ++ block) {
+            uint32_t *offset = block_shard_count.data() + block * num_shards;
+            for (size_t corner = 3 * block * facets_per_block; corner < std::min(num_corners, 3 * (block + 1) * facets_per_block); ++ corner)
+                shard_corners[offset[corner_shard[corner]] ++] = uint32_t(corner);
+        }
+    });
+    block_shard_count.clear();
+    block_shard_count.shrink_to_fit();
+
+    // 3) Deduplicate the vertices of each shard, storing the index of the vertex local to its shard into the facet indices.
+    // The first occurence of a vertex is marked, so that the vertices may be numbered by their first occurence as admesh does.
+    if (! progress())
+        return false;
+    out.indices.assign(num_facets, stl_triangle_vertex_indices());
+    int *indices = out.indices.front().data();
+    std::vector<std::vector<int>> shard_global_ids(num_shards);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_shards, 1), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t shard = range.begin(); shard < range.end(); ++ shard) {
+            ankerl::unordered_dense::map<VertexKey, int, VertexKeyHash> map;
+            map.reserve((shard_begin[shard + 1] - shard_begin[shard]) / 5);
+            for (size_t i = shard_begin[shard]; i < shard_begin[shard + 1]; ++ i) {
+                const uint32_t corner = shard_corners[i];
+                auto [it, inserted] = map.try_emplace(vertex_key(facets + (corner / 3) * facet_size, corner % 3), int(map.size()));
+                if (inserted)
+                    corner_shard[corner] |= first_corner_flag;
+                indices[corner] = it->second;
+            }
+            shard_global_ids[shard].assign(map.size(), -1);
+        }
+    });
+    shard_corners.clear();
+    shard_corners.shrink_to_fit();
+
+    // 4) Number the vertices by their first occurence, a prefix sum of the first occurence flags.
+    if (! progress())
+        return false;
+    std::vector<int> block_first_vertex(num_blocks + 1, 0);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_blocks, 1), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t block = range.begin(); block < range.end(); ++ block)
+            block_first_vertex[block + 1] = int(std::count_if(corner_shard.begin() + 3 * block * facets_per_block,
+                corner_shard.begin() + std::min(num_corners, 3 * (block + 1) * facets_per_block), [](uint8_t s) { return (s & first_corner_flag) != 0; }));
+    });
+    for (size_t block = 0; block < num_blocks; ++ block)
+        block_first_vertex[block + 1] += block_first_vertex[block];
+    out.vertices.assign(size_t(block_first_vertex.back()), stl_vertex());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_blocks, 1), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t block = range.begin(); block < range.end(); ++ block) {
+            int vertex_id = block_first_vertex[block];
+            for (size_t corner = 3 * block * facets_per_block; corner < std::min(num_corners, 3 * (block + 1) * facets_per_block); ++ corner)
+                if (uint8_t s = corner_shard[corner]; (s & first_corner_flag) != 0) {
+                    shard_global_ids[s & ~first_corner_flag][indices[corner]] = vertex_id;
+                    const VertexKey key = vertex_key(facets + (corner / 3) * facet_size, corner % 3);
+                    ::memcpy(out.vertices[vertex_id ++].data(), key.bits, sizeof(key.bits));
+                }
+        }
+    });
+
+    // 5) Replace the shard local vertex indices with the global ones.
+    if (! progress())
+        return false;
+    std::atomic<bool> has_degenerate { false };
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_facets), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t facet = range.begin(); facet < range.end(); ++ facet) {
+            stl_triangle_vertex_indices &face = out.indices[facet];
+            for (size_t j = 0; j < 3; ++ j)
+                face(j) = shard_global_ids[corner_shard[3 * facet + j] & ~first_corner_flag][face(j)];
+            if (face(0) == face(1) || face(1) == face(2) || face(2) == face(0))
+                has_degenerate = true;
+        }
+    });
+    // Degenerate facets are removed by the admesh repair.
+    return ! has_degenerate;
+}
+
 bool load_stl(const char *path, Model *model, const char *object_name_in, ImportstlProgressFn stlFn, int custom_header_length)
 {
     TriangleMesh mesh;
     std::string design_id;
 
-    if (!mesh.ReadSTLFile(path, true, stlFn, custom_header_length)) {
+    {
+        // Fast path for binary STLs describing a closed mesh, for which the admesh repair would be a no-op.
+        indexed_triangle_set its;
+        bool                 canceled = false;
+        if (read_binary_stl_mapped(path, its, stlFn, custom_header_length, &canceled)) {
+            mesh = TriangleMesh(std::move(its));
+            if (! mesh.stats().manifold() || mesh.stats().volume <= 0) {
+                BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": %1% needs to be repaired") % path;
+                mesh = TriangleMesh();
+            }
+        } else if (canceled)
+            return false;
+    }
+
+    if (mesh.empty() && !mesh.ReadSTLFile(path, true, stlFn, custom_header_length)) {
         //    die "Failed to open $file\n" if !-e $path;
         return false;
     }
@@ -12,6 +12,11 @@ class ModelObject;
 // Load an STL file into a provided model.
 extern bool load_stl(const char *path, Model *model, const char *object_name = nullptr, ImportstlProgressFn stlFn = nullptr, int custom_header_length = 80);
 
+// Read a binary STL by memory mapping it, decoding the facets and merging the identical vertices in parallel.
+// Returns false if the file is not a binary STL or if it contains NaN vertices or degenerate facets, which need to be repaired by admesh.
+// canceled is set if stlFn canceled the loading. custom_header_length is clamped to at least LABEL_SIZE as in admesh.
+extern bool read_binary_stl_mapped(const char *path, indexed_triangle_set &out, ImportstlProgressFn stlFn = nullptr, int custom_header_length = 80, bool *canceled = nullptr);
+
 extern bool store_stl(const char *path, TriangleMesh *mesh, bool binary);
 extern bool store_stl(const char *path, ModelObject *model_object, bool binary);
 extern bool store_stl(const char *path, Model *model, bool binary);
@@ -15,9 +15,15 @@
 
 #include "bbs_3mf.hpp"
 
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <chrono>
 #include <limits>
+#include <numeric>
 #include <stdexcept>
 #include <iomanip>
+#include <thread>
 
 #include <boost/assign.hpp>
 #include <boost/bimap.hpp>
@@ -44,6 +50,8 @@ namespace pt = boost::property_tree;
 #include <tbb/blocked_range.h>
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_reduce.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
 
 #include <expat.h>
 #include <Eigen/Dense>
@@ -57,6 +65,7 @@ namespace pt = boost::property_tree;
 #include "NSVGUtils.hpp"
 
 #include <fast_float/fast_float.h>
+#include <ankerl/unordered_dense.h>
 
 // Slightly faster than sprintf("%.9g"), but there is an issue with the karma floating point formatter,
 // https://github.com/boostorg/spirit/pull/586
@@ -954,9 +963,17 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                     return false;
                 }
 
-                if (!top_importer->_extract_from_archive(archive, object_path, [this] (mz_zip_archive& archive, const mz_zip_archive_file_stat& stat) {
-                    return _extract_object_from_archive(archive, stat);
-                }, top_importer->m_load_restore)) {
+                bool extracted = false;
+                try {
+                    extracted = top_importer->_extract_from_archive(archive, object_path, [this] (mz_zip_archive& archive, const mz_zip_archive_file_stat& stat) {
+                        return _extract_object_from_archive(archive, stat);
+                    }, top_importer->m_load_restore);
+                } catch (...) {
+                    // ensure the zip archive is closed and rethrow the exception
+                    close_zip_reader(&archive);
+                    throw;
+                }
+                if (!extracted) {
                     std::string error_msg = std::string("Archive does not contain a valid model for ") + object_path;
                     top_importer->add_error(error_msg);
 
@@ -1715,22 +1732,88 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                 m_object_importers.push_back(object_importer);
             }
 
-            bool object_load_result = true;
-            boost::mutex mutex;
-            tbb::parallel_for(
-                tbb::blocked_range<size_t>(0, m_object_importers.size()),
-                [this, &mutex, &object_load_result](const tbb::blocked_range<size_t>& importer_range) {
-                    CNumericLocalesSetter locales_setter;
-                    for (size_t object_index = importer_range.begin(); object_index < importer_range.end(); ++ object_index) {
-                        bool result = m_object_importers[object_index]->extract_object_model();
-                        {
-                            boost::unique_lock l(mutex);
-                            object_load_result &= result;
-                        }
+            // Parse the largest object files first, so that a single large object does not end up parsed last on a single thread.
+            std::vector<size_t>      object_order(m_object_importers.size());
+            std::vector<mz_uint64>   object_sizes(m_object_importers.size(), 0);
+            for (size_t i = 0; i < m_object_importers.size(); ++ i) {
+                std::string path = m_object_importers[i]->object_path;
+                if (! path.empty() && path.front() == '/')
+                    path = path.substr(1);
+                mz_zip_archive_file_stat object_stat;
+                if (int index = mz_zip_reader_locate_file(&archive, path.c_str(), nullptr, 0); index >= 0 && mz_zip_reader_file_stat(&archive, index, &object_stat))
+                    object_sizes[i] = object_stat.m_uncomp_size;
+            }
+            std::iota(object_order.begin(), object_order.end(), 0);
+            std::stable_sort(object_order.begin(), object_order.end(), [&object_sizes](size_t l, size_t r) { return object_sizes[l] > object_sizes[r]; });
+
+            // The objects are taken from a shared counter by the tasks of a task group and by this thread. Only this thread reports
+            // the progress and polls for cancelation, as the progress callback updates the UI. The results are kept per object,
+            // thus the objects are merged in the order of their paths independently of the order in which they were parsed.
+            // An exception thrown while parsing an object cancels the other objects, it is rethrown once all the tasks finished.
+            std::atomic<size_t>     next_object { 0 };
+            std::atomic<size_t>     num_parsed { 0 };
+            std::atomic<bool>       canceled { false };
+            std::exception_ptr      exception;
+            std::mutex              exception_mutex;
+            std::vector<char>       object_results(m_object_importers.size(), true);
+            auto parse_objects = [this, &object_order, &next_object, &num_parsed, &canceled, &exception, &exception_mutex, &object_results](bool single) {
+                CNumericLocalesSetter locales_setter;
+                for (size_t i; ! canceled && (i = next_object ++) < object_order.size();) {
+                    const size_t object_index = object_order[i];
+                    try {
+                        object_results[object_index] = m_object_importers[object_index]->extract_object_model();
+                    } catch (...) {
+                        std::scoped_lock lock(exception_mutex);
+                        if (! exception)
+                            exception = std::current_exception();
+                        object_results[object_index] = false;
+                        canceled = true;
+                    }
+                    ++ num_parsed;
+                    if (single)
+                        break;
+                }
+            };
+            auto delete_object_importers = [this]() {
+                for (ObjectImporter *obj_importer : m_object_importers)
+                    delete obj_importer;
+                m_object_importers.clear();
+            };
+            tbb::task_group task_group;
+            for (size_t i = 1; i < std::min<size_t>(object_order.size(), tbb::this_task_arena::max_concurrency()); ++ i)
+                task_group.run([&parse_objects]() { parse_objects(false); });
+            try {
+                while (! canceled && num_parsed < object_order.size()) {
+                    if (next_object < object_order.size())
+                        parse_objects(true);
+                    else
+                        // The remaining objects are being parsed by the other threads.
+                        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                    if (proFn) {
+                        // Between 1/3 and 2/3 of the stage, 2/3 is reported once the root model is being loaded.
+                        proFn(IMPORT_STAGE_READ_FILES, int(m_object_importers.size() + num_parsed), 3 * int(m_object_importers.size()), cb_cancel);
+                        if (cb_cancel)
+                            canceled = true;
                     }
                 }
-            );
+            } catch (...) {
+                // Thrown by the progress callback, the tasks reference the locals of this function.
+                canceled = true;
+                task_group.wait();
+                delete_object_importers();
+                throw;
+            }
+            task_group.wait();
+            if (exception) {
+                delete_object_importers();
+                std::rethrow_exception(exception);
+            }
+            if (canceled) {
+                delete_object_importers();
+                return false;
+            }
 
+            const bool object_load_result = std::all_of(object_results.begin(), object_results.end(), [](char result) { return result != 0; });
             if (!object_load_result) {
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", loading sub-objects error\n");
                 return false;
@@ -5612,6 +5695,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         bool m_skip_auxiliary { false };    // skip normal axuiliary files
         bool m_use_loaded_id { false };        // whether to use loaded id for identify_id
         bool m_share_mesh { false };        // whether to share mesh between objects
+        mz_uint m_compression_level { MZ_DEFAULT_LEVEL }; // deflate level of the model, G-code and config files
         std::string m_thumbnail_middle = PRINTER_THUMBNAIL_MIDDLE_FILE;
         std::string m_thumbnail_small  = PRINTER_THUMBNAIL_SMALL_FILE;
         std::map<void const *, std::pair<ObjectData*, ModelVolume const *>> m_shared_meshes;
@@ -5708,6 +5792,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         m_skip_auxiliary = store_params.strategy & SaveStrategy::SkipAuxiliary;
         m_share_mesh       = store_params.strategy & SaveStrategy::ShareMesh;
         m_from_backup_save = store_params.strategy & SaveStrategy::Backup;
+        m_compression_level = (store_params.strategy & SaveStrategy::FastCompression) ? MZ_BEST_SPEED : MZ_DEFAULT_LEVEL;
 
         m_use_loaded_id = store_params.strategy & SaveStrategy::UseLoadedId;
 
@@ -5738,18 +5823,25 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         return result;
     }
 
+    // Path of the backup mesh of an object inside the backup folder.
+    static std::string backup_object_mesh_filename(ModelObject const & object, int obj_id)
+    {
+        return (boost::format("3D/Objects/%s_%d.model") % object.name % obj_id).str();
+    }
+
     // backup mesh-only
     bool _BBS_3MF_Exporter::save_object_mesh(const std::string& temp_path, ModelObject const & object, int obj_id)
     {
         m_production_ext = true;
         m_from_backup_save = true;
+        m_compression_level = MZ_BEST_SPEED;
         Model const & model = *object.get_model();
 
         mz_zip_archive archive;
         mz_zip_zero_struct(&archive);
 
-        auto filename = boost::format("3D/Objects/%s_%d.model") % object.name % obj_id;
-        std::string filepath = temp_path + "/" + filename.str();
+        std::string filename = backup_object_mesh_filename(object, obj_id);
+        std::string filepath = temp_path + "/" + filename;
         std::string filepath_tmp = filepath + ".tmp";
         boost::system::error_code ec;
         boost::filesystem::remove(filepath_tmp, ec);
@@ -5784,7 +5876,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             volumes_objectID.insert({volume, (++volume_count << 16 | obj_id)});
         }
 
-        _add_model_file_to_archive(filename.str(), archive, model, objects_data);
+        _add_model_file_to_archive(filename, archive, model, objects_data);
 
         mz_zip_writer_finalize_archive(&archive);
         lock.close();
@@ -6296,7 +6388,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, CONTENT_TYPES_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, CONTENT_TYPES_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add content types file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add content types file to archive\n");
             return false;
@@ -6399,7 +6491,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         std::string out = j.dump();
 
         std::string json_file_name = (boost::format(PATTERN_CONFIG_FILE_FORMAT) % (index + 1)).str();
-        if (!mz_zip_writer_add_mem(&archive, json_file_name.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, json_file_name.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add json file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add json file to archive\n");
             return false;
@@ -6472,7 +6564,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, from.empty() ? RELATIONSHIPS_FILE.c_str() : from.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, from.empty() ? RELATIONSHIPS_FILE.c_str() : from.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add relationships file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add relationships file to archive\n");
             return false;
@@ -6521,9 +6613,9 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                 // GH issue #6193.
                 (uint64_t(1) << 32) - 1,
 #if WRITE_ZIP_LANGUAGE_ENCODING
-            nullptr, nullptr, 0, MZ_DEFAULT_LEVEL, nullptr, 0, nullptr, 0)) {
+            nullptr, nullptr, 0, m_compression_level, nullptr, 0, nullptr, 0)) {
 #else
-            nullptr, nullptr, 0, MZ_DEFAULT_COMPRESSION, extra.c_str(), extra.length(), extra.c_str(), extra.length())) {
+            nullptr, nullptr, 0, m_compression_level, extra.c_str(), extra.length(), extra.c_str(), extra.length())) {
 #endif
             add_error("Unable to add model file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add model file to archive\n");
@@ -6776,31 +6868,43 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         _add_relationships_file_to_archive(archive, MODEL_RELS_FILE, object_paths, {"http://schemas.microsoft.com/3dmanufacturing/2013/01/3dmodel"});
 
         if (!m_from_backup_save) {
-            boost::mutex mutex;
-            tbb::parallel_for(tbb::blocked_range<size_t>(0, objects_data.size(), 1), [this, &mutex, &model, objects = model.objects, &objects_data, &object_paths, main = &archive, project](const tbb::blocked_range<size_t>& range) {
+            // Format and deflate the objects in parallel into independent in-memory archives, then copy the already compressed
+            // entries into the main archive in the order of the objects, so that the saved file does not depend on the thread scheduling.
+            std::vector<std::pair<void*, size_t>> object_zips(objects_data.size(), { nullptr, 0 });
+            std::atomic<bool> object_failed { false };
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, objects_data.size(), 1), [this, &model, objects = model.objects, &objects_data, &object_paths, &object_zips, &object_failed, project](const tbb::blocked_range<size_t>& range) {
                 for (size_t i = range.begin(); i < range.end(); ++i) {
                     auto iter = objects_data.find(objects[i]);
                     ObjectToObjectDataMap objects_data2;
                     objects_data2.insert(*iter);
-                    auto & object = *iter->second.object;
                     mz_zip_archive archive;
                     mz_zip_zero_struct(&archive);
                     mz_zip_writer_init_heap(&archive, 0, 1024 * 1024);
                     CNumericLocalesSetter locales_setter;
-                    _add_model_file_to_archive(object_paths[i], archive, model, objects_data2, nullptr, project);
+                    if (!_add_model_file_to_archive(object_paths[i], archive, model, objects_data2, nullptr, project))
+                        object_failed = true;
                     iter->second = objects_data2.begin()->second;
-                    void *ppBuf; size_t pSize;
-                    mz_zip_writer_finalize_heap_archive(&archive, &ppBuf, &pSize);
+                    if (!mz_zip_writer_finalize_heap_archive(&archive, &object_zips[i].first, &object_zips[i].second))
+                        object_failed = true;
                     mz_zip_writer_end(&archive);
-                    mz_zip_zero_struct(&archive);
-                    mz_zip_reader_init_mem(&archive, ppBuf, pSize, 0);
-                    {
-                        boost::unique_lock l(mutex);
-                        mz_zip_writer_add_from_zip_reader(main, &archive, 0);
-                    }
-                    mz_zip_reader_end(&archive);
                 }
             });
+            bool result = !object_failed;
+            for (std::pair<void*, size_t> &object_zip : object_zips) {
+                if (result && object_zip.first != nullptr) {
+                    mz_zip_archive object_archive;
+                    mz_zip_zero_struct(&object_archive);
+                    result = mz_zip_reader_init_mem(&object_archive, object_zip.first, object_zip.second, 0) &&
+                             mz_zip_writer_add_from_zip_reader(&archive, &object_archive, 0);
+                    mz_zip_reader_end(&object_archive);
+                }
+                mz_free(object_zip.first);
+            }
+            if (!result) {
+                add_error("Unable to add object files to archive");
+                BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add object files to archive\n");
+                return false;
+            }
         }
 
         return true;
@@ -7228,7 +7332,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, CUT_INFORMATION_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, CUT_INFORMATION_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add cut information file to archive");
                 return false;
             }
@@ -7262,7 +7366,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, BBS_LAYER_HEIGHTS_PROFILE_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, BBS_LAYER_HEIGHTS_PROFILE_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add layer heights profile file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add layer heights profile file to archive\n");
                 return false;
@@ -7321,7 +7425,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, LAYER_CONFIG_RANGES_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, LAYER_CONFIG_RANGES_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add layer heights profile file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add layer heights profile file to archive\n");
                 return false;
@@ -7357,7 +7461,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             // Adds version header at the beginning:
             out = std::string("brim_points_format_version=") + std::to_string(brim_points_format_version) + std::string("\n") + out;
 
-            if (!mz_zip_writer_add_mem(&archive, BRIM_EAR_POINTS_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, BRIM_EAR_POINTS_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add brim ear points file to archive");
                 return false;
             }
@@ -7393,7 +7497,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             // Adds version header at the beginning:
             //out = std::string("support_points_format_version=") + std::to_string(support_points_format_version) + std::string("\n") + out;
 
-            if (!mz_zip_writer_add_mem(&archive, SLA_SUPPORT_POINTS_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, SLA_SUPPORT_POINTS_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add sla support points file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add sla support points file to archive\n");
                 return false;
@@ -7445,7 +7549,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             // Adds version header at the beginning:
             //out = std::string("drain_holes_format_version=") + std::to_string(drain_holes_format_version) + std::string("\n") + out;
 
-            if (!mz_zip_writer_add_mem(&archive, SLA_DRAIN_HOLES_FILE.c_str(), static_cast<const void*>(out.data()), out.length(), mz_uint(MZ_DEFAULT_COMPRESSION))) {
+            if (!mz_zip_writer_add_mem(&archive, SLA_DRAIN_HOLES_FILE.c_str(), static_cast<const void*>(out.data()), out.length(), m_compression_level)) {
                 add_error("Unable to add sla support points file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add sla support points file to archive\n");
                 return false;
@@ -7466,7 +7570,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                 out += "; " + key + " = " + config.opt_serialize(key) + "\n";
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, BBS_PRINT_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, BBS_PRINT_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add print config file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add print config file to archive\n");
                 return false;
@@ -7837,7 +7941,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         stream << "</" << CONFIG_TAG << ">\n";
 
         std::string out = stream.str();
-        if (!mz_zip_writer_add_mem(&archive, BBS_MODEL_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, BBS_MODEL_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add model config file to archive\n");
             add_error("Unable to add model config file to archive");
             return false;
@@ -7948,7 +8052,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, SLICE_INFO_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, SLICE_INFO_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add model config file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", store  slice-info to 3mf,  length %1%, failed\n") % out.length();
             return false;
@@ -7976,9 +8080,12 @@ bool _BBS_3MF_Exporter::_add_gcode_file_to_archive(mz_zip_archive& archive, cons
         }
     }
 
-    boost::mutex mutex;
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, plate_data_list2.size(), 1), [this, &plate_data_list2, &root_archive = archive, &mutex, &result](const tbb::blocked_range<size_t>& range) {
-        for (int i = range.begin(); i < range.end(); ++i) {
+    // Deflate the G-code of the plates in parallel into independent in-memory archives, then copy the entries into the main archive
+    // in the order of the plates.
+    std::vector<std::pair<void*, size_t>> gcode_zips(plate_data_list2.size(), { nullptr, 0 });
+    std::atomic<bool> gcode_failed { false };
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, plate_data_list2.size(), 1), [this, &plate_data_list2, &gcode_zips, &gcode_failed](const tbb::blocked_range<size_t>& range) {
+        for (size_t i = range.begin(); i < range.end(); ++i) {
             PlateData* plate_data = plate_data_list2[i];
             auto src_gcode_file = plate_data->gcode_file;
             std::string gcode_in_3mf = (boost::format(GCODE_FILE_FORMAT) % (plate_data->plate_index + 1)).str();
@@ -7987,37 +8094,50 @@ bool _BBS_3MF_Exporter::_add_gcode_file_to_archive(mz_zip_archive& archive, cons
             mz_zip_archive archive;
             mz_zip_writer_staged_context context;
             mz_zip_zero_struct(&archive);
-            mz_zip_writer_init_heap(&archive, 0, 1024 * 1024);
-            {
-                mz_zip_writer_add_staged_open(&archive, &context, gcode_in_3mf.c_str(), m_zip64 ? (uint64_t(1) << 30) * 16 : (uint64_t(1) << 32) - 1, nullptr, nullptr, 0,
-                    MZ_DEFAULT_COMPRESSION, nullptr, 0, nullptr, 0);
-                boost::filesystem::path src_gcode_path(src_gcode_file);
-                if (!boost::filesystem::exists(src_gcode_path)) {
-                    BOOST_LOG_TRIVIAL(error) << "Gcode is missing, filename = " << src_gcode_file;
-                    result = false;
-                }
+            bool written = false;
+            boost::filesystem::path src_gcode_path(src_gcode_file);
+            if (!boost::filesystem::exists(src_gcode_path)) {
+                BOOST_LOG_TRIVIAL(error) << "Gcode is missing, filename = " << src_gcode_file;
+            } else if (mz_zip_writer_init_heap(&archive, 0, 1024 * 1024)) {
+                written = mz_zip_writer_add_staged_open(&archive, &context, gcode_in_3mf.c_str(), m_zip64 ? (uint64_t(1) << 30) * 16 : (uint64_t(1) << 32) - 1, nullptr, nullptr, 0,
+                    m_compression_level, nullptr, 0, nullptr, 0);
                 boost::filesystem::ifstream ifs(src_gcode_file, std::ios::binary);
                 std::string buf(64 * 1024, 0);
-                while (ifs) {
+                while (written && ifs) {
                     ifs.read(buf.data(), buf.size());
-                    mz_zip_writer_add_staged_data(&context, buf.data(), ifs.gcount());
+                    written = mz_zip_writer_add_staged_data(&context, buf.data(), ifs.gcount());
                 }
-                mz_zip_writer_add_staged_finish(&context);
+                // mz_zip_writer_add_staged_finish() must not be called if adding the data failed.
+                written = written && mz_zip_writer_add_staged_finish(&context) && !ifs.bad();
+                written = written && mz_zip_writer_finalize_heap_archive(&archive, &gcode_zips[i].first, &gcode_zips[i].second);
+                mz_zip_writer_end(&archive);
             }
-            void *ppBuf; size_t pSize;
-            mz_zip_writer_finalize_heap_archive(&archive, &ppBuf, &pSize);
-            mz_zip_writer_end(&archive);
-            mz_zip_zero_struct(&archive);
-            mz_zip_reader_init_mem(&archive, ppBuf, pSize, 0);
-            {
-                boost::unique_lock l(mutex);
-                mz_zip_writer_add_from_zip_reader(&root_archive, &archive, 0);
+            if (!written) {
+                BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", failed to store %1% to 3mf %2%\n") % src_gcode_file % gcode_in_3mf;
+                gcode_failed = true;
+                continue;
             }
-            mz_zip_reader_end(&archive);
             BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ":" <<__LINE__ << boost::format(", store  %1% to 3mf %2%\n") % src_gcode_file % gcode_in_3mf;
         }
     });
-    return result;
+    if (gcode_failed)
+        result = false;
+    for (std::pair<void*, size_t> &gcode_zip : gcode_zips) {
+        if (result && gcode_zip.first != nullptr) {
+            mz_zip_archive gcode_archive;
+            mz_zip_zero_struct(&gcode_archive);
+            result = mz_zip_reader_init_mem(&gcode_archive, gcode_zip.first, gcode_zip.second, 0) &&
+                     mz_zip_writer_add_from_zip_reader(&archive, &gcode_archive, 0);
+            mz_zip_reader_end(&gcode_archive);
+        }
+        mz_free(gcode_zip.first);
+    }
+    if (!result) {
+        add_error("Unable to add gcode files to archive");
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add gcode files to archive\n");
+        return false;
+    }
+    return true;
 }
 
 bool _BBS_3MF_Exporter::_add_custom_gcode_per_print_z_file_to_archive(mz_zip_archive& archive, Model& model, const DynamicPrintConfig* config)
@@ -8067,7 +8187,7 @@ bool _BBS_3MF_Exporter::_add_custom_gcode_per_print_z_file_to_archive(mz_zip_arc
     }
 
     if (!out.empty()) {
-        if (!mz_zip_writer_add_mem(&archive, CUSTOM_GCODE_PER_PRINT_Z_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, CUSTOM_GCODE_PER_PRINT_Z_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add custom Gcodes per print_z file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add custom Gcodes per print_z file to archive\n");
             return false;
@@ -8148,6 +8268,47 @@ static void handle_legacy_project_loaded(unsigned int version_project_file, Dyna
     }
 }
 
+// Hash of the content written by _BBS_3MF_Exporter::save_object_mesh(): the meshes, face properties and painting of the volumes.
+// The transformations of the volumes are not written into the backup mesh, they are hashed anyway, so that an edit
+// of a volume never keeps a stale backup mesh.
+uint64_t backup_object_mesh_hash(ModelObject const & object)
+{
+    using namespace ankerl::unordered_dense::detail;
+    uint64_t hash = wyhash::hash(object.name.data(), object.name.size());
+    // Only mix in the output of wyhash::hash(), mixing in a zero (such as the std::hash of an empty vector) would zero the hash.
+    auto add = [&hash](const void *data, size_t size) { hash = wyhash::mix(hash, wyhash::hash(data, size)); };
+    auto add_value = [&add](uint64_t value) { add(&value, sizeof(value)); };
+    auto add_facets = [&add, &add_value](const FacetsAnnotation &facets) {
+        const TriangleSelector::TriangleSplittingData &data = facets.get_data();
+        add_value(data.triangles_to_split.size());
+        for (const TriangleSelector::TriangleBitStreamMapping &mapping : data.triangles_to_split) {
+            add(&mapping.triangle_idx, sizeof(mapping.triangle_idx));
+            add(&mapping.bitstream_start_idx, sizeof(mapping.bitstream_start_idx));
+        }
+        add_value(data.bitstream.size());
+        add_value(std::hash<std::vector<bool>>()(data.bitstream));
+        add_value(data.used_states.size());
+        add_value(std::hash<std::vector<bool>>()(data.used_states));
+    };
+    for (ModelVolume const *volume : object.volumes) {
+        if (volume == nullptr)
+            continue;
+        const indexed_triangle_set &its = volume->mesh().its;
+        add(its.vertices.data(), its.vertices.size() * sizeof(stl_vertex));
+        add(its.indices.data(), its.indices.size() * sizeof(stl_triangle_vertex_indices));
+        for (const FaceProperty &property : its.properties) {
+            add(&property.type, sizeof(property.type));
+            add(&property.area, sizeof(property.area));
+        }
+        add_facets(volume->supported_facets);
+        add_facets(volume->seam_facets);
+        add_facets(volume->mmu_segmentation_facets);
+        add_facets(volume->fuzzy_skin_facets);
+        add(volume->get_matrix().data(), sizeof(double) * 16);
+    }
+    return hash;
+}
+
 // backup backgroud thread to dispatch tasks and coperate with ui thread
 class _BBS_Backup_Manager
 {
@@ -8402,9 +8563,22 @@ private:
                 break;
             case AddObject: {
                 {
+                    // Most of the edits do not touch the meshes or the painting, skip rewriting a backup mesh with the same content.
+                    std::string filepath = t.path + "/" + backup_object_mesh_filename(*t.object, (int) t.id);
+                    uint64_t    hash     = backup_object_mesh_hash(*t.object);
+                    auto        it       = m_object_mesh_hashes.find(filepath);
+                    if (it != m_object_mesh_hashes.end() && it->second == hash && boost::filesystem::exists(filepath)) {
+                        BOOST_LOG_TRIVIAL(info) << "process_task: backup mesh " << filepath << " is not changed, skip writing";
+                        break;
+                    }
                     CNumericLocalesSetter locales_setter;
                     _BBS_3MF_Exporter     e;
-                    e.save_object_mesh(t.path, *t.object, (int) t.id);
+                    if (e.save_object_mesh(t.path, *t.object, (int) t.id)) {
+                        m_object_mesh_hashes[filepath] = hash;
+                        boost::system::error_code ec;
+                        BOOST_LOG_TRIVIAL(info) << "process_task: backup mesh " << filepath << " written, size " << boost::filesystem::file_size(filepath, ec);
+                    } else
+                        m_object_mesh_hashes.erase(filepath);
                     // response to delete cloned object
                 }
                 break;
@@ -8416,6 +8590,7 @@ private:
                 break;
             }
             case RemoveBackup: {
+                m_object_mesh_hashes.clear();
                 try {
                     boost::system::error_code ec;
                     boost::filesystem::remove(t.path + "/.3mf", ec);
@@ -8505,6 +8680,7 @@ private:
     bool m_other_changes = false; // visit only in main thread
     bool m_other_changes_backup = false; // visit only in main thread
     std::vector<std::pair<ModelObject*, size_t>> m_gaurd_objects;
+    std::map<std::string, uint64_t> m_object_mesh_hashes; // content hashes of the written backup meshes, visit only in backup thread
     boost::thread m_thread;
 };
 
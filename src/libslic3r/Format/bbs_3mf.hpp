@@ -123,10 +123,11 @@ enum class SaveStrategy
     SkipAuxiliary       = 1 << 9,
     UseLoadedId         = 1 << 10,
     ShareMesh           = 1 << 11,
+    FastCompression     = 1 << 13,  // deflate with the fastest level, trading the file size for the save time
 
     SplitModel = 0x1000 | ProductionExt,
     Encrypted  = SecureContentExt | SplitModel,
-    Backup = 0x10000 | WithGcode | Silence | SkipStatic | SplitModel,
+    Backup = 0x10000 | WithGcode | Silence | SkipStatic | SplitModel | FastCompression,
 };
 
 inline SaveStrategy operator | (SaveStrategy lhs, SaveStrategy rhs)
@@ -273,6 +274,9 @@ extern void save_object_mesh(ModelObject& object);
 
 extern void delete_object_mesh(ModelObject& object);
 
+// Hash of the backup mesh of an object, the backup mesh is only written again if the hash changed.
+extern uint64_t backup_object_mesh_hash(ModelObject const & object);
+
 extern void backup_soon();
 
 extern void remove_backup(Model& model, bool removeAll);
@@ -23,6 +23,7 @@
 #include "LocalesUtils.hpp"
 #include "libslic3r/format.hpp"
 #include "Time.hpp"
+#include "Timer.hpp"
 #include "GCode/ExtrusionProcessor.hpp"
 #include <algorithm>
 #include <cmath>
@@ -41,6 +42,7 @@
 #include <boost/algorithm/string/find.hpp>
 #include <boost/foreach.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/beast/core/detail/base64.hpp>
 
@@ -1609,6 +1611,31 @@ std::vector<std::pair<coordf_t, std::vector<GCode::LayerToPrint>>> GCode::collec
     return layers_to_print;
 }
 
+// Total G-code of the layers recorded by all the Prints for replaying by their next export.
+static constexpr size_t GCODE_LAYER_CACHE_MAX_MEMORY = size_t(256) * 1024 * 1024;
+static std::atomic<size_t> g_gcode_layer_cache_memory { 0 };
+
+GCodeLayerResultCache::~GCodeLayerResultCache()
+{
+    g_gcode_layer_cache_memory -= this->layers_size;
+}
+
+bool GCodeLayerResultCache::reserve(size_t size)
+{
+    size_t memory = g_gcode_layer_cache_memory.load();
+    do {
+        if (memory + size > GCODE_LAYER_CACHE_MAX_MEMORY)
+            return false;
+    } while (! g_gcode_layer_cache_memory.compare_exchange_weak(memory, memory + size));
+    this->layers_size += size;
+    return true;
+}
+
+size_t GCodeLayerResultCache::total_memory()
+{
+    return g_gcode_layer_cache_memory.load();
+}
+
 // free functions called by GCode::do_export()
 namespace DoExport {
 //    static void update_print_estimated_times_stats(const GCodeProcessor& processor, PrintStatistics& print_statistics)
@@ -1737,6 +1764,92 @@ static std::vector<std::pair<std::string, std::string>> validate_custom_gcode(co
 
     return ret;
 }
+
+// Replaying the layers requires the G-code generator to run the same way as when the layers were recorded.
+// Sequential printing generates the layers object by object and the adaptive pressure advance
+// and the calibrations feed the post-processing stages from the generator.
+static bool gcode_layer_cache_enabled(const Print& print)
+{
+    // Nothing to replay for, if the Print is exported just once.
+    if (! print.keep_reslice_caches())
+        return false;
+    if (print.config().print_sequence == PrintSequence::ByObject || print.calib_mode() != CalibMode::Calib_None)
+        return false;
+    const PrintConfig& config = print.config();
+    for (size_t i = 0; i < config.adaptive_pressure_advance.values.size(); ++i)
+        if (config.adaptive_pressure_advance.get_at(i) && config.enable_pressure_advance.get_at(i))
+            return false;
+    return true;
+}
+
+// Key of the G-code generated for the layers: the timestamps of the steps producing the extrusions, the placement of the objects
+// and the configuration of the G-code generator, that is all the options but those only consumed by the cooling buffer and the fan mover.
+static size_t gcode_layer_cache_key(const Print& print)
+{
+    static const std::vector<std::string> post_processing_options = {
+        "additional_cooling_fan_speed", "dont_slow_down_outer_wall", "fan_cooling_layer_time", "fan_max_speed", "fan_min_speed",
+        "full_fan_speed_layer", "internal_bridge_fan_speed", "overhang_fan_speed", "reduce_fan_stop_start_freq",
+        "slow_down_for_layer_cooling", "slow_down_layer_time", "slow_down_min_speed", "fan_speedup_time", "fan_speedup_overhangs",
+        "fan_kickstart"
+    };
+    // Set by PlaceholderParser::update_timestamp() and refreshed by each export.
+    static const std::vector<std::string> time_variables = { "timestamp", "year", "month", "day", "hour", "minute", "second" };
+
+    const DynamicPrintConfig&   config         = print.full_print_config();
+    const CustomGCode::Info     custom_gcodes  = print.model().get_curr_plate_custom_gcodes();
+    std::vector<std::string>    templates;
+    for (const std::string& opt_key : config.keys()) {
+        const ConfigOption* opt = config.option(opt_key);
+        if (opt->type() == coString)
+            templates.emplace_back(static_cast<const ConfigOptionString*>(opt)->value);
+        else if (opt->type() == coStrings)
+            append(templates, static_cast<const ConfigOptionStrings*>(opt)->values);
+    }
+    for (const CustomGCode::Item& item : custom_gcodes.gcodes)
+        templates.emplace_back(item.extra);
+    // A post-processing option referenced by a custom G-code template influences the generated layers.
+    auto is_post_processing_option = [&templates](const std::string& opt_key) {
+        return std::find(post_processing_options.begin(), post_processing_options.end(), opt_key) != post_processing_options.end() &&
+               std::none_of(templates.begin(), templates.end(),
+                            [&opt_key](const std::string& tmpl) { return tmpl.find(opt_key) != std::string::npos; });
+    };
+
+    size_t seed = 0;
+    boost::hash_combine(seed, print.step_state_with_timestamp(psWipeTower).timestamp);
+    boost::hash_combine(seed, print.step_state_with_timestamp(psSkirtBrim).timestamp);
+    for (const PrintObject* object : print.objects()) {
+        for (int step = 0; step < int(posCount); ++step)
+            boost::hash_combine(seed, object->step_state_with_timestamp(PrintObjectStep(step)).timestamp);
+        boost::hash_combine(seed, object->model_object()->name);
+        for (const PrintInstance& instance : object->instances()) {
+            boost::hash_combine(seed, instance.shift.x());
+            boost::hash_combine(seed, instance.shift.y());
+        }
+    }
+    const Vec3d origin = print.get_plate_origin();
+    boost::hash_combine(seed, origin.x());
+    boost::hash_combine(seed, origin.y());
+    boost::hash_combine(seed, int(custom_gcodes.mode));
+    for (const CustomGCode::Item& item : custom_gcodes.gcodes) {
+        boost::hash_combine(seed, item.print_z);
+        boost::hash_combine(seed, int(item.type));
+        boost::hash_combine(seed, item.extruder);
+        boost::hash_combine(seed, item.color);
+        boost::hash_combine(seed, item.extra);
+    }
+    for (const std::string& opt_key : config.keys())
+        if (!is_post_processing_option(opt_key)) {
+            boost::hash_combine(seed, opt_key);
+            boost::hash_combine(seed, config.opt_serialize(opt_key));
+        }
+    const DynamicConfig& variables = print.placeholder_parser().config();
+    for (const std::string& opt_key : variables.keys())
+        if (std::find(time_variables.begin(), time_variables.end(), opt_key) == time_variables.end()) {
+            boost::hash_combine(seed, opt_key);
+            boost::hash_combine(seed, variables.opt_serialize(opt_key));
+        }
+    return seed;
+}
 } // namespace DoExport
 
 bool GCode::is_BBL_Printer()
@@ -1808,6 +1921,26 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
         throw Slic3r::RuntimeError(std::string("G-code export to ") + path + " failed.\nCannot open the file for writing.\n");
     }
 
+    // Replay the layers generated by the previous export if only the post-processing options changed, record them otherwise.
+    m_layer_cache_replay.reset();
+    m_layer_cache_record.reset();
+    print->m_slice_cache_statistics.gcode_layers_replayed = 0;
+    print->m_slice_cache_statistics.gcode_layers_recorded = 0;
+    if (DoExport::gcode_layer_cache_enabled(*print)) {
+        const size_t key = DoExport::gcode_layer_cache_key(*print);
+        if (print->m_gcode_layer_cache && print->m_gcode_layer_cache->key == key) {
+            m_layer_cache_replay = print->m_gcode_layer_cache;
+            print->m_slice_cache_statistics.gcode_layers_replayed = m_layer_cache_replay->layers.size();
+            BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": replaying %1% cached layers") % m_layer_cache_replay->layers.size();
+        } else {
+            m_layer_cache_record      = std::make_shared<GCodeLayerResultCache>();
+            m_layer_cache_record->key = key;
+        }
+    }
+    if (!m_layer_cache_replay)
+        // Outdated, release the memory before recording.
+        print->m_gcode_layer_cache.reset();
+
     try {
         this->_do_export(*print, file, thumbnail_cb);
         file.flush();
@@ -1903,6 +2036,10 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
     }
 
     BOOST_LOG_TRIVIAL(info) << "Exporting G-code finished" << log_memory_info();
+    if (m_layer_cache_record) {
+        print->m_slice_cache_statistics.gcode_layers_recorded = m_layer_cache_record->layers.size();
+        print->m_gcode_layer_cache = std::move(m_layer_cache_record);
+    }
     print->set_done(psGCodeExport);
 
     if (is_BBL_Printer())
@@ -2984,94 +3121,112 @@ void GCode::_do_export(Print& print, GCodeOutputStream& file, ThumbnailsGenerato
             // Generate G-code, run the filters (vase mode, cooling buffer), run the G-code analyser
             // and export G-code into file.
             this->process_layers(print, tool_ordering, print_object_instances_ordering, layers_to_print, file);
-            // BBS: close powerlost recovery
-            {
-                if (is_bbl_printers && m_second_layer_things_done) {
-                    file.write("; close powerlost recovery\n");
-                    file.write("M1003 S0\n");
+            if (m_layer_cache_record)
+                file.set_recording(&m_layer_cache_record->tail);
+            if (!m_layer_cache_replay) {
+                // BBS: close powerlost recovery
+                {
+                    if (is_bbl_printers && m_second_layer_things_done) {
+                        file.write("; close powerlost recovery\n");
+                        file.write("M1003 S0\n");
+                    }
                 }
+                if (m_wipe_tower)
+                    // Purge the extruder, pull out the active filament.
+                    file.write(m_wipe_tower->finalize(*this));
             }
-            if (m_wipe_tower)
-                // Purge the extruder, pull out the active filament.
-                file.write(m_wipe_tower->finalize(*this));
         }
     }
-    // BBS: the last retraction
-    //  Write end commands to file.
-    file.write(this->retract(false, true));
+    if (m_layer_cache_replay) {
+        // The end of the G-code depends on the state of the generator after the last layer, which was not generated.
+        file.write(m_layer_cache_replay->tail);
+        print.m_print_statistics         = m_layer_cache_replay->print_statistics;
+        m_initial_layer_extruders        = m_layer_cache_replay->initial_layer_extruders;
+        m_support_traditional_timelapse  = m_layer_cache_replay->support_traditional_timelapse;
+    } else {
+        // BBS: the last retraction
+        //  Write end commands to file.
+        file.write(this->retract(false, true));
 
-    // if needed, write the gcode_label_objects_end
-    {
-        std::string gcode;
-        m_writer.add_object_change_labels(gcode);
-        file.write(gcode);
-    }
+        // if needed, write the gcode_label_objects_end
+        {
+            std::string gcode;
+            m_writer.add_object_change_labels(gcode);
+            file.write(gcode);
+        }
 
-    file.write(m_writer.set_fan(0));
-    // BBS: make sure the additional fan is closed when end
-    if (m_config.auxiliary_fan.value)
-        file.write(m_writer.set_additional_fan(0));
-    if (is_bbl_printers) {
-        // BBS: close spaghetti detector
-        // Note: M981 is also used to tell xcam the last layer is finished, so we need always send it even if spaghetti option is disabled.
-        // if (print.config().spaghetti_detector.value)
-        file.write("M981 S0 P20000 ; close spaghetti detector\n");
-    }
+        file.write(m_writer.set_fan(0));
+        // BBS: make sure the additional fan is closed when end
+        if (m_config.auxiliary_fan.value)
+            file.write(m_writer.set_additional_fan(0));
+        if (is_bbl_printers) {
+            // BBS: close spaghetti detector
+            // Note: M981 is also used to tell xcam the last layer is finished, so we need always send it even if spaghetti option is disabled.
+            // if (print.config().spaghetti_detector.value)
+            file.write("M981 S0 P20000 ; close spaghetti detector\n");
+        }
 
-    // adds tag for processor
-    file.write_format(";%s%s\n", GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Role).c_str(),
-                      ExtrusionEntity::role_to_string(erCustom).c_str());
+        // adds tag for processor
+        file.write_format(";%s%s\n", GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Role).c_str(),
+                          ExtrusionEntity::role_to_string(erCustom).c_str());
 
-    // Process filament-specific gcode in extruder order.
-    {
-        DynamicConfig config;
-        config.set_key_value("layer_num", new ConfigOptionInt(m_layer_index));
-        // BBS
-        config.set_key_value("layer_z", new ConfigOptionFloat(m_writer.get_position()(2) - m_config.z_offset.value));
-        config.set_key_value("max_layer_z", new ConfigOptionFloat(m_max_layer_z));
-        if (print.config().single_extruder_multi_material) {
-            // Process the filament_end_gcode for the active filament only.
-            int extruder_id = m_writer.extruder()->id();
-            config.set_key_value("filament_extruder_id", new ConfigOptionInt(extruder_id));
-            file.writeln(this->placeholder_parser_process("filament_end_gcode", print.config().filament_end_gcode.get_at(extruder_id),
-                                                          extruder_id, &config));
-        } else {
-            for (const std::string& end_gcode : print.config().filament_end_gcode.values) {
-                int extruder_id = (unsigned int) (&end_gcode - &print.config().filament_end_gcode.values.front());
+        // Process filament-specific gcode in extruder order.
+        {
+            DynamicConfig config;
+            config.set_key_value("layer_num", new ConfigOptionInt(m_layer_index));
+            // BBS
+            config.set_key_value("layer_z", new ConfigOptionFloat(m_writer.get_position()(2) - m_config.z_offset.value));
+            config.set_key_value("max_layer_z", new ConfigOptionFloat(m_max_layer_z));
+            if (print.config().single_extruder_multi_material) {
+                // Process the filament_end_gcode for the active filament only.
+                int extruder_id = m_writer.extruder()->id();
                 config.set_key_value("filament_extruder_id", new ConfigOptionInt(extruder_id));
-                file.writeln(this->placeholder_parser_process("filament_end_gcode", end_gcode, extruder_id, &config));
+                file.writeln(this->placeholder_parser_process("filament_end_gcode", print.config().filament_end_gcode.get_at(extruder_id),
+                                                              extruder_id, &config));
+            } else {
+                for (const std::string& end_gcode : print.config().filament_end_gcode.values) {
+                    int extruder_id = (unsigned int) (&end_gcode - &print.config().filament_end_gcode.values.front());
+                    config.set_key_value("filament_extruder_id", new ConfigOptionInt(extruder_id));
+                    file.writeln(this->placeholder_parser_process("filament_end_gcode", end_gcode, extruder_id, &config));
+                }
             }
-        }
-        file.writeln(
-            this->placeholder_parser_process("machine_end_gcode", print.config().machine_end_gcode, m_writer.extruder()->id(), &config));
-    }
-    file.write(m_writer.update_progress(m_layer_count, m_layer_count, true)); // 100%
-    file.write(m_writer.postamble());
-
-    if (activate_chamber_temp_control && max_chamber_temp > 0)
-        file.write(m_writer.set_chamber_temperature(0, false)); // close chamber_temperature
-
-    if (activate_air_filtration) {
-        int complete_print_exhaust_fan_speed = 0;
-        for (const auto& extruder : m_writer.extruders())
-            if (m_config.activate_air_filtration.get_at(extruder.id()))
-                complete_print_exhaust_fan_speed = std::max(complete_print_exhaust_fan_speed,
-                                                            m_config.complete_print_exhaust_fan_speed.get_at(extruder.id()));
-        file.write(m_writer.set_exhaust_fan(complete_print_exhaust_fan_speed, true));
+            file.writeln(
+                this->placeholder_parser_process("machine_end_gcode", print.config().machine_end_gcode, m_writer.extruder()->id(), &config));
+        }
+        file.write(m_writer.update_progress(m_layer_count, m_layer_count, true)); // 100%
+        file.write(m_writer.postamble());
+
+        if (activate_chamber_temp_control && max_chamber_temp > 0)
+            file.write(m_writer.set_chamber_temperature(0, false)); // close chamber_temperature
+
+        if (activate_air_filtration) {
+            int complete_print_exhaust_fan_speed = 0;
+            for (const auto& extruder : m_writer.extruders())
+                if (m_config.activate_air_filtration.get_at(extruder.id()))
+                    complete_print_exhaust_fan_speed = std::max(complete_print_exhaust_fan_speed,
+                                                                m_config.complete_print_exhaust_fan_speed.get_at(extruder.id()));
+            file.write(m_writer.set_exhaust_fan(complete_print_exhaust_fan_speed, true));
+        }
+        // adds tags for time estimators
+        file.write_format(";%s\n", GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Last_Line_M73_Placeholder).c_str());
+        file.write_format("; EXECUTABLE_BLOCK_END\n\n");
+
+        print.throw_if_canceled();
+
+        // Get filament stats.
+        file.write(DoExport::update_print_stats_and_format_filament_stats(
+            // Const inputs
+            has_wipe_tower, print.wipe_tower_data(), m_writer.extruders(),
+            // Modifies
+            print.m_print_statistics));
+        print.m_print_statistics.initial_tool = initial_extruder_id;
+    }
+    if (m_layer_cache_record) {
+        file.set_recording(nullptr);
+        m_layer_cache_record->print_statistics              = print.m_print_statistics;
+        m_layer_cache_record->initial_layer_extruders       = m_initial_layer_extruders;
+        m_layer_cache_record->support_traditional_timelapse = m_support_traditional_timelapse;
     }
-    // adds tags for time estimators
-    file.write_format(";%s\n", GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Last_Line_M73_Placeholder).c_str());
-    file.write_format("; EXECUTABLE_BLOCK_END\n\n");
-
-    print.throw_if_canceled();
-
-    // Get filament stats.
-    file.write(DoExport::update_print_stats_and_format_filament_stats(
-        // Const inputs
-        has_wipe_tower, print.wipe_tower_data(), m_writer.extruders(),
-        // Modifies
-        print.m_print_statistics));
-    print.m_print_statistics.initial_tool = initial_extruder_id;
     if (!is_bbl_printers) {
         file.write_format("; total filament used [g] = %.2lf\n", print.m_print_statistics.total_weight);
         file.write_format("; total filament cost = %.2lf\n", print.m_print_statistics.total_cost);
@@ -3131,6 +3286,19 @@ void GCode::process_layers(const Print&
         slic3r_tbb_filtermode::serial_in_order,
         [this, &print, &tool_ordering, &print_object_instances_ordering, &layers_to_print,
          &layer_to_print_idx](tbb::flow_control& fc) -> LayerResult {
+            TASK_TRACE_SCOPE("GCode::process_layers generator");
+            if (m_layer_cache_replay) {
+                // Only the post-processing options changed since the layers were recorded, feed the recorded layers to the filters.
+                if (layer_to_print_idx == m_layer_cache_replay->layers.size()) {
+                    fc.stop();
+                    return {};
+                }
+                const size_t layer_id = std::min(layer_to_print_idx + 1, layers_to_print.size());
+                print.set_status(80, Slic3r::format(_(L("Generating G-code: layer %1%")), std::to_string(layer_id)));
+                print.throw_if_canceled();
+                return m_layer_cache_replay->layers[layer_to_print_idx++];
+            }
+            LayerResult result;
             if (layer_to_print_idx >= layers_to_print.size()) {
                 if (layer_to_print_idx == layers_to_print.size() + (m_pressure_equalizer ? 1 : 0)) {
                     fc.stop();
@@ -3139,7 +3307,7 @@ void GCode::process_layers(const Print&
                     // Pressure equalizer need insert empty input. Because it returns one layer back.
                     // Insert NOP (no operation) layer;
                     ++layer_to_print_idx;
-                    return LayerResult::make_nop_layer_result();
+                    result = LayerResult::make_nop_layer_result();
                 }
             } else {
                 const std::pair<coordf_t, std::vector<LayerToPrint>>& layer       = layers_to_print[layer_to_print_idx++];
@@ -3150,9 +3318,17 @@ void GCode::process_layers(const Print&
                 // BBS
                 check_placeholder_parser_failed();
                 print.throw_if_canceled();
-                return this->process_layer(print, layer.second, layer_tools, &layer == &layers_to_print.back(),
-                                                    &print_object_instances_ordering, size_t(-1));
+                result = this->process_layer(print, layer.second, layer_tools, &layer == &layers_to_print.back(),
+                                             &print_object_instances_ordering, size_t(-1));
             }
+            if (m_layer_cache_record) {
+                if (! m_layer_cache_record->reserve(result.gcode.size())) {
+                    BOOST_LOG_TRIVIAL(info) << "GCode::process_layers: G-code of the layers too large to be cached";
+                    m_layer_cache_record.reset();
+                } else
+                    m_layer_cache_record->layers.emplace_back(result);
+            }
+            return result;
         });
     if (m_spiral_vase) {
         float nozzle_diameter  = EXTRUDER_CONFIG(nozzle_diameter);
@@ -3162,6 +3338,7 @@ void GCode::process_layers(const Print&
     const auto spiral_mode = tbb::make_filter<
         LayerResult,
         LayerResult>(slic3r_tbb_filtermode::serial_in_order, [&spiral_mode = *this->m_spiral_vase.get(), &layers_to_print](LayerResult in) -> LayerResult {
+        TASK_TRACE_SCOPE("GCode::process_layers spiral vase");
         if (in.nop_layer_result)
             return in;
 
@@ -3172,29 +3349,69 @@ void GCode::process_layers(const Print&
     const auto pressure_equalizer  = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
                                                                                [pressure_equalizer = this->m_pressure_equalizer.get()](
                                                                                    LayerResult in) -> LayerResult {
+                                                                                   TASK_TRACE_SCOPE("GCode::process_layers pressure equalizer");
                                                                                    return pressure_equalizer->process_layer(std::move(in));
                                                                                });
-    const auto cooling             = tbb::make_filter<LayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
+    // Split the G-code into lines and decode them in parallel for multiple layers, so that the serial stages don't parse the text.
+    const auto decode              = tbb::make_filter<LayerResult, DecodedLayerResult>(slic3r_tbb_filtermode::parallel,
+                                                                    [&cooling_buffer = *this->m_cooling_buffer.get()](
+                                                                        LayerResult in) -> DecodedLayerResult {
+                                                                        TASK_TRACE_SCOPE("GCode::process_layers decode");
+                                                                        DecodedLayerResult out{LayerGCode(std::move(in.gcode)), in.layer_id,
+                                                                                               in.cooling_buffer_flush, in.nop_layer_result};
+                                                                        if (!out.nop_layer_result)
+                                                                            out.cooling_state_update = cooling_buffer.layer_state_update(out.gcode);
+                                                                        return out;
+                                                                    });
+    // The cooling buffer only carries the position, the extruder and the fan speeds from layer to layer serially,
+    // the G-code is parsed and the slow down is calculated in parallel for multiple layers.
+    const auto cooling_collect     = tbb::make_filter<DecodedLayerResult, CoolingLayerResult>(slic3r_tbb_filtermode::serial_in_order,
                                                                     [&cooling_buffer = *this->m_cooling_buffer.get()](
-                                                                        LayerResult in) -> std::string {
+                                                                        DecodedLayerResult in) -> CoolingLayerResult {
+                                                                        TASK_TRACE_SCOPE("GCode::process_layers cooling collect");
+                                                                        CoolingLayerResult out;
+                                                                        out.nop_layer_result = in.nop_layer_result;
                                                                         if (in.nop_layer_result)
-                                                                            return in.gcode;
-                                                                        return cooling_buffer.process_layer(std::move(in.gcode),
-                                                                                                                        in.layer_id,
-                                                                                                                        in.cooling_buffer_flush);
+                                                                            out.layer.gcode = std::move(in.gcode);
+                                                                        else
+                                                                            out.layer = cooling_buffer.collect_layer(std::move(in.gcode), in.cooling_state_update,
+                                                                                                                     in.layer_id, in.cooling_buffer_flush);
+                                                                        return out;
                                                                     });
+    const auto cooling_prepare     = tbb::make_filter<CoolingLayerResult, CoolingLayerResult>(slic3r_tbb_filtermode::parallel,
+                                                                    [&cooling_buffer = *this->m_cooling_buffer.get()](
+                                                                        CoolingLayerResult in) -> CoolingLayerResult {
+                                                                        TASK_TRACE_SCOPE("GCode::process_layers cooling prepare");
+                                                                        if (!in.nop_layer_result)
+                                                                            cooling_buffer.prepare_layer(in.layer);
+                                                                        return in;
+                                                                    });
+    const auto cooling_apply       = tbb::make_filter<CoolingLayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
+                                                                    [&cooling_buffer = *this->m_cooling_buffer.get()](
+                                                                        CoolingLayerResult in) -> std::string {
+                                                                        TASK_TRACE_SCOPE("GCode::process_layers cooling apply");
+                                                                        if (in.nop_layer_result)
+                                                                            return in.layer.gcode.release();
+                                                                        return cooling_buffer.apply_layer(std::move(in.layer));
+                                                                    });
+    const auto cooling             = cooling_collect & cooling_prepare & cooling_apply;
     const auto pa_processor_filter = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
                                                                                 [&pa_processor = *this->m_pa_processor](
                                                                                     std::string in) -> std::string {
+                                                                                    TASK_TRACE_SCOPE("GCode::process_layers pressure advance");
                                                                                     return pa_processor.process_layer(std::move(in));
                                                                                 });
 
     const auto output = tbb::make_filter<std::string, void>(slic3r_tbb_filtermode::serial_in_order,
-                                                            [&output_stream](std::string s) { output_stream.write(s); });
+                                                            [&output_stream](std::string s) {
+                                                                TASK_TRACE_SCOPE("GCode::process_layers output");
+                                                                output_stream.write(s);
+                                                            });
 
     const auto fan_mover = tbb::make_filter<std::string, std::string>(
         slic3r_tbb_filtermode::serial_in_order,
         [&fan_mover = this->m_fan_mover, &config = this->config(), &writer = this->m_writer](std::string in) -> std::string {
+            TASK_TRACE_SCOPE("GCode::process_layers fan mover");
             CNumericLocalesSetter locales_setter;
 
             if (config.fan_speedup_time.value != 0 || config.fan_kickstart.value > 0) {
@@ -3210,13 +3427,13 @@ void GCode::process_layers(const Print&
 
     // The pipeline elements are joined using const references, thus no copying is performed.
     if (m_spiral_vase && m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & spiral_mode & pressure_equalizer & cooling & fan_mover & output);
+        tbb::parallel_pipeline(12, generator & spiral_mode & pressure_equalizer & decode & cooling & fan_mover & output);
     else if (m_spiral_vase)
-        tbb::parallel_pipeline(12, generator & spiral_mode & cooling & fan_mover & output);
+        tbb::parallel_pipeline(12, generator & spiral_mode & decode & cooling & fan_mover & output);
     else if (m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & pressure_equalizer & cooling & fan_mover & pa_processor_filter & output);
+        tbb::parallel_pipeline(12, generator & pressure_equalizer & decode & cooling & fan_mover & pa_processor_filter & output);
     else
-        tbb::parallel_pipeline(12, generator & cooling & fan_mover & pa_processor_filter & output);
+        tbb::parallel_pipeline(12, generator & decode & cooling & fan_mover & pa_processor_filter & output);
 }
 
 // Process all layers of a single object instance (sequential mode) with a parallel pipeline:
@@ -3236,6 +3453,7 @@ void GCode::process_layers(const Print&              print,
         tbb::make_filter<void, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
                                             [this, &print, &tool_ordering, &layers_to_print, &layer_to_print_idx, single_object_idx,
                                              prime_extruder](tbb::flow_control& fc) -> LayerResult {
+                                                TASK_TRACE_SCOPE("GCode::process_layers generator");
                                                 if (layer_to_print_idx >= layers_to_print.size()) {
                                                     if (layer_to_print_idx == layers_to_print.size() + (m_pressure_equalizer ? 1 : 0)) {
                                                         fc.stop();
@@ -3267,6 +3485,7 @@ void GCode::process_layers(const Print&              print,
     const auto spiral_mode = tbb::make_filter<
         LayerResult,
         LayerResult>(slic3r_tbb_filtermode::serial_in_order, [&spiral_mode = *this->m_spiral_vase.get(), &layers_to_print](LayerResult in) -> LayerResult {
+        TASK_TRACE_SCOPE("GCode::process_layers spiral vase");
         if (in.nop_layer_result)
             return in;
         spiral_mode.enable(in.spiral_vase_enable);
@@ -3276,29 +3495,69 @@ void GCode::process_layers(const Print&              print,
     const auto pressure_equalizer  = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
                                                                                [pressure_equalizer = this->m_pressure_equalizer.get()](
                                                                                    LayerResult in) -> LayerResult {
+                                                                                   TASK_TRACE_SCOPE("GCode::process_layers pressure equalizer");
                                                                                    return pressure_equalizer->process_layer(std::move(in));
                                                                                });
-    const auto cooling             = tbb::make_filter<LayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
+    // Split the G-code into lines and decode them in parallel for multiple layers, so that the serial stages don't parse the text.
+    const auto decode              = tbb::make_filter<LayerResult, DecodedLayerResult>(slic3r_tbb_filtermode::parallel,
+                                                                    [&cooling_buffer = *this->m_cooling_buffer.get()](
+                                                                        LayerResult in) -> DecodedLayerResult {
+                                                                        TASK_TRACE_SCOPE("GCode::process_layers decode");
+                                                                        DecodedLayerResult out{LayerGCode(std::move(in.gcode)), in.layer_id,
+                                                                                               in.cooling_buffer_flush, in.nop_layer_result};
+                                                                        if (!out.nop_layer_result)
+                                                                            out.cooling_state_update = cooling_buffer.layer_state_update(out.gcode);
+                                                                        return out;
+                                                                    });
+    // The cooling buffer only carries the position, the extruder and the fan speeds from layer to layer serially,
+    // the G-code is parsed and the slow down is calculated in parallel for multiple layers.
+    const auto cooling_collect     = tbb::make_filter<DecodedLayerResult, CoolingLayerResult>(slic3r_tbb_filtermode::serial_in_order,
+                                                                    [&cooling_buffer = *this->m_cooling_buffer.get()](
+                                                                        DecodedLayerResult in) -> CoolingLayerResult {
+                                                                        TASK_TRACE_SCOPE("GCode::process_layers cooling collect");
+                                                                        CoolingLayerResult out;
+                                                                        out.nop_layer_result = in.nop_layer_result;
+                                                                        if (in.nop_layer_result)
+                                                                            out.layer.gcode = std::move(in.gcode);
+                                                                        else
+                                                                            out.layer = cooling_buffer.collect_layer(std::move(in.gcode), in.cooling_state_update,
+                                                                                                                     in.layer_id, in.cooling_buffer_flush);
+                                                                        return out;
+                                                                    });
+    const auto cooling_prepare     = tbb::make_filter<CoolingLayerResult, CoolingLayerResult>(slic3r_tbb_filtermode::parallel,
+                                                                    [&cooling_buffer = *this->m_cooling_buffer.get()](
+                                                                        CoolingLayerResult in) -> CoolingLayerResult {
+                                                                        TASK_TRACE_SCOPE("GCode::process_layers cooling prepare");
+                                                                        if (!in.nop_layer_result)
+                                                                            cooling_buffer.prepare_layer(in.layer);
+                                                                        return in;
+                                                                    });
+    const auto cooling_apply       = tbb::make_filter<CoolingLayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
                                                                     [&cooling_buffer = *this->m_cooling_buffer.get()](
-                                                                        LayerResult in) -> std::string {
+                                                                        CoolingLayerResult in) -> std::string {
+                                                                        TASK_TRACE_SCOPE("GCode::process_layers cooling apply");
                                                                         if (in.nop_layer_result)
-                                                                            return in.gcode;
-                                                                        return cooling_buffer.process_layer(std::move(in.gcode),
-                                                                                                                        in.layer_id,
-                                                                                                                        in.cooling_buffer_flush);
+                                                                            return in.layer.gcode.release();
+                                                                        return cooling_buffer.apply_layer(std::move(in.layer));
                                                                     });
+    const auto cooling             = cooling_collect & cooling_prepare & cooling_apply;
     const auto pa_processor_filter = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
                                                                                 [&pa_processor = *this->m_pa_processor](
                                                                                     std::string in) -> std::string {
+                                                                                    TASK_TRACE_SCOPE("GCode::process_layers pressure advance");
                                                                                     return pa_processor.process_layer(std::move(in));
                                                                                 });
 
     const auto output = tbb::make_filter<std::string, void>(slic3r_tbb_filtermode::serial_in_order,
-                                                            [&output_stream](std::string s) { output_stream.write(s); });
+                                                            [&output_stream](std::string s) {
+                                                                TASK_TRACE_SCOPE("GCode::process_layers output");
+                                                                output_stream.write(s);
+                                                            });
 
     const auto fan_mover = tbb::make_filter<std::string, std::string>(
         slic3r_tbb_filtermode::serial_in_order,
         [&fan_mover = this->m_fan_mover, &config = this->config(), &writer = this->m_writer](std::string in) -> std::string {
+            TASK_TRACE_SCOPE("GCode::process_layers fan mover");
             if (config.fan_speedup_time.value != 0 || config.fan_kickstart.value > 0) {
                 if (fan_mover.get() == nullptr)
                     fan_mover.reset(new Slic3r::FanMover(writer, std::abs((float) config.fan_speedup_time.value),
@@ -3312,13 +3571,13 @@ void GCode::process_layers(const Print&              print,
 
     // The pipeline elements are joined using const references, thus no copying is performed.
     if (m_spiral_vase && m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & spiral_mode & pressure_equalizer & cooling & fan_mover & output);
+        tbb::parallel_pipeline(12, generator & spiral_mode & pressure_equalizer & decode & cooling & fan_mover & output);
     else if (m_spiral_vase)
-        tbb::parallel_pipeline(12, generator & spiral_mode & cooling & fan_mover & output);
+        tbb::parallel_pipeline(12, generator & spiral_mode & decode & cooling & fan_mover & output);
     else if (m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & pressure_equalizer & cooling & fan_mover & pa_processor_filter & output);
+        tbb::parallel_pipeline(12, generator & pressure_equalizer & decode & cooling & fan_mover & pa_processor_filter & output);
     else
-        tbb::parallel_pipeline(12, generator & cooling & fan_mover & pa_processor_filter & output);
+        tbb::parallel_pipeline(12, generator & decode & cooling & fan_mover & pa_processor_filter & output);
 }
 
 std::string GCode::placeholder_parser_process(const std::string&   name,
@@ -7230,6 +7489,8 @@ void GCode::GCodeOutputStream::write(const char* what)
         const char* gcode = what;
         // writes string to file
         fwrite(gcode, 1, ::strlen(gcode), this->f);
+        if (m_recording != nullptr)
+            m_recording->append(gcode);
         // FIXME don't allocate a string, maybe process a batch of lines?
         m_processor.process_buffer(std::string(gcode));
     }
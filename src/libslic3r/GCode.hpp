@@ -40,6 +40,7 @@ class GCode;
 
 namespace { struct Item; }
 struct PrintInstance;
+struct GCodeLayerResultCache;
 class ConstPrintObjectPtrsAdaptor;
 
 class OozePrevention {
@@ -182,6 +183,21 @@ struct LayerResult {
     static LayerResult make_nop_layer_result() { return {"", std::numeric_limits<coord_t>::max(), false, false, true}; }
 };
 
+// LayerResult with the G-code split into lines and decoded for the serial post-processing stages of GCode::process_layers().
+struct DecodedLayerResult {
+    LayerGCode  gcode;
+    size_t      layer_id;
+    bool        cooling_buffer_flush { false };
+    bool        nop_layer_result { false };
+    CoolingBuffer::LayerStateUpdate cooling_state_update;
+};
+
+// Layer passing through the cooling buffer stages of GCode::process_layers().
+struct CoolingLayerResult {
+    CoolingBuffer::CollectedLayer layer;
+    bool        nop_layer_result { false };
+};
+
 class GCode {
 
 public:
@@ -323,9 +339,13 @@ private:
         // Formats and write into a file the given data.
         void write_format(const char* format, ...);
 
+        // Append everything written to the string as well, stop recording if nullptr.
+        void set_recording(std::string *recording) { m_recording = recording; }
+
     private:
         FILE *f = nullptr;
         GCodeProcessor &m_processor;
+        std::string *m_recording = nullptr;
     };
     void            _do_export(Print &print, GCodeOutputStream &file, ThumbnailsGeneratorCallback thumbnail_cb);
 
@@ -626,6 +646,9 @@ private:
     int m_start_gcode_filament = -1;
 
     std::set<unsigned int>                  m_initial_layer_extruders;
+    // Layers generated by a previous export to be replayed by process_layers(), or the layers being recorded by this export.
+    std::shared_ptr<const GCodeLayerResultCache> m_layer_cache_replay;
+    std::shared_ptr<GCodeLayerResultCache>       m_layer_cache_record;
     // BBS
     int get_bed_temperature(const int extruder_id, const bool is_first_layer, const BedType bed_type) const;
     // BBS: max bed temperature over all used extruders, so that the bed temperature always
@@ -5,6 +5,7 @@
 
 #include "../GCode.hpp"
 #include "AdaptivePAProcessor.hpp"
+#include "../GCodeScanner.hpp"
 #include <sstream>
 #include <iostream>
 #include <cmath>
@@ -64,16 +65,24 @@ AdaptivePAInterpolator* AdaptivePAProcessor::getInterpolator(unsigned int tool_i
  * @return A string containing the processed G-code with adaptive pressure advance applied.
  */
 std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
-    std::istringstream stream(gcode);
-    std::string line;
-    std::ostringstream output;
+    const char *gcode_end = gcode.data() + gcode.size();
+    // Equivalent of std::getline() without copying the line: returns the line at ptr without the '\n' and advances ptr to the next line.
+    auto get_line = [gcode_end](const char *&ptr) {
+        const char *line_end = GCodeScanner::find_newline(ptr, gcode_end);
+        std::string_view line(ptr, line_end - ptr);
+        ptr = line_end == gcode_end ? line_end : line_end + 1;
+        return line;
+    };
+    std::string output;
+    output.reserve(gcode.size() + gcode.size() / 64);
     double mm3mm_value = 0.0;
     unsigned int accel_value = 0;
     std::string pa_change_line;
     bool wipe_command = false;
 
     // Iterate through each line of the layer G-code
-    while (std::getline(stream, line)) {
+    for (const char *ptr = gcode.data(); ptr != gcode_end;) {
+        const std::string_view line = get_line(ptr);
         
         // If a wipe start command is found, ignore all speed changes till the wipe end part is found
         if (line.find("WIPE_START") != std::string::npos) {
@@ -85,7 +94,7 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
         if ( (line.find("G1 F") == 0) && (!wipe_command) ) { // prune lines quickly before running pattern matching
             std::size_t pos = line.find('F');
             if (pos != std::string::npos){
-                m_current_feedrate = std::stod(line.substr(pos + 1)) / 60.0; // Convert from mm/min to mm/s
+                m_current_feedrate = std::stod(std::string(line.substr(pos + 1))) / 60.0; // Convert from mm/min to mm/s
             }
         }
         
@@ -106,7 +115,7 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
         // For a mixed extruder layer with both adaptive PA enabled and disabled when the new tool is selected
         // the PA for that material is set. As no tag below will be found for this extruder, the original PA is retained.
         if (line.find("; PA_CHANGE") == 0) { // prune lines quickly before running regex check as regex is more expensive to run
-            if (std::regex_search(line, m_match, m_pa_change_pattern)) {
+            if (std::regex_search(line.begin(), line.end(), m_match, m_pa_change_pattern)) {
                 int extruder_id = std::stoi(m_match[1].str());
                 mm3mm_value = std::stod(m_match[2].str());
                 accel_value = std::stod(m_match[3].str());
@@ -122,8 +131,7 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
                 pa_change_line = line;
                 
                 // Look ahead for feedrate before any line containing both G and E commands
-                std::streampos current_pos = stream.tellg();
-                std::string next_line;
+                const char *next_ptr = ptr;
                 double temp_feed_rate = 0;
                 bool extrude_move_found = false;
                 int line_counter = 0;
@@ -132,7 +140,8 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
                 // If a G1 Fxxxx pattern is found, the new speed is identified
                 // Carry on searching for feedrates to find the maximum print speed
                 // until a feature change pattern or a wipe command is detected
-                while (std::getline(stream, next_line)) {
+                while (next_ptr != gcode_end) {
+                    const std::string_view next_line = get_line(next_ptr);
                     line_counter++;
                     // Found an extrude move, set extrude move found flag and move to the next line
                     if ((!extrude_move_found) && next_line.find("G1 ") == 0 &&
@@ -170,7 +179,7 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
                     if (next_line.find("; PA_CHANGE") == 0) { // prune lines quickly before running pattern matching
                         std::size_t rc_pos = next_line.rfind("RC:");
                         if (rc_pos != std::string::npos) {
-                            int rc_value = std::stoi(next_line.substr(rc_pos + 3));
+                            int rc_value = std::stoi(std::string(next_line.substr(rc_pos + 3)));
                             if (rc_value == 1) {
                                 break; // Role change found, stop searching
                             }
@@ -183,7 +192,7 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
                     if (next_line.find("G1 F") == 0) { // prune lines quickly before running pattern matching
                         std::size_t pos = next_line.find('F');
                         if (pos != std::string::npos) {
-                            double feedrate = std::stod(next_line.substr(pos + 1)) / 60.0; // Convert from mm/min to mm/s
+                            double feedrate = std::stod(std::string(next_line.substr(pos + 1))) / 60.0; // Convert from mm/min to mm/s
                             if(line_counter==1){ // this is the first command after the PA change pattern, and hence before any extrusion has happened. Reset
                                                 // the current speed to this one
                                 m_current_feedrate = feedrate;
@@ -205,10 +214,7 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
                 } else // If we didnt find a new feedrate at all after the PA change command, use the current feedrate.
                     m_max_next_feedrate = m_current_feedrate;
                 
-                // Restore stream position
-                stream.clear();
-                stream.seekg(current_pos);
-                
+
                 // Calculate the predicted PA using the upcomming feature maximum feedrate
                 // Get the interpolator for the active tool
                 AdaptivePAInterpolator* interpolator = getInterpolator(m_last_extruder_id);
@@ -219,7 +225,7 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
                 if(!interpolator){ // Tool not found in the interpolator map
                     // Tool not found in the PA interpolator to tool map
                     predicted_pa = m_config.enable_pressure_advance.get_at(m_last_extruder_id) ? m_config.pressure_advance.get_at(m_last_extruder_id) : 0;
-                    if(m_config.gcode_comments) output << "; APA: Tool doesnt have APA enabled\n";
+                    if(m_config.gcode_comments) output += "; APA: Tool doesnt have APA enabled\n";
                 } else if (!interpolator->isInitialised() || (!m_config.adaptive_pressure_advance.get_at(m_last_extruder_id)) )
                     // Check if the model is not initialised by the constructor for the active extruder
                     // Also check that adaptive PA is enabled for that extruder. This should not be needed
@@ -228,7 +234,7 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
                 {
                     // Model failed or adaptive pressure advance not enabled - use default value from m_config
                     predicted_pa = m_config.enable_pressure_advance.get_at(m_last_extruder_id) ? m_config.pressure_advance.get_at(m_last_extruder_id) : 0;
-                    if(m_config.gcode_comments) output << "; APA: Interpolator setup failed, using default pressure advance\n";
+                    if(m_config.gcode_comments) output += "; APA: Interpolator setup failed, using default pressure advance\n";
                 } else { // Model setup succeeded
                     // Proceed to identify the print speed to use to calculate the adaptive PA value
                     if(isOverhang > 0){  // If we are in an overhang area, use the minimum between current print speed
@@ -253,33 +259,34 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
                     
                     if (predicted_pa < 0) { // If extrapolation fails, fall back to the default PA for the extruder.
                         predicted_pa = m_config.enable_pressure_advance.get_at(m_last_extruder_id) ? m_config.pressure_advance.get_at(m_last_extruder_id) : 0;
-                        if(m_config.gcode_comments) output << "; APA: Interpolation failed, using fallback pressure advance value\n";
+                        if(m_config.gcode_comments) output += "; APA: Interpolation failed, using fallback pressure advance value\n";
                     }
                 }
                 if(m_config.gcode_comments) {
                     // Output debug GCode comments
-                    output << pa_change_line << '\n'; // Output PA change command tag
+                    output += pa_change_line + '\n'; // Output PA change command tag
                     if(isBridge && m_config.adaptive_pressure_advance_bridges.get_at(m_last_extruder_id) > EPSILON)
-                        output << "; APA Model Override (bridge)\n";
-                    output << "; APA Current Speed: " << std::to_string(m_current_feedrate) << "\n";
-                    output << "; APA Next Speed: " << std::to_string(m_next_feedrate) << "\n";
-                    output << "; APA Max Next Speed: " << std::to_string(m_max_next_feedrate) << "\n";
-                    output << "; APA Speed Used: " << std::to_string(adaptive_PA_speed) << "\n";
-                    output << "; APA Flow rate: " << std::to_string(mm3mm_value * m_max_next_feedrate) << "\n";
-                    output << "; APA Prev PA: " << std::to_string(m_last_predicted_pa) << " New PA: " << std::to_string(predicted_pa) << "\n"; 
+                        output += "; APA Model Override (bridge)\n";
+                    output += "; APA Current Speed: " + std::to_string(m_current_feedrate) + "\n";
+                    output += "; APA Next Speed: " + std::to_string(m_next_feedrate) + "\n";
+                    output += "; APA Max Next Speed: " + std::to_string(m_max_next_feedrate) + "\n";
+                    output += "; APA Speed Used: " + std::to_string(adaptive_PA_speed) + "\n";
+                    output += "; APA Flow rate: " + std::to_string(mm3mm_value * m_max_next_feedrate) + "\n";
+                    output += "; APA Prev PA: " + std::to_string(m_last_predicted_pa) + " New PA: " + std::to_string(predicted_pa) + "\n"; 
                 }
                 if (extruder_changed || std::fabs(predicted_pa - m_last_predicted_pa) > EPSILON) {
-                    output << m_gcodegen.writer().set_pressure_advance(predicted_pa); // Use m_writer to set pressure advance
+                    output += m_gcodegen.writer().set_pressure_advance(predicted_pa); // Use m_writer to set pressure advance
                     m_last_predicted_pa = predicted_pa; // Update the last predicted PA value
                 }
             }
         }else {
             // Output the current line as this isn't a PA change tag
-            output << line << '\n';
+            output += line;
+            output += '\n';
         }
     }
 
-    return output.str();
+    return output;
 }
 
 } // namespace Slic3r
@@ -1,10 +1,10 @@
 #include "ConflictChecker.hpp"
 
 #include <tbb/parallel_for.h>
-#include <tbb/concurrent_vector.h>
+#include <ankerl/unordered_dense.h>
 
+#include <algorithm>
 #include <map>
-#include <functional>
 #include <atomic>
 
 namespace Slic3r {
@@ -22,9 +22,9 @@ inline IndexPair point_map_grid_index(const Point &pt, int64_t xdist, int64_t yd
 
 inline bool nearly_equal(const Point &p1, const Point &p2) { return std::abs(p1.x() - p2.x()) < SCALED_EPSILON && std::abs(p1.y() - p2.y()) < SCALED_EPSILON; }
 
-inline Grids line_rasterization(const Line &line, int64_t xdist = scale_(1), int64_t ydist = scale_(1))
+// Calls visitor with the index of each grid cell crossed by the line, stops early and returns false if visitor returns false.
+template<typename Visitor> inline bool line_rasterization(const Line &line, Visitor &&visitor, int64_t xdist = scale_(1), int64_t ydist = scale_(1))
 {
-    Grids     res;
     Point     rayStart     = line.a;
     Point     rayEnd       = line.b;
     IndexPair currentVoxel = point_map_grid_index(rayStart, xdist, ydist);
@@ -48,23 +48,24 @@ inline Grids line_rasterization(const Line &line, int64_t xdist = scale_(1), int
     double tDeltaX = ray.x() != 0 ? static_cast<double>(xdist) / ray.x() * stepX : DBL_MAX;
     double tDeltaY = ray.y() != 0 ? static_cast<double>(ydist) / ray.y() * stepY : DBL_MAX;
 
-    res.push_back(currentVoxel);
+    if (!visitor(currentVoxel)) { return false; }
 
     double tx = tMaxX;
     double ty = tMaxY;
+    size_t count = 1;
 
     while (lastVoxel != currentVoxel) {
         if (lastVoxel.first == currentVoxel.first) {
             for (int64_t i = currentVoxel.second; i != lastVoxel.second; i += (int64_t) stepY) {
                 currentVoxel.second += (int64_t) stepY;
-                res.push_back(currentVoxel);
+                if (!visitor(currentVoxel)) { return false; }
             }
             break;
         }
         if (lastVoxel.second == currentVoxel.second) {
             for (int64_t i = currentVoxel.first; i != lastVoxel.first; i += (int64_t) stepX) {
                 currentVoxel.first += (int64_t) stepX;
-                res.push_back(currentVoxel);
+                if (!visitor(currentVoxel)) { return false; }
             }
             break;
         }
@@ -76,189 +77,312 @@ inline Grids line_rasterization(const Line &line, int64_t xdist = scale_(1), int
             currentVoxel.second += (int64_t) stepY;
             ty += tDeltaY;
         }
-        res.push_back(currentVoxel);
-        if (res.size() >= 100000) { // bug
+        if (!visitor(currentVoxel)) { return false; }
+        if (++count >= 100000) { // bug
             assert(0);
         }
     }
 
-    return res;
+    return true;
 }
+
+// Key of a grid cell in the hashed grid of find_inter_of_lines().
+inline uint64_t grid_cell_key(const IndexPair &index) { return (uint64_t(uint32_t(index.first)) << 32) | uint64_t(uint32_t(index.second)); }
 } // namespace RasterizationImpl
 
-void LinesBucketQueue::emplace_back_bucket(ExtrusionLayers &&els, const void *objPtr, Point offset)
+namespace StreamingImpl {
+
+// Calls visitor for each path of the collection, the paths are not copied.
+template<typename Visitor> void visit_extrusion_paths(const ExtrusionEntityCollection &collection, Visitor &visitor)
 {
-    auto oldSize = line_buckets.capacity();
-    line_buckets.emplace_back(std::move(els), objPtr, offset);
-    auto newSize = line_buckets.capacity();
-    // Since line_bucket_ptr_queue is storing pointers into line_buckets,
-    // we need to handle the case where the capacity changes since that makes
-    // the existing pointers invalid
-    if (oldSize == newSize) {
-        line_bucket_ptr_queue.push(&line_buckets.back());
-    }
-    else { // pointers change, create a new queue from scratch
-        decltype(line_bucket_ptr_queue) newQueue;
-        for (LinesBucket &bucket : line_buckets) { newQueue.push(&bucket); }
-        std::swap(line_bucket_ptr_queue, newQueue);
+    for (const ExtrusionEntity *entityPtr : collection.entities) {
+        if (const ExtrusionEntityCollection *sub = dynamic_cast<const ExtrusionEntityCollection *>(entityPtr)) {
+            visit_extrusion_paths(*sub, visitor);
+        } else if (const ExtrusionPath *path = dynamic_cast<const ExtrusionPath *>(entityPtr)) {
+            visitor(*path);
+        } else if (const ExtrusionMultiPath *multipath = dynamic_cast<const ExtrusionMultiPath *>(entityPtr)) {
+            for (const ExtrusionPath &path : multipath->paths) { visitor(path); }
+        } else if (const ExtrusionLoop *loop = dynamic_cast<const ExtrusionLoop *>(entityPtr)) {
+            for (const ExtrusionPath &path : loop->paths) { visitor(path); }
+        }
     }
 }
 
-// remove lowest and get the current bottom z
-float LinesBucketQueue::getCurrBottomZ()
+// Layers of an object (perimeters and infill or support) or of the wipe tower in Z order.
+// The object extrusions are referenced in place, only the wipe tower paths are owned as they are generated on demand.
+struct LayersBucket
 {
-    auto lowest = line_bucket_ptr_queue.top();
-    line_bucket_ptr_queue.pop();
-    float                      layerBottomZ = lowest->curBottomZ();
-    std::vector<LinesBucket *> lowests;
-    lowests.push_back(lowest);
-
-    while (line_bucket_ptr_queue.empty() == false && std::abs(line_bucket_ptr_queue.top()->curBottomZ() - lowest->curBottomZ()) < EPSILON) {
-        lowests.push_back(line_bucket_ptr_queue.top());
-        line_bucket_ptr_queue.pop();
+    ExtrusionLayersType        type;
+    const void *               id;
+    Point                      offset;
+    std::vector<const Layer *> layers;
+    ExtrusionLayers            wipe_tower;
+    // Bounding box of each layer and of all layers, shifted by offset.
+    std::vector<BoundingBox>   bboxes;
+    BoundingBox                bbox;
+
+    size_t size() const { return type == ExtrusionLayersType::WIPE_TOWER ? wipe_tower.size() : layers.size(); }
+    float  bottom_z(size_t idx) const { return type == ExtrusionLayersType::WIPE_TOWER ? wipe_tower[idx].bottom_z : float(layers[idx]->bottom_z()); }
+    // End of the pile of layers starting at idx, which share the same bottom z.
+    size_t pile_end(size_t idx) const
+    {
+        size_t end = idx + 1;
+        while (end < this->size() && this->bottom_z(end) == this->bottom_z(idx)) ++end;
+        return end;
     }
 
-    for (LinesBucket *bp : lowests) {
-        float prevZ = bp->curBottomZ();
-        bp->raise();
-        if (bp->curBottomZ() == prevZ) continue;
-        if (bp->valid()) { line_bucket_ptr_queue.push(bp); }
+    template<typename Visitor> void visit_paths(size_t idx, Visitor &&visitor) const
+    {
+        switch (type) {
+        case ExtrusionLayersType::WIPE_TOWER:
+            for (const ExtrusionPath &path : wipe_tower[idx].paths) { visitor(path); }
+            break;
+        case ExtrusionLayersType::SUPPORT:
+            visit_extrusion_paths(static_cast<const SupportLayer *>(layers[idx])->support_fills, visitor);
+            break;
+        default:
+            for (const LayerRegion *region : layers[idx]->regions()) {
+                visit_extrusion_paths(region->perimeters, visitor);
+                visit_extrusion_paths(region->fills, visitor);
+            }
+            break;
+        }
     }
-    return layerBottomZ;
-}
 
-LineWithIDs LinesBucketQueue::getCurLines() const
-{
-    LineWithIDs lines;
-    for (const LinesBucket &bucket : line_buckets) {
-        if (bucket.valid()) {
-            LineWithIDs tmpLines = bucket.curLines();
-            lines.insert(lines.end(), tmpLines.begin(), tmpLines.end());
+    void update_bboxes()
+    {
+        bboxes.assign(this->size(), BoundingBox());
+        bbox.reset();
+        for (size_t idx = 0; idx < this->size(); ++idx) {
+            BoundingBox &bb = bboxes[idx];
+            this->visit_paths(idx, [&bb](const ExtrusionPath &path) {
+                if (path.is_force_no_extrusion() == false)
+                    bb.merge(path.polyline.points);
+            });
+            if (bb.defined) {
+                bb.translate(offset);
+                bbox.merge(bb);
+            }
         }
     }
-    return lines;
-}
+};
 
-void getExtrusionPathsFromEntity(const ExtrusionEntityCollection *entity, ExtrusionPaths &paths)
+// Layers [begin, end) of a bucket checked together with the layers of the other buckets at the same step of the sweep.
+struct BucketPile
 {
-    std::function<void(const ExtrusionEntityCollection *, ExtrusionPaths &)> getExtrusionPathImpl = [&](const ExtrusionEntityCollection *entity, ExtrusionPaths &paths) {
-        for (auto entityPtr : entity->entities) {
-            if (const ExtrusionEntityCollection *collection = dynamic_cast<ExtrusionEntityCollection *>(entityPtr)) {
-                getExtrusionPathImpl(collection, paths);
-            } else if (const ExtrusionPath *path = dynamic_cast<ExtrusionPath *>(entityPtr)) {
-                paths.push_back(*path);
-            } else if (const ExtrusionMultiPath *multipath = dynamic_cast<ExtrusionMultiPath *>(entityPtr)) {
-                for (const ExtrusionPath &path : multipath->paths) { paths.push_back(path); }
-            } else if (const ExtrusionLoop *loop = dynamic_cast<ExtrusionLoop *>(entityPtr)) {
-                for (const ExtrusionPath &path : loop->paths) { paths.push_back(path); }
-            }
-        }
-    };
-    getExtrusionPathImpl(entity, paths);
-}
+    uint32_t bucket;
+    uint32_t begin;
+    uint32_t end;
+};
 
-ExtrusionLayers getExtrusionPathsFromLayer(const LayerRegionPtrs layerRegionPtrs)
+struct SweepStep
+{
+    float                   bottom_z;
+    std::vector<BucketPile> piles;
+};
+
+// Walks the buckets in Z order the same way as a priority queue of buckets sorted by their current bottom z:
+// each step checks the current pile of all the buckets and then raises the lowest buckets.
+// Buckets, which do not overlap any bucket of another object, are not recorded.
+std::vector<SweepStep> sweep_buckets(const std::vector<LayersBucket> &buckets, const std::vector<char> &isolated)
 {
-    ExtrusionLayers perimeters; // periments and infills
-    perimeters.resize(layerRegionPtrs.size());
-    int i = 0;
-    for (LayerRegion *regionPtr : layerRegionPtrs) {
-        perimeters[i].layer    = regionPtr->layer();
-        perimeters[i].bottom_z = regionPtr->layer()->bottom_z();
-        perimeters[i].height   = regionPtr->layer()->height;
-        getExtrusionPathsFromEntity(&regionPtr->perimeters, perimeters[i].paths);
-        getExtrusionPathsFromEntity(&regionPtr->fills, perimeters[i].paths);
-        ++i;
+    struct BucketState
+    {
+        size_t cur        = 0;
+        float  cur_bottom_z = 0.f;
+    };
+    std::vector<BucketState> states(buckets.size());
+    auto higher = [&states](uint32_t l, uint32_t r) { return states[l].cur_bottom_z > states[r].cur_bottom_z; };
+    std::vector<uint32_t> queue;
+    for (uint32_t i = 0; i < buckets.size(); ++i) {
+        queue.push_back(i);
+        std::push_heap(queue.begin(), queue.end(), higher);
     }
-    return perimeters;
-}
 
-ExtrusionLayer getExtrusionPathsFromSupportLayer(SupportLayer *supportLayer)
-{
-    ExtrusionLayer el;
-    getExtrusionPathsFromEntity(&supportLayer->support_fills, el.paths);
-    el.layer    = supportLayer;
-    el.bottom_z = supportLayer->bottom_z();
-    el.height   = supportLayer->height;
-    return el;
+    std::vector<SweepStep> steps;
+    std::vector<uint32_t>  lowests;
+    while (! queue.empty()) {
+        SweepStep step;
+        for (uint32_t i = 0; i < buckets.size(); ++i)
+            if (! isolated[i] && states[i].cur < buckets[i].size())
+                step.piles.push_back({ i, uint32_t(states[i].cur), uint32_t(buckets[i].pile_end(states[i].cur)) });
+
+        // remove lowest and get the current bottom z
+        std::pop_heap(queue.begin(), queue.end(), higher);
+        uint32_t lowest = queue.back();
+        queue.pop_back();
+        step.bottom_z = states[lowest].cur_bottom_z;
+        lowests.assign(1, lowest);
+        while (! queue.empty() && std::abs(states[queue.front()].cur_bottom_z - step.bottom_z) < EPSILON) {
+            std::pop_heap(queue.begin(), queue.end(), higher);
+            lowests.push_back(queue.back());
+            queue.pop_back();
+        }
+        for (uint32_t idx : lowests) {
+            BucketState &state = states[idx];
+            const LayersBucket &bucket = buckets[idx];
+            if (state.cur >= bucket.size()) continue;
+            float prevZ = state.cur_bottom_z;
+            state.cur = bucket.pile_end(state.cur);
+            state.cur_bottom_z = bucket.bottom_z(state.cur == bucket.size() ? bucket.size() - 1 : state.cur);
+            if (state.cur_bottom_z == prevZ) continue;
+            if (state.cur < bucket.size()) {
+                queue.push_back(idx);
+                std::push_heap(queue.begin(), queue.end(), higher);
+            }
+        }
+        if (step.piles.size() > 1)
+            steps.emplace_back(std::move(step));
+    }
+    return steps;
 }
 
-ObjectExtrusions getAllLayersExtrusionPathsFromObject(PrintObject *obj)
+// Lines of a sweep step, which lie close to a pile of another object, thus which may intersect it.
+LineWithIDs step_lines(const std::vector<LayersBucket> &buckets, const SweepStep &step)
 {
-    ObjectExtrusions oe;
-
-    for (auto layerPtr : obj->layers()) {
-        auto perimeters = getExtrusionPathsFromLayer(layerPtr->regions());
-        oe.perimeters.insert(oe.perimeters.end(), perimeters.begin(), perimeters.end());
+    std::vector<BoundingBox> bboxes(step.piles.size());
+    for (size_t i = 0; i < step.piles.size(); ++i) {
+        const BucketPile &pile = step.piles[i];
+        for (uint32_t idx = pile.begin; idx < pile.end; ++idx)
+            if (buckets[pile.bucket].bboxes[idx].defined)
+                bboxes[i].merge(buckets[pile.bucket].bboxes[idx]);
     }
 
-    for (auto supportLayerPtr : obj->support_layers()) { oe.support.push_back(getExtrusionPathsFromSupportLayer(supportLayerPtr)); }
-
-    return oe;
+    LineWithIDs              lines;
+    std::vector<BoundingBox> others;
+    for (size_t i = 0; i < step.piles.size(); ++i) {
+        if (! bboxes[i].defined) continue;
+        const BucketPile   &pile   = step.piles[i];
+        const LayersBucket &bucket = buckets[pile.bucket];
+        others.clear();
+        for (size_t j = 0; j < step.piles.size(); ++j)
+            if (bboxes[j].defined && buckets[step.piles[j].bucket].id != bucket.id && bboxes[i].overlap(bboxes[j]))
+                others.push_back(bboxes[j]);
+        if (others.empty()) continue;
+        auto close_to_others = [&others](const Point &a, const Point &b) {
+            for (const BoundingBox &bb : others)
+                if (! (std::max(a.x(), b.x()) < bb.min.x() || std::min(a.x(), b.x()) > bb.max.x() ||
+                       std::max(a.y(), b.y()) < bb.min.y() || std::min(a.y(), b.y()) > bb.max.y()))
+                    return true;
+            return false;
+        };
+        for (uint32_t idx = pile.begin; idx < pile.end; ++idx) {
+            const BoundingBox &layer_bbox = bucket.bboxes[idx];
+            if (! layer_bbox.defined || ! close_to_others(layer_bbox.min, layer_bbox.max)) continue;
+            bucket.visit_paths(idx, [&](const ExtrusionPath &path) {
+                if (path.is_force_no_extrusion()) return;
+                const Points &pts = path.polyline.points;
+                for (size_t k = 1; k < pts.size(); ++k) {
+                    Point a = pts[k - 1] + bucket.offset;
+                    Point b = pts[k] + bucket.offset;
+                    if (close_to_others(a, b))
+                        lines.emplace_back(Line(a, b), bucket.id, path.role());
+                }
+            });
+        }
+    }
+    return lines;
 }
 
+} // namespace StreamingImpl
+
 ConflictComputeOpt ConflictChecker::find_inter_of_lines(const LineWithIDs &lines)
 {
     using namespace RasterizationImpl;
-    std::map<IndexPair, std::vector<int>> indexToLine;
-
-    for (int i = 0; i < lines.size(); ++i) {
-        const LineWithID &l1      = lines[i];
-        auto              indexes = line_rasterization(l1._line);
-        for (auto index : indexes) {
-            const auto &possibleIntersectIdxs = indexToLine[index];
-            for (auto possibleIntersectIdx : possibleIntersectIdxs) {
-                const LineWithID &l2 = lines[possibleIntersectIdx];
-                if (auto interRes = line_intersect(l1, l2); interRes.has_value()) { return interRes; }
+    // Flat hashed grid: each cell points to the last line entry crossing it, the entries of a cell are chained.
+    struct CellEntry
+    {
+        int line;
+        int next;
+    };
+    ankerl::unordered_dense::map<uint64_t, int> cellHeads;
+    std::vector<CellEntry>                      entries;
+    cellHeads.reserve(lines.size());
+    entries.reserve(lines.size() * 2);
+
+    ConflictComputeOpt res;
+    for (int i = 0; i < lines.size() && ! res.has_value(); ++i) {
+        const LineWithID &l1 = lines[i];
+        line_rasterization(l1._line, [&](const IndexPair &index) {
+            int &head = cellHeads.try_emplace(grid_cell_key(index), -1).first->second;
+            for (int entry = head; entry != -1; entry = entries[entry].next) {
+                const LineWithID &l2 = lines[entries[entry].line];
+                if (auto interRes = line_intersect(l1, l2); interRes.has_value()) {
+                    res = interRes;
+                    return false;
+                }
             }
-            indexToLine[index].push_back(i);
-        }
+            entries.push_back({ i, head });
+            head = int(entries.size()) - 1;
+            return true;
+        });
     }
-    return {};
+    return res;
 }
 
 ConflictResultOpt ConflictChecker::find_inter_of_lines_in_diff_objs(PrintObjectPtrs                      objs,
                                                                     std::optional<const FakeWipeTower *> wtdptr) // find the first intersection point of lines in different objects
 {
+    using namespace StreamingImpl;
     if (objs.size() <= 1 && !wtdptr) { return {}; }
-    LinesBucketQueue conflictQueue;
 
+    std::vector<LayersBucket> buckets;
     if (wtdptr.has_value()) { // wipe tower at 0 by default
-        ExtrusionLayers wtels = wtdptr.value()->getTrueExtrusionLayersFromWipeTower();
-        conflictQueue.emplace_back_bucket(std::move(wtels), wtdptr.value(), {wtdptr.value()->plate_origin.x(), wtdptr.value()->plate_origin.y()});
+        LayersBucket bucket;
+        bucket.type       = ExtrusionLayersType::WIPE_TOWER;
+        bucket.id         = wtdptr.value();
+        bucket.offset     = {wtdptr.value()->plate_origin.x(), wtdptr.value()->plate_origin.y()};
+        bucket.wipe_tower = wtdptr.value()->getTrueExtrusionLayersFromWipeTower();
+        buckets.emplace_back(std::move(bucket));
     }
     for (PrintObject *obj : objs) {
-        auto layers = getAllLayersExtrusionPathsFromObject(obj);
-        conflictQueue.emplace_back_bucket(std::move(layers.perimeters), obj, obj->instances().front().shift);
-        conflictQueue.emplace_back_bucket(std::move(layers.support), obj, obj->instances().front().shift);
+        LayersBucket perimeters;
+        perimeters.type   = ExtrusionLayersType::PERIMETERS;
+        perimeters.id     = obj;
+        perimeters.offset = obj->instances().front().shift;
+        perimeters.layers.assign(obj->layers().begin(), obj->layers().end());
+        LayersBucket support;
+        support.type   = ExtrusionLayersType::SUPPORT;
+        support.id     = obj;
+        support.offset = perimeters.offset;
+        support.layers.assign(obj->support_layers().begin(), obj->support_layers().end());
+        buckets.emplace_back(std::move(perimeters));
+        buckets.emplace_back(std::move(support));
     }
 
-    std::vector<LineWithIDs> layersLines;
-    std::vector<float>       bottomZs;
-    while (conflictQueue.valid()) {
-        LineWithIDs lines = conflictQueue.getCurLines();
-        float curBottomZ = conflictQueue.getCurrBottomZ();
-        bottomZs.push_back(curBottomZ);
-        layersLines.push_back(std::move(lines));
-    }
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, buckets.size(), 1), [&buckets](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end(); ++i)
+            buckets[i].update_bboxes();
+    });
 
-    bool                                                          find = false;
-    tbb::concurrent_vector<std::pair<ConflictComputeResult, float>> conflict;
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, layersLines.size()), [&](tbb::blocked_range<size_t> range) {
-        for (size_t i = range.begin(); i < range.end(); i++) {
-            auto interRes = find_inter_of_lines(layersLines[i]);
-            if (interRes.has_value()) {
-                find = true;
-                conflict.emplace_back(interRes.value(), bottomZs[i]);
+    // Objects far from all the other objects are not checked at all.
+    std::vector<char> isolated(buckets.size(), 1);
+    for (size_t i = 0; i < buckets.size(); ++i)
+        for (size_t j = i + 1; j < buckets.size(); ++j)
+            if (buckets[i].id != buckets[j].id && buckets[i].bbox.defined && buckets[j].bbox.defined && buckets[i].bbox.overlap(buckets[j].bbox))
+                isolated[i] = isolated[j] = 0;
+
+    std::vector<SweepStep> steps = sweep_buckets(buckets, isolated);
+
+    // Report the lowest conflict, the layers above an already found conflict are skipped.
+    std::atomic<size_t>             firstConflict(steps.size());
+    std::vector<ConflictComputeOpt> conflicts(steps.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, steps.size()), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end() && i < firstConflict.load(std::memory_order_relaxed); ++i) {
+            LineWithIDs lines = step_lines(buckets, steps[i]);
+            if (lines.empty()) continue;
+            conflicts[i] = find_inter_of_lines(lines);
+            if (conflicts[i].has_value()) {
+                for (size_t cur = firstConflict.load(); i < cur && ! firstConflict.compare_exchange_weak(cur, i);) ;
                 break;
             }
         }
     });
 
-    if (find) {
-        const void *ptr1           = conflict[0].first._obj1;
-        const void *ptr2           = conflict[0].first._obj2;
-        float       conflictPrintZ = conflict[0].second;
+    if (size_t idx = firstConflict.load(); idx < steps.size()) {
+        const void *ptr1           = conflicts[idx]->_obj1;
+        const void *ptr2           = conflicts[idx]->_obj2;
+        float       conflictPrintZ = steps[idx].bottom_z;
         if (wtdptr.has_value()) {
             const FakeWipeTower *wtdp = wtdptr.value();
             if (ptr1 == wtdp || ptr2 == wtdp) {
@@ -313,27 +313,118 @@ finished:
 
 std::string CoolingBuffer::process_layer(std::string &&gcode, size_t layer_id, bool flush)
 {
+    return this->process_layer(LayerGCode(std::move(gcode)), layer_id, flush);
+}
+
+std::string CoolingBuffer::process_layer(LayerGCode &&gcode, size_t layer_id, bool flush)
+{
+    const LayerStateUpdate update = this->layer_state_update(gcode);
+    CollectedLayer         layer  = this->collect_layer(std::move(gcode), update, layer_id, flush);
+    this->prepare_layer(layer);
+    return this->apply_layer(std::move(layer));
+}
+
+// Slowed down lines of a layer and the layer time after the slow down, calculated by CoolingBuffer::prepare_layer().
+struct CoolingLayerAdjustments
+{
+    std::vector<PerExtruderAdjustments> per_extruder;
+    float                               layer_time { 0.f };
+};
+
+// Tracks the axes the same way as parse_layer_gcode() does, only symbolically relative to the starting position.
+CoolingBuffer::LayerStateUpdate CoolingBuffer::layer_state_update(const LayerGCode &gcode) const
+{
+    LayerStateUpdate update;
+    for (const LayerGCode::Line &gline : gcode.lines()) {
+        switch (gline.command) {
+        case LayerGCode::Command::G0:
+        case LayerGCode::Command::G1:
+        case LayerGCode::Command::G2:
+        case LayerGCode::Command::G3:
+        case LayerGCode::Command::G92:
+        {
+            const LayerStateUpdate prev = update;
+            for (size_t axis = 0; axis < 7; ++ axis)
+                if (gline.has(Axis(axis))) {
+                    if (axis == 5 || axis == 6) {
+                        // BBS: position of the arc center, relative to the position before the move.
+                        update.source[axis] = prev.source[axis - 5];
+                        update.offset[axis] = gline.value(Axis(axis)) + prev.offset[axis - 5];
+                    } else {
+                        update.source[axis] = -1;
+                        update.offset[axis] = axis == 4 ? gline.value(Axis(axis)) / 60.f : gline.value(Axis(axis));
+                    }
+                }
+            break;
+        }
+        default:
+            if (! gline.has_tag(LayerGCode::TAG_EXTRUDE_END)) {
+                std::string_view sline = gcode.text(gline);
+                if (boost::starts_with(sline, m_toolchange_prefix)) {
+                    unsigned int new_extruder = 0;
+                    auto ret = std::from_chars(sline.data() + m_toolchange_prefix.size(), sline.data() + sline.size(), new_extruder);
+                    if (std::errc::invalid_argument != ret.ec && new_extruder < m_num_extruders)
+                        update.extruder = int(new_extruder);
+                }
+            }
+            break;
+        }
+    }
+    return update;
+}
+
+CoolingBuffer::CollectedLayer CoolingBuffer::collect_layer(LayerGCode &&gcode, const LayerStateUpdate &update, size_t layer_id, bool flush)
+{
+    if (m_gcode.empty()) {
+        m_gcode_start_pos      = m_current_pos;
+        m_gcode_start_extruder = m_collected_extruder;
+    }
     // Cache the input G-code.
-    if (m_gcode.empty())
-        m_gcode = std::move(gcode);
-    else
-        m_gcode += gcode;
+    m_gcode.append(std::move(gcode));
+    const std::vector<float> start_pos = m_current_pos;
+    for (size_t axis = 0; axis < 7; ++ axis)
+        if (update.source[axis] != int8_t(axis))
+            m_current_pos[axis] = update.source[axis] < 0 ? update.offset[axis] : start_pos[update.source[axis]] + update.offset[axis];
+    if (update.extruder >= 0)
+        m_collected_extruder = unsigned(update.extruder);
 
-    std::string out;
+    CollectedLayer layer;
     if (flush) {
-        // This is either an object layer or the very last print layer. Calculate cool down over the collected support layers
+        // This is either an object layer or the very last print layer. Cool down will be calculated over the collected support layers
         // and one object layer.
-        std::vector<PerExtruderAdjustments> per_extruder_adjustments = this->parse_layer_gcode(m_gcode, m_current_pos);
-        float layer_time_stretched = this->calculate_layer_slowdown(per_extruder_adjustments);
-        out = this->apply_layer_cooldown(m_gcode, layer_id, layer_time_stretched, per_extruder_adjustments);
+        layer.gcode          = std::move(m_gcode);
+        layer.layer_id       = layer_id;
+        layer.flush          = true;
+        layer.start_pos      = std::move(m_gcode_start_pos);
+        layer.start_extruder = m_gcode_start_extruder;
         m_gcode.clear();
     }
-    return out;
+    return layer;
+}
+
+void CoolingBuffer::prepare_layer(CollectedLayer &layer) const
+{
+    if (! layer.flush)
+        return;
+    std::vector<float> current_pos = layer.start_pos;
+    auto adjustments = std::make_shared<CoolingLayerAdjustments>();
+    adjustments->per_extruder = this->parse_layer_gcode(layer.gcode, current_pos, layer.start_extruder);
+    adjustments->layer_time   = calculate_layer_slowdown(adjustments->per_extruder);
+    layer.adjustments = std::move(adjustments);
+    layer.end_pos     = std::move(current_pos);
+}
+
+std::string CoolingBuffer::apply_layer(CollectedLayer &&layer)
+{
+    if (! layer.flush)
+        return {};
+    assert(layer.adjustments);
+    return this->apply_layer_cooldown(layer.gcode.gcode(), layer.layer_id, layer.adjustments->layer_time, layer.adjustments->per_extruder);
 }
 
 // Parse the layer G-code for the moves, which could be adjusted.
 // Return the list of parsed lines, bucketed by an extruder.
-std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos) const
+std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const LayerGCode &gcode, std::vector<float> &current_pos, unsigned int current_extruder) const
 {
     std::vector<PerExtruderAdjustments> per_extruder_adjustments(m_extruder_ids.size());
     std::vector<size_t>                 map_extruder_to_per_extruder_adjustment(m_num_extruders, 0);
@@ -349,10 +440,7 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
         map_extruder_to_per_extruder_adjustment[extruder_id] = i;
     }
 
-    unsigned int      current_extruder  = m_current_extruder;
     PerExtruderAdjustments *adjustment  = &per_extruder_adjustments[map_extruder_to_per_extruder_adjustment[current_extruder]];
-    const char       *line_start = gcode.c_str();
-    const char       *line_end   = line_start;
     // Index of an existing CoolingLine of the current adjustment, which holds the feedrate setting command
     // for a sequence of extrusion moves.
     size_t            active_speed_modifier = size_t(-1);
@@ -361,44 +449,29 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
     // Time of any other movements before the first extrusion will be excluded from the layer time.
     bool layer_had_extrusion = false;
 
-    for (; *line_start != 0; line_start = line_end) 
+    for (const LayerGCode::Line &gline : gcode.lines())
     {
-        while (*line_end != '\n' && *line_end != 0)
-            ++ line_end;
         // sline will not contain the trailing '\n'.
-        std::string sline(line_start, line_end);
+        std::string_view sline = gcode.text(gline);
         // CoolingLine will contain the trailing '\n'.
-        if (*line_end == '\n')
-            ++ line_end;
-        CoolingLine line(0, line_start - gcode.c_str(), line_end - gcode.c_str());
-        if (boost::starts_with(sline, "G0 "))
-            line.type = CoolingLine::TYPE_G0;
-        else if (boost::starts_with(sline, "G1 "))
-            line.type = CoolingLine::TYPE_G1;
-        else if (boost::starts_with(sline, "G92 "))
-            line.type = CoolingLine::TYPE_G92;
-        else if (boost::starts_with(sline, "G2 "))
-            line.type = CoolingLine::TYPE_G2;
-        else if (boost::starts_with(sline, "G3 "))
-            line.type = CoolingLine::TYPE_G3;
+        CoolingLine line(0, gline.begin, gline.next);
+        switch (gline.command) {
+        case LayerGCode::Command::G0:  line.type = CoolingLine::TYPE_G0; break;
+        case LayerGCode::Command::G1:  line.type = CoolingLine::TYPE_G1; break;
+        case LayerGCode::Command::G92: line.type = CoolingLine::TYPE_G92; break;
+        case LayerGCode::Command::G2:  line.type = CoolingLine::TYPE_G2; break;
+        case LayerGCode::Command::G3:  line.type = CoolingLine::TYPE_G3; break;
+        default: break;
+        }
         if (line.type) {
             // G0, G1 or G92
-            // Parse the G-code line.
-            std::vector<float> new_pos(current_pos);
-            const char *c = sline.data() + 3;
-            for (;;) {
-                // Skip whitespaces.
-                for (; *c == ' ' || *c == '\t'; ++ c);
-                if (*c == 0 || *c == ';')
-                    break;
-
-                assert(is_decimal_separator_point()); // for atof
-                //BBS: Parse the axis.
-                size_t axis = (*c >= 'X' && *c <= 'Z') ? (*c - 'X') :
-                              (*c == 'E') ? 3 : (*c == 'F') ? 4 :
-                              (*c == 'I') ? 5 : (*c == 'J') ? 6 : size_t(-1);
-                if (axis != size_t(-1)) {
-                    new_pos[axis] = float(atof(++c));
+            // The axes of the G-code line were decoded by LayerGCode already.
+            //BBS: X,Y,Z,E,F,I,J
+            float new_pos[7];
+            std::copy(current_pos.begin(), current_pos.end(), new_pos);
+            for (size_t axis = 0; axis < 7; ++ axis)
+                if (gline.has(Axis(axis))) {
+                    new_pos[axis] = gline.value(Axis(axis));
                     if (axis == 4) {
                         // Convert mm/min to mm/sec.
                         new_pos[4] /= 60.f;
@@ -410,18 +483,15 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
                         new_pos[axis] += current_pos[axis - 5];
                     }
                 }
-                // Skip this word.
-                for (; *c != ' ' && *c != '\t' && *c != 0; ++ c);
-            }
-            bool external_perimeter = boost::contains(sline, ";_EXTERNAL_PERIMETER");
-            bool wipe               = boost::contains(sline, ";_WIPE");
+            bool external_perimeter = gline.has_tag(LayerGCode::TAG_EXTERNAL_PERIMETER);
+            bool wipe               = gline.has_tag(LayerGCode::TAG_WIPE);
             if (external_perimeter)
                 line.type |= CoolingLine::TYPE_EXTERNAL_PERIMETER;
             if (wipe)
                 line.type |= CoolingLine::TYPE_WIPE;
 
             // Orca: only slow down movements since the first extrusion
-            if (boost::contains(sline, ";_EXTRUDE_SET_SPEED"))
+            if (gline.has_tag(LayerGCode::TAG_EXTRUDE_SET_SPEED))
                 layer_had_extrusion = true;
             
             // ORCA: Dont slowdown external perimeters for layer time feature
@@ -431,7 +501,7 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
             
             // ORCA: Dont slowdown external perimeters for layer time works by not marking the external perimeter as adjustable, 
             // hence the slowdown algorithm ignores it.
-            if (boost::contains(sline, ";_EXTRUDE_SET_SPEED") && ! wipe && adjust_external) {
+            if (gline.has_tag(LayerGCode::TAG_EXTRUDE_SET_SPEED) && ! wipe && adjust_external) {
                 line.type |= CoolingLine::TYPE_ADJUSTABLE;
                 active_speed_modifier = adjustment->lines.size();
             }
@@ -490,8 +560,8 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
                     line.type = 0;
                 }
             }
-            current_pos = std::move(new_pos);
-        } else if (boost::starts_with(sline, ";_EXTRUDE_END")) {
+            std::copy(new_pos, new_pos + 7, current_pos.begin());
+        } else if (gline.has_tag(LayerGCode::TAG_EXTRUDE_END)) {
             line.type = CoolingLine::TYPE_EXTRUDE_END;
             active_speed_modifier = size_t(-1);
         } else if (boost::starts_with(sline, m_toolchange_prefix)) {
@@ -513,32 +583,32 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
                         BOOST_LOG_TRIVIAL(error) << "CoolingBuffer encountered an invalid toolchange, maybe from a custom gcode: " << sline;
                 }
             }
-        } else if (boost::starts_with(sline, ";_OVERHANG_FAN_START")) {
+        } else if (gline.has_tag(LayerGCode::TAG_OVERHANG_FAN_START)) {
             line.type = CoolingLine::TYPE_OVERHANG_FAN_START;
-        } else if (boost::starts_with(sline, ";_OVERHANG_FAN_END")) {
+        } else if (gline.has_tag(LayerGCode::TAG_OVERHANG_FAN_END)) {
             line.type = CoolingLine::TYPE_OVERHANG_FAN_END;
-        } else if (boost::starts_with(sline, ";_INTERNAL_BRIDGE_FAN_START")) { // ORCA: Add support for separate internal bridge fan speed control
+        } else if (gline.has_tag(LayerGCode::TAG_INTERNAL_BRIDGE_FAN_START)) { // ORCA: Add support for separate internal bridge fan speed control
             line.type = CoolingLine::TYPE_INTERNAL_BRIDGE_FAN_START;
-        } else if (boost::starts_with(sline, ";_INTERNAL_BRIDGE_FAN_END")) { // ORCA: Add support for separate internal bridge fan speed control
+        } else if (gline.has_tag(LayerGCode::TAG_INTERNAL_BRIDGE_FAN_END)) { // ORCA: Add support for separate internal bridge fan speed control
             line.type = CoolingLine::TYPE_INTERNAL_BRIDGE_FAN_END;
-        } else if (boost::starts_with(sline, ";_SUPP_INTERFACE_FAN_START")) {
+        } else if (gline.has_tag(LayerGCode::TAG_SUPP_INTERFACE_FAN_START)) {
             line.type = CoolingLine::TYPE_SUPPORT_INTERFACE_FAN_START;
-        } else if (boost::starts_with(sline, ";_SUPP_INTERFACE_FAN_END")) {
+        } else if (gline.has_tag(LayerGCode::TAG_SUPP_INTERFACE_FAN_END)) {
             line.type = CoolingLine::TYPE_SUPPORT_INTERFACE_FAN_END;
-        } else if (boost::starts_with(sline, ";_IRONING_FAN_START")) { // ORCA: Add support for ironing fan speed control
+        } else if (gline.has_tag(LayerGCode::TAG_IRONING_FAN_START)) { // ORCA: Add support for ironing fan speed control
             line.type = CoolingLine::TYPE_IRONING_FAN_START;
-        } else if (boost::starts_with(sline, ";_IRONING_FAN_END")) { // ORCA: Add support for ironing fan speed control
+        } else if (gline.has_tag(LayerGCode::TAG_IRONING_FAN_END)) { // ORCA: Add support for ironing fan speed control
             line.type = CoolingLine::TYPE_IRONING_FAN_END;
-        } else if (boost::starts_with(sline, "G4 ")) {
+        } else if (gline.command == LayerGCode::Command::G4) {
             // Parse the wait time.
             line.type = CoolingLine::TYPE_G4;
             size_t pos_S = sline.find('S', 3);
             size_t pos_P = sline.find('P', 3);
             assert(is_decimal_separator_point()); // for atof
             line.time = line.time_max = float(
-                (pos_S > 0) ? atof(sline.c_str() + pos_S + 1) :
-                (pos_P > 0) ? atof(sline.c_str() + pos_P + 1) * 0.001 : 0.);
-        } else if (boost::starts_with(sline, ";_FORCE_RESUME_FAN_SPEED")) {
+                (pos_S > 0) ? atof(sline.data() + pos_S + 1) :
+                (pos_P > 0) ? atof(sline.data() + pos_P + 1) * 0.001 : 0.);
+        } else if (gline.has_tag(LayerGCode::TAG_FORCE_RESUME_FAN_SPEED)) {
             line.type = CoolingLine::TYPE_FORCE_RESUME_FAN;
         }
 
@@ -2,7 +2,9 @@
 #define slic3r_CoolingBuffer_hpp_
 
 #include "../libslic3r.h"
+#include "LayerGCode.hpp"
 #include <map>
+#include <memory>
 #include <string>
 #include <cfloat>
 
@@ -11,6 +13,7 @@ namespace Slic3r {
 class GCode;
 class Layer;
 struct PerExtruderAdjustments;
+struct CoolingLayerAdjustments;
 
 // A standalone G-code filter, to control cooling of the print.
 // The G-code is processed per layer. Once a layer is collected, fan start / stop commands are edited
@@ -23,24 +26,71 @@ struct PerExtruderAdjustments;
 //
 class CoolingBuffer {
 public:
+    // Effect of a layer on the position and on the extruder tracked by the cooling buffer from layer to layer.
+    // It does not depend on the position and on the extruder the layer starts with, thus it may be calculated for multiple layers in parallel.
+    struct LayerStateUpdate
+    {
+        // BBS: X,Y,Z,E,F,I,J
+        // Axis of the starting position the final value is taken from, shifted by offset, or -1 if the value is set by the layer.
+        int8_t          source[7] { 0, 1, 2, 3, 4, 5, 6 };
+        float           offset[7] { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+        // Extruder selected by the last tool change of the layer, -1 if the layer does not change the extruder.
+        int             extruder { -1 };
+    };
+
+    // Layer passing through the stages of the pipelined cooling buffer.
+    struct CollectedLayer
+    {
+        // G-code of the layer and of the preceding layers collected without flushing.
+        LayerGCode      gcode;
+        size_t          layer_id { 0 };
+        // False if the G-code was collected to be processed together with the following layers, then there is nothing to output.
+        bool            flush { false };
+        // Position and extruder the G-code starts with.
+        std::vector<float> start_pos;
+        unsigned int    start_extruder { 0 };
+        // Filled in by prepare_layer().
+        std::shared_ptr<CoolingLayerAdjustments> adjustments;
+        // Position the G-code ends with, tracked by prepare_layer() while parsing the G-code from start_pos.
+        std::vector<float> end_pos;
+    };
+
     CoolingBuffer(GCode &gcodegen);
     void        reset(const Vec3d &position);
-    void        set_current_extruder(unsigned int extruder_id) { m_current_extruder = extruder_id; }
+    void        set_current_extruder(unsigned int extruder_id) { m_current_extruder = extruder_id; m_collected_extruder = extruder_id; }
     std::string process_layer(std::string &&gcode, size_t layer_id, bool flush);
+    // Same as above, with the G-code already split into lines and decoded.
+    std::string process_layer(LayerGCode &&gcode, size_t layer_id, bool flush);
+
+    // process_layer() split into stages, so that parsing of the G-code and calculation of the slow down run in parallel
+    // and only the position, the extruder and the fan speeds are carried from layer to layer serially.
+    // layer_state_update() and prepare_layer() may be called for multiple layers in parallel,
+    // collect_layer() and apply_layer() shall be called in the order of the layers, each of them from a single thread at a time.
+    LayerStateUpdate layer_state_update(const LayerGCode &gcode) const;
+    // Collect the G-code until flush, assign the position and the extruder the collected G-code starts with.
+    CollectedLayer collect_layer(LayerGCode &&gcode, const LayerStateUpdate &update, size_t layer_id, bool flush);
+    // Parse the collected G-code and calculate the slow down.
+    void        prepare_layer(CollectedLayer &layer) const;
+    // Emit the fan speed changes and the slowed down feed rates.
+    std::string apply_layer(CollectedLayer &&layer);
 
 private:
 	CoolingBuffer& operator=(const CoolingBuffer&) = delete;
-    std::vector<PerExtruderAdjustments> parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos) const;
-    float       calculate_layer_slowdown(std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
+    std::vector<PerExtruderAdjustments> parse_layer_gcode(const LayerGCode &gcode, std::vector<float> &current_pos, unsigned int current_extruder) const;
+    static float calculate_layer_slowdown(std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
     // Apply slow down over G-code lines stored in per_extruder_adjustments, enable fan if needed.
     // Returns the adjusted G-code.
     std::string apply_layer_cooldown(const std::string &gcode, size_t layer_id, float layer_time, std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
 
     // G-code snippet cached for the support layers preceding an object layer.
-    std::string                 m_gcode;
+    LayerGCode                  m_gcode;
+    // Position and extruder m_gcode starts with.
+    std::vector<float>          m_gcode_start_pos;
+    unsigned int                m_gcode_start_extruder { 0 };
     // Internal data.
     // BBS: X,Y,Z,E,F,I,J
     std::vector<char>           m_axis;
+    // Position at the end of the G-code collected by collect_layer().
     std::vector<float>          m_current_pos;
     // Current known fan speed or -1 if not known yet.
     int                         m_fan_speed;
@@ -54,7 +104,10 @@ private:
     // Referencs GCode::m_config, which is FullPrintConfig. While the PrintObjectConfig slice of FullPrintConfig is being modified,
     // the PrintConfig slice of FullPrintConfig is constant, thus no thread synchronization is required.
     const PrintConfig          &m_config;
+    // Extruder at the end of the G-code emitted by apply_layer(), it drives the fan.
     unsigned int                m_current_extruder;
+    // Extruder at the end of the G-code collected by collect_layer(), ahead of m_current_extruder when pipelined.
+    unsigned int                m_collected_extruder { 0 };
     //BBS: current fan speed
     int                         m_current_fan_speed;
 };
@@ -764,6 +764,7 @@ class Print;
 
         GCodeProcessorResult m_result;
         static unsigned int s_result_id;
+        bool m_parallel_parsing{ true };
 
 #if ENABLE_GCODE_VIEWER_DATA_CHECKING
         DataChecker m_mm3_per_mm_compare{ "mm3_per_mm", 0.01f };
@@ -781,11 +782,16 @@ class Print;
             return m_time_processor.machines[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Stealth)].enabled;
         }
         void enable_machine_envelope_processing(bool enabled) { m_time_processor.machine_envelope_processing_enabled = enabled; }
+        // Tokenize the G-code and decode the axes in parallel in process_file(), the lines are still processed serially.
+        void enable_parallel_parsing(bool enabled) { m_parallel_parsing = enabled; }
+        bool is_parallel_parsing_enabled() const { return m_parallel_parsing; }
         void reset();
 
         const GCodeProcessorResult& get_result() const { return m_result; }
         GCodeProcessorResult& result() { return m_result; }
         GCodeProcessorResult&& extract_result() { return std::move(m_result); }
+        // Id for a result which was not produced by process_file() / initialize(), for example loaded from a file.
+        static unsigned int new_result_id() { return ++s_result_id; }
         DynamicConfig&              current_dynamic_config() { return m_current_config; }
 
 
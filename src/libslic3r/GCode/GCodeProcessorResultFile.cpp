@@ -0,0 +1,671 @@
+#include "GCodeProcessorResultFile.hpp"
+#include "libslic3r/Utils.hpp"
+
+#include <boost/log/trivial.hpp>
+#include <boost/format.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/uuid/detail/md5.hpp>
+
+#include <array>
+#include <cstring>
+#include <map>
+#include <type_traits>
+
+namespace Slic3r {
+
+namespace {
+
+// Increase whenever the layout of the file or the content of GCodeProcessorResult changes.
+constexpr const uint32_t RESULT_FILE_VERSION = 2;
+constexpr const char     RESULT_FILE_MAGIC[8] = { 'S', 'M', 'G', 'C', 'R', 'E', 'S', '\0' };
+
+// Column ids of the stored file, the order of the columns in the file.
+enum EResultColumn : size_t
+{
+    rcGCodeId,
+    rcType,
+    rcExtrusionRole,
+    rcExtruderId,
+    rcCpColorId,
+    rcMovePathType,
+    rcPosition,
+    rcArcCenterPosition,
+    rcDeltaExtruder,
+    rcFeedrate,
+    rcWidth,
+    rcHeight,
+    rcMm3PerMm,
+    rcTravelDist,
+    rcFanSpeed,
+    rcTemperature,
+    rcTime,
+    rcLayerDuration,
+    rcArcPointsBegin,
+    rcArcPoints,
+    rcLinesEnds,
+    rcCount
+};
+
+inline uint64_t align8(uint64_t offset) { return (offset + 7) & ~uint64_t(7); }
+
+} // namespace
+
+struct GCodeProcessorResultFileColumn
+{
+    uint64_t offset;
+    uint64_t count;
+    uint64_t element_size;
+};
+
+// The file is a local cache, thus it is stored in the native byte order.
+struct GCodeProcessorResultFileHeader
+{
+    char                           magic[8];
+    uint32_t                       version;
+    uint32_t                       columns_count;
+    uint64_t                       file_size;
+    // Source the result was created from.
+    uint64_t                       gcode_file_size;
+    // MD5 of the content of the G-code file. The modification time does not identify the content, the G-code
+    // extracted from a 3MF gets the 2 seconds resolution time stamp of its zip entry.
+    uint8_t                        gcode_file_md5[16];
+    double                         xy_offset[2];
+    uint64_t                       bbl_printer;
+    // Scalar and per extruder data.
+    uint64_t                       metadata_offset;
+    uint64_t                       metadata_size;
+    GCodeProcessorResultFileColumn columns[rcCount];
+};
+
+namespace {
+
+// Minimal binary archives for the non-column data of GCodeProcessorResult.
+// The struct specific serialize_xxx() functions are shared by the writer and the reader.
+template<class Ar, class T> void serialize_settings_ids(Ar &ar, T &ids) { ar(ids.print, ids.filament, ids.printer); }
+template<class Ar, class T> void serialize_custom_gcode_item(Ar &ar, T &item) { ar(item.print_z, item.type, item.extruder, item.color, item.extra); }
+template<class Ar, class T> void serialize_slice_warning(Ar &ar, T &warning) { ar(warning.level, warning.msg, warning.error_code, warning.params); }
+template<class Ar, class T> void serialize_bed_match_result(Ar &ar, T &bed_match) { ar(bed_match.match, bed_match.bed_type_name, bed_match.extruder_id); }
+template<class Ar, class T> void serialize_time_mode(Ar &ar, T &mode)
+{
+    ar(mode.time, mode.prepare_time, mode.custom_gcode_times, mode.moves_times, mode.roles_times, mode.layers_times);
+}
+template<class Ar, class T> void serialize_statistics(Ar &ar, T &stats)
+{
+    ar(stats.volumes_per_color_change, stats.model_volumes_per_extruder, stats.wipe_tower_volumes_per_extruder, stats.support_volumes_per_extruder,
+       stats.total_volumes_per_extruder, stats.flush_per_filament, stats.used_filaments_per_role, stats.modes, stats.total_filamentchanges);
+}
+template<class Ar, class T> void serialize_result(Ar &ar, T &result)
+{
+    ar(result.filename, result.printable_area, result.bed_exclude_area, result.toolpath_outside, result.label_object_enabled,
+       result.long_retraction_when_cut, result.timelapse_warning_code, result.support_traditional_timelapse, result.printable_height,
+       result.settings_ids, result.extruders_count, result.backtrace_enabled, result.extruder_colors, result.filament_diameters,
+       result.required_nozzle_HRC, result.filament_densities, result.filament_costs, result.filament_vitrification_temperature,
+       result.print_statistics, result.custom_gcode_per_print_z, result.spiral_vase_layers, result.warnings, result.nozzle_hrc,
+       result.nozzle_type, result.bed_type, result.bed_match_result);
+}
+
+class MetadataWriter
+{
+public:
+    explicit MetadataWriter(std::string &out) : m_out(out) {}
+
+    template<class... Ts> void operator()(const Ts &...args) { (this->write(args), ...); }
+
+private:
+    template<class T> std::enable_if_t<std::is_arithmetic<T>::value || std::is_enum<T>::value> write(const T &value)
+    {
+        m_out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+    void write(const std::string &str) { this->write(uint64_t(str.size())); m_out.append(str); }
+    void write(const Vec2d &pt) { this->write(pt.x()); this->write(pt.y()); }
+    template<class A, class B> void write(const std::pair<A, B> &pair) { this->write(pair.first); this->write(pair.second); }
+    template<class T, size_t N> void write(const std::array<T, N> &array) { for (const T &v : array) this->write(v); }
+    template<class T> void write(const std::vector<T> &vec)
+    {
+        this->write(uint64_t(vec.size()));
+        for (const T &v : vec)
+            this->write(v);
+    }
+    template<class K, class V> void write(const std::map<K, V> &map)
+    {
+        this->write(uint64_t(map.size()));
+        for (const auto &kvp : map)
+            this->write(kvp);
+    }
+    void write(const GCodeProcessorResult::SettingsIds &ids) { serialize_settings_ids(*this, ids); }
+    void write(const GCodeProcessorResult::SliceWarning &warning) { serialize_slice_warning(*this, warning); }
+    void write(const CustomGCode::Item &item) { serialize_custom_gcode_item(*this, item); }
+    void write(const BedMatchResult &bed_match) { serialize_bed_match_result(*this, bed_match); }
+    void write(const PrintEstimatedStatistics::Mode &mode) { serialize_time_mode(*this, mode); }
+    void write(const PrintEstimatedStatistics &stats) { serialize_statistics(*this, stats); }
+
+    std::string &m_out;
+};
+
+class MetadataReader
+{
+public:
+    MetadataReader(const char *data, size_t size) : m_ptr(data), m_end(data + size) {}
+
+    template<class... Ts> void operator()(Ts &...args) { (this->read(args), ...); }
+    // False if the data ended prematurely or contained invalid sizes.
+    bool ok() const { return m_ok; }
+
+private:
+    bool consume(void *dst, size_t size)
+    {
+        if (! m_ok || size_t(m_end - m_ptr) < size)
+            return m_ok = false;
+        memcpy(dst, m_ptr, size);
+        m_ptr += size;
+        return true;
+    }
+    // Element count of a container, rejects counts which cannot possibly fit into the remaining data.
+    size_t read_count()
+    {
+        uint64_t count = 0;
+        if (this->consume(&count, sizeof(count)) && count > uint64_t(m_end - m_ptr))
+            m_ok = false;
+        return m_ok ? size_t(count) : 0;
+    }
+
+    template<class T> std::enable_if_t<std::is_arithmetic<T>::value || std::is_enum<T>::value> read(T &value) { this->consume(&value, sizeof(T)); }
+    void read(bool &value)
+    {
+        unsigned char c = 0;
+        this->consume(&c, 1);
+        value = c != 0;
+    }
+    void read(std::string &str)
+    {
+        str.assign(this->read_count(), '\0');
+        if (! str.empty())
+            this->consume(&str.front(), str.size());
+    }
+    void read(Vec2d &pt) { this->read(pt.x()); this->read(pt.y()); }
+    template<class A, class B> void read(std::pair<A, B> &pair) { this->read(pair.first); this->read(pair.second); }
+    template<class T, size_t N> void read(std::array<T, N> &array) { for (T &v : array) this->read(v); }
+    template<class T> void read(std::vector<T> &vec)
+    {
+        vec.clear();
+        vec.resize(this->read_count());
+        for (T &v : vec)
+            this->read(v);
+    }
+    template<class K, class V> void read(std::map<K, V> &map)
+    {
+        map.clear();
+        for (size_t cnt = this->read_count(); cnt > 0 && m_ok; -- cnt) {
+            std::pair<K, V> kvp;
+            this->read(kvp);
+            map.emplace(std::move(kvp));
+        }
+    }
+    void read(GCodeProcessorResult::SettingsIds &ids) { serialize_settings_ids(*this, ids); }
+    void read(GCodeProcessorResult::SliceWarning &warning) { serialize_slice_warning(*this, warning); }
+    void read(CustomGCode::Item &item) { serialize_custom_gcode_item(*this, item); }
+    void read(BedMatchResult &bed_match) { serialize_bed_match_result(*this, bed_match); }
+    void read(PrintEstimatedStatistics::Mode &mode) { serialize_time_mode(*this, mode); }
+    void read(PrintEstimatedStatistics &stats) { serialize_statistics(*this, stats); }
+
+    const char *m_ptr;
+    const char *m_end;
+    bool        m_ok{ true };
+};
+
+struct ColumnData
+{
+    const void *data{ nullptr };
+    uint64_t    count{ 0 };
+    uint64_t    element_size{ 0 };
+};
+
+template<class T> ColumnData column_data(const std::vector<T> &vec) { return { vec.data(), vec.size(), sizeof(T) }; }
+
+// MD5 of the content of a G-code file, returns false if the file cannot be read.
+bool gcode_file_md5(const std::string &gcode_file, uint8_t (&digest)[16])
+{
+    using boost::uuids::detail::md5;
+    static_assert(sizeof(md5::digest_type) == sizeof(digest), "Unexpected size of the MD5 digest");
+    boost::nowide::ifstream ifs(gcode_file, std::ios::binary);
+    if (! ifs)
+        return false;
+    md5               md5_hash;
+    std::vector<char> buffer(1024 * 1024);
+    while (ifs) {
+        ifs.read(buffer.data(), std::streamsize(buffer.size()));
+        if (ifs.gcount() > 0)
+            md5_hash.process_bytes(buffer.data(), size_t(ifs.gcount()));
+    }
+    if (ifs.bad())
+        return false;
+    md5::digest_type md5_digest{};
+    md5_hash.get_digest(md5_digest);
+    memcpy(digest, &md5_digest, sizeof(digest));
+    return true;
+}
+
+// Fill in the source part of the header except for the digest of the G-code, returns false if the G-code file cannot be accessed.
+bool fill_source(GCodeProcessorResultFileHeader &header, const GCodeProcessorResultSource &source)
+{
+    boost::system::error_code ec;
+    const uintmax_t size = boost::filesystem::file_size(boost::filesystem::path(source.gcode_file), ec);
+    if (ec)
+        return false;
+    header.gcode_file_size  = uint64_t(size);
+    header.xy_offset[0]     = source.xy_offset.x();
+    header.xy_offset[1]     = source.xy_offset.y();
+    header.bbl_printer      = source.bbl_printer ? 1 : 0;
+    return true;
+}
+
+} // namespace
+
+void GCodeMovesColumns::clear()
+{
+    gcode_id.clear();
+    type.clear();
+    extrusion_role.clear();
+    extruder_id.clear();
+    cp_color_id.clear();
+    move_path_type.clear();
+    position.clear();
+    arc_center_position.clear();
+    delta_extruder.clear();
+    feedrate.clear();
+    width.clear();
+    height.clear();
+    mm3_per_mm.clear();
+    travel_dist.clear();
+    fan_speed.clear();
+    temperature.clear();
+    time.clear();
+    layer_duration.clear();
+    arc_points_begin.assign(1, 0);
+    arc_points.clear();
+}
+
+void GCodeMovesColumns::reserve(size_t moves_count)
+{
+    gcode_id.reserve(moves_count);
+    type.reserve(moves_count);
+    extrusion_role.reserve(moves_count);
+    extruder_id.reserve(moves_count);
+    cp_color_id.reserve(moves_count);
+    move_path_type.reserve(moves_count);
+    position.reserve(moves_count);
+    arc_center_position.reserve(moves_count);
+    delta_extruder.reserve(moves_count);
+    feedrate.reserve(moves_count);
+    width.reserve(moves_count);
+    height.reserve(moves_count);
+    mm3_per_mm.reserve(moves_count);
+    travel_dist.reserve(moves_count);
+    fan_speed.reserve(moves_count);
+    temperature.reserve(moves_count);
+    time.reserve(moves_count);
+    layer_duration.reserve(moves_count);
+    arc_points_begin.reserve(moves_count + 1);
+}
+
+void GCodeMovesColumns::append(const MoveVertex &move)
+{
+    gcode_id.emplace_back(move.gcode_id);
+    type.emplace_back(move.type);
+    extrusion_role.emplace_back(move.extrusion_role);
+    extruder_id.emplace_back(move.extruder_id);
+    cp_color_id.emplace_back(move.cp_color_id);
+    move_path_type.emplace_back(move.move_path_type);
+    position.emplace_back(move.position);
+    arc_center_position.emplace_back(move.arc_center_position);
+    delta_extruder.emplace_back(move.delta_extruder);
+    feedrate.emplace_back(move.feedrate);
+    width.emplace_back(move.width);
+    height.emplace_back(move.height);
+    mm3_per_mm.emplace_back(move.mm3_per_mm);
+    travel_dist.emplace_back(move.travel_dist);
+    fan_speed.emplace_back(move.fan_speed);
+    temperature.emplace_back(move.temperature);
+    time.emplace_back(move.time);
+    layer_duration.emplace_back(move.layer_duration);
+    arc_points.insert(arc_points.end(), move.interpolation_points.begin(), move.interpolation_points.end());
+    arc_points_begin.emplace_back(arc_points.size());
+}
+
+GCodeMovesColumnsView GCodeMovesColumns::view() const
+{
+    GCodeMovesColumnsView out;
+    out.count               = this->size();
+    out.gcode_id            = gcode_id.data();
+    out.type                = type.data();
+    out.extrusion_role      = extrusion_role.data();
+    out.extruder_id         = extruder_id.data();
+    out.cp_color_id         = cp_color_id.data();
+    out.move_path_type      = move_path_type.data();
+    out.position            = position.data();
+    out.arc_center_position = arc_center_position.data();
+    out.delta_extruder      = delta_extruder.data();
+    out.feedrate            = feedrate.data();
+    out.width               = width.data();
+    out.height              = height.data();
+    out.mm3_per_mm          = mm3_per_mm.data();
+    out.travel_dist         = travel_dist.data();
+    out.fan_speed           = fan_speed.data();
+    out.temperature         = temperature.data();
+    out.time                = time.data();
+    out.layer_duration      = layer_duration.data();
+    out.arc_points_begin    = arc_points_begin.data();
+    out.arc_points          = arc_points.data();
+    return out;
+}
+
+GCodeMovesColumns GCodeMovesColumns::from_moves(const std::vector<MoveVertex> &moves)
+{
+    GCodeMovesColumns out;
+    out.reserve(moves.size());
+    for (const MoveVertex &move : moves)
+        out.append(move);
+    return out;
+}
+
+GCodeMovesColumnsView::MoveVertex GCodeMovesColumnsView::vertex(size_t idx) const
+{
+    assert(idx < count);
+    MoveVertex move;
+    move.gcode_id            = gcode_id[idx];
+    move.type                = type[idx];
+    move.extrusion_role      = extrusion_role[idx];
+    move.extruder_id         = extruder_id[idx];
+    move.cp_color_id         = cp_color_id[idx];
+    move.move_path_type      = move_path_type[idx];
+    move.position            = position[idx];
+    move.arc_center_position = arc_center_position[idx];
+    move.delta_extruder      = delta_extruder[idx];
+    move.feedrate            = feedrate[idx];
+    move.width               = width[idx];
+    move.height              = height[idx];
+    move.mm3_per_mm          = mm3_per_mm[idx];
+    move.travel_dist         = travel_dist[idx];
+    move.fan_speed           = fan_speed[idx];
+    move.temperature         = temperature[idx];
+    move.time                = time[idx];
+    move.layer_duration      = layer_duration[idx];
+    move.interpolation_points.assign(arc_points + arc_points_begin[idx], arc_points + arc_points_begin[idx + 1]);
+    return move;
+}
+
+void GCodeMovesColumnsView::to_moves(std::vector<MoveVertex> &moves) const
+{
+    moves.clear();
+    moves.reserve(count);
+    for (size_t i = 0; i < count; ++ i)
+        moves.emplace_back(this->vertex(i));
+}
+
+MappedGCodeProcessorResult::MappedGCodeProcessorResult() = default;
+MappedGCodeProcessorResult::~MappedGCodeProcessorResult() = default;
+
+bool MappedGCodeProcessorResult::open(const std::string &path, const GCodeProcessorResultSource &source)
+{
+    this->close();
+
+    GCodeProcessorResultFileHeader expected;
+    if (! boost::filesystem::exists(path) || ! fill_source(expected, source))
+        return false;
+
+    try {
+        boost::interprocess::file_mapping mapping(path.c_str(), boost::interprocess::read_only);
+        m_region = std::make_unique<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << boost::format(": failed to map %1%: %2%") % path % ex.what();
+        m_region.reset();
+        return false;
+    }
+
+    const size_t size   = m_region->get_size();
+    const auto  *header = reinterpret_cast<const GCodeProcessorResultFileHeader *>(m_region->get_address());
+    bool valid = size >= sizeof(GCodeProcessorResultFileHeader) &&
+                 memcmp(header->magic, RESULT_FILE_MAGIC, sizeof(RESULT_FILE_MAGIC)) == 0 &&
+                 header->version == RESULT_FILE_VERSION &&
+                 header->columns_count == rcCount &&
+                 header->file_size == size &&
+                 header->metadata_offset + header->metadata_size <= size;
+    for (size_t col = 0; valid && col < rcCount; ++ col) {
+        const GCodeProcessorResultFileColumn &column = header->columns[col];
+        valid = column.offset % 8 == 0 && column.element_size > 0 && column.count <= size / column.element_size &&
+                column.offset + column.count * column.element_size <= size;
+    }
+    if (valid) {
+        // All the move columns have to have the same length, the arc table has to be consistent.
+        const uint64_t moves_count = header->columns[rcGCodeId].count;
+        for (size_t col = rcGCodeId; valid && col < rcArcPointsBegin; ++ col)
+            valid = header->columns[col].count == moves_count;
+        valid = valid && header->columns[rcArcPointsBegin].count == moves_count + 1;
+    }
+    if (! valid) {
+        BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << boost::format(": %1% is not a valid G-code processor result") % path;
+        this->close();
+        return false;
+    }
+    // The G-code is only hashed if the cheap checks pass.
+    if (header->gcode_file_size != expected.gcode_file_size ||
+        header->xy_offset[0] != expected.xy_offset[0] || header->xy_offset[1] != expected.xy_offset[1] ||
+        header->bbl_printer != expected.bbl_printer ||
+        ! gcode_file_md5(source.gcode_file, expected.gcode_file_md5) ||
+        memcmp(header->gcode_file_md5, expected.gcode_file_md5, sizeof(expected.gcode_file_md5)) != 0) {
+        BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": %1% is outdated") % path;
+        this->close();
+        return false;
+    }
+
+    m_header = header;
+    const uint64_t *arc_points_begin = this->column<uint64_t>(rcArcPointsBegin);
+    const size_t    moves_count      = this->moves_count();
+    bool            arcs_valid       = arc_points_begin[0] == 0 && arc_points_begin[moves_count] == m_header->columns[rcArcPoints].count;
+    for (size_t i = 0; arcs_valid && i < moves_count; ++ i)
+        arcs_valid = arc_points_begin[i] <= arc_points_begin[i + 1];
+    if (! arcs_valid) {
+        BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << boost::format(": %1% contains invalid arc data") % path;
+        this->close();
+        return false;
+    }
+    return true;
+}
+
+void MappedGCodeProcessorResult::close()
+{
+    m_header = nullptr;
+    m_region.reset();
+}
+
+bool MappedGCodeProcessorResult::bbl_printer() const
+{
+    return m_header != nullptr && m_header->bbl_printer != 0;
+}
+
+size_t MappedGCodeProcessorResult::moves_count() const
+{
+    return m_header ? size_t(m_header->columns[rcGCodeId].count) : 0;
+}
+
+size_t MappedGCodeProcessorResult::arc_points_count() const
+{
+    return m_header ? size_t(m_header->columns[rcArcPoints].count) : 0;
+}
+
+template<class T> const T* MappedGCodeProcessorResult::column(size_t col) const
+{
+    assert(m_header != nullptr && col < rcCount);
+    const GCodeProcessorResultFileColumn &column = m_header->columns[col];
+    return column.element_size == sizeof(T) ?
+        reinterpret_cast<const T *>(reinterpret_cast<const char *>(m_region->get_address()) + column.offset) : nullptr;
+}
+
+GCodeMovesColumnsView MappedGCodeProcessorResult::moves() const
+{
+    GCodeMovesColumnsView out;
+    if (m_header == nullptr)
+        return out;
+    out.count               = this->moves_count();
+    out.gcode_id            = this->column<unsigned int>(rcGCodeId);
+    out.type                = this->column<EMoveType>(rcType);
+    out.extrusion_role      = this->column<ExtrusionRole>(rcExtrusionRole);
+    out.extruder_id         = this->column<unsigned char>(rcExtruderId);
+    out.cp_color_id         = this->column<unsigned char>(rcCpColorId);
+    out.move_path_type      = this->column<EMovePathType>(rcMovePathType);
+    out.position            = this->column<Vec3f>(rcPosition);
+    out.arc_center_position = this->column<Vec3f>(rcArcCenterPosition);
+    out.delta_extruder      = this->column<float>(rcDeltaExtruder);
+    out.feedrate            = this->column<float>(rcFeedrate);
+    out.width               = this->column<float>(rcWidth);
+    out.height              = this->column<float>(rcHeight);
+    out.mm3_per_mm          = this->column<float>(rcMm3PerMm);
+    out.travel_dist         = this->column<float>(rcTravelDist);
+    out.fan_speed           = this->column<float>(rcFanSpeed);
+    out.temperature         = this->column<float>(rcTemperature);
+    out.time                = this->column<float>(rcTime);
+    out.layer_duration      = this->column<float>(rcLayerDuration);
+    out.arc_points_begin    = this->column<uint64_t>(rcArcPointsBegin);
+    out.arc_points          = this->column<Vec3f>(rcArcPoints);
+    return out;
+}
+
+const uint64_t* MappedGCodeProcessorResult::lines_ends() const
+{
+    return m_header ? this->column<uint64_t>(rcLinesEnds) : nullptr;
+}
+
+size_t MappedGCodeProcessorResult::lines_ends_count() const
+{
+    return m_header ? size_t(m_header->columns[rcLinesEnds].count) : 0;
+}
+
+bool MappedGCodeProcessorResult::load(GCodeProcessorResult &result) const
+{
+    if (m_header == nullptr)
+        return false;
+
+    const GCodeMovesColumnsView moves = this->moves();
+    // Element sizes are validated here, so that a file written by a build with different type sizes is rejected.
+    if (moves.gcode_id == nullptr || moves.type == nullptr || moves.extrusion_role == nullptr || moves.extruder_id == nullptr ||
+        moves.cp_color_id == nullptr || moves.move_path_type == nullptr || moves.position == nullptr || moves.arc_center_position == nullptr ||
+        moves.delta_extruder == nullptr || moves.feedrate == nullptr || moves.width == nullptr || moves.height == nullptr ||
+        moves.mm3_per_mm == nullptr || moves.travel_dist == nullptr || moves.fan_speed == nullptr || moves.temperature == nullptr ||
+        moves.time == nullptr || moves.layer_duration == nullptr || moves.arc_points_begin == nullptr || moves.arc_points == nullptr ||
+        this->lines_ends() == nullptr)
+        return false;
+
+    const char    *base = reinterpret_cast<const char *>(m_region->get_address());
+    MetadataReader reader(base + m_header->metadata_offset, size_t(m_header->metadata_size));
+    serialize_result(reader, result);
+    if (! reader.ok())
+        return false;
+
+    moves.to_moves(result.moves);
+    const uint64_t *lines_ends = this->lines_ends();
+    result.lines_ends.assign(lines_ends, lines_ends + this->lines_ends_count());
+    return true;
+}
+
+bool store_gcode_processor_result(const GCodeProcessorResult &result, const GCodeProcessorResultSource &source, const std::string &path)
+{
+    GCodeProcessorResultFileHeader header;
+    memset(&header, 0, sizeof(header));
+    if (! fill_source(header, source) || ! gcode_file_md5(source.gcode_file, header.gcode_file_md5))
+        return false;
+    memcpy(header.magic, RESULT_FILE_MAGIC, sizeof(RESULT_FILE_MAGIC));
+    header.version       = RESULT_FILE_VERSION;
+    header.columns_count = rcCount;
+
+    std::string metadata;
+    MetadataWriter writer(metadata);
+    serialize_result(writer, result);
+
+    const GCodeMovesColumns     moves = GCodeMovesColumns::from_moves(result.moves);
+    const std::vector<uint64_t> lines_ends(result.lines_ends.begin(), result.lines_ends.end());
+    const std::array<ColumnData, rcCount> columns {
+        column_data(moves.gcode_id),       column_data(moves.type),           column_data(moves.extrusion_role),
+        column_data(moves.extruder_id),    column_data(moves.cp_color_id),    column_data(moves.move_path_type),
+        column_data(moves.position),       column_data(moves.arc_center_position),
+        column_data(moves.delta_extruder), column_data(moves.feedrate),       column_data(moves.width),
+        column_data(moves.height),         column_data(moves.mm3_per_mm),     column_data(moves.travel_dist),
+        column_data(moves.fan_speed),      column_data(moves.temperature),    column_data(moves.time),
+        column_data(moves.layer_duration), column_data(moves.arc_points_begin), column_data(moves.arc_points),
+        column_data(lines_ends)
+    };
+
+    uint64_t offset = align8(sizeof(header));
+    header.metadata_offset = offset;
+    header.metadata_size   = metadata.size();
+    offset = align8(offset + metadata.size());
+    for (size_t col = 0; col < rcCount; ++ col) {
+        header.columns[col] = { offset, columns[col].count, columns[col].element_size };
+        offset = align8(offset + columns[col].count * columns[col].element_size);
+    }
+    header.file_size = offset;
+
+    const std::string tmp_path = path + ".tmp" + std::to_string(get_current_pid());
+    {
+        boost::nowide::ofstream out(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (! out.good()) {
+            BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << boost::format(": can not create %1%") % tmp_path;
+            return false;
+        }
+        uint64_t   written = 0;
+        const char padding[8] = {};
+        auto write_aligned = [&out, &written, &padding](const void *data, uint64_t size) {
+            out.write(reinterpret_cast<const char *>(data), std::streamsize(size));
+            written += size;
+            out.write(padding, std::streamsize(align8(written) - written));
+            written = align8(written);
+        };
+        write_aligned(&header, sizeof(header));
+        write_aligned(metadata.data(), metadata.size());
+        for (const ColumnData &column : columns)
+            write_aligned(column.data, column.count * column.element_size);
+        out.close();
+        if (out.fail() || written != header.file_size) {
+            BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << boost::format(": failed to write %1%") % tmp_path;
+            boost::system::error_code ec;
+            boost::filesystem::remove(tmp_path, ec);
+            return false;
+        }
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << boost::format(": failed to rename %1% to %2%: %3%") % tmp_path % path % ec.message();
+        boost::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": stored %1% moves to %2%") % result.moves.size() % path;
+    return true;
+}
+
+bool load_gcode_processor_result(const std::string &path, const GCodeProcessorResultSource &source, GCodeProcessorResult &result)
+{
+    MappedGCodeProcessorResult mapped;
+    if (! mapped.open(path, source))
+        return false;
+    if (! mapped.load(result)) {
+        BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << boost::format(": failed to load %1%") % path;
+        return false;
+    }
+    // The G-code may have been moved together with its result file.
+    result.filename = source.gcode_file;
+    // The viewer and the exporter read the reserved tags through the global flag, which processing would have set.
+    GCodeProcessor::s_IsBBLPrinter = mapped.bbl_printer();
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": loaded %1% moves from %2%") % result.moves.size() % path;
+    return true;
+}
+
+std::string gcode_processor_result_path(const std::string &gcode_file)
+{
+    return gcode_file + ".result";
+}
+
+} // namespace Slic3r
@@ -0,0 +1,148 @@
+#ifndef slic3r_GCodeProcessorResultFile_hpp_
+#define slic3r_GCodeProcessorResultFile_hpp_
+
+#include "libslic3r/GCode/GCodeProcessor.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace boost { namespace interprocess { class mapped_region; } }
+
+namespace Slic3r {
+
+struct GCodeProcessorResultFileHeader;
+
+// Binary image of a GCodeProcessorResult, stored next to a G-code file so that the G-code preview
+// can be restored without running GCodeProcessor::process_file() again.
+//
+// Layout: a fixed size header, a small block with the scalar / per extruder data of the result,
+// followed by the moves stored column wise (structure of arrays), each column 8 bytes aligned,
+// so that the file may be memory mapped and the columns accessed in place.
+// The interpolation points of arc moves are stored in a single side table indexed by arc_points_begin.
+
+// Read only view of moves stored as structure of arrays, see GCodeMovesColumns.
+struct GCodeMovesColumnsView
+{
+    using MoveVertex = GCodeProcessorResult::MoveVertex;
+
+    size_t               count{ 0 };
+    const unsigned int  *gcode_id{ nullptr };
+    const EMoveType     *type{ nullptr };
+    const ExtrusionRole *extrusion_role{ nullptr };
+    const unsigned char *extruder_id{ nullptr };
+    const unsigned char *cp_color_id{ nullptr };
+    const EMovePathType *move_path_type{ nullptr };
+    const Vec3f         *position{ nullptr };
+    const Vec3f         *arc_center_position{ nullptr };
+    const float         *delta_extruder{ nullptr };
+    const float         *feedrate{ nullptr };
+    const float         *width{ nullptr };
+    const float         *height{ nullptr };
+    const float         *mm3_per_mm{ nullptr };
+    const float         *travel_dist{ nullptr };
+    const float         *fan_speed{ nullptr };
+    const float         *temperature{ nullptr };
+    const float         *time{ nullptr };
+    const float         *layer_duration{ nullptr };
+    // count + 1 entries.
+    const uint64_t      *arc_points_begin{ nullptr };
+    const Vec3f         *arc_points{ nullptr };
+
+    size_t     size() const { return count; }
+    MoveVertex vertex(size_t idx) const;
+    void       to_moves(std::vector<MoveVertex> &moves) const;
+};
+
+// GCodeProcessorResult::moves stored as structure of arrays.
+struct GCodeMovesColumns
+{
+    using MoveVertex = GCodeProcessorResult::MoveVertex;
+
+    std::vector<unsigned int>   gcode_id;
+    std::vector<EMoveType>      type;
+    std::vector<ExtrusionRole>  extrusion_role;
+    std::vector<unsigned char>  extruder_id;
+    std::vector<unsigned char>  cp_color_id;
+    std::vector<EMovePathType>  move_path_type;
+    std::vector<Vec3f>          position;
+    std::vector<Vec3f>          arc_center_position;
+    std::vector<float>          delta_extruder;
+    std::vector<float>          feedrate;
+    std::vector<float>          width;
+    std::vector<float>          height;
+    std::vector<float>          mm3_per_mm;
+    std::vector<float>          travel_dist;
+    std::vector<float>          fan_speed;
+    std::vector<float>          temperature;
+    std::vector<float>          time;
+    std::vector<float>          layer_duration;
+    // Interpolation points of move i are arc_points[arc_points_begin[i], arc_points_begin[i + 1]).
+    std::vector<uint64_t>       arc_points_begin{ 0 };
+    std::vector<Vec3f>          arc_points;
+
+    size_t size() const { return gcode_id.size(); }
+    void   clear();
+    void   reserve(size_t moves_count);
+    void   append(const MoveVertex &move);
+
+    GCodeMovesColumnsView view() const;
+
+    static GCodeMovesColumns from_moves(const std::vector<MoveVertex> &moves);
+};
+
+// Identifies the G-code file and the processing parameters a stored result was created from.
+// A stored result is only reused if all of them match.
+struct GCodeProcessorResultSource
+{
+    std::string gcode_file;
+    Vec2d       xy_offset{ Vec2d::Zero() };
+    // GCodeProcessor::s_IsBBLPrinter the result was processed with, restored by load_gcode_processor_result().
+    bool        bbl_printer{ false };
+};
+
+// Read only, memory mapped view of a stored GCodeProcessorResult.
+class MappedGCodeProcessorResult
+{
+public:
+    MappedGCodeProcessorResult();
+    ~MappedGCodeProcessorResult();
+
+    // Returns false if the file does not exist, is corrupted, was written by an incompatible version
+    // or does not match the source (the G-code file was modified in the meantime).
+    bool open(const std::string &path, const GCodeProcessorResultSource &source);
+    void close();
+    bool is_open() const { return m_header != nullptr; }
+    // GCodeProcessor::s_IsBBLPrinter the stored result was processed with.
+    bool bbl_printer() const;
+
+    size_t moves_count() const;
+    size_t arc_points_count() const;
+
+    // Moves and line ends pointing directly into the mapped file, valid until close().
+    GCodeMovesColumnsView moves() const;
+    const uint64_t*       lines_ends() const;
+    size_t                lines_ends_count() const;
+
+    // Materialize the whole result, the moves included.
+    bool load(GCodeProcessorResult &result) const;
+
+private:
+    template<class T> const T* column(size_t col) const;
+
+    std::unique_ptr<boost::interprocess::mapped_region> m_region;
+    const GCodeProcessorResultFileHeader               *m_header{ nullptr };
+};
+
+// Write the result to path (via a temporary file, so that readers never see a partially written file).
+bool store_gcode_processor_result(const GCodeProcessorResult &result, const GCodeProcessorResultSource &source, const std::string &path);
+// Load the result stored by store_gcode_processor_result(), returns false if the stored data cannot be used.
+// On success GCodeProcessor::s_IsBBLPrinter is set to the value the result was processed with.
+bool load_gcode_processor_result(const std::string &path, const GCodeProcessorResultSource &source, GCodeProcessorResult &result);
+// Path of the stored result belonging to a G-code file.
+std::string gcode_processor_result_path(const std::string &gcode_file);
+
+} // namespace Slic3r
+
+#endif // slic3r_GCodeProcessorResultFile_hpp_
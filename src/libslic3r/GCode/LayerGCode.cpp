@@ -0,0 +1,171 @@
+#include "LayerGCode.hpp"
+
+#include "../GCodeScanner.hpp"
+#include "../LocalesUtils.hpp"
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace Slic3r {
+
+static inline bool is_whitespace(char c) { return c == ' ' || c == '\t'; }
+
+// A command is only recognized at the very start of a line and followed by a space, the same way CoolingBuffer
+// used to detect the moves with boost::starts_with(line, "G1 "). Thus "  G1 X1" or "G1" alone is not a move.
+static LayerGCode::Command decode_command(const char *line, const char *line_end, const char *&cmd_end)
+{
+    using Command = LayerGCode::Command;
+    cmd_end = line;
+    if (line == line_end || *line == ';')
+        return Command::None;
+    for (; cmd_end != line_end && ! is_whitespace(*cmd_end); ++ cmd_end) ;
+    if (cmd_end == line_end || *cmd_end != ' ')
+        return Command::Other;
+    const std::string_view cmd(line, cmd_end - line);
+    if (cmd.size() == 2 && cmd[0] == 'G') {
+        switch (cmd[1]) {
+        case '0': return Command::G0;
+        case '1': return Command::G1;
+        case '2': return Command::G2;
+        case '3': return Command::G3;
+        case '4': return Command::G4;
+        default: break;
+        }
+    } else if (cmd == "G92")
+        return Command::G92;
+    return Command::Other;
+}
+
+// Parse the axes of a move the way CoolingBuffer did before the G-code was decoded by LayerGCode:
+// words are separated by spaces or tabs, a word starting with ';' ends the line and the value is parsed by atof(),
+// thus "X1.5mm" is 1.5 and "X" alone is 0.
+static void decode_axes(const char *ptr, const char *line_end, LayerGCode::Line &line)
+{
+    // atof() needs a zero terminated string. The buffer is reused by the parallel decoding stages of each thread.
+    thread_local std::string buffer;
+    buffer.assign(ptr, line_end);
+    assert(is_decimal_separator_point()); // for atof
+    for (const char *c = buffer.c_str();;) {
+        // Skip whitespaces.
+        for (; is_whitespace(*c); ++ c) ;
+        if (*c == 0 || *c == ';')
+            break;
+        //BBS: X, Y, Z, E, F, I, J
+        const int axis = (*c >= 'X' && *c <= 'Z') ? (*c - 'X') :
+                         (*c == 'E') ? int(E) : (*c == 'F') ? int(F) :
+                         (*c == 'I') ? int(I) : (*c == 'J') ? int(J) : -1;
+        if (axis != -1) {
+            line.axes[axis] = float(atof(++ c));
+            line.axes_mask |= 1 << axis;
+        }
+        // Skip this word.
+        for (; ! is_whitespace(*c) && *c != 0; ++ c) ;
+    }
+}
+
+// Markers found anywhere in a line.
+static const std::pair<std::string_view, LayerGCode::Tag> contained_tags[] = {
+    { ";_EXTERNAL_PERIMETER",       LayerGCode::TAG_EXTERNAL_PERIMETER },
+    { ";_WIPE",                     LayerGCode::TAG_WIPE },
+    { ";_EXTRUDE_SET_SPEED",        LayerGCode::TAG_EXTRUDE_SET_SPEED },
+};
+
+// Markers found at the start of a line.
+static const std::pair<std::string_view, LayerGCode::Tag> line_tags[] = {
+    { ";_EXTRUDE_END",              LayerGCode::TAG_EXTRUDE_END },
+    { ";_OVERHANG_FAN_START",       LayerGCode::TAG_OVERHANG_FAN_START },
+    { ";_OVERHANG_FAN_END",         LayerGCode::TAG_OVERHANG_FAN_END },
+    { ";_INTERNAL_BRIDGE_FAN_START", LayerGCode::TAG_INTERNAL_BRIDGE_FAN_START },
+    { ";_INTERNAL_BRIDGE_FAN_END",  LayerGCode::TAG_INTERNAL_BRIDGE_FAN_END },
+    { ";_SUPP_INTERFACE_FAN_START", LayerGCode::TAG_SUPP_INTERFACE_FAN_START },
+    { ";_SUPP_INTERFACE_FAN_END",   LayerGCode::TAG_SUPP_INTERFACE_FAN_END },
+    { ";_IRONING_FAN_START",        LayerGCode::TAG_IRONING_FAN_START },
+    { ";_IRONING_FAN_END",          LayerGCode::TAG_IRONING_FAN_END },
+    { ";_FORCE_RESUME_FAN_SPEED",   LayerGCode::TAG_FORCE_RESUME_FAN_SPEED },
+};
+
+void LayerGCode::decode(size_t begin, size_t end)
+{
+    const char *data       = m_gcode.data();
+    const char *gcode_end  = data + m_gcode.size();
+    const char *decode_end = data + end;
+    // Rough estimate of the number of lines, G-code lines are mostly 20 to 40 characters long.
+    m_lines.reserve(m_lines.size() + (end - begin) / 24);
+    // The text is processed up to the first '\0' the same way the post-processing stages did when parsing the text.
+    for (const char *ptr = data + begin; ptr < decode_end && *ptr != 0;) {
+        const char *line_end = GCodeScanner::find_newline(ptr, gcode_end);
+        Line line {};
+        line.begin = ptr - data;
+        line.end   = line_end - data;
+        line.next  = line_end == gcode_end ? line.end : line.end + 1;
+
+        const char *cmd_end;
+        line.command = decode_command(ptr, line_end, cmd_end);
+        if (line.command != Command::None && line.command != Command::Other)
+            decode_axes(cmd_end, line_end, line);
+
+        if (memchr(ptr, ';', line_end - ptr) != nullptr) {
+            const std::string_view text(ptr, line_end - ptr);
+            if (*ptr == ';')
+                for (const auto &tag : line_tags)
+                    if (boost::starts_with(text, tag.first)) {
+                        line.tags |= tag.second;
+                        break;
+                    }
+            for (const auto &tag : contained_tags)
+                if (text.find(tag.first) != std::string_view::npos)
+                    line.tags |= tag.second;
+        }
+
+        m_lines.emplace_back(line);
+        ptr = data + line.next;
+    }
+}
+
+void LayerGCode::append(LayerGCode &&rhs)
+{
+    if (rhs.empty())
+        return;
+    if (m_gcode.empty()) {
+        *this = std::move(rhs);
+        return;
+    }
+    const size_t offset = m_gcode.size();
+    m_gcode += rhs.m_gcode;
+    if (m_lines.empty() || m_lines.back().next != offset) {
+        // Decoding stopped at a '\0', nothing after it is processed.
+        rhs.clear();
+        return;
+    }
+    size_t first = 0;
+    if (m_gcode[offset - 1] != '\n') {
+        // The last line continues in rhs, only the joined line is decoded again.
+        const size_t begin = m_lines.back().begin;
+        m_lines.pop_back();
+        this->decode(begin, rhs.m_lines.empty() ? m_gcode.size() : offset + rhs.m_lines.front().next);
+        first = 1;
+    }
+    // The other lines of rhs are still valid, only shifted.
+    m_lines.reserve(m_lines.size() + rhs.m_lines.size());
+    for (size_t i = first; i < rhs.m_lines.size(); ++ i) {
+        Line line = rhs.m_lines[i];
+        line.begin += offset;
+        line.end   += offset;
+        line.next  += offset;
+        m_lines.emplace_back(line);
+    }
+    rhs.clear();
+}
+
+std::string LayerGCode::release()
+{
+    std::string out = std::move(m_gcode);
+    this->clear();
+    return out;
+}
+
+} // namespace Slic3r
@@ -0,0 +1,96 @@
+#ifndef slic3r_GCode_LayerGCode_hpp_
+#define slic3r_GCode_LayerGCode_hpp_
+
+#include "../libslic3r.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Slic3r {
+
+// G-code of a layer split into lines, with the command, the axes and the markers of the post-processing stages decoded.
+// GCode::process_layers() builds it from the text emitted by GCode::process_layer() in a parallel stage of its pipeline,
+// thus CoolingBuffer does not need to tokenize the G-code of each layer again in its serial stage.
+// Only CoolingBuffer consumes the decoded lines. PressureEqualizer rewrites the text before it is decoded, FanMover
+// and AdaptivePAProcessor run on the text CoolingBuffer emits, thus all three still parse the text they receive.
+// Lines are classified exactly as CoolingBuffer did by matching the line start: "G1 X1" is a move, "  G1 X1",
+// "G1\tX1" or "G1" alone are not.
+class LayerGCode
+{
+public:
+    enum class Command : uint8_t {
+        // Empty line or a comment only.
+        None,
+        G0,
+        G1,
+        G2,
+        G3,
+        G4,
+        G92,
+        Other,
+    };
+
+    // Markers emitted by GCode for the post-processing stages.
+    enum Tag : uint32_t {
+        // Contained in the comment of a line.
+        TAG_EXTERNAL_PERIMETER          = 1 << 0,
+        TAG_WIPE                        = 1 << 1,
+        TAG_EXTRUDE_SET_SPEED           = 1 << 2,
+        // Starting a line.
+        TAG_EXTRUDE_END                 = 1 << 3,
+        TAG_OVERHANG_FAN_START          = 1 << 4,
+        TAG_OVERHANG_FAN_END            = 1 << 5,
+        TAG_INTERNAL_BRIDGE_FAN_START   = 1 << 6,
+        TAG_INTERNAL_BRIDGE_FAN_END     = 1 << 7,
+        TAG_SUPP_INTERFACE_FAN_START    = 1 << 8,
+        TAG_SUPP_INTERFACE_FAN_END      = 1 << 9,
+        TAG_IRONING_FAN_START           = 1 << 10,
+        TAG_IRONING_FAN_END             = 1 << 11,
+        TAG_FORCE_RESUME_FAN_SPEED      = 1 << 12,
+    };
+
+    struct Line
+    {
+        // The line occupies [begin, end) of the G-code without the trailing '\n', the next line starts at next.
+        size_t   begin;
+        size_t   end;
+        size_t   next;
+        Command  command;
+        // Combination of Tag.
+        uint32_t tags;
+        // X, Y, Z, E, F, I and J axes of a G0 to G3 or G92 line, decoded the way CoolingBuffer always parsed them.
+        uint32_t axes_mask;
+        float    axes[NUM_AXES];
+
+        bool     has(Axis axis) const { return (axes_mask & (1 << int(axis))) != 0; }
+        float    value(Axis axis) const { return axes[axis]; }
+        bool     has_tag(Tag tag) const { return (tags & tag) != 0; }
+    };
+
+    LayerGCode() = default;
+    explicit LayerGCode(std::string &&gcode) : m_gcode(std::move(gcode)) { this->decode(0, m_gcode.size()); }
+
+    const std::string&       gcode() const { return m_gcode; }
+    const std::vector<Line>& lines() const { return m_lines; }
+    std::string_view         text(const Line &line) const { return std::string_view(m_gcode.data() + line.begin, line.end - line.begin); }
+    bool                     empty() const { return m_gcode.empty(); }
+
+    // Append G-code of the following layer.
+    void                     append(LayerGCode &&rhs);
+    void                     clear() { m_gcode.clear(); m_lines.clear(); }
+    // Move the G-code out, leaving this object empty.
+    std::string              release();
+
+private:
+    // Decode the lines of m_gcode starting in [begin, end).
+    void                     decode(size_t begin, size_t end);
+
+    std::string              m_gcode;
+    std::vector<Line>        m_lines;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_GCode_LayerGCode_hpp_
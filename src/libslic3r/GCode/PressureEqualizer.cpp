@@ -8,6 +8,7 @@
 #include "../PrintConfig.hpp"
 #include "../LocalesUtils.hpp"
 #include "../GCode.hpp"
+#include "../GCodeScanner.hpp"
 
 #include "PressureEqualizer.hpp"
 #include "fast_float/fast_float.h"
@@ -91,11 +92,11 @@ void PressureEqualizer::process_layer(const std::string &gcode)
 {
     if (!gcode.empty()) {
         const char *gcode_begin = gcode.c_str();
+        const char *buffer_end  = gcode.c_str() + gcode.size();
         while (*gcode_begin != 0) {
             // Find end of the line.
-            const char *gcode_end = gcode_begin;
             // Slic3r always generates end of lines in a Unix style.
-            for (; *gcode_end != 0 && *gcode_end != '\n'; ++gcode_end);
+            const char *gcode_end = GCodeScanner::find_newline(gcode_begin, buffer_end);
 
             m_gcode_lines.emplace_back();
             if (!this->process_line(gcode_begin, gcode_end, m_gcode_lines.back())) {
@@ -8,12 +8,26 @@
 #include <iostream>
 #include <iomanip>
 #include "Utils.hpp"
+#include "GCodeScanner.hpp"
 
 #include "LocalesUtils.hpp"
 
 #include <Shiny/Shiny.h>
 #include <fast_float/fast_float.h>
 
+#include <atomic>
+#include <memory>
+
+#include <tbb/task_arena.h>
+#include <tbb/version.h>
+#if TBB_VERSION_MAJOR >= 2021
+#include <tbb/parallel_pipeline.h>
+using slic3r_tbb_filtermode = tbb::filter_mode;
+#else
+#include <tbb/pipeline.h>
+using slic3r_tbb_filtermode = tbb::filter;
+#endif
+
 namespace Slic3r {
 
 void GCodeReader::apply_config(const GCodeConfig &config)
@@ -31,69 +45,35 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
     PROFILE_FUNC();
 
     assert(is_decimal_separator_point());
-    
-    // command and args
-    const char *c = ptr;
-    {
-        PROFILE_BLOCK(command_and_args);
-        // Skip the whitespaces.
-        command.first = skip_whitespaces(c);
-        // Skip the command.
-        c = command.second = skip_word(command.first);
-        // Up to the end of line or comment.
-		while (! is_end_of_gcode_line(*c)) {
-            // Skip whitespaces.
-            c = skip_whitespaces(c);
-			if (is_end_of_gcode_line(*c))
-				break;
-            // Check the name of the axis.
-            Axis axis = NUM_AXES_WITH_UNKNOWN;
-            switch (*c) {
-            case 'X': axis = X; break;
-            case 'Y': axis = Y; break;
-            case 'Z': axis = Z; break;
-            case 'F': axis = F; break;
-            //BBS: add I and J axis
-            case 'I': axis = I; break;
-            case 'J': axis = J; break;
-            case 'E': axis = E; break;
-            case 'P': axis = P; break;
-            default:
-                if (*c >= 'A' && *c <= 'Z')
-                	// Unknown axis, but we still want to remember that such a axis was seen.
-                	axis = UNKNOWN_AXIS;
-                break;
-            }
-            if (axis != NUM_AXES_WITH_UNKNOWN) {
-                // Try to parse the numeric value.
-                double v;
-                auto [pend, ec] = fast_float::from_chars(++ c, end, v);
-                if (pend != c && is_end_of_word(*pend)) {
-                    // The axis value has been parsed correctly.
-                    if (axis != UNKNOWN_AXIS)
-	                    gline.m_axis[int(axis)] = float(v);
-                    gline.m_mask |= 1 << int(axis);
-                    c = pend;
-                } else
-                    // Skip the rest of the word.
-                    c = skip_word(c);
-            } else
-                // Skip the rest of the word.
-                c = skip_word(c);
-        }
-    }
-    
+
+    const char *c = decode_line(ptr, end, gline, command);
+
     if (gline.has(E) && m_config.use_relative_e_distances)
         m_position[E] = 0;
 
+    if (m_verbose)
+        std::cout << gline.m_raw << std::endl;
+
+    return c;
+}
+
+// Parse the command and the axes of a single line, does not depend on the state of the reader, thus it may be called in parallel.
+// fast_float::from_chars() does not depend on the locale.
+const char* GCodeReader::decode_line(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command)
+{
+    // Skip the whitespaces.
+    command.first = skip_whitespaces(ptr);
+    // Skip the command.
+    command.second = skip_word(command.first);
+    const char *c = decode_axes(command.second, end, gline.m_axis, gline.m_mask);
+
     // Skip the rest of the line.
-    for (; ! is_end_of_line(*c); ++ c);
+    if (c != end && *c == ';')
+        c = GCodeScanner::find_end_of_line(c, end);
 
     // Copy the raw string including the comment, without the trailing newlines.
-    if (c > ptr) {
-        PROFILE_BLOCK(copy_raw_string);
+    if (c > ptr)
         gline.m_raw.assign(ptr, c);
-    }
 
     // Skip the trailing newlines.
 	if (*c == '\r')
@@ -101,12 +81,45 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
 	if (*c == '\n')
 		++ c;
 
-    if (m_verbose)
-        std::cout << gline.m_raw << std::endl;
-
     return c;
 }
 
+const char* GCodeReader::decode_axes(const char *ptr, const char *end, float *axes, uint32_t &mask)
+{
+    // Words up to the end of line or comment, located by the vectorized scanner.
+    return GCodeScanner::for_each_word(ptr, end, [axes, &mask, end](const char *word) {
+        // Check the name of the axis.
+        Axis axis = NUM_AXES_WITH_UNKNOWN;
+        switch (*word) {
+        case 'X': axis = X; break;
+        case 'Y': axis = Y; break;
+        case 'Z': axis = Z; break;
+        case 'F': axis = F; break;
+        //BBS: add I and J axis
+        case 'I': axis = I; break;
+        case 'J': axis = J; break;
+        case 'E': axis = E; break;
+        case 'P': axis = P; break;
+        default:
+            if (*word >= 'A' && *word <= 'Z')
+                // Unknown axis, but we still want to remember that such a axis was seen.
+                axis = UNKNOWN_AXIS;
+            break;
+        }
+        if (axis != NUM_AXES_WITH_UNKNOWN) {
+            // Try to parse the numeric value.
+            double v;
+            auto [pend, ec] = fast_float::from_chars(word + 1, end, v);
+            if (pend != word + 1 && is_end_of_word(*pend)) {
+                // The axis value has been parsed correctly.
+                if (axis != UNKNOWN_AXIS)
+                    axes[int(axis)] = float(v);
+                mask |= 1 << int(axis);
+            }
+        }
+    });
+}
+
 void GCodeReader::update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command)
 {
     PROFILE_FUNC();
@@ -151,11 +164,9 @@ bool GCodeReader::parse_file_raw_internal(const std::string &filename, ParseLine
         auto it_bufend = buffer.begin() + cnt_read;
         while (it != it_bufend || (eof && ! gcode_line.empty())) {
             // Find end of line.
-            bool eol    = false;
-            auto it_end = it;
-            for (; it_end != it_bufend && ! (eol = *it_end == '\r' || *it_end == '\n'); ++ it_end)
-                if (*it_end == '\n')
-                    line_end_callback(file_pos + (it_end - buffer.begin()) + 1);
+            const char *line_begin = buffer.data() + (it - buffer.begin());
+            auto        it_end     = it + (GCodeScanner::find_line_break(line_begin, buffer.data() + cnt_read) - line_begin);
+            bool        eol        = it_end != it_bufend;
             // End of line is indicated also if end of file was reached.
             eol |= eof && it_end == it_bufend;
             if (eol) {
@@ -224,6 +235,150 @@ bool GCodeReader::parse_file(const std::string &file, callback_t callback, std::
     return ret;
 }
 
+bool GCodeReader::parse_file_parallel(const std::string &filename, callback_t callback, std::vector<size_t> &lines_ends)
+{
+    lines_ends.clear();
+    FilePtr in{ boost::nowide::fopen(filename.c_str(), "rb") };
+    if (in.f == nullptr) {
+        BOOST_LOG_TRIVIAL(error) << "GCodeReader::parse_file_parallel: failed to open file '" << filename << "'";
+        return false;
+    }
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(":  before parse_file %1%") % filename.c_str();
+
+    // A block of the file ending with a full line, together with its lines decoded.
+    struct Block
+    {
+        // Data of the block, zero terminated.
+        std::vector<char>                                  data;
+        size_t                                             data_end { 0 };
+        // Position of data[0] in the file.
+        size_t                                             file_pos { 0 };
+        std::vector<GCodeLine>                             lines;
+        std::vector<std::pair<const char*, const char*>>   commands;
+        // File position after the '\n' terminating the line, zero if the line was not terminated by '\n'.
+        std::vector<size_t>                                line_ends;
+    };
+    using BlockPtr = std::shared_ptr<Block>;
+
+    // Approximate size of a block, each token of the pipeline holds one block and its decoded lines.
+    static constexpr const size_t block_size = 1 << 20;
+    const size_t                  max_tokens = 2 * size_t(tbb::this_task_arena::max_concurrency()) + 2;
+
+    std::vector<char> carry;
+    size_t            file_pos    = 0;
+    bool              eof         = false;
+    bool              read_failed = false;
+    // Set by the serial consumer if the callback called quit_parsing(), the other filters only read it.
+    std::atomic<bool> stop_parsing { false };
+    m_parsing = true;
+
+    auto reader = tbb::make_filter<void, BlockPtr>(slic3r_tbb_filtermode::serial_in_order,
+        [&in, &carry, &file_pos, &eof, &read_failed, &stop_parsing](tbb::flow_control &fc) -> BlockPtr {
+            if (eof || stop_parsing) {
+                fc.stop();
+                return {};
+            }
+            BlockPtr block = std::make_shared<Block>();
+            block->data.swap(carry);
+            block->file_pos = file_pos;
+            size_t data_end = block->data.size();
+            // Read until there is at least one line end in the block, so that a block always ends with a full line.
+            for (;;) {
+                block->data.resize(data_end + block_size + 1);
+                const size_t cnt_read = ::fread(block->data.data() + data_end, 1, block_size, in.f);
+                if (::ferror(in.f)) {
+                    read_failed = true;
+                    fc.stop();
+                    return {};
+                }
+                const size_t search_begin = data_end;
+                data_end += cnt_read;
+                if (cnt_read < block_size) {
+                    eof = true;
+                    break;
+                }
+                auto it_last_eol = std::find(std::make_reverse_iterator(block->data.begin() + data_end), std::make_reverse_iterator(block->data.begin() + search_begin), '\n');
+                if (it_last_eol != std::make_reverse_iterator(block->data.begin() + search_begin)) {
+                    // Move the incomplete last line to the next block.
+                    auto it_next = it_last_eol.base();
+                    carry.assign(it_next, block->data.begin() + data_end);
+                    data_end = it_next - block->data.begin();
+                    break;
+                }
+            }
+            if (data_end == 0) {
+                fc.stop();
+                return {};
+            }
+            block->data.resize(data_end + 1);
+            block->data[data_end] = 0;
+            block->data_end = data_end;
+            file_pos += data_end;
+            return block;
+        });
+
+    auto decoder = tbb::make_filter<BlockPtr, BlockPtr>(slic3r_tbb_filtermode::parallel,
+        [&stop_parsing](BlockPtr block) -> BlockPtr {
+            if (! block || stop_parsing)
+                return block;
+            const char *data = block->data.data();
+            const char *end  = data + block->data_end;
+            // Rough estimate of the number of lines.
+            block->lines.reserve(block->data_end / 24);
+            block->commands.reserve(block->data_end / 24);
+            block->line_ends.reserve(block->data_end / 24);
+            for (const char *ptr = data; ptr < end;) {
+                // Lines are terminated by "\r\n", "\n" or "\r" the same way as in parse_file_raw_internal().
+                const char *eol = GCodeScanner::find_line_break(ptr, end);
+                block->lines.emplace_back();
+                block->commands.emplace_back();
+                // Skip the line number.
+                const char *begin = skip_whitespaces(ptr);
+                if (std::toupper(*begin) == 'N')
+                    begin = skip_whitespaces(skip_word(begin));
+                // Bounded by the end of the block rather than by the end of the line, so that the scanner may process full 64 byte blocks.
+                decode_line(begin, end, block->lines.back(), block->commands.back());
+                ptr = eol;
+                if (ptr != end && *ptr == '\r')
+                    ++ ptr;
+                size_t line_end = 0;
+                if (ptr != end && *ptr == '\n')
+                    line_end = block->file_pos + (++ ptr - data);
+                block->line_ends.emplace_back(line_end);
+            }
+            return block;
+        });
+
+    auto consumer = tbb::make_filter<BlockPtr, void>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &callback, &lines_ends, &stop_parsing](BlockPtr block) {
+            if (! block || stop_parsing)
+                return;
+            // The filter may be executed by any thread of the arena.
+            CNumericLocalesSetter locales_setter;
+            for (size_t i = 0; i < block->lines.size(); ++ i) {
+                GCodeLine &gline = block->lines[i];
+                if (gline.has(E) && m_config.use_relative_e_distances)
+                    m_position[E] = 0;
+                if (m_verbose)
+                    std::cout << gline.m_raw << std::endl;
+                callback(*this, gline);
+                this->update_coordinates(gline, block->commands[i]);
+                if (block->line_ends[i] != 0)
+                    lines_ends.emplace_back(block->line_ends[i]);
+                if (! m_parsing) {
+                    // The callback wishes to exit.
+                    stop_parsing = true;
+                    return;
+                }
+            }
+        });
+
+    tbb::parallel_pipeline(max_tokens, reader & decoder & consumer);
+
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(":  finished parse_file %1%") % filename.c_str();
+    return ! read_failed;
+}
+
 bool GCodeReader::parse_file_raw(const std::string &filename, raw_line_callback_t line_callback)
 {
     return this->parse_file_raw_internal(filename,
@@ -140,9 +140,17 @@ public:
     // Collect positions of line ends in the binary G-code to be used by the G-code viewer when memory mapping and displaying section of G-code
     // as an overlay in the 3D scene.
     bool parse_file(const std::string &file, callback_t callback, std::vector<size_t> &lines_ends);
+    // Same as above, but the file is read in blocks split at line boundaries and the lines of the blocks are tokenized and their axes
+    // decoded by multiple threads in parallel. The callback is still called serially in the order of the lines, thus it may accumulate state.
+    bool parse_file_parallel(const std::string &file, callback_t callback, std::vector<size_t> &lines_ends);
     // Just read the G-code file line by line, calls callback (const char *begin, const char *end). Returns false if reading the file failed.
     bool parse_file_raw(const std::string &file, raw_line_callback_t callback);
 
+    // Decode the axes of the words starting at ptr up to the end of the G-code part of the line into axes and mask, laid out as in GCodeLine.
+    // ptr shall point past the command. Returns the end of the G-code part of the line: the start of the comment, the line end or end.
+    // Does not depend on the state of the reader.
+    static const char* decode_axes(const char *ptr, const char *end, float *axes, uint32_t &mask);
+
     // To be called by the callback to stop parsing.
     void quit_parsing() { m_parsing = false; }
 
@@ -169,6 +177,7 @@ private:
     bool        parse_file_internal(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback);
 
     const char* parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command);
+    static const char* decode_line(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command);
     void        update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command);
 
     static bool         is_whitespace(char c)           { return c == ' ' || c == '\t'; }
@@ -0,0 +1,346 @@
+#include "GCodeScanner.hpp"
+
+#include <cassert>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define SLIC3R_GCODE_SCANNER_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        // MSVC allows the intrinsics of any instruction set without enabling it for the whole translation unit.
+        #define SLIC3R_TARGET(ISA)
+    #else
+        #define SLIC3R_TARGET(ISA) __attribute__((target(ISA)))
+    #endif
+#endif
+
+namespace Slic3r {
+namespace GCodeScanner {
+
+namespace {
+
+enum class CharSet
+{
+    // '\r', '\n', '\0'
+    EndOfLine,
+    // ';', '\r', '\n', '\0'
+    EndOfGCodeLine,
+    // '\r', '\n'
+    LineBreak,
+};
+
+template<CharSet Set> inline bool in_set(char c)
+{
+    switch (Set) {
+    case CharSet::EndOfLine:      return c == '\r' || c == '\n' || c == 0;
+    case CharSet::EndOfGCodeLine: return c == ';' || c == '\r' || c == '\n' || c == 0;
+    case CharSet::LineBreak:      return c == '\r' || c == '\n';
+    }
+    return false;
+}
+
+inline bool is_whitespace(char c) { return c == ' ' || c == '\t'; }
+
+inline unsigned int lowest_set_bit(uint32_t mask)
+{
+    assert(mask != 0);
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return (unsigned int)idx;
+#else
+    return (unsigned int)__builtin_ctz(mask);
+#endif
+}
+
+// Mask of the bits below the lowest set bit, all bits if mask is zero.
+inline uint32_t bits_below_lowest(uint32_t mask) { return mask ? (mask & (0u - mask)) - 1 : ~uint32_t(0); }
+
+template<CharSet Set> const char* find_first_scalar(const char *ptr, const char *end)
+{
+    for (; ptr != end && ! in_set<Set>(*ptr); ++ ptr) ;
+    return ptr;
+}
+
+// Also finishes find_words() of the vectorized implementations for the tail shorter than their block.
+size_t find_words_scalar(const char *ptr, const char *end, bool prev_whitespace, const char **words, size_t num_words, size_t max_words, const char *&stop)
+{
+    for (; ptr != end; ++ ptr) {
+        const char c = *ptr;
+        if (in_set<CharSet::EndOfGCodeLine>(c))
+            break;
+        const bool whitespace = is_whitespace(c);
+        if (! whitespace && prev_whitespace) {
+            if (num_words == max_words)
+                break;
+            words[num_words ++] = ptr;
+        }
+        prev_whitespace = whitespace;
+    }
+    stop = ptr;
+    return num_words;
+}
+
+// Portable implementation processing 8 characters at once in a 64 bit integer (SIMD within a register).
+// High bit set in each zero byte of x, exact (no false positives due to borrows).
+inline uint64_t swar_zero_bytes(uint64_t x)
+{
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    return ~(((x & low7) + low7) | x | low7);
+}
+inline uint64_t swar_equal(uint64_t x, char c) { return swar_zero_bytes(x ^ (0x0101010101010101ULL * uint8_t(c))); }
+// Gather the high bits of the 8 bytes into 8 bits, byte i to bit i.
+inline uint32_t swar_movemask(uint64_t high_bits) { return uint32_t(((high_bits >> 7) * 0x0102040810204080ULL) >> 56); }
+inline uint64_t swar_load(const char *ptr)
+{
+    uint64_t x;
+    memcpy(&x, ptr, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    // The first character to the lowest byte.
+    x = __builtin_bswap64(x);
+#endif
+    return x;
+}
+
+size_t find_words_scalar(const char *ptr, const char *end, const char **words, size_t max_words, const char *&stop)
+{
+    size_t   num_words       = 0;
+    uint32_t prev_whitespace = 1;
+    for (; end - ptr >= 8; ptr += 8) {
+        const uint64_t x          = swar_load(ptr);
+        const uint32_t whitespace = swar_movemask(swar_equal(x, ' ') | swar_equal(x, '\t'));
+        const uint32_t terminator = swar_movemask(swar_equal(x, ';') | swar_equal(x, '\r') | swar_equal(x, '\n') | swar_zero_bytes(x));
+        for (uint32_t starts = ~whitespace & 0xff & bits_below_lowest(terminator) & ((whitespace << 1) | prev_whitespace); starts != 0; starts &= starts - 1) {
+            if (num_words == max_words) {
+                stop = ptr + lowest_set_bit(starts);
+                return num_words;
+            }
+            words[num_words ++] = ptr + lowest_set_bit(starts);
+        }
+        if (terminator != 0) {
+            stop = ptr + lowest_set_bit(terminator);
+            return num_words;
+        }
+        prev_whitespace = whitespace >> 7;
+    }
+    return find_words_scalar(ptr, end, prev_whitespace != 0, words, num_words, max_words, stop);
+}
+
+#ifdef SLIC3R_GCODE_SCANNER_X86
+
+template<CharSet Set> SLIC3R_TARGET("sse4.2") uint32_t set_mask_sse42(__m128i data)
+{
+    constexpr const int mode = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK;
+    // Explicit length string compare, thus '\0' is a regular character of both the set and the data.
+    switch (Set) {
+    case CharSet::EndOfLine:
+        return uint32_t(_mm_cvtsi128_si32(_mm_cmpestrm(_mm_setr_epi8('\r', '\n', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), 3, data, 16, mode))) & 0xffff;
+    case CharSet::EndOfGCodeLine:
+        return uint32_t(_mm_cvtsi128_si32(_mm_cmpestrm(_mm_setr_epi8(';', '\r', '\n', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), 4, data, 16, mode))) & 0xffff;
+    case CharSet::LineBreak:
+        return uint32_t(_mm_cvtsi128_si32(_mm_cmpestrm(_mm_setr_epi8('\r', '\n', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), 2, data, 16, mode))) & 0xffff;
+    }
+    return 0;
+}
+
+template<CharSet Set> SLIC3R_TARGET("sse4.2") const char* find_first_sse42(const char *ptr, const char *end)
+{
+    for (; end - ptr >= 16; ptr += 16)
+        if (uint32_t mask = set_mask_sse42<Set>(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr))); mask != 0)
+            return ptr + lowest_set_bit(mask);
+    return find_first_scalar<Set>(ptr, end);
+}
+
+SLIC3R_TARGET("sse4.2") size_t find_words_sse42(const char *ptr, const char *end, const char **words, size_t max_words, const char *&stop)
+{
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab   = _mm_set1_epi8('\t');
+    size_t        num_words       = 0;
+    uint32_t      prev_whitespace = 1;
+    for (; end - ptr >= 16; ptr += 16) {
+        const __m128i  data       = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+        const uint32_t whitespace = uint32_t(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(data, space), _mm_cmpeq_epi8(data, tab))));
+        const uint32_t terminator = set_mask_sse42<CharSet::EndOfGCodeLine>(data);
+        for (uint32_t starts = ~whitespace & 0xffff & bits_below_lowest(terminator) & ((whitespace << 1) | prev_whitespace); starts != 0; starts &= starts - 1) {
+            if (num_words == max_words) {
+                stop = ptr + lowest_set_bit(starts);
+                return num_words;
+            }
+            words[num_words ++] = ptr + lowest_set_bit(starts);
+        }
+        if (terminator != 0) {
+            stop = ptr + lowest_set_bit(terminator);
+            return num_words;
+        }
+        prev_whitespace = whitespace >> 15;
+    }
+    return find_words_scalar(ptr, end, prev_whitespace != 0, words, num_words, max_words, stop);
+}
+
+template<CharSet Set> SLIC3R_TARGET("avx2") uint32_t set_mask_avx2(__m256i data)
+{
+    const __m256i cr = _mm256_cmpeq_epi8(data, _mm256_set1_epi8('\r'));
+    const __m256i lf = _mm256_cmpeq_epi8(data, _mm256_set1_epi8('\n'));
+    switch (Set) {
+    case CharSet::EndOfLine:
+        return uint32_t(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(cr, lf), _mm256_cmpeq_epi8(data, _mm256_setzero_si256()))));
+    case CharSet::EndOfGCodeLine:
+        return uint32_t(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(cr, lf),
+            _mm256_or_si256(_mm256_cmpeq_epi8(data, _mm256_setzero_si256()), _mm256_cmpeq_epi8(data, _mm256_set1_epi8(';'))))));
+    case CharSet::LineBreak:
+        return uint32_t(_mm256_movemask_epi8(_mm256_or_si256(cr, lf)));
+    }
+    return 0;
+}
+
+template<CharSet Set> SLIC3R_TARGET("avx2") const char* find_first_avx2(const char *ptr, const char *end)
+{
+    for (; end - ptr >= 32; ptr += 32)
+        if (uint32_t mask = set_mask_avx2<Set>(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr))); mask != 0)
+            return ptr + lowest_set_bit(mask);
+    return find_first_scalar<Set>(ptr, end);
+}
+
+SLIC3R_TARGET("avx2") size_t find_words_avx2(const char *ptr, const char *end, const char **words, size_t max_words, const char *&stop)
+{
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab   = _mm256_set1_epi8('\t');
+    size_t        num_words       = 0;
+    uint32_t      prev_whitespace = 1;
+    for (; end - ptr >= 32; ptr += 32) {
+        const __m256i  data       = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+        const uint32_t whitespace = uint32_t(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(data, space), _mm256_cmpeq_epi8(data, tab))));
+        const uint32_t terminator = set_mask_avx2<CharSet::EndOfGCodeLine>(data);
+        for (uint32_t starts = ~whitespace & bits_below_lowest(terminator) & ((whitespace << 1) | prev_whitespace); starts != 0; starts &= starts - 1) {
+            if (num_words == max_words) {
+                stop = ptr + lowest_set_bit(starts);
+                return num_words;
+            }
+            words[num_words ++] = ptr + lowest_set_bit(starts);
+        }
+        if (terminator != 0) {
+            stop = ptr + lowest_set_bit(terminator);
+            return num_words;
+        }
+        prev_whitespace = whitespace >> 31;
+    }
+    return find_words_scalar(ptr, end, prev_whitespace != 0, words, num_words, max_words, stop);
+}
+
+bool cpu_supports(ISA isa)
+{
+    #if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        const int max_id = info[0];
+        __cpuid(info, 1);
+        const bool sse42   = (info[2] & (1 << 20)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx     = (info[2] & (1 << 28)) != 0;
+        bool       avx2    = false;
+        // AVX2 requires the operating system to save the YMM registers.
+        if (max_id >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+    #else
+        // Checks the support by the operating system (XSAVE) as well.
+        __builtin_cpu_init();
+        const bool sse42 = __builtin_cpu_supports("sse4.2");
+        const bool avx2  = __builtin_cpu_supports("avx2");
+    #endif
+    switch (isa) {
+    case ISA::Scalar: return true;
+    case ISA::SSE42:  return sse42;
+    case ISA::AVX2:   return avx2;
+    }
+    return false;
+}
+
+#else
+
+bool cpu_supports(ISA isa) { return isa == ISA::Scalar; }
+
+#endif // SLIC3R_GCODE_SCANNER_X86
+
+struct Implementation
+{
+    ISA           isa;
+    const char* (*find_end_of_line)(const char*, const char*);
+    const char* (*find_end_of_gcode_line)(const char*, const char*);
+    const char* (*find_line_break)(const char*, const char*);
+    size_t      (*find_words)(const char*, const char*, const char**, size_t, const char*&);
+};
+
+Implementation make_implementation(ISA isa)
+{
+    switch (isa) {
+#ifdef SLIC3R_GCODE_SCANNER_X86
+    case ISA::AVX2:
+        return { isa, find_first_avx2<CharSet::EndOfLine>, find_first_avx2<CharSet::EndOfGCodeLine>, find_first_avx2<CharSet::LineBreak>, find_words_avx2 };
+    case ISA::SSE42:
+        return { isa, find_first_sse42<CharSet::EndOfLine>, find_first_sse42<CharSet::EndOfGCodeLine>, find_first_sse42<CharSet::LineBreak>, find_words_sse42 };
+#endif // SLIC3R_GCODE_SCANNER_X86
+    default:
+        return { ISA::Scalar, find_first_scalar<CharSet::EndOfLine>, find_first_scalar<CharSet::EndOfGCodeLine>, find_first_scalar<CharSet::LineBreak>, find_words_scalar };
+    }
+}
+
+Implementation& implementation()
+{
+    static Implementation impl = make_implementation(best_supported_isa());
+    return impl;
+}
+
+} // namespace
+
+ISA best_supported_isa()
+{
+    static const ISA best = cpu_supports(ISA::AVX2) ? ISA::AVX2 : cpu_supports(ISA::SSE42) ? ISA::SSE42 : ISA::Scalar;
+    return best;
+}
+
+ISA active_isa()
+{
+    return implementation().isa;
+}
+
+ISA set_isa(ISA isa)
+{
+    implementation() = make_implementation(cpu_supports(isa) ? isa : best_supported_isa());
+    return implementation().isa;
+}
+
+const char* isa_name(ISA isa)
+{
+    switch (isa) {
+    case ISA::Scalar: return "scalar";
+    case ISA::SSE42:  return "SSE4.2";
+    case ISA::AVX2:   return "AVX2";
+    }
+    return "unknown";
+}
+
+const char* find_end_of_line(const char *ptr, const char *end)
+{
+    return implementation().find_end_of_line(ptr, end);
+}
+
+const char* find_end_of_gcode_line(const char *ptr, const char *end)
+{
+    return implementation().find_end_of_gcode_line(ptr, end);
+}
+
+const char* find_line_break(const char *ptr, const char *end)
+{
+    return implementation().find_line_break(ptr, end);
+}
+
+size_t find_words(const char *ptr, const char *end, const char **words, size_t max_words, const char *&stop)
+{
+    return implementation().find_words(ptr, end, words, max_words, stop);
+}
+
+} // namespace GCodeScanner
+} // namespace Slic3r
@@ -0,0 +1,73 @@
+#ifndef slic3r_GCodeScanner_hpp_
+#define slic3r_GCodeScanner_hpp_
+
+#include <cstddef>
+#include <cstring>
+
+namespace Slic3r {
+
+// Vectorized scanning of G-code text for the G-code parsers (GCodeReader, CoolingBuffer, PressureEqualizer ...).
+// The text is processed in blocks of 32 (AVX2) or 16 (SSE4.2) characters, the implementation is selected at runtime
+// based on the capabilities of the CPU, with a portable fallback processing 8 characters per step. None of the functions reads past the end pointer.
+namespace GCodeScanner {
+
+enum class ISA : unsigned char
+{
+    Scalar,
+    SSE42,
+    AVX2,
+};
+
+// Instruction set used by the functions below.
+ISA         active_isa();
+// The best instruction set supported by the CPU.
+ISA         best_supported_isa();
+// Select the implementation, for testing and benchmarking, not thread safe.
+// Falls back to the best supported instruction set if isa is not supported, returns the instruction set active after the call.
+ISA         set_isa(ISA isa);
+const char* isa_name(ISA isa);
+
+// First '\r', '\n' or '\0' in [ptr, end), end if there is none.
+const char* find_end_of_line(const char *ptr, const char *end);
+// First ';', '\r', '\n' or '\0' in [ptr, end), end if there is none.
+const char* find_end_of_gcode_line(const char *ptr, const char *end);
+// First '\r' or '\n' in [ptr, end), end if there is none. '\0' is considered a regular character.
+const char* find_line_break(const char *ptr, const char *end);
+// First '\n' in [ptr, end), end if there is none. The C library implementation of memchr() is vectorized already.
+inline const char* find_newline(const char *ptr, const char *end)
+{
+    const void *p = ptr < end ? memchr(ptr, '\n', size_t(end - ptr)) : nullptr;
+    return p ? static_cast<const char*>(p) : end;
+}
+
+inline bool is_end_of_gcode_line(char c) { return c == ';' || c == '\r' || c == '\n' || c == 0; }
+
+// Store the starts of the whitespace (' ', '\t') separated words of the G-code part of the line starting at ptr into words,
+// the G-code part ends with the first ';', '\r', '\n' or '\0'. The character before ptr is considered to be a whitespace.
+// Returns the number of words stored. stop is set to the end of the G-code part of the line (end if there is no terminator),
+// or to the start of the first word not stored if there are more than max_words words.
+size_t find_words(const char *ptr, const char *end, const char **words, size_t max_words, const char *&stop);
+
+// Call fn(const char *word) for the start of each word of the G-code part of the line starting at ptr, see find_words().
+// Returns the end of the G-code part of the line, end if there is no terminator in [ptr, end).
+template<typename Fn>
+inline const char* for_each_word(const char *ptr, const char *end, Fn &&fn)
+{
+    static constexpr const size_t max_words = 16;
+    const char *words[max_words];
+    for (;;) {
+        const char  *stop = nullptr;
+        const size_t n    = find_words(ptr, end, words, max_words, stop);
+        for (size_t i = 0; i < n; ++ i)
+            fn(words[i]);
+        if (n < max_words || stop == end || is_end_of_gcode_line(*stop))
+            return stop;
+        // More words than fit into the buffer, continue with the first word not reported yet.
+        ptr = stop;
+    }
+}
+
+} // namespace GCodeScanner
+} // namespace Slic3r
+
+#endif // slic3r_GCodeScanner_hpp_
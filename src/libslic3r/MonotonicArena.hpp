@@ -0,0 +1,127 @@
+#ifndef slic3r_MonotonicArena_hpp_
+#define slic3r_MonotonicArena_hpp_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace Slic3r {
+
+// Bump allocator for the temporaries of a single thread. Memory returned to the arena is not reused individually
+// (with the exception of the last allocation), all of it is made available again by reset() and freed by release() or the destructor.
+// Not thread safe, use one arena per thread, for example a tbb::enumerable_thread_specific<MonotonicArena>.
+class MonotonicArena
+{
+public:
+    explicit MonotonicArena(size_t block_size = 64 * 1024) : m_block_size(block_size) {}
+    MonotonicArena(const MonotonicArena &) = delete;
+    MonotonicArena& operator=(const MonotonicArena &) = delete;
+    ~MonotonicArena() = default;
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t))
+    {
+        assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+        uintptr_t ptr = align(m_ptr, alignment);
+        if (m_blocks.empty() || ptr + bytes > m_end) {
+            this->add_block(bytes + alignment);
+            ptr = align(m_ptr, alignment);
+        }
+        m_ptr = ptr + bytes;
+        return reinterpret_cast<void*>(ptr);
+    }
+
+    // Only the last allocation is returned to the arena, so that a temporary allocated and freed right away does not waste memory.
+    void deallocate(void *ptr, size_t bytes) noexcept
+    {
+        if (reinterpret_cast<uintptr_t>(ptr) + bytes == m_ptr)
+            m_ptr = reinterpret_cast<uintptr_t>(ptr);
+    }
+
+    // Make all the memory available again. The blocks are merged into a single block large enough to serve
+    // the same allocations again without allocating, thus an arena reset after each task soon stops calling the system allocator.
+    void reset()
+    {
+        if (m_blocks.size() > 1) {
+            const size_t size = this->capacity();
+            m_blocks.clear();
+            this->add_block(size);
+        } else if (! m_blocks.empty()) {
+            m_ptr = reinterpret_cast<uintptr_t>(m_blocks.front().data.get());
+        }
+    }
+
+    // Free all the memory.
+    void release() { m_blocks.clear(); m_ptr = 0; m_end = 0; }
+
+    // Total size of the blocks allocated from the system.
+    size_t capacity() const
+    {
+        size_t size = 0;
+        for (const Block &block : m_blocks)
+            size += block.size;
+        return size;
+    }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        size_t                  size;
+    };
+
+    static uintptr_t align(uintptr_t ptr, size_t alignment) { return (ptr + alignment - 1) & ~uintptr_t(alignment - 1); }
+
+    void add_block(size_t min_size)
+    {
+        // Grow the blocks geometrically, so that the number of blocks stays logarithmic.
+        size_t size = std::max(m_block_size, m_blocks.empty() ? size_t(0) : m_blocks.back().size * 2);
+        size = std::max(size, min_size);
+        m_blocks.push_back({ std::unique_ptr<char[]>(new char[size]), size });
+        m_ptr = reinterpret_cast<uintptr_t>(m_blocks.back().data.get());
+        m_end = m_ptr + size;
+    }
+
+    size_t             m_block_size;
+    std::vector<Block> m_blocks;
+    // Free space of the last block.
+    uintptr_t          m_ptr { 0 };
+    uintptr_t          m_end { 0 };
+};
+
+// STL allocator allocating from a MonotonicArena.
+template<typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(MonotonicArena &arena) noexcept : m_arena(&arena) {}
+    template<typename U> ArenaAllocator(const ArenaAllocator<U> &rhs) noexcept : m_arena(rhs.arena()) {}
+
+    T* allocate(size_t n)
+    {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *ptr, size_t n) noexcept { m_arena->deallocate(ptr, n * sizeof(T)); }
+
+    MonotonicArena* arena() const noexcept { return m_arena; }
+
+    template<typename U> bool operator==(const ArenaAllocator<U> &rhs) const noexcept { return m_arena == rhs.arena(); }
+    template<typename U> bool operator!=(const ArenaAllocator<U> &rhs) const noexcept { return m_arena != rhs.arena(); }
+
+private:
+    MonotonicArena *m_arena;
+};
+
+template<typename T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace Slic3r
+
+#endif // slic3r_MonotonicArena_hpp_
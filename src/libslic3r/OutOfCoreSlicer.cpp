@@ -0,0 +1,771 @@
+#include "OutOfCoreSlicer.hpp"
+#include "Exception.hpp"
+#include "miniz_extension.hpp"
+#include "TriangleMesh.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <type_traits>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/format.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/cstdio.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include <ankerl/unordered_dense.h>
+#include <expat.h>
+#include <fast_float/fast_float.h>
+
+namespace Slic3r {
+
+TriangleStream stl_triangle_stream(const std::string &path)
+{
+    return [path](const TriangleVisitor &visitor) {
+        boost::system::error_code ec;
+        const uintmax_t file_size = boost::filesystem::file_size(path, ec);
+        if (ec)
+            throw Slic3r::FileIOError("Cannot read STL file " + path);
+
+        FILE *file = boost::nowide::fopen(path.c_str(), "rb");
+        if (file == nullptr)
+            throw Slic3r::FileIOError("Cannot open STL file " + path);
+        std::unique_ptr<FILE, int(*)(FILE*)> file_closer(file, fclose);
+
+        // Binary or ASCII, tested the way admesh does: a binary STL of the exact size announced by its header is binary
+        // even if its header starts with "solid", as some exporters write. Otherwise an STL starting with "solid" and containing
+        // no bytes above 127 after the binary header is ASCII. Anything else is binary, possibly with trailing data
+        // or with a wrong number of facets in its header.
+        char     header[80];
+        uint32_t num_facets = 0;
+        bool     binary     = false;
+        if (file_size >= 84 && fread(header, 1, 80, file) == 80 && fread(&num_facets, 4, 1, file) == 1) {
+            binary = file_size == 84 + 50 * uintmax_t(num_facets);
+            if (! binary) {
+                unsigned char chtest[128];
+                const size_t  num_test = fread(chtest, 1, sizeof(chtest), file);
+                binary = strncmp(header, "solid", 5) != 0 || std::any_of(chtest, chtest + num_test, [](unsigned char c) { return c > 127; });
+                if (binary) {
+                    const uintmax_t num_facets_by_size = (file_size - 84) / 50;
+                    if (num_facets == 0 || num_facets > num_facets_by_size) {
+                        // Some exporters leave the number of facets zero.
+                        BOOST_LOG_TRIVIAL(warning) << "STL file " << path << " does not match the number of facets in its header";
+                        num_facets = uint32_t(std::min<uintmax_t>(num_facets_by_size, std::numeric_limits<uint32_t>::max()));
+                    }
+                    if (fseek(file, 84, SEEK_SET) != 0)
+                        throw Slic3r::FileIOError("Cannot read STL file " + path);
+                }
+            }
+        }
+        if (binary) {
+            // Binary STL: 50 bytes per facet, the normal, three vertices and the attribute byte count.
+            constexpr size_t facets_per_chunk = 4096;
+            std::vector<char> chunk(50 * facets_per_chunk);
+            stl_vertex        triangle[3];
+            for (uint32_t facet_idx = 0; facet_idx < num_facets;) {
+                const size_t num = std::min<size_t>(facets_per_chunk, num_facets - facet_idx);
+                if (fread(chunk.data(), 50, num, file) != num)
+                    throw Slic3r::FileIOError("Truncated STL file " + path);
+                for (size_t i = 0; i < num; ++ i) {
+                    ::memcpy(triangle, chunk.data() + 50 * i + 12, sizeof(triangle));
+                    visitor(triangle);
+                }
+                facet_idx += uint32_t(num);
+            }
+            return;
+        }
+
+        // ASCII STL, only the vertices are of interest.
+        file_closer.reset();
+        boost::nowide::ifstream in(path);
+        std::string token;
+        if (! in || ! (in >> token) || token != "solid")
+            throw Slic3r::FileIOError("Not an STL file " + path);
+        stl_vertex triangle[3];
+        size_t     num_vertices = 0;
+        while (in >> token) {
+            if (token != "vertex")
+                continue;
+            stl_vertex &v = triangle[num_vertices];
+            for (size_t i = 0; i < 3; ++ i) {
+                if (! (in >> token) || fast_float::from_chars(token.data(), token.data() + token.size(), v(i)).ec != std::errc())
+                    throw Slic3r::FileIOError("Invalid vertex in STL file " + path);
+            }
+            if (++ num_vertices == 3) {
+                visitor(triangle);
+                num_vertices = 0;
+            }
+        }
+    };
+}
+
+namespace ThreeMFStreaming {
+
+static const char* attribute(const char **attributes, const char *key)
+{
+    for (; *attributes != nullptr; attributes += 2)
+        if (::strcmp(attributes[0], key) == 0)
+            return attributes[1];
+    return nullptr;
+}
+
+static float attribute_float(const char **attributes, const char *key)
+{
+    float value = 0.f;
+    if (const char *text = attribute(attributes, key); text != nullptr)
+        fast_float::from_chars(text, text + strlen(text), value);
+    return value;
+}
+
+static long attribute_index(const char **attributes, const char *key)
+{
+    const char *text = attribute(attributes, key);
+    return text == nullptr ? -1 : std::strtol(text, nullptr, 10);
+}
+
+static float get_unit_factor(const char *unit)
+{
+    if (unit == nullptr)                          return 1.f;
+    else if (::strcmp(unit, "micron") == 0)       return 0.001f;
+    else if (::strcmp(unit, "centimeter") == 0)   return 10.f;
+    else if (::strcmp(unit, "inch") == 0)         return 25.4f;
+    else if (::strcmp(unit, "foot") == 0)         return 304.8f;
+    else if (::strcmp(unit, "meter") == 0)        return 1000.f;
+    // default "millimeter" (see specification)
+    return 1.f;
+}
+
+// Path of a model file inside the archive, as referenced by the p:path attribute of the production extension.
+static std::string zip_path(const char *path)
+{
+    std::string out(path == nullptr ? "" : path);
+    if (! out.empty() && out.front() == '/')
+        out.erase(out.begin());
+    return out;
+}
+
+// Transformation stored as 4x3 matrix, row by row, the points being row vectors (see the 3MF core specification).
+static Transform3d attribute_transform(const char **attributes)
+{
+    Transform3d out = Transform3d::Identity();
+    const char *text = attribute(attributes, "transform");
+    if (text == nullptr)
+        return out;
+    double      values[12];
+    const char *end = text + strlen(text);
+    for (size_t i = 0; i < 12; ++ i) {
+        while (text != end && ::isspace(static_cast<unsigned char>(*text)))
+            ++ text;
+        fast_float::from_chars_result res = fast_float::from_chars(text, end, values[i]);
+        if (res.ec != std::errc())
+            // Invalid transformation, identity as the 3MF loader does.
+            return Transform3d::Identity();
+        text = res.ptr;
+    }
+    for (size_t c = 0; c < 4; ++ c)
+        for (size_t r = 0; r < 3; ++ r)
+            out(r, c) = values[c * 3 + r];
+    return out;
+}
+
+// Object of a model file.
+using ObjectKey = std::pair<std::string, long>;
+
+struct ObjectReference
+{
+    ObjectKey   object;
+    Transform3d transform;
+};
+
+// Objects, components and build items of all the model files, without the meshes.
+struct Structure
+{
+    std::set<ObjectKey>                               meshes;
+    std::map<ObjectKey, std::vector<ObjectReference>> components;
+    std::vector<ObjectReference>                      build_items;
+    // Model file containing the build, the objects of the volume metadata are the objects of this file.
+    std::string                                       root_path;
+    // Volumes which are not model parts (modifiers, negative volumes, support enforcers and blockers) by the object of the root model:
+    // the object IDs of the components of the object and the triangle ranges of the mesh of the object.
+    std::map<long, std::set<long>>                    excluded_components;
+    std::map<long, std::vector<std::pair<long, long>>> excluded_triangles;
+};
+
+struct StructureParser
+{
+    Structure         &structure;
+    const std::string &path;
+    long               object_id { -1 };
+
+    static void start_element(void *user_data, const char *name, const char **attributes)
+    {
+        auto &self = *static_cast<StructureParser*>(user_data);
+        if (::strcmp(name, "object") == 0) {
+            self.object_id = attribute_index(attributes, "id");
+        } else if (::strcmp(name, "mesh") == 0) {
+            self.structure.meshes.insert({ self.path, self.object_id });
+        } else if (::strcmp(name, "component") == 0 || ::strcmp(name, "item") == 0) {
+            const char     *path = attribute(attributes, "p:path");
+            ObjectReference reference { { path == nullptr ? self.path : zip_path(path), attribute_index(attributes, "objectid") }, attribute_transform(attributes) };
+            if (name[0] == 'c') {
+                self.structure.components[{ self.path, self.object_id }].emplace_back(std::move(reference));
+            } else {
+                self.structure.build_items.emplace_back(std::move(reference));
+                self.structure.root_path = self.path;
+            }
+        }
+    }
+
+    static void end_element(void *user_data, const char *name)
+    {
+        if (::strcmp(name, "object") == 0)
+            static_cast<StructureParser*>(user_data)->object_id = -1;
+    }
+};
+
+// Volume type stored by the 3MF exporters of Orca / Bambu Studio (ModelVolume::type_to_string()) and of PrusaSlicer.
+static bool is_model_part(const char *type)
+{
+    for (const char *other : { "negative_part", "modifier_part", "support_enforcer", "support_blocker",
+                               "NegativeVolume", "ParameterModifier", "SupportEnforcer", "SupportBlocker" })
+        if (::strcmp(type, other) == 0)
+            return false;
+    return true;
+}
+
+// Parses the volume metadata of Metadata/model_settings.config or Metadata/Slic3r_PE_model.config, as the 3MF importers do:
+// a volume is either a component of the object referenced by its ID, or a triangle range of the mesh of the object.
+struct VolumeTypeParser
+{
+    Structure &structure;
+    long       object_id { -1 };
+    bool       in_volume { false };
+    long       volume_id { -1 };
+    long       first_triangle { -1 };
+    long       last_triangle { -1 };
+    bool       model_part { true };
+
+    static void start_element(void *user_data, const char *name, const char **attributes)
+    {
+        auto &self = *static_cast<VolumeTypeParser*>(user_data);
+        if (::strcmp(name, "object") == 0) {
+            self.object_id = attribute_index(attributes, "id");
+        } else if (::strcmp(name, "part") == 0 || ::strcmp(name, "volume") == 0) {
+            const char *subtype  = attribute(attributes, "subtype");
+            self.in_volume       = true;
+            self.volume_id       = attribute_index(attributes, "id");
+            self.first_triangle  = attribute_index(attributes, "firstid");
+            self.last_triangle   = attribute_index(attributes, "lastid");
+            self.model_part      = subtype == nullptr || is_model_part(subtype);
+        } else if (::strcmp(name, "metadata") == 0 && self.in_volume) {
+            const char *key   = attribute(attributes, "key");
+            const char *value = attribute(attributes, "value");
+            if (key == nullptr || value == nullptr)
+                return;
+            if (::strcmp(key, "volume_type") == 0 || ::strcmp(key, "part_type") == 0)
+                self.model_part = is_model_part(value);
+            else if (::strcmp(key, "modifier") == 0 && ::strcmp(value, "1") == 0)
+                self.model_part = false;
+        }
+    }
+
+    static void end_element(void *user_data, const char *name)
+    {
+        auto &self = *static_cast<VolumeTypeParser*>(user_data);
+        if (::strcmp(name, "object") == 0) {
+            self.object_id = -1;
+        } else if ((::strcmp(name, "part") == 0 || ::strcmp(name, "volume") == 0) && self.in_volume) {
+            if (! self.model_part && self.object_id >= 0) {
+                if (self.last_triangle > 0)
+                    self.structure.excluded_triangles[self.object_id].emplace_back(std::max(0L, self.first_triangle), self.last_triangle);
+                else
+                    self.structure.excluded_components[self.object_id].insert(self.volume_id);
+            }
+            self.in_volume = false;
+        }
+    }
+};
+
+// Transformations of the meshes to the build plate, a mesh instanced multiple times has multiple transformations.
+static std::map<ObjectKey, std::vector<Transform3d>> mesh_transforms(const Structure &structure)
+{
+    std::map<ObjectKey, std::vector<Transform3d>> out;
+    if (structure.build_items.empty()) {
+        // No build, take the meshes as they are.
+        for (const ObjectKey &mesh : structure.meshes)
+            out[mesh].emplace_back(Transform3d::Identity());
+        return out;
+    }
+    std::function<void(const ObjectKey&, const Transform3d&, size_t)> instantiate = [&](const ObjectKey &object, const Transform3d &transform, size_t depth) {
+        // Components shall not reference their parents, limit the depth to survive invalid files.
+        if (depth > 32)
+            return;
+        if (structure.meshes.count(object))
+            out[object].emplace_back(transform);
+        if (auto it = structure.components.find(object); it != structure.components.end()) {
+            // The volumes of an object of the root model, which are not model parts, are not sliced.
+            const std::set<long> *excluded = nullptr;
+            if (object.first == structure.root_path)
+                if (auto it_excluded = structure.excluded_components.find(object.second); it_excluded != structure.excluded_components.end())
+                    excluded = &it_excluded->second;
+            for (const ObjectReference &component : it->second)
+                if (excluded == nullptr || excluded->count(component.object.second) == 0)
+                    instantiate(component.object, transform * component.transform, depth + 1);
+        }
+    };
+    for (const ObjectReference &item : structure.build_items)
+        instantiate(item.object, item.transform, 0);
+    return out;
+}
+
+// Parses a single .model file of the archive, keeping the vertices of the current mesh only.
+// The triangles are emitted once for each transformation of their mesh, the meshes not placed by the build are skipped.
+struct ModelParser
+{
+    const TriangleVisitor                               &visitor;
+    const std::map<ObjectKey, std::vector<Transform3d>> &transforms;
+    const std::string                                   &path;
+    // Triangle ranges of the meshes of this model file, which are not model parts, nullptr if not the root model.
+    const std::map<long, std::vector<std::pair<long, long>>> *excluded_triangles { nullptr };
+    float                                                unit_factor { 1.f };
+    long                                                 object_id { -1 };
+    // Index of the next triangle of the current mesh and the excluded triangle ranges of the current mesh.
+    long                                                 triangle_idx { 0 };
+    const std::vector<std::pair<long, long>>            *mesh_excluded { nullptr };
+    // Transformations of the current mesh including the unit factor, empty if the mesh is not placed.
+    std::vector<Transform3f>                             mesh_transforms;
+    std::vector<bool>                                    mesh_mirrored;
+    std::vector<stl_vertex>                              vertices;
+    bool                                                 invalid_index { false };
+
+    static void start_element(void *user_data, const char *name, const char **attributes)
+    {
+        auto &self = *static_cast<ModelParser*>(user_data);
+        if (::strcmp(name, "vertex") == 0) {
+            if (! self.mesh_transforms.empty())
+                self.vertices.emplace_back(attribute_float(attributes, "x"), attribute_float(attributes, "y"), attribute_float(attributes, "z"));
+        } else if (::strcmp(name, "triangle") == 0) {
+            if (self.mesh_transforms.empty())
+                return;
+            const long triangle_idx = self.triangle_idx ++;
+            if (self.mesh_excluded != nullptr && std::any_of(self.mesh_excluded->begin(), self.mesh_excluded->end(),
+                    [triangle_idx](const std::pair<long, long> &range) { return triangle_idx >= range.first && triangle_idx <= range.second; }))
+                return;
+            const long idx[3] { attribute_index(attributes, "v1"), attribute_index(attributes, "v2"), attribute_index(attributes, "v3") };
+            for (size_t i = 0; i < 3; ++ i)
+                if (idx[i] < 0 || size_t(idx[i]) >= self.vertices.size()) {
+                    self.invalid_index = true;
+                    return;
+                }
+            stl_vertex triangle[3];
+            for (size_t t = 0; t < self.mesh_transforms.size(); ++ t) {
+                for (size_t i = 0; i < 3; ++ i)
+                    triangle[i] = self.mesh_transforms[t] * self.vertices[idx[i]];
+                if (self.mesh_mirrored[t])
+                    // Keep the triangles oriented outwards.
+                    std::swap(triangle[1], triangle[2]);
+                self.visitor(triangle);
+            }
+        } else if (::strcmp(name, "mesh") == 0) {
+            self.vertices.clear();
+            self.mesh_transforms.clear();
+            self.mesh_mirrored.clear();
+            self.triangle_idx  = 0;
+            self.mesh_excluded = nullptr;
+            if (self.excluded_triangles != nullptr)
+                if (auto it = self.excluded_triangles->find(self.object_id); it != self.excluded_triangles->end())
+                    self.mesh_excluded = &it->second;
+            if (auto it = self.transforms.find({ self.path, self.object_id }); it != self.transforms.end())
+                for (const Transform3d &transform : it->second) {
+                    Transform3d scaled = Transform3d::Identity();
+                    scaled.matrix().block<3, 3>(0, 0) = double(self.unit_factor) * transform.matrix().block<3, 3>(0, 0);
+                    scaled.translation() = double(self.unit_factor) * transform.translation();
+                    self.mesh_transforms.emplace_back(scaled.cast<float>());
+                    self.mesh_mirrored.emplace_back(transform.matrix().block<3, 3>(0, 0).determinant() < 0.);
+                }
+        } else if (::strcmp(name, "object") == 0) {
+            self.object_id = attribute_index(attributes, "id");
+        } else if (::strcmp(name, "model") == 0) {
+            self.unit_factor = get_unit_factor(attribute(attributes, "unit"));
+        }
+    }
+
+    static void end_element(void *user_data, const char *name)
+    {
+        auto &self = *static_cast<ModelParser*>(user_data);
+        if (::strcmp(name, "mesh") == 0) {
+            self.vertices.clear();
+            self.vertices.shrink_to_fit();
+            self.mesh_transforms.clear();
+            self.mesh_mirrored.clear();
+        } else if (::strcmp(name, "object") == 0) {
+            self.object_id = -1;
+        }
+    }
+};
+
+// Stream a model file of the archive through an XML parser with the handlers of Parser.
+// The model is decompressed and parsed in chunks, the decompressed XML is never kept in memory as a whole.
+template<typename Parser>
+static void parse_model_file(mz_zip_archive &archive, mz_uint file_index, const mz_zip_archive_file_stat &stat, Parser &model_parser, const std::string &path)
+{
+    std::unique_ptr<std::remove_pointer_t<XML_Parser>, void(*)(XML_Parser)> parser(XML_ParserCreate(nullptr), XML_ParserFree);
+    if (! parser)
+        throw Slic3r::FileIOError("Unable to create XML parser");
+    XML_SetUserData(parser.get(), &model_parser);
+    XML_SetElementHandler(parser.get(), Parser::start_element, Parser::end_element);
+
+    struct CallbackData {
+        XML_Parser                       parser;
+        const mz_zip_archive_file_stat  &stat;
+    } data { parser.get(), stat };
+    const mz_bool res = mz_zip_reader_extract_to_callback(&archive, file_index,
+        [](void *opaque, mz_uint64 file_ofs, const void *buf, size_t n) -> size_t {
+            auto *data = static_cast<CallbackData*>(opaque);
+            return XML_Parse(data->parser, static_cast<const char*>(buf), int(n), file_ofs + n == data->stat.m_uncomp_size) ? n : 0;
+        }, &data, 0);
+    if (! res)
+        throw Slic3r::FileIOError((boost::format("Error while parsing %1% of 3MF archive %2%") % stat.m_filename % path).str());
+}
+
+} // namespace ThreeMFStreaming
+
+TriangleStream threemf_triangle_stream(const std::string &path)
+{
+    return [path](const TriangleVisitor &visitor) {
+        using namespace ThreeMFStreaming;
+        mz_zip_archive archive;
+        mz_zip_zero_struct(&archive);
+        if (! open_zip_reader(&archive, path))
+            throw Slic3r::FileIOError("Cannot open 3MF archive " + path);
+        std::unique_ptr<mz_zip_archive, bool(*)(mz_zip_archive*)> archive_closer(&archive, close_zip_reader);
+
+        std::vector<std::pair<mz_uint, mz_zip_archive_file_stat>> model_files;
+        std::vector<std::pair<mz_uint, mz_zip_archive_file_stat>> config_files;
+        const mz_uint num_entries = mz_zip_reader_get_num_files(&archive);
+        for (mz_uint i = 0; i < num_entries; ++ i) {
+            mz_zip_archive_file_stat stat;
+            if (! mz_zip_reader_file_stat(&archive, i, &stat))
+                continue;
+            if (boost::algorithm::iends_with(stat.m_filename, ".model"))
+                model_files.emplace_back(i, stat);
+            else if (boost::algorithm::iequals(stat.m_filename, "Metadata/model_settings.config") || boost::algorithm::iequals(stat.m_filename, "Metadata/Slic3r_PE_model.config"))
+                config_files.emplace_back(i, stat);
+        }
+
+        // 1) Objects, components and build items, to find out where and how many times the meshes are placed.
+        //    The build is at the end of the root model, thus it has to be parsed before the meshes are streamed.
+        Structure structure;
+        for (const auto &[file_index, stat] : model_files) {
+            const std::string file_path = zip_path(stat.m_filename);
+            StructureParser   structure_parser { structure, file_path };
+            parse_model_file(archive, file_index, stat, structure_parser, path);
+        }
+        // Modifiers, negative volumes, support enforcers and blockers are not printed.
+        for (const auto &[file_index, stat] : config_files) {
+            VolumeTypeParser volume_type_parser { structure };
+            parse_model_file(archive, file_index, stat, volume_type_parser, path);
+        }
+        const std::map<ObjectKey, std::vector<Transform3d>> transforms = mesh_transforms(structure);
+
+        // 2) Stream the triangles of the placed meshes.
+        for (const auto &[file_index, stat] : model_files) {
+            const std::string file_path = zip_path(stat.m_filename);
+            ModelParser       model_parser { visitor, transforms, file_path };
+            if (file_path == structure.root_path)
+                model_parser.excluded_triangles = &structure.excluded_triangles;
+            parse_model_file(archive, file_index, stat, model_parser, path);
+            if (model_parser.invalid_index)
+                throw Slic3r::FileIOError((boost::format("Error while parsing %1% of 3MF archive %2%") % stat.m_filename % path).str());
+        }
+    };
+}
+
+TriangleStream triangle_stream_from_file(const std::string &path)
+{
+    if (boost::algorithm::iends_with(path, ".stl"))
+        return stl_triangle_stream(path);
+    if (boost::algorithm::iends_with(path, ".3mf"))
+        return threemf_triangle_stream(path);
+    throw Slic3r::FileIOError("Out-of-core slicing supports STL and 3MF files only: " + path);
+}
+
+TriangleStream triangle_stream(const indexed_triangle_set &its)
+{
+    return [&its](const TriangleVisitor &visitor) {
+        stl_vertex triangle[3];
+        for (const stl_triangle_vertex_indices &face : its.indices) {
+            for (size_t i = 0; i < 3; ++ i)
+                triangle[i] = its.vertices[face(i)];
+            visitor(triangle);
+        }
+    };
+}
+
+namespace OutOfCoreImpl {
+
+// Approximate memory of a triangle while its bucket is being sliced: the indexed triangle set, the vertex deduplication map,
+// the edge IDs, the vertices transformed for slicing.
+static constexpr size_t bytes_per_triangle      = 128;
+// Approximate memory of an intersection line of a triangle with a slicing plane, including its share of the polygons created.
+static constexpr size_t bytes_per_line          = 64;
+// Triangle spilled to disk: three vertices.
+static constexpr size_t floats_per_triangle     = 9;
+
+// Span of the slicing planes touched by a triangle, half open interval of layer indices.
+struct LayerSpan
+{
+    size_t begin;
+    size_t end;
+    bool   empty() const { return begin >= end; }
+};
+
+class LayerSpanner
+{
+public:
+    LayerSpanner(const std::vector<float> &zs, const Transform3d &trafo) : m_zs(zs), m_identity(trafo.matrix() == Transform3d::Identity().matrix())
+    {
+        // The slicer scales the transformation in XY only, Z row of the slicing transformation is the Z row of trafo.
+        m_z_row    = trafo.matrix().block<1, 3>(2, 0).transpose().cast<float>();
+        m_z_offset = float(trafo.matrix()(2, 3));
+    }
+
+    LayerSpan operator()(const stl_vertex *triangle) const
+    {
+        float zmin = std::numeric_limits<float>::max();
+        float zmax = std::numeric_limits<float>::lowest();
+        for (size_t i = 0; i < 3; ++ i) {
+            const float z = m_identity ? triangle[i].z() : m_z_row.dot(triangle[i]) + m_z_offset;
+            zmin = std::min(zmin, z);
+            zmax = std::max(zmax, z);
+        }
+        // Be conservative, a triangle not crossing any of its planes produces no intersection lines anyways.
+        const float eps = 1e-4f * std::max(1.f, std::max(std::abs(zmin), std::abs(zmax)));
+        return { size_t(std::lower_bound(m_zs.begin(), m_zs.end(), zmin - eps) - m_zs.begin()),
+                 size_t(std::upper_bound(m_zs.begin(), m_zs.end(), zmax + eps) - m_zs.begin()) };
+    }
+
+private:
+    const std::vector<float> &m_zs;
+    bool                      m_identity;
+    Vec3f                     m_z_row;
+    float                     m_z_offset;
+};
+
+struct Bucket
+{
+    size_t              layer_begin;
+    size_t              layer_end;
+    size_t              num_triangles;
+    std::string         path;
+    // Triangles not yet written to the spill file.
+    std::vector<float>  buffer;
+};
+
+// Split the layers into consecutive buckets, each fitting the memory budget, if possible.
+// Bucket [begin, end) contains the triangles touching layer begin and the triangles starting at the layers above.
+static std::vector<Bucket> make_buckets(const std::vector<size_t> &starts, const std::vector<size_t> &active, size_t memory_budget)
+{
+    std::vector<Bucket> buckets;
+    const size_t num_layers = starts.size();
+    for (size_t layer_id = 0; layer_id < num_layers;) {
+        Bucket bucket { layer_id, layer_id + 1, active[layer_id] };
+        size_t num_lines = active[layer_id];
+        for (++ layer_id; layer_id < num_layers; ++ layer_id) {
+            const size_t num_triangles = bucket.num_triangles + starts[layer_id];
+            if (num_triangles * bytes_per_triangle + (num_lines + active[layer_id]) * bytes_per_line > memory_budget)
+                break;
+            bucket.num_triangles = num_triangles;
+            num_lines           += active[layer_id];
+        }
+        bucket.layer_end = layer_id;
+        buckets.emplace_back(std::move(bucket));
+    }
+    return buckets;
+}
+
+// Owns the spill files, the directory is deleted with its contents at the end of slicing, even if slicing is canceled.
+class SpillDirectory
+{
+public:
+    explicit SpillDirectory(const std::string &parent)
+    {
+        m_path = (parent.empty() ? boost::filesystem::temp_directory_path() : boost::filesystem::path(parent)) /
+                 boost::filesystem::unique_path("orca_spill_%%%%-%%%%-%%%%");
+        boost::filesystem::create_directories(m_path);
+    }
+    ~SpillDirectory()
+    {
+        boost::system::error_code ec;
+        boost::filesystem::remove_all(m_path, ec);
+    }
+
+    std::string file(size_t idx) const { return (m_path / ("bucket_" + std::to_string(idx) + ".bin")).string(); }
+
+private:
+    boost::filesystem::path m_path;
+};
+
+static void flush(Bucket &bucket)
+{
+    if (bucket.buffer.empty())
+        return;
+    // Opened for each flush, so that the number of buckets is not limited by the number of open files.
+    FILE *file = boost::nowide::fopen(bucket.path.c_str(), "ab");
+    if (file == nullptr)
+        throw Slic3r::FileIOError("Cannot create spill file " + bucket.path);
+    const size_t written = fwrite(bucket.buffer.data(), sizeof(float), bucket.buffer.size(), file);
+    if (fclose(file) != 0 || written != bucket.buffer.size())
+        throw Slic3r::FileIOError("Cannot write spill file " + bucket.path);
+    bucket.buffer.clear();
+}
+
+// Load the triangles of a bucket, merging the vertices with the same coordinates, so that the slicer may chain the intersection lines
+// by the shared edges as if the whole mesh was sliced.
+static indexed_triangle_set load_bucket(const Bucket &bucket, std::function<void()> throw_on_cancel)
+{
+    indexed_triangle_set its;
+    its.indices.reserve(bucket.num_triangles);
+    its.vertices.reserve(bucket.num_triangles / 2 + 3);
+    ankerl::unordered_dense::map<VertexKey, int, VertexKeyHash> vertex_map;
+    vertex_map.reserve(bucket.num_triangles / 2 + 3);
+
+    FILE *file = boost::nowide::fopen(bucket.path.c_str(), "rb");
+    if (file == nullptr)
+        throw Slic3r::FileIOError("Cannot read spill file " + bucket.path);
+    std::unique_ptr<FILE, int(*)(FILE*)> file_closer(file, fclose);
+
+    constexpr size_t   triangles_per_chunk = 16384;
+    std::vector<float> chunk(floats_per_triangle * triangles_per_chunk);
+    for (;;) {
+        const size_t num_floats = fread(chunk.data(), sizeof(float), chunk.size(), file);
+        if (num_floats % floats_per_triangle != 0)
+            throw Slic3r::FileIOError("Truncated spill file " + bucket.path);
+        for (size_t i = 0; i < num_floats; i += floats_per_triangle) {
+            stl_triangle_vertex_indices face;
+            for (size_t j = 0; j < 3; ++ j) {
+                VertexKey key;
+                ::memcpy(key.bits, chunk.data() + i + 3 * j, sizeof(key.bits));
+                auto [it, inserted] = vertex_map.try_emplace(key, int(its.vertices.size()));
+                if (inserted)
+                    its.vertices.emplace_back(chunk[i + 3 * j], chunk[i + 3 * j + 1], chunk[i + 3 * j + 2]);
+                face(j) = it->second;
+            }
+            its.indices.emplace_back(face);
+        }
+        if (num_floats < chunk.size())
+            break;
+        throw_on_cancel();
+    }
+    return its;
+}
+
+} // namespace OutOfCoreImpl
+
+void slice_mesh_out_of_core(
+    const TriangleStream             &triangles,
+    const std::vector<float>         &zs,
+    const OutOfCoreSlicingParams     &params,
+    const LayerSlicesFn              &layer_slices,
+    std::function<void()>             throw_on_cancel)
+{
+    using namespace OutOfCoreImpl;
+    assert(std::is_sorted(zs.begin(), zs.end()));
+    if (zs.empty())
+        return;
+
+    const LayerSpanner layer_span(zs, params.trafo);
+
+    // 1) Histogram of the triangles over the layers.
+    std::vector<size_t> starts(zs.size(), 0);
+    std::vector<size_t> active;
+    {
+        std::vector<int64_t> delta(zs.size() + 1, 0);
+        size_t num_triangles = 0;
+        triangles([&](const stl_vertex *triangle) {
+            if (LayerSpan span = layer_span(triangle); ! span.empty()) {
+                ++ starts[span.begin];
+                ++ delta[span.begin];
+                -- delta[span.end];
+            }
+            if ((++ num_triangles & 0xffff) == 0)
+                throw_on_cancel();
+        });
+        active.reserve(zs.size());
+        int64_t num_active = 0;
+        for (size_t i = 0; i < zs.size(); ++ i)
+            active.emplace_back(size_t(num_active += delta[i]));
+        BOOST_LOG_TRIVIAL(debug) << __FUNCTION__ << boost::format(": %1% triangles streamed") % num_triangles;
+    }
+
+    std::vector<Bucket> buckets = make_buckets(starts, active, params.memory_budget);
+    starts.clear();
+    starts.shrink_to_fit();
+    active.clear();
+    active.shrink_to_fit();
+
+    // 2) Spill the triangles into the buckets of the layers they touch. A triangle spanning multiple buckets is spilled into each of them.
+    SpillDirectory spill_dir(params.spill_dir);
+    {
+        size_t num_triangles = 0;
+        size_t num_spilled   = 0;
+        for (size_t i = 0; i < buckets.size(); ++ i)
+            buckets[i].path = spill_dir.file(i);
+        const size_t buffer_floats = std::clamp<size_t>(params.memory_budget / (4 * buckets.size() * sizeof(float)), 16384, 1024 * 1024)
+                                     / floats_per_triangle * floats_per_triangle;
+        triangles([&](const stl_vertex *triangle) {
+            if ((++ num_triangles & 0xffff) == 0)
+                throw_on_cancel();
+            LayerSpan span = layer_span(triangle);
+            if (span.empty())
+                return;
+            auto it = std::upper_bound(buckets.begin(), buckets.end(), span.begin, [](size_t layer_id, const Bucket &b) { return layer_id < b.layer_end; });
+            for (; it != buckets.end() && it->layer_begin < span.end; ++ it) {
+                for (size_t i = 0; i < 3; ++ i)
+                    it->buffer.insert(it->buffer.end(), triangle[i].data(), triangle[i].data() + 3);
+                if (it->buffer.size() >= buffer_floats)
+                    flush(*it);
+                ++ num_spilled;
+            }
+        });
+        for (Bucket &bucket : buckets) {
+            flush(bucket);
+            bucket.buffer.shrink_to_fit();
+        }
+        BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": %1% triangles spilled into %2% buckets of %3% layers") % num_spilled % buckets.size() % zs.size();
+    }
+
+    // 3) Slice bucket by bucket.
+    for (const Bucket &bucket : buckets) {
+        throw_on_cancel();
+        if (bucket.num_triangles == 0) {
+            for (size_t layer_id = bucket.layer_begin; layer_id < bucket.layer_end; ++ layer_id)
+                layer_slices(layer_id, ExPolygons());
+            continue;
+        }
+        std::vector<ExPolygons> layers;
+        {
+            indexed_triangle_set its = load_bucket(bucket, throw_on_cancel);
+            boost::filesystem::remove(bucket.path);
+            MeshSlicingParamsEx bucket_params(params);
+            if (params.slicing_mode_normal_below_layer > 0)
+                // 0 = ignore, all the layers of the bucket are above slicing_mode_normal_below_layer.
+                bucket_params.slicing_mode_normal_below_layer = params.slicing_mode_normal_below_layer > bucket.layer_begin ?
+                    params.slicing_mode_normal_below_layer - bucket.layer_begin : 0;
+            layers = slice_mesh_ex(its, std::vector<float>(zs.begin() + bucket.layer_begin, zs.begin() + bucket.layer_end), bucket_params, throw_on_cancel);
+        }
+        for (size_t i = 0; i < layers.size(); ++ i)
+            layer_slices(bucket.layer_begin + i, std::move(layers[i]));
+    }
+}
+
+} // namespace Slic3r
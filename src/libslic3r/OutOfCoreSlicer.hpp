@@ -0,0 +1,65 @@
+#ifndef slic3r_OutOfCoreSlicer_hpp_
+#define slic3r_OutOfCoreSlicer_hpp_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <admesh/stl.h>
+
+#include "TriangleMeshSlicer.hpp"
+
+namespace Slic3r {
+
+// Out-of-core slicing of meshes too large to be kept in memory as a whole.
+// The triangles are streamed from a file twice: the first pass collects a histogram of the triangles over the slicing planes,
+// the second pass spills the triangles into Z sorted buckets on disk. The buckets are then loaded and sliced one by one,
+// thus the peak memory is bounded by the memory budget instead of by the size of the mesh.
+// PrintObject slicing works on the meshes of the Model, which are kept in memory anyway, thus it does not go through
+// the out-of-core slicer. The command line exports the outlines of huge meshes by the out-of-core slicer with --export_slice_outlines.
+
+// Called for each triangle of a TriangleStream with its three vertices.
+using TriangleVisitor = std::function<void(const stl_vertex *triangle)>;
+// Source of triangles. A TriangleStream may be called multiple times, each call shall visit the same triangles in the same order.
+using TriangleStream  = std::function<void(const TriangleVisitor &visitor)>;
+
+// Stream the triangles of a binary or ASCII STL file, detected like admesh does, thus a binary STL with trailing data
+// or with a wrong number of facets in its header is accepted. Throws Slic3r::FileIOError if the file cannot be read.
+TriangleStream  stl_triangle_stream(const std::string &path);
+// Stream the triangles of the meshes of a 3MF archive placed by its build items, transformed by the build items and by the components
+// referencing them, including the components of the production extension referencing other model files. A mesh placed multiple times
+// is streamed multiple times, a mesh not placed is skipped. If the archive has no build items, all meshes are streamed untransformed.
+// The volumes, which are not model parts by the volume metadata of Orca / Bambu Studio or PrusaSlicer (modifiers, negative volumes,
+// support enforcers and blockers), are skipped: either the components of an object or the triangle ranges of its mesh.
+// The model files are parsed twice, first for the objects and the build, then for the meshes. Only the vertices of the mesh being
+// streamed are kept in memory. Throws Slic3r::FileIOError if the archive cannot be read.
+TriangleStream  threemf_triangle_stream(const std::string &path);
+// Choose the stream by the file extension (.stl or .3mf).
+TriangleStream  triangle_stream_from_file(const std::string &path);
+// Stream the triangles of a mesh in memory.
+TriangleStream  triangle_stream(const indexed_triangle_set &its);
+
+struct OutOfCoreSlicingParams : public MeshSlicingParamsEx
+{
+    // Approximate peak memory in bytes used by the triangles and intersection lines of a single bucket.
+    // A bucket contains at least a single layer, thus the budget may be exceeded by a layer crossing more triangles than the budget allows.
+    size_t        memory_budget { size_t(1024) * 1024 * 1024 };
+    // Directory to create the spill files in, system temporary directory if empty.
+    std::string   spill_dir;
+};
+
+// Called with the slices of each layer, in the order of increasing layer_id.
+using LayerSlicesFn = std::function<void(size_t layer_id, ExPolygons &&slices)>;
+
+// Produces the same slices as slice_mesh_ex() of the whole mesh, emitting them layer by layer.
+// zs shall be sorted in ascending order.
+void slice_mesh_out_of_core(
+    const TriangleStream             &triangles,
+    const std::vector<float>         &zs,
+    const OutOfCoreSlicingParams     &params,
+    const LayerSlicesFn              &layer_slices,
+    std::function<void()>             throw_on_cancel = []{});
+
+} // namespace Slic3r
+
+#endif // slic3r_OutOfCoreSlicer_hpp_
@@ -9,6 +9,7 @@
 #include "ShortestPath.hpp"
 #include "VariableWidth.hpp"
 #include "Arachne/WallToolPaths.hpp"
+#include "Arachne/WallToolPathsCache.hpp"
 #include "Geometry/ConvexHull.hpp"
 #include "ExPolygonCollection.hpp"
 #include "Geometry.hpp"
@@ -2156,10 +2157,10 @@ void PerimeterGenerator::process_arachne()
         Arachne::WallToolPathsParams input_params_tmp = input_params;
         
         Polygons   last_p = to_polygons(last);
-        Arachne::WallToolPaths wallToolPaths(last_p, bead_width_0, perimeter_spacing, coord_t(loop_number + 1),
-                                               wall_0_inset, layer_height, input_params_tmp);
-        std::vector<Arachne::VariableWidthLines>   perimeters = wallToolPaths.getToolPaths();
-        ExPolygons  infill_contour = union_ex(wallToolPaths.getInnerContour());
+        Arachne::WallToolPathsCache::Result wall_tool_paths = Arachne::generate_wall_toolpaths(this->wall_toolpaths_cache, last_p, bead_width_0, perimeter_spacing,
+                                                                                                coord_t(loop_number + 1), wall_0_inset, layer_height, input_params_tmp);
+        std::vector<Arachne::VariableWidthLines>   perimeters = std::move(wall_tool_paths.toolpaths);
+        ExPolygons  infill_contour = union_ex(wall_tool_paths.inner_contour);
 
         // Check if there are some remaining perimeters to generate (the number of perimeters
         // is greater than one together with enabled the single perimeter on top surface feature).
@@ -2208,8 +2209,9 @@ void PerimeterGenerator::process_arachne()
                 top_expolygons = intersection_ex(top_expolygons, infill_contour);
 
                 const Polygons not_top_polygons = to_polygons(offset_ex(not_top_expolygons,wall_0_inset));
-                Arachne::WallToolPaths inner_wall_tool_paths(not_top_polygons, perimeter_spacing, perimeter_spacing, coord_t(inner_loop_number + 1), 0, layer_height, input_params_tmp);
-                std::vector<Arachne::VariableWidthLines> inner_perimeters = inner_wall_tool_paths.getToolPaths();
+                Arachne::WallToolPathsCache::Result inner_wall_tool_paths = Arachne::generate_wall_toolpaths(this->wall_toolpaths_cache, not_top_polygons, perimeter_spacing, perimeter_spacing,
+                                                                                                              coord_t(inner_loop_number + 1), 0, layer_height, input_params_tmp);
+                std::vector<Arachne::VariableWidthLines> &inner_perimeters = inner_wall_tool_paths.toolpaths;
 
                 // Recalculate indexes of inner perimeters before merging them.
                 if (!perimeters.empty()) {
@@ -2222,13 +2224,14 @@ void PerimeterGenerator::process_arachne()
                 }
 
                 perimeters.insert(perimeters.end(), inner_perimeters.begin(), inner_perimeters.end());
-                infill_contour = union_ex(top_expolygons, inner_wall_tool_paths.getInnerContour());
+                infill_contour = union_ex(top_expolygons, inner_wall_tool_paths.inner_contour);
             } else {
                 // There is no top surface ExPolygon, so we call Arachne again with parameters
                 // like when the single perimeter feature is disabled.
-                Arachne::WallToolPaths no_single_perimeter_tool_paths(last_p, bead_width_0, perimeter_spacing, coord_t(inner_loop_number + 2), wall_0_inset, layer_height, input_params_tmp);
-                perimeters     = no_single_perimeter_tool_paths.getToolPaths();
-                infill_contour = union_ex(no_single_perimeter_tool_paths.getInnerContour());
+                Arachne::WallToolPathsCache::Result no_single_perimeter_tool_paths = Arachne::generate_wall_toolpaths(this->wall_toolpaths_cache, last_p, bead_width_0, perimeter_spacing,
+                                                                                                                       coord_t(inner_loop_number + 2), wall_0_inset, layer_height, input_params_tmp);
+                perimeters     = std::move(no_single_perimeter_tool_paths.toolpaths);
+                infill_contour = union_ex(no_single_perimeter_tool_paths.inner_contour);
             }
         }
         //PS
@@ -2238,7 +2241,7 @@ void PerimeterGenerator::process_arachne()
         #ifdef ARACHNE_DEBUG
         {
             static int iRun = 0;
-            export_perimeters_to_svg(debug_out_path("arachne-perimeters-%d-%d.svg", layer_id, iRun++), to_polygons(last), perimeters, union_ex(wallToolPaths.getInnerContour()));
+            export_perimeters_to_svg(debug_out_path("arachne-perimeters-%d-%d.svg", layer_id, iRun++), to_polygons(last), perimeters, union_ex(wall_tool_paths.inner_contour));
         }
 #endif
 
@@ -10,6 +10,10 @@
 #include "SurfaceCollection.hpp"
 
 namespace Slic3r {
+namespace Arachne {
+    class WallToolPathsCache;
+}
+
 struct FuzzySkinConfig
 {
     FuzzySkinType type;
@@ -77,6 +81,8 @@ public:
     const PrintRegionConfig     *config;
     const PrintObjectConfig     *object_config;
     const PrintConfig           *print_config;
+    // Arachne tool paths shared by the layers of the PrintObject, may be null.
+    Arachne::WallToolPathsCache *wall_toolpaths_cache { nullptr };
     // Outputs:
     ExtrusionEntityCollection   *loops;
     ExtrusionEntityCollection   *gap_fill;
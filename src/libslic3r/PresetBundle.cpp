@@ -3,6 +3,7 @@
 #include "PresetBundle.hpp"
 #include "FilamentColorLibrary.hpp"
 #include "PrintConfig.hpp"
+#include "VendorProfileIndex.hpp"
 #include "libslic3r.h"
 #include "Utils.hpp"
 #include "Model.hpp"
@@ -29,6 +30,8 @@
 #include <boost/log/trivial.hpp>
 #include <miniz/miniz.h>
 
+#include <tbb/task_group.h>
+
 
 // Store the print/filament/printer presets into a "presets" subdirectory of the Slic3rPE config dir.
 // This breaks compatibility with the upstream Slic3r if the --datadir is used to switch between the two versions.
@@ -1431,8 +1434,35 @@ std::pair<PresetsConfigSubstitutions, std::string> PresetBundle::load_system_pre
         }
     }
 
-    for (auto &vendor_name : vendor_names)
+    // The json documents of the vendors are read from binary indices, the stale ones are rebuilt while parsing the json files.
+    // The index of the next vendor is read in the background while the presets of the current vendor are being loaded,
+    // only the indices of two vendors are held in memory at a time. The profiles being validated are always parsed from the json files.
+    std::vector<VendorProfileIndex> indices;
+    if (!validation_mode) {
+        const std::string cache_dir = (boost::filesystem::path(data_dir()) / "cache" / "profiles").make_preferred().string();
+        indices.reserve(vendor_names.size());
+        for (const std::string &vendor_name : vendor_names)
+            indices.emplace_back(dir.string(), vendor_name, cache_dir);
+    }
+    tbb::task_group index_prefetch;
+    auto            prefetch_index = [&indices, &index_prefetch](size_t vendor_idx) {
+        if (vendor_idx < indices.size()) {
+            // The presets of the other vendors may inherit from OrcaFilamentLibrary, which is loaded first.
+            std::string base_digest = vendor_idx > 0 && indices.front().vendor_name() == ORCA_FILAMENT_LIBRARY ?
+                indices.front().manifest_digest() : std::string();
+            index_prefetch.run([&indices, vendor_idx, base_digest]() { indices[vendor_idx].load(base_digest); });
+        }
+    };
+    prefetch_index(0);
+    size_t num_vendors_resolved = 0;
+    size_t num_vendors_indexed  = 0;
+
+    for (size_t vendor_idx = 0; vendor_idx < vendor_names.size(); ++ vendor_idx)
     {
+        const std::string  &vendor_name  = vendor_names[vendor_idx];
+        index_prefetch.wait();
+        prefetch_index(vendor_idx + 1);
+        VendorProfileIndex *vendor_index = indices.empty() ? nullptr : &indices[vendor_idx];
         const auto vendor_start = std::chrono::steady_clock::now();
         if (validation_mode && !vendor_to_validate.empty() && vendor_name != vendor_to_validate && vendor_name != ORCA_FILAMENT_LIBRARY)
             continue;
@@ -1441,13 +1471,13 @@ std::pair<PresetsConfigSubstitutions, std::string> PresetBundle::load_system_pre
             // Load the config bundle, flatten it.
             if (first) {
                 // Reset this PresetBundle and load the first vendor config.
-                append(substitutions, this->load_vendor_configs_from_json(dir.string(), vendor_name, PresetBundle::LoadSystem, compatibility_rule).first);
+                append(substitutions, this->load_vendor_configs_from_json(dir.string(), vendor_name, PresetBundle::LoadSystem, compatibility_rule, nullptr, vendor_index).first);
                 first = false;
             } else {
                 // Load the other vendor configs, merge them with this PresetBundle.
                 // Report duplicate profiles.
                 PresetBundle other;
-                append(substitutions, other.load_vendor_configs_from_json(dir.string(), vendor_name, PresetBundle::LoadSystem, compatibility_rule, this).first);
+                append(substitutions, other.load_vendor_configs_from_json(dir.string(), vendor_name, PresetBundle::LoadSystem, compatibility_rule, this, vendor_index).first);
                 std::vector<std::string> duplicates = this->merge_presets(std::move(other));
                 if (!duplicates.empty()) {
                     errors_cummulative += "Found duplicated settings in vendor " + vendor_name + "'s json file lists: ";
@@ -1460,6 +1490,9 @@ std::pair<PresetsConfigSubstitutions, std::string> PresetBundle::load_system_pre
                     }
                 }
             }
+            // Only the indices of the vendors loaded without an exception are stored.
+            if (vendor_index != nullptr)
+                vendor_index->save();
         } catch (const std::runtime_error &err) {
             if (validation_mode)
                 throw err;
@@ -1469,12 +1502,21 @@ std::pair<PresetsConfigSubstitutions, std::string> PresetBundle::load_system_pre
             }
         }
 
+        const bool indexed  = vendor_index != nullptr && vendor_index->loaded();
+        const bool resolved = indexed && vendor_index->resolved_presets() != nullptr;
+        num_vendors_indexed  += indexed;
+        num_vendors_resolved += resolved;
+        if (vendor_index != nullptr)
+            vendor_index->clear();
+
         if (startup_profile) {
             const auto vendor_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - vendor_start).count();
             startup_profile_log("PresetBundle::load_system_presets_from_json vendor=" + vendor_name +
-                                " vendor_ms=" + std::to_string(vendor_ms));
+                                " vendor_ms=" + std::to_string(vendor_ms) +
+                                " indexed=" + (indexed ? "1" : "0") + " resolved=" + (resolved ? "1" : "0"));
         }
     }
+    index_prefetch.wait();
 
     if (first) {
 		// No config bundle loaded, reset.
@@ -1484,6 +1526,9 @@ std::pair<PresetsConfigSubstitutions, std::string> PresetBundle::load_system_pre
     this->update_system_maps();
     //BBS: add config related logs
     BOOST_LOG_TRIVIAL(debug) << __FUNCTION__ << boost::format(" finished, errors_cummulative %1%")%errors_cummulative;
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": loaded system presets of %1% vendors in %2% ms, %3% vendors from resolved presets, %4% from indexed documents")
+        % vendor_names.size() % std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - total_start).count()
+        % num_vendors_resolved % (num_vendors_indexed - num_vendors_resolved);
     if (startup_profile) {
         const auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - total_start).count();
         startup_profile_log("PresetBundle::load_system_presets_from_json end vendor_count=" + std::to_string(vendor_names.size()) +
@@ -3011,9 +3056,36 @@ void PresetBundle::load_config_file_config(const std::string &name_or_path, bool
     BOOST_LOG_TRIVIAL(debug) << __FUNCTION__ << boost::format(": finished");
 }
 
+// Serialize the options of a resolved preset differing from the default preset. Returns false if the config could not be restored
+// from the serialized options exactly, for example if a floating point value does not survive serialization.
+static bool resolved_config_diff(const DynamicPrintConfig &config, const DynamicPrintConfig &base, json &diff)
+{
+    CNumericLocalesSetter locales_setter;
+    diff = json::object();
+    for (const t_config_option_key &key : base.keys())
+        if (! config.has(key))
+            return false;
+    for (const t_config_option_key &key : config.keys()) {
+        const ConfigOption *opt      = config.option(key);
+        const ConfigOption *base_opt = base.option(key);
+        if (base_opt != nullptr && *opt == *base_opt)
+            continue;
+        const ConfigOptionDef *def = config.def()->get(key);
+        if (base_opt == nullptr && def == nullptr)
+            return false;
+        std::string                   value = opt->serialize();
+        std::unique_ptr<ConfigOption> restored(base_opt != nullptr ? base_opt->clone() : def->create_default_option());
+        if (! restored->deserialize(value) || ! (*restored == *opt))
+            return false;
+        diff[key] = std::move(value);
+    }
+    return true;
+}
+
 //BBS: Load a config bundle file from json
 std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_from_json(
-    const std::string &path, const std::string &vendor_name, LoadConfigBundleAttributes flags, ForwardCompatibilitySubstitutionRule compatibility_rule, const PresetBundle* base_bundle)
+    const std::string &path, const std::string &vendor_name, LoadConfigBundleAttributes flags, ForwardCompatibilitySubstitutionRule compatibility_rule, const PresetBundle* base_bundle,
+    VendorProfileIndex *index)
 {
     const bool startup_profile = startup_profile_enabled();
     const auto total_start     = std::chrono::steady_clock::now();
@@ -3106,9 +3178,13 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
             subfile_map.emplace_back(file.stem().string(), file.lexically_relative(vendor_dir).generic_string());
     };
     try {
-        boost::nowide::ifstream ifs(root_file);
         json j;
-        ifs >> j;
+        if (index)
+            j = index->document(vendor_name + ".json");
+        else {
+            boost::nowide::ifstream ifs(root_file);
+            ifs >> j;
+        }
         //parse the json elements
         for (auto it = j.begin(); it != j.end(); it++) {
             if (boost::iequals(it.key(), BBL_JSON_KEY_VERSION)) {
@@ -3159,7 +3235,9 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
         //goto __error_process;
     }
 
-    if (vendor_name == ORCA_FILAMENT_LIBRARY && filament_subfiles.empty()) {
+    if (vendor_name == ORCA_FILAMENT_LIBRARY && filament_subfiles.empty() && index != nullptr && index->discovered_subfiles() != nullptr) {
+        filament_subfiles = *index->discovered_subfiles();
+    } else if (vendor_name == ORCA_FILAMENT_LIBRARY && filament_subfiles.empty()) {
         const fs::path vendor_dir   = fs::path(path) / vendor_name;
         const fs::path filament_dir = vendor_dir / "filament";
 
@@ -3180,6 +3258,8 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
 
         BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ": discovered " << filament_subfiles.size()
                                 << " OrcaFilamentLibrary filament profiles from disk";
+        if (index)
+            index->set_discovered_subfiles(filament_subfiles);
     }
 
     if (startup_profile) {
@@ -3203,9 +3283,13 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
         VendorProfile::PrinterModel model;
         model.id = machine_model.first;
         try {
-            boost::nowide::ifstream ifs(subfile);
             json j;
-            ifs >> j;
+            if (index)
+                j = index->document(vendor_name + "/" + machine_model.second);
+            else {
+                boost::nowide::ifstream ifs(subfile);
+                ifs >> j;
+            }
             //parse the json elements
             for (auto it = j.begin(); it != j.end(); it++) {
                 if (boost::iequals(it.key(), BBL_JSON_KEY_VERSION)) {
@@ -3296,7 +3380,29 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
     PresetCollection         *presets = nullptr;
     size_t                   presets_loaded = 0;
 
-    auto parse_subfile = [this, path, vendor_name, presets_loaded, current_vendor_profile, base_bundle](
+    if (index != nullptr && index->loaded() && index->resolved_presets() != nullptr) {
+        // The inheritance of the presets was resolved when the index was stored, the sub-profiles are not parsed at all.
+        if (this->load_resolved_presets(*index, current_vendor_profile, presets_loaded)) {
+            if (startup_profile) {
+                const auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - total_start).count();
+                startup_profile_log("PresetBundle::load_vendor_configs_from_json vendor=" + vendor_name + " resolved=1" +
+                                    " presets_loaded=" + std::to_string(presets_loaded) + " total_ms=" + std::to_string(total_ms));
+            }
+            return std::make_pair(std::move(substitutions), presets_loaded);
+        }
+        // Parse the sub-profiles, they are not stored together with the resolved presets.
+        index->set_resolved_presets(json());
+    }
+
+    // Record the presets with their inheritance resolved into an index, which will be stored.
+    // Only vendors loaded without errors and substitutions and with all the presets restorable exactly are recorded.
+    json resolved;
+    bool resolvable   = index != nullptr && ! index->loaded() && flags.has(LoadConfigBundleAttribute::LoadSystem);
+    const int errors_start = m_errors;
+    if (resolvable)
+        resolved = json{ { "process", json::array() }, { "filament", json::array() }, { "machine", json::array() }, { "templates", json::array() } };
+
+    auto parse_subfile = [this, path, vendor_name, presets_loaded, current_vendor_profile, base_bundle, index, &resolved, &resolvable](
         ConfigSubstitutionContext& substitution_context,
         PresetsConfigSubstitutions& substitutions,
         LoadConfigBundleAttributes& flags,
@@ -3321,7 +3427,10 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
             //parse the json elements
             DynamicPrintConfig config_src;
             std::string _renamed_from_str;
-            config_src.load_from_json(subfile, substitution_context, false, key_values, reason);
+            if (index)
+                config_src.load_from_json(index->document(vendor_name + "/" + subfile_iter.second), subfile, substitution_context, false, key_values, reason);
+            else
+                config_src.load_from_json(subfile, substitution_context, false, key_values, reason);
             if (!reason.empty()) {
                 ++m_errors;
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": load config file "<<subfile<<" Failed!";
@@ -3401,6 +3510,14 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
             config = *default_config;
             config.apply(config_src);
             if (instantiation == "false" && "Template" != vendor_name) {
+                if (resolvable && is_from_lib) {
+                    // The templates of OrcaFilamentLibrary are inherited by the presets of the other vendors.
+                    json diff;
+                    if (resolved_config_diff(config, presets_collection->default_preset().config, diff))
+                        resolved["templates"].push_back({ { "name", preset_name }, { "filament_id", filament_id }, { "diff", std::move(diff) } });
+                    else
+                        resolvable = false;
+                }
                 config_maps.emplace(preset_name, std::move(config));
                 if ((presets_collection->type() == Preset::TYPE_FILAMENT) && (!filament_id.empty()))
                     filament_id_maps.emplace(preset_name, filament_id);
@@ -3519,6 +3636,7 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
                 boost::trim_right(alias_name);
             }
         }
+        const bool hold_alias = ! alias_name.empty();
         if (alias_name.empty())
             loaded.alias = preset_name;
         else {
@@ -3526,6 +3644,22 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
             filaments.set_printer_hold_alias(loaded.alias, loaded);
         }
         loaded.renamed_from = std::move(renamed_from);
+        if (! substitution_context.empty())
+            resolvable = false;
+        if (resolvable) {
+            json diff;
+            if (&presets_collection->default_preset_for(loaded.config) == &presets_collection->default_preset() &&
+                resolved_config_diff(loaded.config, presets_collection->default_preset().config, diff)) {
+                const char *section = presets_collection->type() == Preset::TYPE_PRINT ? "process" :
+                                      presets_collection->type() == Preset::TYPE_FILAMENT ? "filament" : "machine";
+                resolved[section].push_back({
+                    { "name", preset_name }, { "file", subfile_iter.second }, { "description", loaded.description },
+                    { "setting_id", loaded.setting_id }, { "filament_id", loaded.filament_id }, { "alias", loaded.alias },
+                    { "hold_alias", hold_alias }, { "renamed_from", loaded.renamed_from }, { "from_lib", is_from_lib },
+                    { "diff", std::move(diff) } });
+            } else
+                resolvable = false;
+        }
         if (! substitution_context.empty())
             substitutions.push_back({
                 preset_name, presets_collection->type(), PresetConfigSubstitutions::Source::ConfigBundle,
@@ -3614,11 +3748,110 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
                             " total_ms=" + std::to_string(total_ms));
     }
 
+    if (resolvable && m_errors == errors_start) {
+        // The sub-profiles are not needed anymore once the presets were resolved.
+        for (const auto *subfiles : { &process_subfiles, &filament_subfiles, &machine_subfiles })
+            for (const auto &subfile : *subfiles)
+                index->erase_document(vendor_name + "/" + subfile.second);
+        index->set_resolved_presets(std::move(resolved));
+    }
+
     //BBS: add config related logs
     BOOST_LOG_TRIVIAL(debug) << __FUNCTION__ << boost::format(", finished, presets_loaded %1%")%presets_loaded;
     return std::make_pair(std::move(substitutions), presets_loaded);
 }
 
+bool PresetBundle::load_resolved_presets(const VendorProfileIndex &index, const VendorProfile *vendor_profile, size_t &presets_loaded)
+{
+    struct ResolvedPreset {
+        PresetCollection         *collection;
+        std::string               name;
+        std::string               file;
+        std::string               description;
+        std::string               setting_id;
+        std::string               filament_id;
+        std::string               alias;
+        bool                      hold_alias;
+        std::vector<std::string>  renamed_from;
+        bool                      from_lib;
+        DynamicPrintConfig        config;
+    };
+    const std::string  &vendor_name = index.vendor_name();
+    const json         &resolved    = *index.resolved_presets();
+    std::vector<ResolvedPreset>                 presets;
+    std::map<std::string, DynamicPrintConfig>   config_maps;
+    std::map<std::string, std::string>          filament_id_maps;
+
+    // Restore all the configs first, so that nothing is loaded if any of them fails.
+    CNumericLocalesSetter locales_setter;
+    auto restore_config = [](const DynamicPrintConfig &base, const json &diff, DynamicPrintConfig &config) {
+        config = base;
+        for (auto it = diff.begin(); it != diff.end(); ++ it) {
+            ConfigOption *opt = config.option(it.key(), true);
+            if (opt == nullptr || ! opt->deserialize(it.value().get<std::string>()))
+                throw ConfigurationError("invalid value of " + it.key());
+        }
+    };
+    try {
+        for (const auto &[section, collection] : { std::make_pair("process", static_cast<PresetCollection*>(&this->prints)),
+                                                   std::make_pair("filament", static_cast<PresetCollection*>(&this->filaments)),
+                                                   std::make_pair("machine", static_cast<PresetCollection*>(&this->printers)) })
+            for (const json &entry : resolved.at(section)) {
+                ResolvedPreset &preset = presets.emplace_back();
+                preset.collection   = collection;
+                preset.name         = entry.at("name").get<std::string>();
+                preset.file         = entry.at("file").get<std::string>();
+                preset.description  = entry.at("description").get<std::string>();
+                preset.setting_id   = entry.at("setting_id").get<std::string>();
+                preset.filament_id  = entry.at("filament_id").get<std::string>();
+                preset.alias        = entry.at("alias").get<std::string>();
+                preset.hold_alias   = entry.at("hold_alias").get<bool>();
+                preset.renamed_from = entry.at("renamed_from").get<std::vector<std::string>>();
+                preset.from_lib     = entry.at("from_lib").get<bool>();
+                restore_config(collection->default_preset().config, entry.at("diff"), preset.config);
+            }
+        if (vendor_name == ORCA_FILAMENT_LIBRARY)
+            for (const json &entry : resolved.at("templates")) {
+                const std::string name        = entry.at("name").get<std::string>();
+                const std::string filament_id = entry.at("filament_id").get<std::string>();
+                restore_config(this->filaments.default_preset().config, entry.at("diff"), config_maps[name]);
+                if (! filament_id.empty())
+                    filament_id_maps.emplace(name, filament_id);
+            }
+    } catch (const std::exception &err) {
+        BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << boost::format(": failed restoring the resolved presets of vendor %1%, reason = %2%") % vendor_name % err.what();
+        return false;
+    }
+
+    for (ResolvedPreset &preset : presets) {
+        const auto file_path = (boost::filesystem::path(data_dir()) / PRESET_SYSTEM_DIR / vendor_name / preset.file).make_preferred();
+        Preset &loaded = preset.collection->load_preset(file_path.string(), preset.name, std::move(preset.config), false);
+        loaded.is_system                = true;
+        loaded.vendor                   = vendor_profile;
+        loaded.version                  = vendor_profile->config_version;
+        loaded.description              = std::move(preset.description);
+        loaded.setting_id               = std::move(preset.setting_id);
+        loaded.filament_id              = preset.filament_id;
+        loaded.m_from_orca_filament_lib = preset.from_lib;
+        loaded.alias                    = std::move(preset.alias);
+        if (preset.hold_alias)
+            this->filaments.set_printer_hold_alias(loaded.alias, loaded);
+        loaded.renamed_from             = std::move(preset.renamed_from);
+        if (vendor_name == ORCA_FILAMENT_LIBRARY && preset.collection == &this->filaments) {
+            config_maps.emplace(loaded.name, loaded.config);
+            if (! preset.filament_id.empty())
+                filament_id_maps.emplace(loaded.name, preset.filament_id);
+        }
+        ++ presets_loaded;
+    }
+    if (vendor_name == ORCA_FILAMENT_LIBRARY) {
+        m_config_maps      = std::move(config_maps);
+        m_filament_id_maps = std::move(filament_id_maps);
+    }
+    BOOST_LOG_TRIVIAL(debug) << __FUNCTION__ << boost::format(": restored %1% resolved presets of vendor %2%") % presets_loaded % vendor_name;
+    return true;
+}
+
 void PresetBundle::update_multi_material_filament_presets(size_t to_delete_filament_id, size_t old_num_filaments_arg)
 {
     if (printers.get_edited_preset().printer_technology() != ptFFF)
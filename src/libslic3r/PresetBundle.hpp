@@ -43,6 +43,8 @@ struct ConnectMachineInfo
 
 namespace Slic3r {
 
+class VendorProfileIndex;
+
 // Bundle of Print + Filament + Printer presets.
 class PresetBundle
 {
@@ -246,8 +248,11 @@ public:
     /*std::pair<PresetsConfigSubstitutions, size_t> load_configbundle(
         const std::string &path, LoadConfigBundleAttributes flags, ForwardCompatibilitySubstitutionRule compatibility_rule);*/
     //Orca: load config bundle from json, pass the base bundle to support cross vendor inheritance
+    // The json documents are read through index if provided, see VendorProfileIndex. The presets are restored from the index
+    // if it holds the resolved presets, otherwise the resolved presets are recorded into the index to be stored.
     std::pair<PresetsConfigSubstitutions, size_t> load_vendor_configs_from_json(
-        const std::string &path, const std::string &vendor_name, LoadConfigBundleAttributes flags, ForwardCompatibilitySubstitutionRule compatibility_rule, const PresetBundle* base_bundle = nullptr);
+        const std::string &path, const std::string &vendor_name, LoadConfigBundleAttributes flags, ForwardCompatibilitySubstitutionRule compatibility_rule, const PresetBundle* base_bundle = nullptr,
+        VendorProfileIndex *index = nullptr);
 
     // Export a config bundle file containing all the presets and the names of the active presets.
     //void                        export_configbundle(const std::string &path, bool export_system_settings = false, bool export_physical_printers = false);
@@ -440,6 +445,9 @@ private:
                                                         const std::vector<unsigned int> &kept_physical_ids = {});
     // Update renamed_from and alias maps of system profiles.
     void 						update_system_maps();
+    // Load the presets of a vendor stored with their inheritance resolved by load_vendor_configs_from_json() into index.
+    // Returns false without loading any preset if the stored presets cannot be restored.
+    bool                        load_resolved_presets(const VendorProfileIndex &index, const VendorProfile *vendor_profile, size_t &presets_loaded);
 
     // Set the is_visible flag for filaments and sla materials,
     // apply defaults based on enabled printers when no filaments/materials are installed.
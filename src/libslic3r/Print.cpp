@@ -12,11 +12,13 @@
 #include "ShortestPath.hpp"
 #include "Thread.hpp"
 #include "Time.hpp"
+#include "Timer.hpp"
 #include "GCode.hpp"
 #include "GCode/WipeTower.hpp"
 #include "GCode/WipeTower2.hpp"
 #include "Utils.hpp"
 #include "PrintConfig.hpp"
+#include "PrintProfiler.hpp"
 #include "FilamentHotBedNozzleRules.hpp"
 #include "Model.hpp"
 #include "format.hpp"
@@ -30,6 +32,9 @@
 #include <boost/log/trivial.hpp>
 #include <boost/regex.hpp>
 #include <boost/nowide/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/algorithm/hex.hpp>
+#include <boost/uuid/detail/md5.hpp>
 
 #include <tbb/blocked_range.h>
 #include <tbb/parallel_for.h>
@@ -38,6 +43,7 @@
 #include "nlohmann/json.hpp"
 
 #include "GCode/ConflictChecker.hpp"
+#include "GCode/GCodeProcessorResultFile.hpp"
 
 #include <codecvt>
 
@@ -515,17 +521,26 @@ void Print::clear()
 	m_objects.clear();
     m_print_regions.clear();
     m_model.clear_objects();
+    m_gcode_layer_cache.reset();
 }
 
-// Called by Print::apply().
-// This method only accepts PrintConfig option keys.
-bool Print::invalidate_state_by_config_options(const ConfigOptionResolver & /* new_config */, const std::vector<t_config_option_key> &opt_keys)
+void Print::set_keep_reslice_caches(bool keep)
 {
-    if (opt_keys.empty())
-        return false;
+    m_keep_reslice_caches = keep;
+    if (! keep) {
+        for (PrintObject *object : m_objects) {
+            object->m_volume_slices_cache.clear();
+            object->m_volume_slices_cache_memory = 0;
+        }
+        m_gcode_layer_cache.reset();
+    }
+}
 
-    // Cache the plenty of parameters, which influence the G-code generator only,
-    // or they are only notes not influencing the generated G-code.
+// Cache the plenty of parameters, which influence the G-code generator only,
+// or they are only notes not influencing the generated G-code.
+// Shared by the step invalidation and by the persistent slice cache key.
+static const std::unordered_set<std::string>& print_config_gcode_only_options()
+{
     static std::unordered_set<std::string> steps_gcode = {
         //BBS
         "additional_cooling_fan_speed",
@@ -661,6 +676,17 @@ bool Print::invalidate_state_by_config_options(const ConfigOptionResolver & /* n
         "filament_long_retractions_when_cut",
         "filament_retraction_distances_when_cut"
     };
+    return steps_gcode;
+}
+
+// Called by Print::apply().
+// This method only accepts PrintConfig option keys.
+bool Print::invalidate_state_by_config_options(const ConfigOptionResolver & /* new_config */, const std::vector<t_config_option_key> &opt_keys)
+{
+    if (opt_keys.empty())
+        return false;
+
+    const std::unordered_set<std::string> &steps_gcode = print_config_gcode_only_options();
 
     static std::unordered_set<std::string> steps_ignore;
 
@@ -842,6 +868,33 @@ void Print::set_calib_params(const Calib_Params& params) {
     m_calib_params.mode = params.mode;
 }
 
+static const char* print_step_name(PrintStep step)
+{
+    switch (step) {
+    case psWipeTower:       return "psWipeTower";
+    case psSkirtBrim:       return "psSkirtBrim";
+    case psGCodeExport:     return "psGCodeExport";
+    case psConflictCheck:   return "psConflictCheck";
+    default:                return "psUnknown";
+    }
+}
+
+bool Print::set_started(PrintStep step)
+{
+    bool started = Inherited::set_started(step);
+    if (started && m_profiler)
+        m_profiler->step_started(this, print_step_name(step));
+    return started;
+}
+
+PrintStateBase::TimeStamp Print::set_done(PrintStep step)
+{
+    PrintStateBase::TimeStamp timestamp = Inherited::set_done(step);
+    if (m_profiler)
+        m_profiler->step_finished(this, print_step_name(step));
+    return timestamp;
+}
+
 bool Print::invalidate_step(PrintStep step)
 {
 	bool invalidated = Inherited::invalidate_step(step);
@@ -2447,6 +2500,10 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
 
     BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": total object counts %1% in current print, need to slice %2%")%m_objects.size()%need_slicing_objects.size();
     BOOST_LOG_TRIVIAL(info) << "Starting the slicing process." << log_memory_info();
+    // Objects sliced by this call, which shall be written into the persistent slice cache, with their cache keys.
+    std::map<PrintObject*, std::string> slice_cache_missed_keys;
+    if (!use_cache && !m_slice_cache_dir.empty())
+        this->load_objects_from_slice_cache(need_slicing_objects, slice_cache_missed_keys);
     if (!use_cache) {
         for (PrintObject *obj : m_objects) {
             if (need_slicing_objects.count(obj) != 0) {
@@ -2491,6 +2548,7 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
 
         tbb::parallel_for(tbb::blocked_range<int>(0, int(m_objects.size())),
             [this, need_slicing_objects](const tbb::blocked_range<int>& range) {
+                TASK_TRACE_SCOPE("Print::process support material");
                 for (int i = range.begin(); i < range.end(); i++) {
                     PrintObject* obj = m_objects[i];
                     if (need_slicing_objects.count(obj) != 0) {
@@ -2543,6 +2601,12 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
         }
     }
 
+    if (!slice_cache_missed_keys.empty())
+        this->store_objects_to_slice_cache(slice_cache_missed_keys);
+    // Evict the least recently used entries of the objects and of the tree supports.
+    if (!m_slice_cache_dir.empty() && (m_slice_cache_statistics.stored > 0 || m_slice_cache_statistics.tree_support_areas_computed > 0))
+        trim_cache_dir(m_slice_cache_dir, m_slice_cache_max_size);
+
     for (PrintObject *obj : m_objects)
     {
         if (need_slicing_objects.count(obj) == 0) {
@@ -2680,6 +2744,10 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
     {
         using Clock                 = std::chrono::high_resolution_clock;
         auto            startTime   = Clock::now();
+        // psConflictCheck is a PrintStep, but process() runs the conflict check every time without set_started() / set_done(),
+        // thus it is reported to the profiler explicitly.
+        if (m_profiler)
+            m_profiler->step_started(this, print_step_name(psConflictCheck));
         std::optional<const FakeWipeTower *> wipe_tower_opt = {};
         if (this->has_wipe_tower()) {
             m_fake_wipe_tower.set_pos({m_config.wipe_tower_x.get_at(m_plate_index), m_config.wipe_tower_y.get_at(m_plate_index)});
@@ -2689,6 +2757,8 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
         auto            endTime     = Clock::now();
         volatile double seconds     = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count() / (double) 1000;
         BOOST_LOG_TRIVIAL(info) << "gcode path conflicts check takes " << seconds << " secs.";
+        if (m_profiler)
+            m_profiler->step_finished(this, print_step_name(psConflictCheck));
 
         m_conflict_result = conflictRes;
         if (conflictRes.has_value()) {
@@ -3496,10 +3566,20 @@ void Print::set_gcode_file_invalidated()
 //BBS: add gcode file preload logic
 void Print::export_gcode_from_previous_file(const std::string& file, GCodeProcessorResult* result, ThumbnailsGeneratorCallback thumbnail_cb)
 {
+    const Vec3d origin = this->get_plate_origin();
+    const GCodeProcessorResultSource source { file, Vec2d(origin(0), origin(1)), is_BBL_printer() };
+    const std::string result_path = gcode_processor_result_path(file);
+    // Reuse the result stored next to the G-code when it was processed last time, it is much faster than parsing the G-code again.
+    result->reset();
+    if (load_gcode_processor_result(result_path, source, *result)) {
+        result->id = GCodeProcessor::new_result_id();
+        BOOST_LOG_TRIVIAL(info) << __FUNCTION__ <<  boost::format(":  loaded the processed G-code file %1% from %2%")%file.c_str() %result_path.c_str();
+        return;
+    }
+
     try {
         GCodeProcessor processor;
         GCodeProcessor::s_IsBBLPrinter = is_BBL_printer();
-        const Vec3d origin = this->get_plate_origin();
         processor.set_xy_offset(origin(0), origin(1));
         //processor.enable_producers(true);
         processor.process_file(file);
@@ -3512,6 +3592,9 @@ void Print::export_gcode_from_previous_file(const std::string& file, GCodeProces
     }
 
     BOOST_LOG_TRIVIAL(info) << __FUNCTION__ <<  boost::format(":  process the G-code file %1% successfully")%file.c_str();
+
+    // Not being able to store the result is not an error, the G-code will be processed again next time.
+    store_gcode_processor_result(*result, source, result_path);
 }
 
 std::tuple<float, float> Print::object_skirt_offset(double margin_height) const
@@ -4385,55 +4468,296 @@ static void from_json(const json& j, groupedVolumeSlices& firstlayer_group)
     }
 }
 
-int Print::export_cached_data(const std::string& directory, bool with_space)
+static void convert_layer_to_json(json& layer_json, const Layer* layer)
 {
-    int ret = 0;
-    boost::filesystem::path directory_path(directory);
+    json slice_polygons_json = json::array(), slice_bboxs_json = json::array(), overhang_polygons_json = json::array(), layer_regions_json = json::array();
+    layer_json[JSON_LAYER_PRINT_Z] = layer->print_z;
+    layer_json[JSON_LAYER_HEIGHT] = layer->height;
+    layer_json[JSON_LAYER_SLICE_Z] = layer->slice_z;
+    layer_json[JSON_LAYER_ID] = layer->id();
+    //layer_json["slicing_errors"] = layer->slicing_errors;
 
-    auto convert_layer_to_json = [](json& layer_json, const Layer* layer) {
-        json slice_polygons_json = json::array(), slice_bboxs_json = json::array(), overhang_polygons_json = json::array(), layer_regions_json = json::array();
-        layer_json[JSON_LAYER_PRINT_Z] = layer->print_z;
-        layer_json[JSON_LAYER_HEIGHT] = layer->height;
-        layer_json[JSON_LAYER_SLICE_Z] = layer->slice_z;
-        layer_json[JSON_LAYER_ID] = layer->id();
-        //layer_json["slicing_errors"] = layer->slicing_errors;
+    //sliced_polygons
+    for (const ExPolygon& slice_polygon : layer->lslices) {
+        json slice_polygon_json = slice_polygon;
+        slice_polygons_json.push_back(std::move(slice_polygon_json));
+    }
+    layer_json[JSON_LAYER_SLICED_POLYGONS] = std::move(slice_polygons_json);
 
-        //sliced_polygons
-        for (const ExPolygon& slice_polygon : layer->lslices) {
-            json slice_polygon_json = slice_polygon;
-            slice_polygons_json.push_back(std::move(slice_polygon_json));
-        }
-        layer_json[JSON_LAYER_SLICED_POLYGONS] = std::move(slice_polygons_json);
+    //sliced_bbox
+    for (const BoundingBox& slice_bbox : layer->lslices_bboxes) {
+        json bbox_json = json::array();
+
+        bbox_json = slice_bbox;
+        slice_bboxs_json.push_back(std::move(bbox_json));
+    }
+    layer_json[JSON_LAYER_SLLICED_BBOXES] = std::move(slice_bboxs_json);
+
+    //overhang_polygons
+    for (const ExPolygon& overhang_polygon : layer->loverhangs) {
+        json overhang_polygon_json = overhang_polygon;
+        overhang_polygons_json.push_back(std::move(overhang_polygon_json));
+    }
+    layer_json[JSON_LAYER_OVERHANG_POLYGONS] = std::move(overhang_polygons_json);
+
+    //overhang_box
+    layer_json[JSON_LAYER_OVERHANG_BBOX] = layer->loverhangs_bbox;
 
-        //sliced_bbox
-        for (const BoundingBox& slice_bbox : layer->lslices_bboxes) {
-            json bbox_json = json::array();
+    for (const LayerRegion *layer_region : layer->regions()) {
+        json region_json = *layer_region;
 
-            bbox_json = slice_bbox;
-            slice_bboxs_json.push_back(std::move(bbox_json));
+        layer_regions_json.push_back(std::move(region_json));
+    }
+    layer_json[JSON_LAYER_REGIONS] = std::move(layer_regions_json);
+}
+
+// Serialize the layers, support layers and first layer groups of a single PrintObject.
+// Shared by export_cached_data() and the persistent slice cache.
+static void convert_print_object_to_json(json& root_json, const PrintObject* obj, size_t identify_id)
+{
+    const ModelObject* model_obj = obj->model_object();
+    json layers_json = json::array(), support_layers_json = json::array(), first_layer_groups = json::array();
+
+    root_json[JSON_OBJECT_NAME] = model_obj->name;
+    root_json[JSON_IDENTIFY_ID] = identify_id;
+
+    //export the layers
+    std::vector<json> layers_json_vector(obj->layer_count());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, obj->layer_count()),
+        [&layers_json_vector, obj](const tbb::blocked_range<size_t>& layer_range) {
+            for (size_t layer_index = layer_range.begin(); layer_index < layer_range.end(); ++ layer_index) {
+                const Layer *layer = obj->get_layer(layer_index);
+                json layer_json;
+                convert_layer_to_json(layer_json, layer);
+                layers_json_vector[layer_index] = std::move(layer_json);
+            }
         }
-        layer_json[JSON_LAYER_SLLICED_BBOXES] = std::move(slice_bboxs_json);
+    );
+    for (int l_index = 0; l_index < layers_json_vector.size(); l_index++) {
+        layers_json.push_back(std::move(layers_json_vector[l_index]));
+    }
+    layers_json_vector.clear();
+
+    root_json[JSON_LAYERS] = std::move(layers_json);
+
+    //export the support layers
+    std::vector<json> support_layers_json_vector(obj->support_layer_count());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, obj->support_layer_count()),
+        [&support_layers_json_vector, obj](const tbb::blocked_range<size_t>& support_layer_range) {
+            for (size_t s_layer_index = support_layer_range.begin(); s_layer_index < support_layer_range.end(); ++ s_layer_index) {
+                const SupportLayer *support_layer = obj->support_layers()[s_layer_index];
+                json support_layer_json, support_islands_json = json::array(), support_fills_json, supportfills_entities_json = json::array();
+
+                convert_layer_to_json(support_layer_json, support_layer);
+
+                support_layer_json[JSON_SUPPORT_LAYER_INTERFACE_ID] = support_layer->interface_id();
+                support_layer_json[JSON_SUPPORT_LAYER_TYPE] = support_layer->support_type;
+
+                //support_islands
+                for (const ExPolygon& support_island : support_layer->support_islands) {
+                    json support_island_json = support_island;
+                    support_islands_json.push_back(std::move(support_island_json));
+                }
+                support_layer_json[JSON_SUPPORT_LAYER_ISLANDS] = std::move(support_islands_json);
 
-        //overhang_polygons
-        for (const ExPolygon& overhang_polygon : layer->loverhangs) {
-            json overhang_polygon_json = overhang_polygon;
-            overhang_polygons_json.push_back(std::move(overhang_polygon_json));
+                //support_fills
+                support_fills_json[JSON_EXTRUSION_NO_SORT] = support_layer->support_fills.no_sort;
+                support_fills_json[JSON_EXTRUSION_ENTITY_TYPE] = JSON_EXTRUSION_TYPE_COLLECTION;
+                for (const ExtrusionEntity* extrusion_entity : support_layer->support_fills.entities) {
+                    json supportfill_entity_json, supportfill_entity_paths_json = json::array();
+                    bool ret = convert_extrusion_to_json(supportfill_entity_json, supportfill_entity_paths_json, extrusion_entity);
+                    if (!ret)
+                        continue;
+
+                    supportfills_entities_json.push_back(std::move(supportfill_entity_json));
+                }
+                support_fills_json[JSON_EXTRUSION_ENTITIES] = std::move(supportfills_entities_json);
+                support_layer_json[JSON_SUPPORT_LAYER_FILLS] = std::move(support_fills_json);
+
+                support_layers_json_vector[s_layer_index] = std::move(support_layer_json);
+            }
         }
-        layer_json[JSON_LAYER_OVERHANG_POLYGONS] = std::move(overhang_polygons_json);
+    );
+    for (int s_index = 0; s_index < support_layers_json_vector.size(); s_index++) {
+        support_layers_json.push_back(std::move(support_layers_json_vector[s_index]));
+    }
+    support_layers_json_vector.clear();
 
-        //overhang_box
-        layer_json[JSON_LAYER_OVERHANG_BBOX] = layer->loverhangs_bbox;
+    root_json[JSON_SUPPORT_LAYERS] = std::move(support_layers_json);
 
-        for (const LayerRegion *layer_region : layer->regions()) {
-            json region_json = *layer_region;
+    const std::vector<groupedVolumeSlices> &first_layer_obj_groups =  obj->firstLayerObjGroups();
+    for (size_t s_group_index = 0; s_group_index < first_layer_obj_groups.size(); ++ s_group_index) {
+        groupedVolumeSlices group = first_layer_obj_groups[s_group_index];
 
-            layer_regions_json.push_back(std::move(region_json));
+        //convert the id
+        for (ObjectID& obj_id : group.volume_ids)
+        {
+            const ModelVolume* currentModelVolumePtr = nullptr;
+            //BBS: support shared object logic
+            const PrintObject* shared_object = obj->get_shared_object();
+            if (!shared_object)
+                shared_object = obj;
+            const ModelVolumePtrs& volumes_ptr = shared_object->model_object()->volumes;
+            size_t volume_count = volumes_ptr.size();
+            for (size_t index = 0; index < volume_count; index ++) {
+                currentModelVolumePtr = volumes_ptr[index];
+                if (currentModelVolumePtr->id() == obj_id) {
+                    obj_id.id = index;
+                    break;
+                }
+            }
         }
-        layer_json[JSON_LAYER_REGIONS] = std::move(layer_regions_json);
 
-        return;
+        json first_layer_group_json;
+
+        first_layer_group_json = group;
+        first_layer_groups.push_back(std::move(first_layer_group_json));
+    }
+    root_json[JSON_FIRSTLAYER_GROUPS] = std::move(first_layer_groups);
+}
+
+// Recreate the layers, support layers and first layer groups of a single PrintObject from its json dump.
+// The PrintObject has to be empty, its print regions are matched by their config hashes.
+// Returns 0 on success, otherwise one of the CLI_IMPORT_CACHE_* / CLI_OUT_OF_MEMORY error codes.
+static int convert_print_object_from_json(json& root_json, PrintObject* obj, const std::string& file_name)
+{
+    auto find_region = [](PrintObject* object, size_t config_hash) -> const PrintRegion* {
+        int regions_count = object->num_printing_regions();
+        for (int index = 0; index < regions_count; index++ )
+        {
+            const PrintRegion&  print_region = object->printing_region(index);
+            if (print_region.config_hash() == config_hash ) {
+                return &print_region;
+            }
+        }
+        return NULL;
     };
 
+    std::string name = root_json.at(JSON_OBJECT_NAME);
+    int identify_id = root_json.at(JSON_IDENTIFY_ID);
+    int layer_count = 0, support_layer_count = 0, firstlayer_group_count = 0;
+
+    layer_count = root_json[JSON_LAYERS].size();
+    support_layer_count = root_json[JSON_SUPPORT_LAYERS].size();
+    firstlayer_group_count = root_json[JSON_FIRSTLAYER_GROUPS].size();
+
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__<<boost::format(":will load %1%, identify_id %2%, layer_count %3%, support_layer_count %4%, firstlayer_group_count %5%")
+        %name %identify_id %layer_count %support_layer_count %firstlayer_group_count;
+
+    Layer* previous_layer = NULL;
+    //create layer and layer regions
+    for (int index = 0; index < layer_count; index++)
+    {
+        json& layer_json = root_json[JSON_LAYERS][index];
+        Layer* new_layer = obj->add_layer(layer_json[JSON_LAYER_ID], layer_json[JSON_LAYER_HEIGHT], layer_json[JSON_LAYER_PRINT_Z], layer_json[JSON_LAYER_SLICE_Z]);
+        if (!new_layer) {
+            BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<< boost::format(":create_layer failed, out of memory");
+            return CLI_OUT_OF_MEMORY;
+        }
+        if (previous_layer) {
+            previous_layer->upper_layer = new_layer;
+            new_layer->lower_layer = previous_layer;
+        }
+        previous_layer = new_layer;
+
+        //layer regions
+        int layer_regions_count = layer_json[JSON_LAYER_REGIONS].size();
+        for (int region_index = 0; region_index < layer_regions_count; region_index++)
+        {
+            json& region_json = layer_json[JSON_LAYER_REGIONS][region_index];
+            size_t config_hash = region_json[JSON_LAYER_REGION_CONFIG_HASH];
+            const PrintRegion *print_region = find_region(obj, config_hash);
+
+            if (!print_region){
+                BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<< boost::format(":can not find print region of object %1%, layer %2%, print_z %3%, layer_region %4%")
+                    %name % index %new_layer->print_z %region_index;
+                //delete new_layer;
+                return CLI_IMPORT_CACHE_DATA_CAN_NOT_USE;
+            }
+
+            new_layer->add_region(print_region);
+        }
+
+    }
+
+    //load the layer data parallel
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__<<boost::format(": load the layers in parallel");
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, obj->layer_count()),
+        [&root_json, &obj](const tbb::blocked_range<size_t>& layer_range) {
+            for (size_t layer_index = layer_range.begin(); layer_index < layer_range.end(); ++ layer_index) {
+                const json& layer_json = root_json[JSON_LAYERS][layer_index];
+                Layer* layer = obj->get_layer(layer_index);
+                extract_layer(layer_json, *layer);
+            }
+        }
+    );
+
+    //support layers
+    Layer* previous_support_layer = NULL;
+    //create support_layers
+    for (int index = 0; index < support_layer_count; index++)
+    {
+        json& layer_json = root_json[JSON_SUPPORT_LAYERS][index];
+        SupportLayer* new_support_layer = obj->add_support_layer(layer_json[JSON_LAYER_ID], layer_json[JSON_SUPPORT_LAYER_INTERFACE_ID], layer_json[JSON_LAYER_HEIGHT], layer_json[JSON_LAYER_PRINT_Z]);
+        if (!new_support_layer) {
+            BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<< boost::format(":add_support_layer failed, out of memory");
+            return CLI_OUT_OF_MEMORY;
+        }
+        if (previous_support_layer) {
+            previous_support_layer->upper_layer = new_support_layer;
+            new_support_layer->lower_layer = previous_support_layer;
+        }
+        previous_support_layer = new_support_layer;
+    }
+
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< boost::format(": finished load layers, start to load support_layers.");
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, obj->support_layer_count()),
+        [&root_json, &obj](const tbb::blocked_range<size_t>& support_layer_range) {
+            for (size_t layer_index = support_layer_range.begin(); layer_index < support_layer_range.end(); ++ layer_index) {
+                const json& layer_json = root_json[JSON_SUPPORT_LAYERS][layer_index];
+                SupportLayer* support_layer = obj->get_support_layer(layer_index);
+                extract_support_layer(layer_json, *support_layer);
+            }
+        }
+    );
+
+    //load first group volumes
+    std::vector<groupedVolumeSlices>& firstlayer_objgroups = obj->firstLayerObjGroupsMod();
+    for (int index = 0; index < firstlayer_group_count; index++)
+    {
+        json& firstlayer_group_json = root_json[JSON_FIRSTLAYER_GROUPS][index];
+        groupedVolumeSlices firstlayer_group = firstlayer_group_json;
+        //convert the id
+        for (ObjectID& obj_id : firstlayer_group.volume_ids)
+        {
+            ModelVolume* currentModelVolumePtr = nullptr;
+            ModelVolumePtrs& volumes_ptr = obj->model_object()->volumes;
+            size_t volume_count = volumes_ptr.size();
+            if (obj_id.id < volume_count) {
+                currentModelVolumePtr = volumes_ptr[obj_id.id];
+                obj_id = currentModelVolumePtr->id();
+            }
+            else {
+                BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< boost::format(": can not find volume_id %1% from object file %2% in firstlayer groups, volume_count %3%!")
+                    %obj_id.id %file_name %volume_count;
+                return CLI_IMPORT_CACHE_LOAD_FAILED;
+            }
+        }
+        firstlayer_objgroups.push_back(std::move(firstlayer_group));
+    }
+
+    return 0;
+}
+
+int Print::export_cached_data(const std::string& directory, bool with_space)
+{
+    int ret = 0;
+    boost::filesystem::path directory_path(directory);
+
     //firstly clear this directory
     if (fs::exists(directory_path)) {
         fs::remove_all(directory_path);
@@ -4468,154 +4792,11 @@ int Print::export_cached_data(const std::string& directory, bool with_space)
         BOOST_LOG_TRIVIAL(info) << boost::format("begin to dump object %1%, identify_id %2% to %3%")%model_obj->name %identify_id %file_name;
 
         try {
-            json root_json, layers_json = json::array(), support_layers_json = json::array(), first_layer_groups = json::array();
-
-            root_json[JSON_OBJECT_NAME] = model_obj->name;
-            root_json[JSON_IDENTIFY_ID] = identify_id;
-
-            //export the layers
-            std::vector<json> layers_json_vector(obj->layer_count());
-            tbb::parallel_for(
-                tbb::blocked_range<size_t>(0, obj->layer_count()),
-                [&layers_json_vector, obj, convert_layer_to_json](const tbb::blocked_range<size_t>& layer_range) {
-                    for (size_t layer_index = layer_range.begin(); layer_index < layer_range.end(); ++ layer_index) {
-                        const Layer *layer = obj->get_layer(layer_index);
-                        json layer_json;
-                        convert_layer_to_json(layer_json, layer);
-                        layers_json_vector[layer_index] = std::move(layer_json);
-                    }
-                }
-            );
-            for (int l_index = 0; l_index < layers_json_vector.size(); l_index++) {
-                layers_json.push_back(std::move(layers_json_vector[l_index]));
-            }
-            layers_json_vector.clear();
-            /*for (const Layer *layer : obj->layers()) {
-                // for each layer
-                json layer_json;
-
-                convert_layer_to_json(layer_json, layer);
-
-                layers_json.push_back(std::move(layer_json));
-            }*/
-
-            root_json[JSON_LAYERS] = std::move(layers_json);
-
-            //export the support layers
-            std::vector<json> support_layers_json_vector(obj->support_layer_count());
-            tbb::parallel_for(
-                tbb::blocked_range<size_t>(0, obj->support_layer_count()),
-                [&support_layers_json_vector, obj, convert_layer_to_json](const tbb::blocked_range<size_t>& support_layer_range) {
-                    for (size_t s_layer_index = support_layer_range.begin(); s_layer_index < support_layer_range.end(); ++ s_layer_index) {
-                        const SupportLayer *support_layer = obj->get_support_layer(s_layer_index);
-                        json support_layer_json, support_islands_json = json::array(), support_fills_json, supportfills_entities_json = json::array();
-
-                        convert_layer_to_json(support_layer_json, support_layer);
-
-                        support_layer_json[JSON_SUPPORT_LAYER_INTERFACE_ID] = support_layer->interface_id();
-                        support_layer_json[JSON_SUPPORT_LAYER_TYPE] = support_layer->support_type;
-
-                        //support_islands
-                        for (const ExPolygon& support_island : support_layer->support_islands) {
-                            json support_island_json = support_island;
-                            support_islands_json.push_back(std::move(support_island_json));
-                        }
-                        support_layer_json[JSON_SUPPORT_LAYER_ISLANDS] = std::move(support_islands_json);
-
-                        //support_fills
-                        support_fills_json[JSON_EXTRUSION_NO_SORT] = support_layer->support_fills.no_sort;
-                        support_fills_json[JSON_EXTRUSION_ENTITY_TYPE] = JSON_EXTRUSION_TYPE_COLLECTION;
-                        for (const ExtrusionEntity* extrusion_entity : support_layer->support_fills.entities) {
-                            json supportfill_entity_json, supportfill_entity_paths_json = json::array();
-                            bool ret = convert_extrusion_to_json(supportfill_entity_json, supportfill_entity_paths_json, extrusion_entity);
-                            if (!ret)
-                                continue;
-
-                            supportfills_entities_json.push_back(std::move(supportfill_entity_json));
-                        }
-                        support_fills_json[JSON_EXTRUSION_ENTITIES] = std::move(supportfills_entities_json);
-                        support_layer_json[JSON_SUPPORT_LAYER_FILLS] = std::move(support_fills_json);
-
-                        support_layers_json_vector[s_layer_index] = std::move(support_layer_json);
-                    }
-                }
-            );
-            for (int s_index = 0; s_index < support_layers_json_vector.size(); s_index++) {
-                support_layers_json.push_back(std::move(support_layers_json_vector[s_index]));
-            }
-            support_layers_json_vector.clear();
-
-            /*for (const SupportLayer *support_layer : obj->support_layers()) {
-                json support_layer_json, support_islands_json = json::array(), support_fills_json, supportfills_entities_json = json::array();
-
-                convert_layer_to_json(support_layer_json, support_layer);
-
-                support_layer_json[JSON_SUPPORT_LAYER_INTERFACE_ID] = support_layer->interface_id();
-
-                //support_islands
-                for (const ExPolygon& support_island : support_layer->support_islands.expolygons) {
-                    json support_island_json = support_island;
-                    support_islands_json.push_back(std::move(support_island_json));
-                }
-                support_layer_json[JSON_SUPPORT_LAYER_ISLANDS] = std::move(support_islands_json);
-
-                //support_fills
-                support_fills_json[JSON_EXTRUSION_NO_SORT] = support_layer->support_fills.no_sort;
-                support_fills_json[JSON_EXTRUSION_ENTITY_TYPE] = JSON_EXTRUSION_TYPE_COLLECTION;
-                for (const ExtrusionEntity* extrusion_entity : support_layer->support_fills.entities) {
-                    json supportfill_entity_json, supportfill_entity_paths_json = json::array();
-                    bool ret = convert_extrusion_to_json(supportfill_entity_json, supportfill_entity_paths_json, extrusion_entity);
-                    if (!ret)
-                        continue;
-
-                    supportfills_entities_json.push_back(std::move(supportfill_entity_json));
-                }
-                support_fills_json[JSON_EXTRUSION_ENTITIES] = std::move(supportfills_entities_json);
-                support_layer_json[JSON_SUPPORT_LAYER_FILLS] = std::move(support_fills_json);
-
-                support_layers_json.push_back(std::move(support_layer_json));
-            } // for each layer*/
-            root_json[JSON_SUPPORT_LAYERS] = std::move(support_layers_json);
-
-            const std::vector<groupedVolumeSlices> &first_layer_obj_groups =  obj->firstLayerObjGroups();
-            for (size_t s_group_index = 0; s_group_index < first_layer_obj_groups.size(); ++ s_group_index) {
-                groupedVolumeSlices group = first_layer_obj_groups[s_group_index];
-
-                //convert the id
-                for (ObjectID& obj_id : group.volume_ids)
-                {
-                    const ModelVolume* currentModelVolumePtr = nullptr;
-                    //BBS: support shared object logic
-                    const PrintObject* shared_object = obj->get_shared_object();
-                    if (!shared_object)
-                        shared_object = obj;
-                    const ModelVolumePtrs& volumes_ptr = shared_object->model_object()->volumes;
-                    size_t volume_count = volumes_ptr.size();
-                    for (size_t index = 0; index < volume_count; index ++) {
-                        currentModelVolumePtr = volumes_ptr[index];
-                        if (currentModelVolumePtr->id() == obj_id) {
-                            obj_id.id = index;
-                            break;
-                        }
-                    }
-                }
-
-                json first_layer_group_json;
-
-                first_layer_group_json = group;
-                first_layer_groups.push_back(std::move(first_layer_group_json));
-            }
-            root_json[JSON_FIRSTLAYER_GROUPS] = std::move(first_layer_groups);
+            json root_json;
+            convert_print_object_to_json(root_json, obj, identify_id);
 
             filename_vector.push_back(file_name);
             json_vector.push_back(std::move(root_json));
-            /*boost::nowide::ofstream c;
-            c.open(file_name, std::ios::out | std::ios::trunc);
-            if (with_space)
-                c << std::setw(4) << root_json << std::endl;
-            else
-                c << root_json.dump(0) << std::endl;
-            c.close();*/
             count ++;
             BOOST_LOG_TRIVIAL(info) << boost::format("will dump object %1%'s json to %2%.")%model_obj->name%file_name;
         }
@@ -4663,18 +4844,6 @@ int Print::load_cached_data(const std::string& directory)
         return CLI_IMPORT_CACHE_NOT_FOUND;
     }
 
-    auto find_region = [this](PrintObject* object, size_t config_hash) -> const PrintRegion* {
-        int regions_count = object->num_printing_regions();
-        for (int index = 0; index < regions_count; index++ )
-        {
-            const PrintRegion&  print_region = object->printing_region(index);
-            if (print_region.config_hash() == config_hash ) {
-                return &print_region;
-            }
-        }
-        return NULL;
-    };
-
     int count = 0;
     std::vector<std::pair<std::string, PrintObject*>> object_filenames;
     for (PrintObject *obj : m_objects) {
@@ -4732,123 +4901,9 @@ int Print::load_cached_data(const std::string& directory)
         PrintObject *obj = object_filenames[obj_index].second;
 
         try {
-            //boost::nowide::ifstream ifs(file_name);
-            //ifs >> root_json;
-
-            std::string name = root_json.at(JSON_OBJECT_NAME);
-            int identify_id = root_json.at(JSON_IDENTIFY_ID);
-            int layer_count = 0, support_layer_count = 0, firstlayer_group_count = 0;
-
-            layer_count = root_json[JSON_LAYERS].size();
-            support_layer_count = root_json[JSON_SUPPORT_LAYERS].size();
-            firstlayer_group_count = root_json[JSON_FIRSTLAYER_GROUPS].size();
-
-            BOOST_LOG_TRIVIAL(info) << __FUNCTION__<<boost::format(":will load %1%, identify_id %2%, layer_count %3%, support_layer_count %4%, firstlayer_group_count %5%")
-                %name %identify_id %layer_count %support_layer_count %firstlayer_group_count;
-
-            Layer* previous_layer = NULL;
-            //create layer and layer regions
-            for (int index = 0; index < layer_count; index++)
-            {
-                json& layer_json = root_json[JSON_LAYERS][index];
-                Layer* new_layer = obj->add_layer(layer_json[JSON_LAYER_ID], layer_json[JSON_LAYER_HEIGHT], layer_json[JSON_LAYER_PRINT_Z], layer_json[JSON_LAYER_SLICE_Z]);
-                if (!new_layer) {
-                    BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<< boost::format(":create_layer failed, out of memory");
-                    return CLI_OUT_OF_MEMORY;
-                }
-                if (previous_layer) {
-                    previous_layer->upper_layer = new_layer;
-                    new_layer->lower_layer = previous_layer;
-                }
-                previous_layer = new_layer;
-
-                //layer regions
-                int layer_regions_count = layer_json[JSON_LAYER_REGIONS].size();
-                for (int region_index = 0; region_index < layer_regions_count; region_index++)
-                {
-                    json& region_json = layer_json[JSON_LAYER_REGIONS][region_index];
-                    size_t config_hash = region_json[JSON_LAYER_REGION_CONFIG_HASH];
-                    const PrintRegion *print_region = find_region(obj, config_hash);
-
-                    if (!print_region){
-                        BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<< boost::format(":can not find print region of object %1%, layer %2%, print_z %3%, layer_region %4%")
-                            %name % index %new_layer->print_z %region_index;
-                        //delete new_layer;
-                        return CLI_IMPORT_CACHE_DATA_CAN_NOT_USE;
-                    }
-
-                    new_layer->add_region(print_region);
-                }
-
-            }
-
-            //load the layer data parallel
-            BOOST_LOG_TRIVIAL(info) << __FUNCTION__<<boost::format(": load the layers in parallel");
-            tbb::parallel_for(
-                tbb::blocked_range<size_t>(0, obj->layer_count()),
-                [&root_json, &obj](const tbb::blocked_range<size_t>& layer_range) {
-                    for (size_t layer_index = layer_range.begin(); layer_index < layer_range.end(); ++ layer_index) {
-                        const json& layer_json = root_json[JSON_LAYERS][layer_index];
-                        Layer* layer = obj->get_layer(layer_index);
-                        extract_layer(layer_json, *layer);
-                    }
-                }
-            );
-
-            //support layers
-            Layer* previous_support_layer = NULL;
-            //create support_layers
-            for (int index = 0; index < support_layer_count; index++)
-            {
-                json& layer_json = root_json[JSON_SUPPORT_LAYERS][index];
-                SupportLayer* new_support_layer = obj->add_support_layer(layer_json[JSON_LAYER_ID], layer_json[JSON_SUPPORT_LAYER_INTERFACE_ID], layer_json[JSON_LAYER_HEIGHT], layer_json[JSON_LAYER_PRINT_Z]);
-                if (!new_support_layer) {
-                    BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<< boost::format(":add_support_layer failed, out of memory");
-                    return CLI_OUT_OF_MEMORY;
-                }
-                if (previous_support_layer) {
-                    previous_support_layer->upper_layer = new_support_layer;
-                    new_support_layer->lower_layer = previous_support_layer;
-                }
-                previous_support_layer = new_support_layer;
-            }
-
-            BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< boost::format(": finished load layers, start to load support_layers.");
-            tbb::parallel_for(
-                tbb::blocked_range<size_t>(0, obj->support_layer_count()),
-                [&root_json, &obj](const tbb::blocked_range<size_t>& support_layer_range) {
-                    for (size_t layer_index = support_layer_range.begin(); layer_index < support_layer_range.end(); ++ layer_index) {
-                        const json& layer_json = root_json[JSON_SUPPORT_LAYERS][layer_index];
-                        SupportLayer* support_layer = obj->get_support_layer(layer_index);
-                        extract_support_layer(layer_json, *support_layer);
-                    }
-                }
-            );
-
-            //load first group volumes
-            std::vector<groupedVolumeSlices>& firstlayer_objgroups = obj->firstLayerObjGroupsMod();
-            for (int index = 0; index < firstlayer_group_count; index++)
-            {
-                json& firstlayer_group_json = root_json[JSON_FIRSTLAYER_GROUPS][index];
-                groupedVolumeSlices firstlayer_group = firstlayer_group_json;
-                //convert the id
-                for (ObjectID& obj_id : firstlayer_group.volume_ids)
-                {
-                    ModelVolume* currentModelVolumePtr = nullptr;
-                    ModelVolumePtrs& volumes_ptr = obj->model_object()->volumes;
-                    size_t volume_count = volumes_ptr.size();
-                    if (obj_id.id < volume_count) {
-                        currentModelVolumePtr = volumes_ptr[obj_id.id];
-                        obj_id = currentModelVolumePtr->id();
-                    }
-                    else {
-                        BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< boost::format(": can not find volume_id %1% from object file %2% in firstlayer groups, volume_count %3%!")
-                            %obj_id.id %object_filenames[obj_index].first %volume_count;
-                        return CLI_IMPORT_CACHE_LOAD_FAILED;
-                    }
-                }
-                firstlayer_objgroups.push_back(std::move(firstlayer_group));
-            }
+            int obj_ret = convert_print_object_from_json(root_json, obj, object_filenames[obj_index].first);
+            if (obj_ret)
+                return obj_ret;
 
             count ++;
             BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< boost::format(": load object %1% from %2% successfully.")%count%object_filenames[obj_index].first;
@@ -4869,6 +4924,177 @@ int Print::load_cached_data(const std::string& directory)
     return ret;
 }
 
+// Bump if the json layout of the cached PrintObjects or the set of hashed inputs changes.
+static constexpr const char *SLICE_CACHE_FORMAT_VERSION = "2";
+
+// Content hash of everything the PrintObject steps posSlice up to posDetectOverhangsForLift depend on:
+// meshes of the model volumes with their transformations and painted facets, variable layer height profile and ranges,
+// the object and region configurations and the print configuration without the options only influencing the G-code export.
+// The instance placement is not hashed, thus the same part at a different position on the bed reuses the cache entry.
+static std::string print_object_slice_cache_key(const PrintObject &print_object)
+{
+    using boost::uuids::detail::md5;
+    md5 md5_hash;
+    auto add_bytes = [&md5_hash](const void *data, size_t size) {
+        if (size > 0)
+            md5_hash.process_bytes(data, size);
+    };
+    auto add_value = [&add_bytes](auto value) { add_bytes(&value, sizeof(value)); };
+    auto add_string = [&add_bytes, &add_value](const std::string &str) {
+        add_value(str.size());
+        add_bytes(str.data(), str.size());
+    };
+    auto add_config = [&add_string](const ConfigBase &config, const std::unordered_set<std::string> *ignore_keys) {
+        for (const t_config_option_key &opt_key : config.keys())
+            if (ignore_keys == nullptr || ignore_keys->find(opt_key) == ignore_keys->end()) {
+                add_string(opt_key);
+                add_string(config.option(opt_key)->serialize());
+            }
+    };
+    auto add_facets = [&add_bytes, &add_value](const FacetsAnnotation &facets) {
+        const TriangleSelector::TriangleSplittingData &data = facets.get_data();
+        add_value(data.triangles_to_split.size());
+        add_bytes(data.triangles_to_split.data(), data.triangles_to_split.size() * sizeof(TriangleSelector::TriangleBitStreamMapping));
+        // std::hash<std::vector<bool>> is implementation defined, hash a stable byte packing of the bits instead.
+        std::vector<uint8_t> bits((data.bitstream.size() + 7) / 8, 0);
+        for (size_t i = 0; i < data.bitstream.size(); ++ i)
+            if (data.bitstream[i])
+                bits[i / 8] |= uint8_t(1 << (i % 8));
+        add_value(uint64_t(data.bitstream.size()));
+        add_bytes(bits.data(), bits.size());
+    };
+
+    add_string(SLICE_CACHE_FORMAT_VERSION);
+    add_string(Snapmaker_VERSION);
+
+    const ModelObject *model_object = print_object.model_object();
+    add_bytes(print_object.trafo().matrix().data(), sizeof(double) * 16);
+    add_value(model_object->volumes.size());
+    for (const ModelVolume *volume : model_object->volumes) {
+        const indexed_triangle_set &its = volume->mesh().its;
+        add_value(int(volume->type()));
+        add_bytes(volume->get_matrix().matrix().data(), sizeof(double) * 16);
+        add_value(its.vertices.size());
+        add_bytes(its.vertices.data(), its.vertices.size() * sizeof(stl_vertex));
+        add_value(its.indices.size());
+        add_bytes(its.indices.data(), its.indices.size() * sizeof(stl_triangle_vertex_indices));
+        add_facets(volume->supported_facets);
+        add_facets(volume->seam_facets);
+        add_facets(volume->mmu_segmentation_facets);
+        add_facets(volume->fuzzy_skin_facets);
+        add_config(volume->config.get(), nullptr);
+    }
+    add_config(model_object->config.get(), nullptr);
+
+    const std::vector<coordf_t> layer_height_profile = model_object->layer_height_profile.get();
+    add_value(layer_height_profile.size());
+    add_bytes(layer_height_profile.data(), layer_height_profile.size() * sizeof(coordf_t));
+    add_value(model_object->layer_config_ranges.size());
+    for (const auto &[range, range_config] : model_object->layer_config_ranges) {
+        add_value(range.first);
+        add_value(range.second);
+        add_config(range_config.get(), nullptr);
+    }
+
+    add_config(print_object.config(), nullptr);
+    for (size_t region_id = 0; region_id < print_object.num_printing_regions(); ++ region_id)
+        add_config(print_object.printing_region(region_id).config(), nullptr);
+    add_config(print_object.print()->config(), &print_config_gcode_only_options());
+
+    md5::digest_type md5_digest{};
+    std::string      md5_digest_str;
+    md5_hash.get_digest(md5_digest);
+    boost::algorithm::hex(md5_digest, md5_digest + std::size(md5_digest), std::back_inserter(md5_digest_str));
+    return md5_digest_str;
+}
+
+void Print::load_objects_from_slice_cache(const std::set<PrintObject*> &objects, std::map<PrintObject*, std::string> &missed_keys)
+{
+    m_slice_cache_statistics.clear();
+    missed_keys.clear();
+
+    boost::system::error_code ec;
+    if (! fs::is_directory(m_slice_cache_dir, ec) && ! fs::create_directories(m_slice_cache_dir, ec)) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << boost::format(": can not create slice cache directory %1%, reason = %2%") % m_slice_cache_dir % ec.message();
+        return;
+    }
+
+    for (PrintObject *obj : m_objects) {
+        // Only the objects to be sliced from scratch may be restored, partially valid objects are finished by process().
+        if (objects.count(obj) == 0 || obj->is_step_done(posSlice))
+            continue;
+
+        std::string key       = print_object_slice_cache_key(*obj);
+        std::string file_name = m_slice_cache_dir + "/" + key + ".json";
+        bool        loaded    = false;
+        if (fs::exists(file_name, ec)) {
+            obj->clear_layers();
+            obj->clear_support_layers();
+            obj->firstLayerObjGroupsMod().clear();
+            try {
+                json root_json;
+                boost::nowide::ifstream ifs(file_name);
+                ifs >> root_json;
+                loaded = convert_print_object_from_json(root_json, obj, file_name) == 0;
+            } catch (std::exception &err) {
+                BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": load from " << file_name << " got a generic exception, reason = " << err.what();
+            }
+            if (! loaded) {
+                obj->clear_layers();
+                obj->clear_support_layers();
+                obj->firstLayerObjGroupsMod().clear();
+            }
+        }
+        this->throw_if_canceled();
+
+        if (loaded) {
+            touch_cache_file(file_name);
+            for (PrintObjectStep step : { posSlice, posPerimeters, posPrepareInfill, posInfill, posIroning, posSupportMaterial, posDetectOverhangsForLift })
+                if (obj->set_started(step))
+                    obj->set_done(step);
+            ++ m_slice_cache_statistics.hits;
+            BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": object %1% restored from slice cache %2%") % obj->model_object()->name % file_name;
+        } else {
+            missed_keys.emplace(obj, std::move(key));
+            ++ m_slice_cache_statistics.misses;
+        }
+    }
+}
+
+void Print::store_objects_to_slice_cache(const std::map<PrintObject*, std::string> &missed_keys)
+{
+    for (const auto &[obj, key] : missed_keys) {
+        if (! obj->is_step_done(posSupportMaterial) || ! obj->is_step_done(posDetectOverhangsForLift))
+            continue;
+
+        const PrintInstance &print_instance = obj->instances()[0];
+        const ModelInstance *model_instance = print_instance.model_instance;
+        size_t identify_id = (model_instance->loaded_id > 0) ? model_instance->loaded_id : model_instance->id().id;
+        std::string file_name = m_slice_cache_dir + "/" + key + ".json";
+        // Write into a temporary file first, so that a concurrent slicing process never reads a partially written entry.
+        std::string tmp_file_name = file_name + "." + std::to_string(get_current_pid()) + ".tmp";
+        try {
+            json root_json;
+            convert_print_object_to_json(root_json, obj, identify_id);
+
+            boost::nowide::ofstream c;
+            c.open(tmp_file_name, std::ios::out | std::ios::trunc);
+            c << root_json.dump(0) << std::endl;
+            c.close();
+            if (c.fail())
+                throw Slic3r::RuntimeError("write error");
+            fs::rename(tmp_file_name, file_name);
+            ++ m_slice_cache_statistics.stored;
+        } catch (std::exception &err) {
+            BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": save to " << file_name << " got a generic exception, reason = " << err.what();
+            boost::system::error_code ec;
+            fs::remove(tmp_file_name, ec);
+        }
+    }
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": slice cache hits %1%, misses %2%, stored %3%")
+        % m_slice_cache_statistics.hits % m_slice_cache_statistics.misses % m_slice_cache_statistics.stored;
+}
+
 BoundingBoxf3 PrintInstance::get_bounding_box() {
     return print_object->model_object()->instance_bounding_box(*model_instance, false);
 }
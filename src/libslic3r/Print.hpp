@@ -22,6 +22,7 @@
 
 #include <Eigen/Geometry>
 
+#include <atomic>
 #include <functional>
 #include <set>
 #include <vector>
@@ -35,6 +36,7 @@ class Layer;
 class ModelObject;
 class Print;
 class PrintObject;
+class PrintProfiler;
 class SupportLayer;
 // BBS
 class TreeSupportData;
@@ -52,6 +54,20 @@ struct VolumeSlices
     std::vector<ExPolygons> slices;
 };
 
+// Raw slices of a single ModelVolume, kept by PrintObject to be reused when the same mesh is sliced again
+// with the same transformation and slicing parameters, for example after a modifier or a layer range was edited.
+struct CachedVolumeSlices
+{
+    ObjectID                            volume_id;
+    // Held to keep the mesh alive, so that the pointer identifies an unmodified mesh.
+    std::shared_ptr<const TriangleMesh> mesh;
+    // Slicing parameters including the complete transformation of the volume.
+    MeshSlicingParamsEx                 params;
+    // Sorted slicing planes and their slices.
+    std::vector<float>                  zs;
+    std::vector<ExPolygons>             slices;
+};
+
 struct groupedVolumeSlices
 {
     int                     groupId = -1;
@@ -101,6 +117,10 @@ namespace FillAdaptive {
     using OctreePtr = std::unique_ptr<Octree, OctreeDeleter>;
 };
 
+namespace Arachne {
+    class WallToolPathsCache;
+}; // namespace Arachne
+
 namespace FillLightning {
     class Generator;
     struct GeneratorDeleter;
@@ -433,6 +453,8 @@ public:
     SupportLayer* add_tree_support_layer(int id, coordf_t height, coordf_t print_z, coordf_t slice_z);
     std::shared_ptr<TreeSupportData> alloc_tree_support_preview_cache();
     void clear_tree_support_preview_cache() { m_tree_support_preview_cache.reset(); }
+    // Arachne tool paths shared by the layers with the same outline, only allocated while generating the perimeters.
+    Arachne::WallToolPathsCache* wall_toolpaths_cache() const { return m_wall_toolpaths_cache.get(); }
     const std::vector<LocalZInterval>& local_z_intervals() const { return m_local_z_intervals; }
     const std::vector<SubLayerPlan>&   local_z_sublayer_plan() const { return m_local_z_sublayer_plan; }
     void                                set_local_z_plan(std::vector<LocalZInterval> intervals, std::vector<SubLayerPlan> sublayers)
@@ -527,6 +549,10 @@ public:
     void                    config_apply(const ConfigBase &other, bool ignore_nonexistent = false) { m_config.apply(other, ignore_nonexistent); }
     void                    config_apply_only(const ConfigBase &other, const t_config_option_keys &keys, bool ignore_nonexistent = false) { m_config.apply_only(other, keys, ignore_nonexistent); }
     PrintBase::ApplyStatus  set_instances(PrintInstances &&instances);
+    // Hide the protected PrintObjectBaseWithState methods to report the step to the Print's profiler, if any.
+    // Private like the methods they hide, called by PrintObject itself and by Print as a friend.
+    bool                    set_started(PrintObjectStep step);
+    PrintStateBase::TimeStamp set_done(PrintObjectStep step);
     // Invalidates the step, and its depending steps in PrintObject and Print.
     bool                    invalidate_step(PrintObjectStep step);
     // Invalidates all PrintObject and Print steps.
@@ -597,6 +623,7 @@ private:
     std::vector<SubLayerPlan>               m_local_z_sublayer_plan;
     // BBS
     std::shared_ptr<TreeSupportData>        m_tree_support_preview_cache;
+    std::shared_ptr<Arachne::WallToolPathsCache> m_wall_toolpaths_cache;
 
     // this is set to true when LayerRegion->slices is split in top/internal/bottom
     // so that next call to make_perimeters() performs a union() before computing loops
@@ -607,6 +634,12 @@ private:
 
     std::vector < VolumeSlices >            firstLayerObjSliceByVolume;
     std::vector<groupedVolumeSlices>        firstLayerObjSliceByGroups;
+    // Raw slices of the ModelVolumes from the last slice_volumes(), survives invalidation of posSlice.
+    // The caches of all the PrintObjects of a Print are limited to VOLUME_SLICES_CACHE_MAX_MEMORY, they are only kept if Print::keep_reslice_caches().
+    // Handed over by Print::apply() to the PrintObject replacing this one if the instance transformation did not change.
+    std::vector<CachedVolumeSlices>         m_volume_slices_cache;
+    // Estimated memory of m_volume_slices_cache.
+    size_t                                  m_volume_slices_cache_memory { 0 };
 
     // BBS: per object skirt
     ExtrusionEntityCollection               m_skirt;
@@ -867,6 +900,59 @@ struct PrintStatistics
     
 };
 
+// Output of the G-code generator stage of GCode::process_layers() recorded by a G-code export, before it is post-processed
+// by the cooling buffer and the fan mover. A following export of the same print replays it instead of generating the layers again
+// if the key matches, that is if only the options consumed by the post-processing stages changed.
+// Only recorded if Print::keep_reslice_caches(). The G-code of the layers recorded by all the Prints is limited to
+// GCODE_LAYER_CACHE_MAX_MEMORY in total, a recording exceeding the remaining memory is dropped.
+struct GCodeLayerResultCache
+{
+    GCodeLayerResultCache() = default;
+    GCodeLayerResultCache(const GCodeLayerResultCache &) = delete;
+    GCodeLayerResultCache& operator=(const GCodeLayerResultCache &) = delete;
+    // Returns the memory of the layers to the budget shared by all the Prints.
+    ~GCodeLayerResultCache();
+
+    // Reserve the memory for recording a layer of the given G-code size from the budget shared by all the Prints.
+    // Returns false if the budget is exhausted.
+    bool                        reserve(size_t size);
+    // G-code of the layers recorded by all the Prints in bytes.
+    static size_t               total_memory();
+
+    size_t                      key { 0 };
+    std::vector<LayerResult>    layers;
+    // Size of the G-code of the layers in bytes, reserved from the budget shared by all the Prints.
+    size_t                      layers_size { 0 };
+    // G-code exported after the layers up to the filament statistics, depending on the state of the generator.
+    std::string                 tail;
+    PrintStatistics             print_statistics;
+    std::set<unsigned int>      initial_layer_extruders;
+    bool                        support_traditional_timelapse { true };
+};
+
+// Hit / miss counters of the persistent slice cache, see Print::set_slice_cache_dir().
+struct SliceCacheStatistics
+{
+    // PrintObjects restored from the cache.
+    size_t                          hits   { 0 };
+    // PrintObjects which had to be sliced, because there was no usable cache entry.
+    size_t                          misses { 0 };
+    // Cache entries written after slicing the missed PrintObjects.
+    size_t                          stored { 0 };
+    // Tree support collision and avoidance areas restored from the cache and calculated in addition to them.
+    // Updated by the support generators of the PrintObjects running in parallel.
+    std::atomic<size_t>             tree_support_areas_loaded   { 0 };
+    std::atomic<size_t>             tree_support_areas_computed { 0 };
+    // ModelVolumes taken completely from the volume slices cache of their PrintObject and ModelVolumes sliced at least partially.
+    std::atomic<size_t>             volumes_reused { 0 };
+    std::atomic<size_t>             volumes_sliced { 0 };
+    // Layers replayed and layers recorded by the last G-code export, see GCodeLayerResultCache.
+    size_t                          gcode_layers_replayed { 0 };
+    size_t                          gcode_layers_recorded { 0 };
+
+    void clear() { hits = 0; misses = 0; stored = 0; tree_support_areas_loaded = 0; tree_support_areas_computed = 0; volumes_reused = 0; volumes_sliced = 0; gcode_layers_replayed = 0; gcode_layers_recorded = 0; }
+};
+
 typedef std::vector<PrintObject*>       PrintObjectPtrs;
 typedef std::vector<const PrintObject*> ConstPrintObjectPtrs;
 class ConstPrintObjectPtrsAdaptor : public ConstVectorOfPtrsAdaptor<PrintObject> {
@@ -922,6 +1008,33 @@ public:
     //return 0 means successful
     int                 export_cached_data(const std::string& dir_path, bool with_space=false);
     int                 load_cached_data(const std::string& directory);
+    // Persistent slice cache: the results of the PrintObject steps posSlice up to posDetectOverhangsForLift are stored
+    // into the directory under a hash of the object geometry and of the configuration they depend on,
+    // and they are reloaded by process() instead of slicing an object with the same hash again.
+    // An empty directory disables the cache. The tree support generator stores its collision and avoidance areas
+    // into the same directory. Once process() stored new entries, the least recently used files are evicted down to
+    // slice_cache_max_size() bytes, loading an entry marks it as used.
+    void                set_slice_cache_dir(const std::string &dir) { m_slice_cache_dir = dir; }
+    const std::string&  slice_cache_dir() const { return m_slice_cache_dir; }
+    void                set_slice_cache_max_size(size_t max_size) { m_slice_cache_max_size = max_size; }
+    size_t              slice_cache_max_size() const { return m_slice_cache_max_size; }
+    const SliceCacheStatistics& slice_cache_statistics() const { return m_slice_cache_statistics; }
+    // Called by the tree support generator after restoring its areas from the cache and calculating the missing ones.
+    void                add_tree_support_cache_statistics(size_t loaded, size_t computed) const
+        { m_slice_cache_statistics.tree_support_areas_loaded += loaded; m_slice_cache_statistics.tree_support_areas_computed += computed; }
+    // Called by PrintObject::slice_volumes() after slicing the volumes with the volume slices cache.
+    void                add_volume_slices_cache_statistics(size_t reused, size_t sliced) const
+        { m_slice_cache_statistics.volumes_reused += reused; m_slice_cache_statistics.volumes_sliced += sliced; }
+    // Keep the intermediate results only worth keeping if the same Print is processed again after an edit: the raw volume slices
+    // reused by the next slicing and the G-code of the layers replayed by the next G-code export.
+    // Enabled by default for the Prints of the GUI living across the edits,
+    // the command line disables it for its Prints processed just once.
+    void                set_keep_reslice_caches(bool keep);
+    bool                keep_reslice_caches() const { return m_keep_reslice_caches; }
+    // Record the timing and memory of the Print and PrintObject steps into the profiler, nullptr disables profiling.
+    // The profiler is owned by the caller.
+    void                set_profiler(PrintProfiler *profiler) { m_profiler = profiler; }
+    PrintProfiler*      profiler() const { return m_profiler; }
 
     // methods for handling state
     bool                is_step_done(PrintStep step) const { return Inherited::is_step_done(step); }
@@ -1087,6 +1200,10 @@ private:
 
     bool                invalidate_state_by_config_options(const ConfigOptionResolver &new_config, const std::vector<t_config_option_key> &opt_keys);
 
+    // Report the step to the profiler, if any.
+    bool                set_started(PrintStep step);
+    PrintStateBase::TimeStamp set_done(PrintStep step);
+
     void                _make_skirt();
     void                _make_wipe_tower();
     void                finalize_first_layer_convex_hull();
@@ -1094,6 +1211,10 @@ private:
     // Islands of objects and their supports extruded at the 1st layer.
     Polygons            first_layer_islands() const;
 
+    // Restore the not yet sliced objects from the persistent slice cache, fill in the cache keys of the objects to be sliced.
+    void                load_objects_from_slice_cache(const std::set<PrintObject*> &objects, std::map<PrintObject*, std::string> &missed_keys);
+    void                store_objects_to_slice_cache(const std::map<PrintObject*, std::string> &missed_keys);
+
     PrintConfig                             m_config;
     PrintObjectConfig                       m_default_object_config;
     PrintRegionConfig                       m_default_region_config;
@@ -1136,6 +1257,16 @@ private:
     //SoftFever: calibration
     Calib_Params m_calib_params;
 
+    std::string             m_slice_cache_dir;
+    size_t                  m_slice_cache_max_size { size_t(2048) * 1024 * 1024 };
+    // Mutable for the tree support generator, which only has access to a const Print.
+    mutable SliceCacheStatistics m_slice_cache_statistics;
+    PrintProfiler          *m_profiler { nullptr };
+    bool                    m_keep_reslice_caches { true };
+    // G-code generated for the layers by the last G-code export, to be replayed by the next export
+    // if only the options consumed by the cooling buffer and the fan mover changed.
+    std::shared_ptr<GCodeLayerResultCache> m_gcode_layer_cache;
+
     // To allow GCode to set the Print's GCodeExport step status.
     friend class GCode;
     // Allow PrintObject to access m_mutex and m_cancel_callback.
@@ -1765,6 +1765,16 @@ Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_
             for (const PrintObjectStatus &pos : print_object_status_db)
                 if (pos.status == PrintObjectStatus::Unknown || pos.status == PrintObjectStatus::Deleted) {
                     update_apply_status(pos.print_object->invalidate_all_steps());
+                    // Hand over the cached volume slices to the PrintObject replacing this one, so that editing a modifier
+                    // or a layer range re-slices just the modified volumes and the changed layers.
+                    if (! pos.print_object->m_volume_slices_cache.empty())
+                        for (PrintObject *print_object : m_objects)
+                            if (print_object->model_object() == pos.print_object->model_object() && print_object->m_volume_slices_cache.empty() &&
+                                transform3d_equal(print_object->trafo(), pos.trafo)) {
+                                print_object->m_volume_slices_cache        = std::move(pos.print_object->m_volume_slices_cache);
+                                print_object->m_volume_slices_cache_memory = pos.print_object->m_volume_slices_cache_memory;
+                                break;
+                            }
                     delete pos.print_object;
 					deleted_objects = true;
                 }
@@ -8025,6 +8025,14 @@ CLIActionsConfigDef::CLIActionsConfigDef()
     def->tooltip = L("Export the objects as multiple STLs to directory.");
     def->set_default_value(new ConfigOptionString("stl_path"));
 
+    def = this->add("export_slice_outlines", coString);
+    def->label = L("Export slice outlines");
+    def->tooltip = L("Slice the STL / 3MF input files out-of-core, without loading their meshes into memory, "
+                     "and export the outlines of each layer as SVG to directory. The layers are spaced by layer_height "
+                     "starting at initial_layer_print_height. The peak memory is limited by slice_memory_budget.");
+    def->cli_params = "dir";
+    def->set_default_value(new ConfigOptionString());
+
     /*def = this->add("export_gcode", coBool);
     def->label = L("Export G-code");
     def->tooltip = L("Slice the model and export toolpaths as G-code.");
@@ -8358,6 +8366,54 @@ CLIMiscConfigDef::CLIMiscConfigDef()
     def->cli_params = "dir";
     def->set_default_value(new ConfigOptionString());
 
+    def = this->add("daemon", coString);
+    def->label = L("Daemon mode");
+    def->tooltip = L("Keep running and slice the jobs received as json lines {\"id\": ..., \"args\": [...]} from stdin (-) "
+                     "or from a Unix domain socket at the given path. The args are the command line arguments of a single slicing job, "
+                     "a json line {\"id\": ..., \"return_code\": ...} is sent back when the job finishes. "
+                     "In the stdin mode the responses are the only output on stdout, the output of the jobs goes to stderr.");
+    def->cli_params = "socket";
+    def->set_default_value(new ConfigOptionString());
+
+    def = this->add("slice_memory_budget", coInt);
+    def->label = L("Slicing memory budget");
+    def->tooltip = L("Approximate peak memory in MB used by the out-of-core slicing of export_slice_outlines.");
+    def->cli_params = "MB";
+    def->min = 16;
+    def->set_default_value(new ConfigOptionInt(1024));
+
+    def = this->add("slice_cache_dir", coString);
+    def->label = L("Slice cache directory");
+    def->tooltip = L("Persistent cache of the object slicing results. Objects with the same geometry and slicing settings are loaded from this directory instead of being sliced again.");
+    def->cli_params = "dir";
+    def->set_default_value(new ConfigOptionString());
+
+    def = this->add("slice_cache_max_size", coInt);
+    def->label = L("Slice cache size limit");
+    def->tooltip = L("Maximum size of the slice cache directory in MB. The least recently used entries are removed above it.");
+    def->cli_params = "MB";
+    def->min = 0;
+    def->set_default_value(new ConfigOptionInt(2048));
+
+    def = this->add("profile", coBool);
+    def->label = L("Profile slicing steps");
+    def->tooltip = L("Record the wall time, CPU time and memory usage of every slicing step of every object into result.json.");
+    def->set_default_value(new ConfigOptionBool(false));
+
+    def = this->add("profile_trace", coString);
+    def->label = L("Profile trace file");
+    def->tooltip = L("Record the slicing steps as with --profile and save them to the given file in the Chrome trace event format, "
+                     "to be opened by chrome://tracing or Perfetto.");
+    def->cli_params = "file";
+    def->set_default_value(new ConfigOptionString());
+
+    def = this->add("task_trace", coString);
+    def->label = L("Task trace file");
+    def->tooltip = L("Record the parallel tasks of slicing and G-code export with the threads running them and save them to the given file "
+                     "in the Chrome trace event format when the application exits. Same as setting the ORCA_TASK_TRACE environment variable.");
+    def->cli_params = "file";
+    def->set_default_value(new ConfigOptionString());
+
     def = this->add("debug", coInt);
     def->label = L("Debug level");
     def->tooltip = L("Sets debug logging level. 0:fatal, 1:error, 2:warning, 3:info, 4:debug, 5:trace\n");
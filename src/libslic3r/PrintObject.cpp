@@ -8,16 +8,19 @@
 #include "Layer.hpp"
 #include "MutablePolygon.hpp"
 #include "PrintConfig.hpp"
+#include "PrintProfiler.hpp"
 #include "Support/SupportMaterial.hpp"
 #include "Support/SupportSpotsGenerator.hpp"
 #include "Support/TreeSupport.hpp"
 #include "Surface.hpp"
 #include "Slicing.hpp"
 #include "Tesselate.hpp"
+#include "Timer.hpp"
 #include "TriangleMeshSlicer.hpp"
 #include "Utils.hpp"
 #include "Fill/FillAdaptive.hpp"
 #include "Fill/FillLightning.hpp"
+#include "Arachne/WallToolPathsCache.hpp"
 #include "Format/STL.hpp"
 #include "format.hpp"
 
@@ -187,6 +190,7 @@ void PrintObject::_transform_hole_to_polyholes()
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, m_layers.size()),
         [this, &layerid2center](const tbb::blocked_range<size_t>& range) {
+        TASK_TRACE_SCOPE("PrintObject::_transform_hole_to_polyholes");
         for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
             m_print->throw_if_canceled();
             Layer* layer = m_layers[layer_idx];
@@ -327,6 +331,7 @@ void PrintObject::make_perimeters()
         tbb::parallel_for(
             tbb::blocked_range<size_t>(0, m_layers.size() - 1),
             [this, &region, region_id](const tbb::blocked_range<size_t>& range) {
+                TASK_TRACE_SCOPE("PrintObject::make_perimeters extra perimeters");
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                     m_print->throw_if_canceled();
                     LayerRegion &layerm                     = *m_layers[layer_idx]->get_region(region_id);
@@ -381,16 +386,30 @@ void PrintObject::make_perimeters()
         BOOST_LOG_TRIVIAL(debug) << "Generating extra perimeters for region " << region_id << " in parallel - end";
     }
 
+    // Layers of prismatic parts share their outlines, reuse the Arachne tool paths among them.
+    if (m_config.wall_generator.value == PerimeterGeneratorType::Arachne)
+        m_wall_toolpaths_cache = std::make_shared<Arachne::WallToolPathsCache>();
     BOOST_LOG_TRIVIAL(debug) << "Generating perimeters in parallel - start";
-    tbb::parallel_for(
-        tbb::blocked_range<size_t>(0, m_layers.size()),
-        [this](const tbb::blocked_range<size_t>& range) {
-            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
-                m_print->throw_if_canceled();
-                m_layers[layer_idx]->make_perimeters();
+    try {
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, m_layers.size()),
+            [this](const tbb::blocked_range<size_t>& range) {
+                TASK_TRACE_SCOPE("PrintObject::make_perimeters");
+                for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                    m_print->throw_if_canceled();
+                    m_layers[layer_idx]->make_perimeters();
+                }
             }
-        }
-    );
+        );
+    } catch (...) {
+        m_wall_toolpaths_cache.reset();
+        throw;
+    }
+    if (m_wall_toolpaths_cache) {
+        BOOST_LOG_TRIVIAL(debug) << __FUNCTION__ << boost::format(": Arachne tool paths cache hits %1%, misses %2%, memory %3%")
+            % m_wall_toolpaths_cache->hits() % m_wall_toolpaths_cache->misses() % m_wall_toolpaths_cache->memory();
+        m_wall_toolpaths_cache.reset();
+    }
     m_print->throw_if_canceled();
     BOOST_LOG_TRIVIAL(debug) << "Generating perimeters in parallel - end";
 
@@ -550,6 +569,7 @@ void PrintObject::infill()
         tbb::parallel_for(
             tbb::blocked_range<size_t>(0, m_layers.size()),
             [this, &adaptive_fill_octree = adaptive_fill_octree, &support_fill_octree = support_fill_octree](const tbb::blocked_range<size_t>& range) {
+                TASK_TRACE_SCOPE("PrintObject::infill");
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                     m_print->throw_if_canceled();
                     m_layers[layer_idx]->make_fills(adaptive_fill_octree.get(), support_fill_octree.get(), this->m_lightning_generator.get());
@@ -573,6 +593,7 @@ void PrintObject::ironing()
             // Ironing starting with layer 0 to support ironing all surfaces.
             tbb::blocked_range<size_t>(0, m_layers.size()),
             [this](const tbb::blocked_range<size_t>& range) {
+                TASK_TRACE_SCOPE("PrintObject::ironing");
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                     m_print->throw_if_canceled();
                     m_layers[layer_idx]->make_ironing();
@@ -614,6 +635,7 @@ void PrintObject::detect_overhangs_for_lift()
         tbb::parallel_for(tbb::blocked_range<size_t>(num_raft_layers + 1, num_layers),
             [this, min_overlap, line_width](const tbb::blocked_range<size_t>& range)
             {
+                TASK_TRACE_SCOPE("PrintObject::detect_overhangs_for_lift");
                 for (size_t layer_id = range.begin(); layer_id < range.end(); ++layer_id) {
                     Layer& layer = *m_layers[layer_id];
                     Layer& lower_layer = *layer.lower_layer;
@@ -703,6 +725,7 @@ void PrintObject::simplify_extrusion_path()
         tbb::parallel_for(
             tbb::blocked_range<size_t>(0, m_layers.size()),
             [this](const tbb::blocked_range<size_t>& range) {
+                TASK_TRACE_SCOPE("PrintObject::simplify_extrusion_path walls");
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                     m_print->throw_if_canceled();
                     m_layers[layer_idx]->simplify_wall_extrusion_path();
@@ -721,6 +744,7 @@ void PrintObject::simplify_extrusion_path()
         tbb::parallel_for(
             tbb::blocked_range<size_t>(0, m_layers.size()),
             [this](const tbb::blocked_range<size_t>& range) {
+                TASK_TRACE_SCOPE("PrintObject::simplify_extrusion_path infill");
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
                     m_print->throw_if_canceled();
                     m_layers[layer_idx]->simplify_infill_extrusion_path();
@@ -738,6 +762,7 @@ void PrintObject::simplify_extrusion_path()
         tbb::parallel_for(
             tbb::blocked_range<size_t>(0, m_support_layers.size()),
             [this](const tbb::blocked_range<size_t>& range) {
+                TASK_TRACE_SCOPE("PrintObject::simplify_extrusion_path support");
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                     m_print->throw_if_canceled();
                     m_support_layers[layer_idx]->simplify_support_extrusion_path();
@@ -769,6 +794,7 @@ std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> PrintObject::prepare
     // ^ make sure vector is not empty, even with no briding surfaces we still want to build the adaptive trees later, some continue normally
     tbb::parallel_for(tbb::blocked_range<int>(0, surfaces_w_bottom_z.size()),
         [this, &to_octree, &overhangs, &surfaces_w_bottom_z](const tbb::blocked_range<int> &range) {
+            TASK_TRACE_SCOPE("PrintObject::prepare_adaptive_infill_data");
             PRINT_OBJECT_TIME_LIMIT_MILLIS(PRINT_OBJECT_TIME_LIMIT_DEFAULT);
             for (int surface_idx = range.begin(); surface_idx < range.end(); ++surface_idx) {
                 std::vector<Vec3d> &out = overhangs[surface_idx];
@@ -1242,6 +1268,41 @@ bool PrintObject::invalidate_state_by_config_options(
     return invalidated;
 }
 
+static const char* print_object_step_name(PrintObjectStep step)
+{
+    switch (step) {
+    case posSlice:                      return "posSlice";
+    case posPerimeters:                 return "posPerimeters";
+    case posEstimateCurledExtrusions:   return "posEstimateCurledExtrusions";
+    case posPrepareInfill:              return "posPrepareInfill";
+    case posInfill:                     return "posInfill";
+    case posIroning:                    return "posIroning";
+    case posSupportMaterial:            return "posSupportMaterial";
+    case posSimplifyPath:               return "posSimplifyPath";
+    case posSimplifySupportPath:        return "posSimplifySupportPath";
+    case posDetectOverhangsForLift:     return "posDetectOverhangsForLift";
+    case posSimplifyWall:               return "posSimplifyWall";
+    case posSimplifyInfill:             return "posSimplifyInfill";
+    default:                            return "posUnknown";
+    }
+}
+
+bool PrintObject::set_started(PrintObjectStep step)
+{
+    bool started = Inherited::set_started(step);
+    if (started && m_print->profiler())
+        m_print->profiler()->step_started(this, print_object_step_name(step));
+    return started;
+}
+
+PrintStateBase::TimeStamp PrintObject::set_done(PrintObjectStep step)
+{
+    PrintStateBase::TimeStamp timestamp = Inherited::set_done(step);
+    if (PrintProfiler *profiler = m_print->profiler(); profiler)
+        profiler->step_finished(this, print_object_step_name(step), this->model_object()->name, this->id().id, m_layers.size(), m_support_layers.size());
+    return timestamp;
+}
+
 bool PrintObject::invalidate_step(PrintObjectStep step)
 {
 	bool invalidated = Inherited::invalidate_step(step);
@@ -1328,6 +1389,7 @@ void PrintObject::detect_surfaces_type()
             		// In non-spiral vase mode, go over all layers.
             		m_layers.size()),
             [this, region_id, interface_shells, &surfaces_new](const tbb::blocked_range<size_t>& range) {
+                TASK_TRACE_SCOPE("PrintObject::detect_surfaces_type");
                 // If we have soluble support material, don't bridge. The overhang will be squished against a soluble layer separating
                 // the support from the print.
                 // BBS: the above logic only applys for normal(auto) support. Complete logic:
@@ -1518,6 +1580,7 @@ void PrintObject::detect_surfaces_type()
         if( (this->config().enable_extra_bridge_layer.value == eblApplyToAll) || (this->config().enable_extra_bridge_layer.value == eblExternalBridgeOnly)){
             const size_t last = (m_layers.empty() ? 0 : m_layers.size() - 1);
             tbb::parallel_for( tbb::blocked_range<size_t>(0, last), [this, region_id](const tbb::blocked_range<size_t> &range) {
+                TASK_TRACE_SCOPE("PrintObject::detect_surfaces_type internal bridges");
                 for (size_t i = range.begin(); i < range.end(); ++i) {
                     m_print->throw_if_canceled();
                     
@@ -1597,6 +1660,7 @@ void PrintObject::detect_surfaces_type()
             // ==============================================================================================================
             for (size_t region_id = 0; region_id < this->num_printing_regions(); ++region_id) {
                 tbb::parallel_for( tbb::blocked_range<size_t>(0, m_layers.size()), [this, region_id](const tbb::blocked_range<size_t> &range) {
+                    TASK_TRACE_SCOPE("PrintObject::detect_surfaces_type reclassify bridges");
                     for (size_t idx_layer = range.begin(); idx_layer < range.end(); ++idx_layer) {
                         Surfaces &surfs = m_layers[idx_layer]->m_regions[region_id]->slices.surfaces;
                         for (Surface &s : surfs) {
@@ -1618,6 +1682,7 @@ void PrintObject::detect_surfaces_type()
         tbb::parallel_for(
             tbb::blocked_range<size_t>(0, m_layers.size()),
             [this, region_id](const tbb::blocked_range<size_t>& range) {
+                TASK_TRACE_SCOPE("PrintObject::detect_surfaces_type fill surfaces");
                 for (size_t idx_layer = range.begin(); idx_layer < range.end(); ++ idx_layer) {
                     m_print->throw_if_canceled();
                     LayerRegion *layerm = m_layers[idx_layer]->m_regions[region_id];
@@ -1676,6 +1741,7 @@ void PrintObject::process_external_surfaces()
 	    tbb::parallel_for(
 	        tbb::blocked_range<size_t>(0, m_layers.size() - 1),
 	        [this, &surfaces_covered, &layer_expansions_and_voids, unsupported_width](const tbb::blocked_range<size_t>& range) {
+	            TASK_TRACE_SCOPE("PrintObject::process_external_surfaces expansions");
 	            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx)
 	            	if (layer_expansions_and_voids[layer_idx + 1]) {
                         // Layer above is partially filled with solid infill (top, bottom, bridging...),
@@ -1701,6 +1767,7 @@ void PrintObject::process_external_surfaces()
         tbb::parallel_for(
             tbb::blocked_range<size_t>(0, m_layers.size()),
             [this, &surfaces_covered, region_id](const tbb::blocked_range<size_t>& range) {
+                TASK_TRACE_SCOPE("PrintObject::process_external_surfaces");
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                     m_print->throw_if_canceled();
                     // BOOST_LOG_TRIVIAL(trace) << "Processing external surface, layer" << m_layers[layer_idx]->print_z;
@@ -1758,6 +1825,7 @@ void PrintObject::discover_vertical_shells()
         tbb::parallel_for(
             tbb::blocked_range<size_t>(0, num_layers, grain_size),
             [this, &cache_top_botom_regions](const tbb::blocked_range<size_t>& range) {
+                TASK_TRACE_SCOPE("PrintObject::discover_vertical_shells cache");
                 const std::initializer_list<SurfaceType> surfaces_bottom { stBottom, stBottomBridge };
                 const size_t num_regions = this->num_printing_regions();
                 for (size_t idx_layer = range.begin(); idx_layer < range.end(); ++ idx_layer) {
@@ -1836,6 +1904,7 @@ void PrintObject::discover_vertical_shells()
             tbb::parallel_for(
                 tbb::blocked_range<size_t>(0, num_layers, grain_size),
                 [this, region_id, &cache_top_botom_regions](const tbb::blocked_range<size_t>& range) {
+                    TASK_TRACE_SCOPE("PrintObject::discover_vertical_shells region cache");
                     const std::initializer_list<SurfaceType> surfaces_bottom { stBottom, stBottomBridge };
                     for (size_t idx_layer = range.begin(); idx_layer < range.end(); ++ idx_layer) {
                         m_print->throw_if_canceled();
@@ -1866,6 +1935,7 @@ void PrintObject::discover_vertical_shells()
             tbb::blocked_range<size_t>(0, num_layers, grain_size),
             [this, region_id, &cache_top_botom_regions]
             (const tbb::blocked_range<size_t>& range) {
+                TASK_TRACE_SCOPE("PrintObject::discover_vertical_shells");
                 // printf("discover_vertical_shells from %d to %d\n", range.begin(), range.end());
                 for (size_t idx_layer = range.begin(); idx_layer < range.end(); ++ idx_layer) {
                     m_print->throw_if_canceled();
@@ -2215,6 +2285,7 @@ void PrintObject::bridge_over_infill()
     {
         tbb::concurrent_vector<CandidateSurface> candidate_surfaces;
         tbb::parallel_for(tbb::blocked_range<size_t>(0, this->layers().size()), [po = static_cast<const PrintObject *>(this), &candidate_surfaces, has_lightning_infill](tbb::blocked_range<size_t> r) {
+            TASK_TRACE_SCOPE("PrintObject::bridge_over_infill candidates");
             PRINT_OBJECT_TIME_LIMIT_MILLIS(PRINT_OBJECT_TIME_LIMIT_DEFAULT);
             for (size_t lidx = r.begin(); lidx < r.end(); lidx++) {
                 const Layer *layer = po->get_layer(lidx);
@@ -2316,6 +2387,7 @@ void PrintObject::bridge_over_infill()
 
         tbb::parallel_for(tbb::blocked_range<size_t>(0, this->layers().size()), [po = this, &backup_surfaces,
                                                                                  &surfaces_by_layer](tbb::blocked_range<size_t> r) {
+            TASK_TRACE_SCOPE("PrintObject::bridge_over_infill backup surfaces");
             PRINT_OBJECT_TIME_LIMIT_MILLIS(PRINT_OBJECT_TIME_LIMIT_DEFAULT);
             for (size_t lidx = r.begin(); lidx < r.end(); lidx++) {
                 if (surfaces_by_layer.find(lidx) == surfaces_by_layer.end())
@@ -2409,6 +2481,7 @@ void PrintObject::bridge_over_infill()
         tbb::parallel_for(tbb::blocked_range<size_t>(0, layers_to_generate_infill.size()), [po = static_cast<const PrintObject *>(this),
                                                                                             &layers_to_generate_infill,
                                                                                             &infill_lines](tbb::blocked_range<size_t> r) {
+            TASK_TRACE_SCOPE("PrintObject::bridge_over_infill infill lines");
             PRINT_OBJECT_TIME_LIMIT_MILLIS(PRINT_OBJECT_TIME_LIMIT_DEFAULT);
             for (size_t job_idx = r.begin(); job_idx < r.end(); job_idx++) {
                 size_t lidx = layers_to_generate_infill[job_idx];
@@ -2441,6 +2514,7 @@ void PrintObject::bridge_over_infill()
         tbb::parallel_for(tbb::blocked_range<size_t>(0, layers_with_candidates.size()), [&layers_with_candidates, &surfaces_by_layer,
                                                                                          &layer_area_covered_by_candidates](
                                                                                             tbb::blocked_range<size_t> r) {
+            TASK_TRACE_SCOPE("PrintObject::bridge_over_infill candidate areas");
             PRINT_OBJECT_TIME_LIMIT_MILLIS(PRINT_OBJECT_TIME_LIMIT_DEFAULT);
             for (size_t job_idx = r.begin(); job_idx < r.end(); job_idx++) {
                 size_t lidx = layers_with_candidates[job_idx];
@@ -2780,6 +2854,7 @@ void PrintObject::bridge_over_infill()
                                                                                            determine_bridging_angle,
                                                                                            construct_anchored_polygon](
                                                                                               tbb::blocked_range<size_t> r) {
+        TASK_TRACE_SCOPE("PrintObject::bridge_over_infill bridges");
         PRINT_OBJECT_TIME_LIMIT_MILLIS(PRINT_OBJECT_TIME_LIMIT_DEFAULT);
         for (size_t cluster_idx = r.begin(); cluster_idx < r.end(); cluster_idx++) {
             for (size_t job_idx = 0; job_idx < clustered_layers_for_threads[cluster_idx].size(); job_idx++) {
@@ -2964,6 +3039,7 @@ void PrintObject::bridge_over_infill()
     BOOST_LOG_TRIVIAL(info) << "Bridge over infill - Directions and expanded surfaces computed" << log_memory_info();
 
     tbb::parallel_for(tbb::blocked_range<size_t>(0, this->layers().size()), [po = this, &surfaces_by_layer](tbb::blocked_range<size_t> r) {
+        TASK_TRACE_SCOPE("PrintObject::bridge_over_infill apply");
         PRINT_OBJECT_TIME_LIMIT_MILLIS(PRINT_OBJECT_TIME_LIMIT_DEFAULT);
         for (size_t lidx = r.begin(); lidx < r.end(); lidx++) {
             if (surfaces_by_layer.find(lidx) == surfaces_by_layer.end() && surfaces_by_layer.find(lidx + 1) == surfaces_by_layer.end())
@@ -3045,6 +3121,7 @@ void PrintObject::bridge_over_infill()
     if ( this->m_config.enable_extra_bridge_layer == eblApplyToAll || this->m_config.enable_extra_bridge_layer == eblInternalBridgeOnly) {
         // Process layers in parallel up to second-to-last
         tbb::parallel_for( tbb::blocked_range<size_t>(0, this->layers().size() - 1), [this](const tbb::blocked_range<size_t>& r) {
+            TASK_TRACE_SCOPE("PrintObject::bridge_over_infill extra bridge layer");
             for (size_t lidx = r.begin(); lidx < r.end(); ++lidx)
             {
                 Layer* layer = this->get_layer(lidx);
@@ -4603,6 +4680,7 @@ static void project_triangles_to_slabs(ConstLayerPtrsAdaptor layers, const index
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, custom_facets.indices.size()),
         [&custom_facets, &tr, tr_det_sign, seam, layers, &projections_of_triangles](const tbb::blocked_range<size_t>& range) {
+        TASK_TRACE_SCOPE("project_triangles_to_slabs");
         for (size_t idx = range.begin(); idx < range.end(); ++ idx) {
 
         std::array<Vec3f, 3> facet;
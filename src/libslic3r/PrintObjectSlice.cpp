@@ -18,6 +18,7 @@
 #include "MultiMaterialSegmentation.hpp"
 #include "Print.hpp"
 #include "SVG.hpp"
+#include "Timer.hpp"
 //BBS
 #include "ShortestPath.hpp"
 #include "libslic3r/Feature/Interlocking/InterlockingGenerator.hpp"
@@ -66,23 +67,79 @@ LayerPtrs new_layers(
     return out;
 }
 
+// Upper limit of the memory held by PrintObject::m_volume_slices_cache of all the PrintObjects of a Print.
+static constexpr const size_t VOLUME_SLICES_CACHE_MAX_MEMORY = 64 * 1024 * 1024;
+
+static inline bool mesh_slicing_params_equal(const MeshSlicingParamsEx &lhs, const MeshSlicingParamsEx &rhs)
+{
+    return lhs.mode == rhs.mode && lhs.mode_below == rhs.mode_below && lhs.slicing_mode_normal_below_layer == rhs.slicing_mode_normal_below_layer &&
+           lhs.closing_radius == rhs.closing_radius && lhs.extra_offset == rhs.extra_offset && lhs.resolution == rhs.resolution &&
+           lhs.trafo.matrix() == rhs.trafo.matrix();
+}
+
 // Slice single triangle mesh.
+// If cache is provided, the slices at the zs already sliced with the same mesh, transformation and parameters are taken from the cache,
+// only the remaining zs are sliced and the cache is updated with the result.
+// The number of the zs sliced is added to num_sliced, if provided.
 static std::vector<ExPolygons> slice_volume(
-    const ModelVolume             &volume,
-    const std::vector<float>      &zs,
-    const MeshSlicingParamsEx     &params,
-    const std::function<void()>   &throw_on_cancel_callback)
+    const ModelVolume               &volume,
+    const std::vector<float>        &zs,
+    const MeshSlicingParamsEx       &params,
+    const std::function<void()>     &throw_on_cancel_callback,
+    std::vector<CachedVolumeSlices> *cache = nullptr,
+    size_t                          *num_sliced = nullptr)
 {
     std::vector<ExPolygons> layers;
-    if (! zs.empty()) {
-        indexed_triangle_set its = volume.mesh().its;
-        if (its.indices.size() > 0) {
-            MeshSlicingParamsEx params2 { params };
-            params2.trafo = params2.trafo * volume.get_matrix();
+    if (! zs.empty() && ! volume.mesh().its.indices.empty()) {
+        MeshSlicingParamsEx params2 { params };
+        params2.trafo = params2.trafo * volume.get_matrix();
+
+        CachedVolumeSlices *cached = nullptr;
+        // The vase mode slices the bottom layers differently based on the layer index, such slices are not reusable at other zs.
+        if (cache != nullptr && params2.mode != MeshSlicingParams::SlicingMode::PositiveLargestContour && params2.slicing_mode_normal_below_layer == 0) {
+            auto it = std::find_if(cache->begin(), cache->end(), [&volume](const CachedVolumeSlices &c) { return c.volume_id == volume.id(); });
+            cached = it == cache->end() ? &cache->emplace_back() : &(*it);
+            if (cached->mesh != volume.mesh_ptr() || ! mesh_slicing_params_equal(cached->params, params2)) {
+                cached->volume_id = volume.id();
+                cached->mesh      = volume.mesh_ptr();
+                cached->params    = params2;
+                cached->zs.clear();
+                cached->slices.clear();
+            }
+        }
+
+        // Collect the zs not found in the cache. Both zs and the cached zs are sorted.
+        layers.assign(zs.size(), ExPolygons());
+        std::vector<float>  zs_missing;
+        std::vector<size_t> idx_missing;
+        size_t              j = 0;
+        for (size_t i = 0; i < zs.size(); ++ i) {
+            if (cached != nullptr) {
+                for (; j < cached->zs.size() && cached->zs[j] < zs[i]; ++ j) ;
+                if (j < cached->zs.size() && cached->zs[j] == zs[i]) {
+                    layers[i] = cached->slices[j];
+                    continue;
+                }
+            }
+            zs_missing.emplace_back(zs[i]);
+            idx_missing.emplace_back(i);
+        }
+
+        if (! zs_missing.empty()) {
+            indexed_triangle_set its = volume.mesh().its;
             if (params2.trafo.rotation().determinant() < 0.)
                 its_flip_triangles(its);
-            layers = slice_mesh_ex(its, zs, params2, throw_on_cancel_callback);
+            std::vector<ExPolygons> sliced = slice_mesh_ex(its, zs_missing, params2, throw_on_cancel_callback);
             throw_on_cancel_callback();
+            for (size_t i = 0; i < idx_missing.size(); ++ i)
+                layers[idx_missing[i]] = std::move(sliced[i]);
+        }
+        if (num_sliced != nullptr)
+            *num_sliced += zs_missing.size();
+        if (cached != nullptr) {
+            BOOST_LOG_TRIVIAL(debug) << "Slicing volume " << volume.id().id << ": " << zs.size() - zs_missing.size() << " of " << zs.size() << " layers reused";
+            cached->zs     = zs;
+            cached->slices = layers;
         }
     }
     return layers;
@@ -95,13 +152,15 @@ static std::vector<ExPolygons> slice_volume(
     const std::vector<float>                    &z,
     const std::vector<t_layer_height_range>     &ranges,
     const MeshSlicingParamsEx                   &params,
-    const std::function<void()>                 &throw_on_cancel_callback)
+    const std::function<void()>                 &throw_on_cancel_callback,
+    std::vector<CachedVolumeSlices>             *cache,
+    size_t                                      *num_sliced)
 {
     std::vector<ExPolygons> out;
     if (! z.empty() && ! ranges.empty()) {
         if (ranges.size() == 1 && z.front() >= ranges.front().first && z.back() < ranges.front().second) {
             // All layers fit into a single range.
-            out = slice_volume(volume, z, params, throw_on_cancel_callback);
+            out = slice_volume(volume, z, params, throw_on_cancel_callback, cache, num_sliced);
         } else {
             std::vector<float>                     z_filtered;
             std::vector<std::pair<size_t, size_t>> n_filtered;
@@ -117,7 +176,7 @@ static std::vector<ExPolygons> slice_volume(
                     n_filtered.emplace_back(std::make_pair(first, i));
             }
             if (! n_filtered.empty()) {
-                std::vector<ExPolygons> layers = slice_volume(volume, z_filtered, params, throw_on_cancel_callback);
+                std::vector<ExPolygons> layers = slice_volume(volume, z_filtered, params, throw_on_cancel_callback, cache, num_sliced);
                 out.assign(z.size(), ExPolygons());
                 i = 0;
                 for (const std::pair<size_t, size_t> &span : n_filtered)
@@ -138,6 +197,9 @@ static inline bool model_volume_needs_slicing(const ModelVolume &mv)
 // Apply closing radius.
 // Apply positive XY compensation to ModelVolumeType::MODEL_PART and ModelVolumeType::PARAMETER_MODIFIER, not to ModelVolumeType::NEGATIVE_VOLUME.
 // Apply contour simplification.
+// Reuse the slices stored in cache by the previous call, the cache is updated to contain just the volumes sliced now
+// and it is trimmed to cache_memory_limit, its estimated memory is returned in cache_memory. Nullptr cache disables the caching.
+// The volumes taken completely from the cache and the volumes sliced at least partially are counted into num_reused and num_sliced.
 static std::vector<VolumeSlices> slice_volumes_inner(
     const PrintConfig                                        &print_config,
     const PrintObjectConfig                                  &print_object_config,
@@ -145,7 +207,12 @@ static std::vector<VolumeSlices> slice_volumes_inner(
     ModelVolumePtrs                                           model_volumes,
     const std::vector<PrintObjectRegions::LayerRangeRegions> &layer_ranges,
     const std::vector<float>                                 &zs,
-    const std::function<void()>                              &throw_on_cancel_callback)
+    const std::function<void()>                              &throw_on_cancel_callback,
+    std::vector<CachedVolumeSlices>                          *cache,
+    size_t                                                    cache_memory_limit,
+    size_t                                                   &cache_memory,
+    size_t                                                   &num_reused,
+    size_t                                                   &num_sliced)
 {
     model_volumes_sort_by_id(model_volumes);
 
@@ -181,6 +248,7 @@ static std::vector<VolumeSlices> slice_volumes_inner(
 
     for (const ModelVolume *model_volume : model_volumes)
         if (model_volume_needs_slicing(*model_volume)) {
+            size_t              num_layers_sliced = 0;
             MeshSlicingParamsEx params { params_base };
             if (! model_volume->is_negative_volume())
                 params.extra_offset = extra_offset;
@@ -199,7 +267,7 @@ static std::vector<VolumeSlices> slice_volumes_inner(
                     }
                     out.push_back({
                         model_volume->id(),
-                        slice_volume(*model_volume, zs, params, throw_on_cancel_callback)
+                        slice_volume(*model_volume, zs, params, throw_on_cancel_callback, cache, &num_layers_sliced)
                     });
                 }
             } else {
@@ -211,13 +279,39 @@ static std::vector<VolumeSlices> slice_volumes_inner(
                 if (! slicing_ranges.empty())
                     out.push_back({
                         model_volume->id(),
-                        slice_volume(*model_volume, zs, slicing_ranges, params, throw_on_cancel_callback)
+                        slice_volume(*model_volume, zs, slicing_ranges, params, throw_on_cancel_callback, cache, &num_layers_sliced)
                     });
             }
-            if (! out.empty() && out.back().slices.empty())
-                out.pop_back();
+            if (! out.empty() && out.back().volume_id == model_volume->id()) {
+                if (num_layers_sliced == 0)
+                    ++ num_reused;
+                else
+                    ++ num_sliced;
+                if (out.back().slices.empty())
+                    out.pop_back();
+            }
         }
 
+    cache_memory = 0;
+    if (cache == nullptr)
+        return out;
+    // Drop the cached slices of the volumes deleted or not sliced anymore.
+    cache->erase(std::remove_if(cache->begin(), cache->end(), [&model_volumes](const CachedVolumeSlices &cached) {
+        return std::none_of(model_volumes.begin(), model_volumes.end(), [&cached](const ModelVolume *mv) { return mv->id() == cached.volume_id && model_volume_needs_slicing(*mv); });
+    }), cache->end());
+    // Keep the cache from holding a full second copy of the slices of large objects: the volumes which do not fit
+    // into the memory limit are dropped from the cache and they will be sliced again.
+    for (auto it = cache->begin(); it != cache->end(); ++ it) {
+        size_t memory = 0;
+        for (const ExPolygons &slices : it->slices)
+            memory += sizeof(ExPolygons) + slices.size() * sizeof(ExPolygon) + (number_polygons(slices) * sizeof(Polygon) + count_points(slices) * sizeof(Point));
+        if (cache_memory + memory > cache_memory_limit) {
+            BOOST_LOG_TRIVIAL(debug) << "Slicing volumes - volume slices cache limit reached, dropping " << cache->end() - it << " of " << cache->size() << " volumes";
+            cache->erase(it, cache->end());
+            break;
+        }
+        cache_memory += memory;
+    }
     return out;
 }
 
@@ -339,6 +433,7 @@ static std::vector<std::vector<ExPolygons>> slices_to_regions(
             tbb::blocked_range<size_t>(0, zs_complex.size()),
             [&slices_by_region, &print_object_regions, &zs_complex, &layer_ranges_regions_to_slices, clip_multipart_objects, &throw_on_cancel_callback]
                 (const tbb::blocked_range<size_t> &range) {
+                TASK_TRACE_SCOPE("slices_to_regions");
                 float z              = zs_complex[range.begin()].second;
                 auto  it_layer_range = layer_range_first(print_object_regions.layer_ranges, z);
                 // Per volume_regions slices at this Z height.
@@ -706,6 +801,7 @@ std::string fix_slicing_errors(PrintObject* object, LayerPtrs &layers, const std
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, buggy_layers.size()),
         [&layers, &throw_if_canceled, &buggy_layers, &is_replaced](const tbb::blocked_range<size_t>& range) {
+            TASK_TRACE_SCOPE("fix_slicing_errors");
             for (size_t buggy_layer_idx = range.begin(); buggy_layer_idx < range.end(); ++ buggy_layer_idx) {
                 throw_if_canceled();
                 size_t idx_layer = buggy_layers[buggy_layer_idx];
@@ -852,6 +948,7 @@ void PrintObject::slice()
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, m_layers.size()),
         [this](const tbb::blocked_range<size_t>& range) {
+            TASK_TRACE_SCOPE("PrintObject::slice");
             for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                 m_print->throw_if_canceled();
                 Layer &layer = *m_layers[layer_idx];
@@ -4222,6 +4319,7 @@ static inline void apply_mm_segmentation(PrintObject &print_object, std::vector<
          local_z_mode,
          bias_mode_enabled,
          throw_on_cancel](const tbb::blocked_range<size_t> &range) {
+            TASK_TRACE_SCOPE("apply_mm_segmentation");
             const auto  &layer_ranges   = print_object.shared_regions()->layer_ranges;
             double       z              = print_object.get_layer(int(range.begin()))->slice_z;
             auto         it_layer_range = layer_range_first(layer_ranges, z);
@@ -5083,6 +5181,7 @@ void apply_fuzzy_skin_segmentation(PrintObject &print_object, ThrowOnCancel thro
     };
 
     tbb::parallel_for(tbb::blocked_range<size_t>(0, segmentation.size(), std::max(segmentation.size() / 128, size_t(1))), [&print_object, &segmentation, throw_on_cancel](const tbb::blocked_range<size_t> &range) {
+        TASK_TRACE_SCOPE("apply_fuzzy_skin_segmentation");
         const auto &layer_ranges   = print_object.shared_regions()->layer_ranges;
         auto        it_layer_range = layer_range_first(layer_ranges, print_object.get_layer(int(range.begin()))->slice_z);
 
@@ -5211,9 +5310,21 @@ void PrintObject::slice_volumes()
     std::vector<float>                   slice_zs      = zs_from_layers(m_layers);
     std::vector<VolumeSlices> objSliceByVolume;
     if (!slice_zs.empty()) {
+        size_t num_volumes_reused = 0;
+        size_t num_volumes_sliced = 0;
+        // The objects are sliced one after another, the cache of this object gets the memory not held by the caches of the other objects.
+        size_t cache_memory_limit = VOLUME_SLICES_CACHE_MAX_MEMORY;
+        for (const PrintObject *object : print->objects())
+            if (object != this)
+                cache_memory_limit -= std::min(cache_memory_limit, object->m_volume_slices_cache_memory);
+        if (! print->keep_reslice_caches())
+            m_volume_slices_cache.clear();
         objSliceByVolume = slice_volumes_inner(
             print->config(), this->config(), this->trafo_centered(),
-            this->model_object()->volumes, m_shared_regions->layer_ranges, slice_zs, throw_on_cancel_callback);
+            this->model_object()->volumes, m_shared_regions->layer_ranges, slice_zs, throw_on_cancel_callback,
+            print->keep_reslice_caches() ? &m_volume_slices_cache : nullptr, cache_memory_limit, m_volume_slices_cache_memory,
+            num_volumes_reused, num_volumes_sliced);
+        print->add_volume_slices_cache_statistics(num_volumes_reused, num_volumes_sliced);
     }
 
     //BBS: "model_part" volumes are grouded according to their connections
@@ -5322,6 +5433,7 @@ void PrintObject::slice_volumes()
 	    tbb::parallel_for(
 	        tbb::blocked_range<size_t>(0, m_layers.size()),
 			[this, xy_hole_scaled, xy_contour_scaled, elephant_foot_compensation_scaled, &lslices_elfoot_uncompensated](const tbb::blocked_range<size_t>& range) {
+	            TASK_TRACE_SCOPE("PrintObject::slice_volumes xy compensation");
 	            for (size_t layer_id = range.begin(); layer_id < range.end(); ++ layer_id) {
 	                m_print->throw_if_canceled();
 	                Layer *layer = m_layers[layer_id];
@@ -5649,6 +5761,7 @@ std::vector<Polygons> PrintObject::slice_support_volumes(const ModelVolumeType m
             tbb::parallel_for(
                 tbb::blocked_range<size_t>(0, to_merge.size()),
                 [&to_merge](const tbb::blocked_range<size_t> &range) {
+                    TASK_TRACE_SCOPE("PrintObject::slice_support_volumes");
                     for (size_t i = range.begin(); i < range.end(); ++ i)
                         *to_merge[i] = union_(*to_merge[i]);
             });
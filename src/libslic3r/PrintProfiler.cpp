@@ -0,0 +1,214 @@
+#include "PrintProfiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#ifdef WIN32
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <unistd.h>
+    #include <sys/resource.h>
+    #ifdef __APPLE__
+        #include <mach/mach.h>
+    #endif
+#endif
+
+#include <boost/format.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include <nlohmann/json.hpp>
+
+namespace Slic3r {
+
+using nlohmann::json;
+
+// Microseconds since the first call, shared by all PrintProfilers so that the steps of multiple Prints share a single timeline.
+static int64_t profiler_time_us()
+{
+    static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+// User and kernel time of all threads of the process.
+static int64_t process_cpu_time_us()
+{
+#ifdef WIN32
+    FILETIME creation, exit, kernel, user;
+    if (! GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0;
+    auto to_us = [](const FILETIME &ft) { return int64_t((uint64_t(ft.dwHighDateTime) << 32) | ft.dwLowDateTime) / 10; };
+    return to_us(kernel) + to_us(user);
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return int64_t(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + int64_t(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+#endif
+}
+
+// Current and peak resident memory of the process in bytes, zero if not available.
+static std::pair<size_t, size_t> process_memory()
+{
+    size_t rss = 0, peak_rss = 0;
+#ifdef WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        rss      = pmc.WorkingSetSize;
+        peak_rss = pmc.PeakWorkingSetSize;
+    }
+#else
+    #ifdef __APPLE__
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS)
+        rss = size_t(info.resident_size);
+    #else
+    size_t size = 0, resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    if (statm && (statm >> size >> resident))
+        rss = resident * size_t(sysconf(_SC_PAGE_SIZE));
+    #endif
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        peak_rss = size_t(usage.ru_maxrss);
+    #ifdef __linux__
+        // getrusage returns the value in kB on linux
+        peak_rss *= 1024;
+    #endif
+    }
+#endif
+    return { rss, peak_rss };
+}
+
+void PrintProfiler::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_started.clear();
+    m_records.clear();
+    m_next_sequence = 0;
+}
+
+bool PrintProfiler::empty() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_records.empty();
+}
+
+void PrintProfiler::step_started(const void *owner, const char *step)
+{
+    const int64_t cpu_us = process_cpu_time_us();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Sample the start time under the lock, so that the start times follow the sequence numbers.
+    m_started[{ owner, step }] = { profiler_time_us(), cpu_us, m_next_sequence ++ };
+}
+
+void PrintProfiler::step_finished(const void *owner, const char *step, const std::string &object, size_t object_id, size_t layers, size_t support_layers)
+{
+    const int64_t                   end_us  = profiler_time_us();
+    const int64_t                   cpu_us  = process_cpu_time_us();
+    const std::pair<size_t, size_t> memory  = process_memory();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_started.find({ owner, step });
+    if (it == m_started.end())
+        return;
+    StepRecord record;
+    record.step           = step;
+    record.object         = object;
+    record.object_id      = object_id;
+    record.start_us       = it->second.start_us;
+    record.start_sequence = it->second.sequence;
+    record.wall_us        = end_us - it->second.start_us;
+    record.cpu_us         = cpu_us - it->second.cpu_us;
+    record.rss            = memory.first;
+    record.peak_rss       = memory.second;
+    record.layers         = layers;
+    record.support_layers = support_layers;
+    record.thread_id      = std::hash<std::thread::id>()(std::this_thread::get_id());
+    m_started.erase(it);
+    m_records.emplace_back(std::move(record));
+}
+
+std::vector<PrintProfiler::StepRecord> PrintProfiler::records() const
+{
+    std::vector<StepRecord> out;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        out = m_records;
+    }
+    std::sort(out.begin(), out.end(), [](const StepRecord &l, const StepRecord &r) { return l.start_sequence < r.start_sequence; });
+    return out;
+}
+
+json PrintProfiler::to_json() const
+{
+    json out = json::array();
+    for (const StepRecord &record : this->records()) {
+        json j;
+        j["step"]     = record.step;
+        if (! record.object.empty() || record.object_id != 0) {
+            j["object"]         = record.object;
+            j["object_id"]      = record.object_id;
+            j["layers"]         = record.layers;
+            j["support_layers"] = record.support_layers;
+        }
+        j["wall_ms"]     = double(record.wall_us) * 0.001;
+        j["cpu_ms"]      = double(record.cpu_us) * 0.001;
+        j["rss_mb"]      = double(record.rss) / (1024. * 1024.);
+        j["peak_rss_mb"] = double(record.peak_rss) / (1024. * 1024.);
+        out.push_back(std::move(j));
+    }
+    return out;
+}
+
+void PrintProfiler::append_trace_events(json &trace_events, int pid, const std::string &process_name) const
+{
+    if (! trace_events.is_array())
+        trace_events = json::array();
+    trace_events.push_back({ { "name", "process_name" }, { "ph", "M" }, { "pid", pid }, { "args", { { "name", process_name } } } });
+    for (const StepRecord &record : this->records()) {
+        json args { { "cpu_ms", double(record.cpu_us) * 0.001 }, { "rss_mb", double(record.rss) / (1024. * 1024.) }, { "peak_rss_mb", double(record.peak_rss) / (1024. * 1024.) } };
+        if (! record.object.empty() || record.object_id != 0) {
+            args["object"]         = record.object;
+            args["object_id"]      = record.object_id;
+            args["layers"]         = record.layers;
+            args["support_layers"] = record.support_layers;
+        }
+        trace_events.push_back({
+            { "name", record.object.empty() ? record.step : record.step + " " + record.object },
+            { "cat",  record.object.empty() ? "print" : "object" },
+            { "ph",   "X" },
+            { "ts",   record.start_us },
+            { "dur",  record.wall_us },
+            { "pid",  pid },
+            // Keep the thread ids small, the trace viewers show them as labels.
+            { "tid",  record.thread_id % 100000 },
+            { "args", std::move(args) }
+        });
+    }
+}
+
+bool PrintProfiler::save_trace(const std::string &path, const json &trace_events)
+{
+    try {
+        json j;
+        j["traceEvents"]     = trace_events.is_array() ? trace_events : json::array();
+        j["displayTimeUnit"] = "ms";
+        boost::nowide::ofstream ofs(path, std::ios::out | std::ios::trunc);
+        ofs << j.dump();
+        if (! ofs.good())
+            throw std::runtime_error("write failed");
+    } catch (const std::exception &err) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << boost::format(": failed saving profile trace %1%, reason = %2%") % path % err.what();
+        return false;
+    }
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": saved profile trace to %1%") % path;
+    return true;
+}
+
+} // namespace Slic3r
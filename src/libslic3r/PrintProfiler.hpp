@@ -0,0 +1,83 @@
+#ifndef slic3r_PrintProfiler_hpp_
+#define slic3r_PrintProfiler_hpp_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json_fwd.hpp>
+
+namespace Slic3r {
+
+// Collects the wall time, CPU time and memory usage of the Print and PrintObject steps, see Print::set_profiler().
+// The steps report themselves from Print::set_started() / set_done() and PrintObject::set_started() / set_done(),
+// thus a step is recorded only if it was executed, a canceled step is not recorded.
+// Thread safe, the PrintObject steps may run in parallel.
+class PrintProfiler
+{
+public:
+    struct StepRecord
+    {
+        // Name of the step, for example "posSlice" or "psGCodeExport".
+        std::string     step;
+        // Name and ObjectID of the PrintObject, empty and zero for the Print steps.
+        std::string     object;
+        size_t          object_id { 0 };
+        // Start of the step in microseconds since the first profiled step of the application.
+        int64_t         start_us  { 0 };
+        // Order of the start of the step within the profiler, tells apart the steps started within the same microsecond.
+        size_t          start_sequence { 0 };
+        int64_t         wall_us   { 0 };
+        // CPU time of the whole process during the step, thus it includes the worker threads of the step
+        // and the steps running concurrently.
+        int64_t         cpu_us    { 0 };
+        // Resident memory at the end of the step and peak resident memory of the process so far, in bytes.
+        size_t          rss       { 0 };
+        size_t          peak_rss  { 0 };
+        // Number of object layers at the end of a PrintObject step.
+        size_t          layers    { 0 };
+        size_t          support_layers { 0 };
+        // Hash of the id of the thread, which executed the step.
+        size_t          thread_id { 0 };
+    };
+
+    void                    clear();
+    bool                    empty() const;
+
+    // owner identifies the Print or PrintObject, the step is started and finished by the same owner.
+    void                    step_started(const void *owner, const char *step);
+    void                    step_finished(const void *owner, const char *step, const std::string &object = std::string(), size_t object_id = 0,
+                                          size_t layers = 0, size_t support_layers = 0);
+
+    // Finished steps in the order of their start.
+    std::vector<StepRecord> records() const;
+
+    // Array of the finished steps with the times in milliseconds and the memory in MB.
+    nlohmann::json          to_json() const;
+    // Append the finished steps as complete events ("ph": "X") of the Chrome trace event format to trace_events,
+    // pid groups the events of a single Print, for example of a plate.
+    void                    append_trace_events(nlohmann::json &trace_events, int pid, const std::string &process_name) const;
+    // Save {"traceEvents": trace_events} to be opened by chrome://tracing or Perfetto.
+    static bool             save_trace(const std::string &path, const nlohmann::json &trace_events);
+
+private:
+    struct StartedStep
+    {
+        int64_t         start_us { 0 };
+        int64_t         cpu_us   { 0 };
+        size_t          sequence { 0 };
+    };
+
+    mutable std::mutex                                          m_mutex;
+    std::map<std::pair<const void*, std::string>, StartedStep>  m_started;
+    std::vector<StepRecord>                                     m_records;
+    size_t                                                      m_next_sequence { 0 };
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_PrintProfiler_hpp_
@@ -0,0 +1,61 @@
+#include "SettingsFileCache.hpp"
+
+#include <iterator>
+
+#include <boost/algorithm/hex.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <boost/uuid/detail/md5.hpp>
+
+namespace Slic3r {
+
+// Bound the number of files kept by a long running daemon.
+static constexpr size_t MAX_CACHED_SETTINGS_FILES = 256;
+
+std::string SettingsFileCache::file_digest(const std::string &file)
+{
+    boost::nowide::ifstream ifs(file, std::ios::binary);
+    if (! ifs)
+        return std::string();
+    const std::string data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    if (ifs.bad())
+        return std::string();
+
+    using boost::uuids::detail::md5;
+    md5 md5_hash;
+    md5_hash.process_bytes(data.data(), data.size());
+    md5::digest_type md5_digest{};
+    std::string      md5_digest_str;
+    md5_hash.get_digest(md5_digest);
+    boost::algorithm::hex(md5_digest, md5_digest + std::size(md5_digest), std::back_inserter(md5_digest_str));
+    return md5_digest_str;
+}
+
+bool SettingsFileCache::load(const std::string &file, const std::string &digest, DynamicPrintConfig &config, std::map<std::string, std::string> &key_values)
+{
+    auto it = m_entries.find(file);
+    if (it == m_entries.end())
+        return false;
+    if (digest.empty() || digest != it->second.digest) {
+        m_entries.erase(it);
+        return false;
+    }
+    config     = it->second.config;
+    key_values = it->second.key_values;
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ": reuse setting file " << file;
+    return true;
+}
+
+void SettingsFileCache::store(const std::string &file, const std::string &digest, const DynamicPrintConfig &config, const std::map<std::string, std::string> &key_values)
+{
+    if (digest.empty())
+        return;
+    if (m_entries.size() >= MAX_CACHED_SETTINGS_FILES && m_entries.find(file) == m_entries.end())
+        m_entries.clear();
+    Entry &entry     = m_entries[file];
+    entry.digest     = digest;
+    entry.config     = config;
+    entry.key_values = key_values;
+}
+
+} // namespace Slic3r
@@ -0,0 +1,39 @@
+#ifndef slic3r_SettingsFileCache_hpp_
+#define slic3r_SettingsFileCache_hpp_
+
+#include <map>
+#include <string>
+
+#include "PrintConfig.hpp"
+
+namespace Slic3r {
+
+// Settings files loaded by the command line with --load_settings / --load_filaments, kept for the following jobs
+// of the daemon mode. An entry is keyed on the hash of the content of the file, so that a file rewritten
+// within the resolution of the file system time stamps with the same size is loaded again.
+class SettingsFileCache
+{
+public:
+    // Hash of the content of a file, empty if it cannot be read.
+    // Take the digest before parsing the file, so that a file changing in the meantime is not stored under the new content.
+    static std::string  file_digest(const std::string &file);
+
+    // Copy the cached config of the file if it was stored with the same digest. An entry with another digest is dropped.
+    bool                load(const std::string &file, const std::string &digest, DynamicPrintConfig &config, std::map<std::string, std::string> &key_values);
+    void                store(const std::string &file, const std::string &digest, const DynamicPrintConfig &config, const std::map<std::string, std::string> &key_values);
+
+    size_t              size() const { return m_entries.size(); }
+    void                clear() { m_entries.clear(); }
+
+private:
+    struct Entry {
+        std::string                         digest;
+        DynamicPrintConfig                  config;
+        std::map<std::string, std::string>  key_values;
+    };
+    std::map<std::string, Entry>            m_entries;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_SettingsFileCache_hpp_
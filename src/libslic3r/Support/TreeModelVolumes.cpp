@@ -21,7 +21,11 @@
 
 #include <string_view>
 
+#include <boost/algorithm/hex.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/log/trivial.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <boost/uuid/detail/md5.hpp>
 
 #include <tbb/parallel_for.h>
 #include <tbb/task_group.h>
@@ -184,6 +188,18 @@ void TreeModelVolumes::precalculate(const PrintObject& print_object, const coord
     if (throw_on_cancel)
         throw_on_cancel();
 
+    // Restore the collisions and avoidances calculated by a previous slicing of the same geometry with compatible settings.
+    const std::string &cache_dir = print_object.print()->slice_cache_dir();
+    std::string        collision_cache_file, avoidance_cache_file;
+    size_t             num_loaded = 0;
+    if (! cache_dir.empty()) {
+        const auto [collision_key, avoidance_key] = this->persistent_cache_keys();
+        collision_cache_file = cache_dir + "/tree_support/" + collision_key + ".collision";
+        avoidance_cache_file = cache_dir + "/tree_support/" + avoidance_key + ".avoidance";
+        num_loaded += load_persistent_cache(collision_cache_file, this->persistent_collision_caches());
+        num_loaded += load_persistent_cache(avoidance_cache_file, this->persistent_avoidance_caches());
+    }
+
     // it may seem that the required avoidance can be of a smaller radius when going to model (no initial layer diameter for to model branches)
     // but as for every branch going towards the bp, the to model avoidance is required to check for possible merges with to model branches, this assumption is in-fact wrong.
     std::unordered_map<coord_t, LayerIndex> radius_until_layer;
@@ -246,6 +262,20 @@ void TreeModelVolumes::precalculate(const PrintObject& print_object, const coord
         task_group.run([this, relevant_avoidance_radiis, throw_on_cancel]{ calculateWallRestrictions(relevant_avoidance_radiis, throw_on_cancel); });
         task_group.wait();
     }
+    if (! cache_dir.empty()) {
+        size_t num_cached = 0;
+        for (const RadiusLayerPolygonCache *cache : this->persistent_collision_caches())
+            num_cached += cache->size();
+        for (const RadiusLayerPolygonCache *cache : this->persistent_avoidance_caches())
+            num_cached += cache->size();
+        print_object.print()->add_tree_support_cache_statistics(num_loaded, num_cached - num_loaded);
+        // Only write the caches back if something new was calculated.
+        if (num_cached > num_loaded) {
+            store_persistent_cache(collision_cache_file, this->persistent_collision_caches());
+            store_persistent_cache(avoidance_cache_file, this->persistent_avoidance_caches());
+        }
+    }
+
     auto t_end = std::chrono::high_resolution_clock::now();
     auto dur_col = 0.001 * std::chrono::duration_cast<std::chrono::microseconds>(t_coll - t_start).count();
     auto dur_avo = 0.001 * std::chrono::duration_cast<std::chrono::microseconds>(t_end - t_coll).count();
@@ -584,14 +614,19 @@ void TreeModelVolumes::calculateCollisionHolefree(const std::vector<RadiusLayerP
     LayerIndex max_layer = 0;
     for (long long unsigned int i = 0; i < keys.size(); i++)
         max_layer = std::max(max_layer, keys[i].second);
+    // Layers already calculated, for example restored from the persistent cache, are skipped.
+    std::vector<LayerIndex> max_calculated_layers;
+    max_calculated_layers.reserve(keys.size());
+    for (RadiusLayerPair key : keys)
+        max_calculated_layers.emplace_back(m_collision_cache_holefree.getMaxCalculatedLayer(key.first));
 
     tbb::parallel_for(tbb::blocked_range<LayerIndex>(0, max_layer + 1, keys.size()),
         [&](const tbb::blocked_range<LayerIndex> &range) {
         std::vector<std::pair<RadiusLayerPair, Polygons>> data;
         data.reserve(range.size() * keys.size());
         for (LayerIndex layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
-            for (RadiusLayerPair key : keys)
-                if (layer_idx <= key.second) {
+            for (size_t key_idx = 0; key_idx < keys.size(); ++ key_idx)
+                if (const RadiusLayerPair key = keys[key_idx]; layer_idx <= key.second && layer_idx > max_calculated_layers[key_idx]) {
                     // Logically increase the collision by m_increase_until_radius
                     coord_t radius = key.first;
                     assert(radius == this->ceilRadius(radius));
@@ -860,12 +895,217 @@ coord_t TreeModelVolumes::ceilRadius(const coord_t radius) const
     return out;
 }
 
-void TreeModelVolumes::RadiusLayerPolygonCache::allocate_layers(size_t num_layers)
+TreeModelVolumes::RadiusLayerPolygonCache::Layer& TreeModelVolumes::RadiusLayerPolygonCache::allocate_layer(LayerIndex layer_idx)
 {
-    if (num_layers > m_data.size()) {
-        if (num_layers > m_data.capacity())
-            reserve_power_of_2(m_data, num_layers);
-        m_data.resize(num_layers, {});
+    assert(layer_idx >= 0);
+    if (size_t(layer_idx) >= MAX_BLOCKS * BLOCK_SIZE)
+        throw RuntimeError("Tree support: Too many layers");
+    std::atomic<Block*> &slot  = m_blocks[size_t(layer_idx) >> BLOCK_BITS];
+    Block               *block = slot.load(std::memory_order_acquire);
+    if (block == nullptr) {
+        // Another thread may be allocating the same block, the one published first wins.
+        auto new_block = std::make_unique<Block>();
+        if (slot.compare_exchange_strong(block, new_block.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+            block = new_block.release();
+    }
+    size_t num_layers = m_num_layers.load(std::memory_order_relaxed);
+    while (num_layers < size_t(layer_idx) + 1 &&
+           ! m_num_layers.compare_exchange_weak(num_layers, size_t(layer_idx) + 1, std::memory_order_release, std::memory_order_relaxed))
+        ;
+    return (*block)[size_t(layer_idx) & (BLOCK_SIZE - 1)];
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::clear()
+{
+    if (m_blocks)
+        for (size_t i = 0; i < MAX_BLOCKS; ++ i)
+            delete m_blocks[i].exchange(nullptr);
+    m_num_layers = 0;
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::clear_all_but_radius0()
+{
+    for (size_t layer_idx = 0; layer_idx < m_num_layers; ++ layer_idx)
+        if (Layer *layer = this->layer(LayerIndex(layer_idx)); layer != nullptr) {
+            LayerData &l = layer->data;
+            auto begin = l.begin();
+            auto end = l.end();
+            if (begin != end && ++ begin != end)
+                l.erase(begin, end);
+        }
+}
+
+size_t TreeModelVolumes::RadiusLayerPolygonCache::size() const
+{
+    size_t out = 0;
+    for (size_t layer_idx = 0; layer_idx < m_num_layers; ++ layer_idx)
+        if (const Layer *layer = this->layer(LayerIndex(layer_idx)); layer != nullptr)
+            out += layer->data.size();
+    return out;
+}
+
+template<typename T> static void write_value(std::ostream &out, T value) { out.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+template<typename T> static bool read_value(std::istream &in, T &value) { return bool(in.read(reinterpret_cast<char*>(&value), sizeof(T))); }
+
+void TreeModelVolumes::RadiusLayerPolygonCache::save(std::ostream &out) const
+{
+    write_value<uint64_t>(out, this->size());
+    for (size_t layer_idx = 0; layer_idx < m_num_layers; ++ layer_idx)
+        if (const Layer *layer = this->layer(LayerIndex(layer_idx)); layer != nullptr)
+            for (const auto &[radius, polygons] : layer->data) {
+                write_value<int64_t>(out, radius);
+                write_value<int32_t>(out, int32_t(layer_idx));
+                write_value<uint64_t>(out, polygons.size());
+                for (const Polygon &polygon : polygons) {
+                    write_value<uint64_t>(out, polygon.size());
+                    out.write(reinterpret_cast<const char*>(polygon.points.data()), polygon.size() * sizeof(Point));
+                }
+            }
+}
+
+bool TreeModelVolumes::RadiusLayerPolygonCache::load(std::istream &in)
+{
+    // The counts read are validated against the bytes left in the stream, so that a corrupt file does not make us allocate
+    // an arbitrary amount of memory.
+    const std::istream::pos_type start = in.tellg();
+    in.seekg(0, std::ios::end);
+    const std::istream::pos_type end = in.tellg();
+    in.seekg(start);
+    if (start < 0 || end < start || ! in)
+        return false;
+    auto remaining = [&in, end]() { std::istream::pos_type pos = in.tellg(); return pos < 0 || pos > end ? uint64_t(0) : uint64_t(end - pos); };
+
+    uint64_t num_entries = 0;
+    if (! read_value(in, num_entries) || num_entries > remaining() / (sizeof(int64_t) + sizeof(int32_t) + sizeof(uint64_t)))
+        return false;
+    for (uint64_t i = 0; i < num_entries; ++ i) {
+        int64_t  radius;
+        int32_t  layer_idx;
+        uint64_t num_polygons;
+        if (! read_value(in, radius) || ! read_value(in, layer_idx) || ! read_value(in, num_polygons) ||
+            layer_idx < 0 || size_t(layer_idx) >= MAX_BLOCKS * BLOCK_SIZE || num_polygons > remaining() / sizeof(uint64_t))
+            return false;
+        Polygons polygons;
+        for (uint64_t j = 0; j < num_polygons; ++ j) {
+            uint64_t num_points;
+            if (! read_value(in, num_points) || num_points > remaining() / sizeof(Point))
+                return false;
+            Polygon &polygon = polygons.emplace_back();
+            polygon.points.resize(num_points);
+            if (! in.read(reinterpret_cast<char*>(polygon.points.data()), num_points * sizeof(Point)))
+                return false;
+        }
+        this->emplace(layer_idx, coord_t(radius), std::move(polygons));
+    }
+    return true;
+}
+
+// Bump if the layout of the persisted caches or the set of hashed inputs changes.
+static constexpr const char *TREE_SUPPORT_CACHE_FORMAT_VERSION = "1";
+
+std::pair<std::string, std::string> TreeModelVolumes::persistent_cache_keys() const
+{
+    using boost::uuids::detail::md5;
+    md5 md5_hash;
+    auto add_bytes = [&md5_hash](const void *data, size_t size) {
+        if (size > 0)
+            md5_hash.process_bytes(data, size);
+    };
+    auto add_value = [&add_bytes](auto value) { add_bytes(&value, sizeof(value)); };
+    auto add_polygons = [&add_bytes, &add_value](const Polygons &polygons) {
+        add_value(polygons.size());
+        for (const Polygon &polygon : polygons) {
+            add_value(polygon.size());
+            add_bytes(polygon.points.data(), polygon.size() * sizeof(Point));
+        }
+    };
+    auto digest = [](md5 hash) {
+        md5::digest_type md5_digest{};
+        std::string      md5_digest_str;
+        hash.get_digest(md5_digest);
+        boost::algorithm::hex(md5_digest, md5_digest + std::size(md5_digest), std::back_inserter(md5_digest_str));
+        return md5_digest_str;
+    };
+
+    add_bytes(TREE_SUPPORT_CACHE_FORMAT_VERSION, strlen(TREE_SUPPORT_CACHE_FORMAT_VERSION));
+    add_value(sizeof(Point));
+    add_value(m_layer_outlines.size());
+    for (const auto &[settings, outlines] : m_layer_outlines) {
+        add_value(settings.layer_height);
+        add_value(settings.support_bottom_distance);
+        add_value(settings.support_top_distance);
+        add_value(settings.support_xy_distance);
+        add_value(outlines.size());
+        for (const Polygons &polygons : outlines)
+            add_polygons(polygons);
+    }
+    add_value(m_current_outline_idx);
+    add_value(m_current_min_xy_dist);
+    add_value(m_current_min_xy_dist_delta);
+    add_value(m_min_resolution);
+    add_value(m_support_rests_on_model);
+    add_polygons(m_machine_border);
+    add_value(m_anti_overhang.size());
+    for (const Polygons &polygons : m_anti_overhang)
+        add_polygons(polygons);
+    std::string collision_key = digest(md5_hash);
+
+    add_value(m_max_move);
+    add_value(m_max_move_slow);
+    add_value(m_increase_until_radius);
+    add_value(m_radius_0);
+    add_value(m_ignorable_radii.size());
+    add_bytes(m_ignorable_radii.data(), m_ignorable_radii.size() * sizeof(coord_t));
+    return { std::move(collision_key), digest(md5_hash) };
+}
+
+size_t TreeModelVolumes::load_persistent_cache(const std::string &file_name, const std::vector<RadiusLayerPolygonCache*> &caches)
+{
+    boost::system::error_code ec;
+    if (! boost::filesystem::exists(file_name, ec))
+        return 0;
+    bool ok = false;
+    try {
+        boost::nowide::ifstream in(file_name, std::ios::in | std::ios::binary);
+        ok = in.good();
+        for (RadiusLayerPolygonCache *cache : caches)
+            ok = ok && cache->load(in);
+    } catch (std::exception &err) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": load of " << file_name << " got a generic exception, reason = " << err.what();
+        ok = false;
+    }
+    if (! ok) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": corrupt tree support cache " << file_name;
+        for (RadiusLayerPolygonCache *cache : caches)
+            cache->clear();
+        return 0;
+    }
+    touch_cache_file(file_name);
+    size_t num_loaded = 0;
+    for (RadiusLayerPolygonCache *cache : caches)
+        num_loaded += cache->size();
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": %1% areas restored from %2%") % num_loaded % file_name;
+    return num_loaded;
+}
+
+void TreeModelVolumes::store_persistent_cache(const std::string &file_name, const std::vector<RadiusLayerPolygonCache*> &caches)
+{
+    // Write into a temporary file first, so that a concurrent slicing process never reads a partially written cache.
+    // The temporary file name is unique, as objects with the same geometry and settings may be stored by multiple threads at once.
+    const std::string         tmp_file_name = boost::filesystem::unique_path(file_name + ".%%%%-%%%%-%%%%-%%%%.tmp").string();
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(boost::filesystem::path(file_name).parent_path(), ec);
+    try {
+        boost::nowide::ofstream out(tmp_file_name, std::ios::out | std::ios::binary | std::ios::trunc);
+        for (const RadiusLayerPolygonCache *cache : caches)
+            cache->save(out);
+        out.close();
+        if (out.fail())
+            throw Slic3r::RuntimeError("write error");
+        boost::filesystem::rename(tmp_file_name, file_name);
+    } catch (std::exception &err) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": save to " << file_name << " got a generic exception, reason = " << err.what();
+        boost::filesystem::remove(tmp_file_name, ec);
     }
 }
 
@@ -873,11 +1113,10 @@ void TreeModelVolumes::RadiusLayerPolygonCache::allocate_layers(size_t num_layer
 std::vector<std::pair<TreeModelVolumes::RadiusLayerPair, std::reference_wrapper<const Polygons>>> TreeModelVolumes::RadiusLayerPolygonCache::sorted() const
 {
     std::vector<std::pair<RadiusLayerPair, std::reference_wrapper<const Polygons>>> out;
-    for (auto &layer : m_data) {
-        auto layer_idx = LayerIndex(&layer - m_data.data());
-        for (auto &radius_polygons : layer)
-            out.emplace_back(std::make_pair(radius_polygons.first, layer_idx), radius_polygons.second);
-    }
+    for (size_t layer_idx = 0; layer_idx < m_num_layers; ++ layer_idx)
+        if (const Layer *layer = this->layer(LayerIndex(layer_idx)); layer != nullptr)
+            for (auto &radius_polygons : layer->data)
+                out.emplace_back(std::make_pair(radius_polygons.first, LayerIndex(layer_idx)), radius_polygons.second);
     assert(std::is_sorted(out.begin(), out.end(), [](auto &l, auto &r){ return l.first.second < r.first.second || (l.first.second == r.first.second) && l.first.first < r.first.first; }));
     return out;
 }
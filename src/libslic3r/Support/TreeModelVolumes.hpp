@@ -9,11 +9,17 @@
 #ifndef slic3r_TreeModelVolumes_hpp
 #define slic3r_TreeModelVolumes_hpp
 
+#include <array>
+#include <atomic>
+#include <iosfwd>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 
 #include <boost/functional/hash.hpp>
 
+#include <tbb/spin_rw_mutex.h>
+
 #include "TreeSupportCommon.hpp"
 
 #include "../Point.hpp"
@@ -193,47 +199,60 @@ private:
         LayerIndex            m_idx_end;
     };
 
+public:
     /*!
      * \brief Convenience typedef for the keys to the caches
      */
     using RadiusLayerPair             = std::pair<coord_t, LayerIndex>;
+    // Public to be unit tested.
     class RadiusLayerPolygonCache {
         // Map from radius to Polygons. Cache of one layer collision regions.
         using LayerData = std::map<coord_t, Polygons>;
-        // Vector of layers, at each layer map of radius to Polygons.
-        // Reference to Polygons returned shall be stable to insertion.
-        using Layers = std::vector<LayerData>;
+        // The cache is sharded by layer: each layer is guarded by its own reader / writer lock, thus the threads
+        // precalculating the collisions and avoidances of different layers do not contend, and the lookups of the same layer
+        // only block while a writer inserts into that very layer.
+        struct Layer {
+            LayerData                   data;
+            mutable tbb::spin_rw_mutex  mutex;
+        };
+        // The layers are allocated in blocks published through atomic pointers, thus locating a layer is lock free
+        // and the layers never move. Reference to Polygons returned shall be stable to insertion.
+        static constexpr size_t BLOCK_BITS = 6;
+        static constexpr size_t BLOCK_SIZE = size_t(1) << BLOCK_BITS;
+        static constexpr size_t MAX_BLOCKS = 4096;
+        using Block = std::array<Layer, BLOCK_SIZE>;
     public:
-        RadiusLayerPolygonCache() = default;
-        RadiusLayerPolygonCache(RadiusLayerPolygonCache &&rhs) : m_data(std::move(rhs.m_data)) {}
-        RadiusLayerPolygonCache& operator=(RadiusLayerPolygonCache &&rhs) { m_data = std::move(rhs.m_data); return *this; }
+        RadiusLayerPolygonCache() : m_blocks(std::make_unique<std::atomic<Block*>[]>(MAX_BLOCKS)) {}
+        RadiusLayerPolygonCache(RadiusLayerPolygonCache &&rhs) : m_blocks(std::move(rhs.m_blocks)), m_num_layers(rhs.m_num_layers.load()) { rhs.m_num_layers = 0; }
+        RadiusLayerPolygonCache& operator=(RadiusLayerPolygonCache &&rhs) {
+            this->clear();
+            m_blocks     = std::move(rhs.m_blocks);
+            m_num_layers = rhs.m_num_layers.load();
+            rhs.m_num_layers = 0;
+            return *this;
+        }
+        ~RadiusLayerPolygonCache() { this->clear(); }
 
         RadiusLayerPolygonCache(const RadiusLayerPolygonCache&) = delete;
         RadiusLayerPolygonCache& operator=(const RadiusLayerPolygonCache&) = delete;
 
         void insert(std::vector<std::pair<RadiusLayerPair, Polygons>> &&in) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             for (auto &d : in)
-                this->get_allocate_layer_data(d.first.second).emplace(d.first.first, std::move(d.second));
+                this->emplace(d.first.second, d.first.first, std::move(d.second));
         }
         // by layer
         void insert(std::vector<std::pair<coord_t, Polygons>> &&in, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             for (auto &d : in)
-                this->get_allocate_layer_data(d.first).emplace(radius, std::move(d.second));
+                this->emplace(d.first, radius, std::move(d.second));
         }
         void insert(std::vector<Polygons> &&in, coord_t first_layer_idx, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            allocate_layers(first_layer_idx + in.size());
             for (auto &d : in)
-                m_data[first_layer_idx ++].emplace(radius, std::move(d));
+                this->emplace(first_layer_idx ++, radius, std::move(d));
         }
         void insert(LayerPolygonCache &&in, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             LayerIndex i = in.begin();
-            allocate_layers(i + LayerIndex(in.size()));
             for (auto &d : in.polygons_mutable())
-                m_data[i ++].emplace(radius, std::move(d));
+                this->emplace(i ++, radius, std::move(d));
         }
         /*!
          * \brief Checks a cache for a given RadiusLayerPair and returns it if it is found
@@ -241,25 +260,25 @@ private:
          * \return A wrapped optional reference of the requested area (if it was found, an empty optional if nothing was found)
          */
         std::optional<std::reference_wrapper<const Polygons>> getArea(const TreeModelVolumes::RadiusLayerPair &key) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            if (key.second >= LayerIndex(m_data.size()))
+            const Layer *layer = this->layer(key.second);
+            if (layer == nullptr)
                 return std::optional<std::reference_wrapper<const Polygons>>{};
-            const auto &layer = m_data[key.second];
-            auto it = layer.find(key.first);
-            return it == layer.end() ? 
+            tbb::spin_rw_mutex::scoped_lock lock(layer->mutex, false);
+            auto it = layer->data.find(key.first);
+            return it == layer->data.end() ? 
                 std::optional<std::reference_wrapper<const Polygons>>{} : std::optional<std::reference_wrapper<const Polygons>>{ it->second };
         }
         // Get a collision area at a given layer for a radius that is a lower or equial to the key radius.
         std::optional<std::pair<coord_t, std::reference_wrapper<const Polygons>>> get_lower_bound_area(const TreeModelVolumes::RadiusLayerPair &key) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            if (key.second >= LayerIndex(m_data.size()))
+            const Layer *layer = this->layer(key.second);
+            if (layer == nullptr)
                 return {};
-            const auto &layer = m_data[key.second];
-            if (layer.empty())
+            tbb::spin_rw_mutex::scoped_lock lock(layer->mutex, false);
+            if (layer->data.empty())
                 return {};
-            auto it = layer.lower_bound(key.first);
-            if (it == layer.end() || it->first != key.first) {
-                if (it == layer.begin())
+            auto it = layer->data.lower_bound(key.first);
+            if (it == layer->data.end() || it->first != key.first) {
+                if (it == layer->data.begin())
                     return {};
                 -- it;
             }
@@ -273,11 +292,13 @@ private:
          * \return A wrapped optional reference of the requested area (if it was found, an empty optional if nothing was found)
          */
         LayerIndex getMaxCalculatedLayer(coord_t radius) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            auto layer_idx = LayerIndex(m_data.size()) - 1;
+            auto layer_idx = LayerIndex(m_num_layers.load(std::memory_order_acquire)) - 1;
             for (; layer_idx > 0; -- layer_idx)
-                if (const auto &layer = m_data[layer_idx]; layer.find(radius) != layer.end())
-                    break;
+                if (const Layer *layer = this->layer(layer_idx); layer != nullptr) {
+                    tbb::spin_rw_mutex::scoped_lock lock(layer->mutex, false);
+                    if (layer->data.find(radius) != layer->data.end())
+                        break;
+                }
             // The placeable on model areas do not exist on layer 0, as there can not be model below it. As such it may be possible that layer 1 is available, but layer 0 does not exist.
             return layer_idx == 0 ? -1 : layer_idx;
         }
@@ -285,28 +306,40 @@ private:
         // For debugging purposes, sorted by layer index, then by radius.
         [[nodiscard]] std::vector<std::pair<RadiusLayerPair, std::reference_wrapper<const Polygons>>> sorted() const;
 
-        void clear() { m_data.clear(); }
-        void clear_all_but_radius0() { 
-            for (LayerData &l : m_data) {
-                auto begin = l.begin();
-                auto end = l.end();
-                if (begin != end && ++ begin != end)
-                    l.erase(begin, end);
-            }
-        }
+        // Not thread safe.
+        void clear();
+        // Not thread safe.
+        void clear_all_but_radius0();
+
+        // Number of the cached RadiusLayerPairs. Not thread safe.
+        size_t size() const;
+        // Binary serialization for persisting the cache on disk. Not thread safe.
+        void save(std::ostream &out) const;
+        // Insert the cached areas read from a stream written by save(). Returns false if the stream is truncated or corrupt.
+        bool load(std::istream &in);
 
     private:
-        LayerData&          get_allocate_layer_data(LayerIndex layer_idx) {
-            allocate_layers(layer_idx + 1);
-            return m_data[layer_idx];
+        // Layer at layer_idx if its block was allocated already, nullptr otherwise. Lock free.
+        Layer*              layer(LayerIndex layer_idx) const {
+            if (layer_idx < 0 || size_t(layer_idx) >= MAX_BLOCKS * BLOCK_SIZE || ! m_blocks)
+                return nullptr;
+            Block *block = m_blocks[size_t(layer_idx) >> BLOCK_BITS].load(std::memory_order_acquire);
+            return block ? &(*block)[size_t(layer_idx) & (BLOCK_SIZE - 1)] : nullptr;
+        }
+        // Allocate the block of layer_idx if it has not been allocated yet.
+        Layer&              allocate_layer(LayerIndex layer_idx);
+        void                emplace(LayerIndex layer_idx, coord_t radius, Polygons &&polygons) {
+            Layer &layer = this->allocate_layer(layer_idx);
+            tbb::spin_rw_mutex::scoped_lock lock(layer.mutex, true);
+            layer.data.emplace(radius, std::move(polygons));
         }
-        void                allocate_layers(size_t num_layers);
 
-        Layers              m_data;
-        mutable std::mutex  m_mutex;
+        std::unique_ptr<std::atomic<Block*>[]> m_blocks;
+        // One past the highest layer allocated.
+        std::atomic<size_t>                    m_num_layers { 0 };
     };
 
-
+private:
     /*!
      * \brief Provides the areas that have to be avoided by the tree's branches to prevent collision with the model on this layer. Holes are removed.
      *
@@ -415,6 +448,28 @@ private:
         calculateWallRestrictions(std::vector<RadiusLayerPair>{ RadiusLayerPair(key) }, []{});
     }
 
+    /*!
+     * \brief Keys of the caches persisted into Print::slice_cache_dir() by precalculate().
+     *
+     * The collision key covers everything the collisions, placeable areas and wall restrictions depend on: the layer outlines,
+     * the support blockers, the z and xy distances and the resolution. The avoidance key adds the move distances and the radius sampling,
+     * which the avoidances and the hole free collisions depend on as well. Thus changing the branch diameter or the interface settings
+     * reuses the persisted collisions.
+     */
+    std::pair<std::string, std::string> persistent_cache_keys() const;
+    // Load the caches from a file stored by store_persistent_cache(). Returns the number of the cached RadiusLayerPairs loaded.
+    static size_t load_persistent_cache(const std::string &file_name, const std::vector<RadiusLayerPolygonCache*> &caches);
+    static void store_persistent_cache(const std::string &file_name, const std::vector<RadiusLayerPolygonCache*> &caches);
+    // Caches depending on the collision key only.
+    std::vector<RadiusLayerPolygonCache*> persistent_collision_caches() {
+        return { &m_collision_cache, &m_placeable_areas_cache, &m_wall_restrictions_cache, &m_wall_restrictions_cache_min };
+    }
+    // Caches depending on the avoidance key.
+    std::vector<RadiusLayerPolygonCache*> persistent_avoidance_caches() {
+        return { &m_collision_cache_holefree, &m_avoidance_cache, &m_avoidance_cache_slow, &m_avoidance_cache_to_model, &m_avoidance_cache_to_model_slow,
+                 &m_avoidance_cache_holefree, &m_avoidance_cache_holefree_to_model };
+    }
+
     /*!
      * \brief The maximum distance that the center point of a tree branch may move in consecutive layers if it has to avoid the model.
      */
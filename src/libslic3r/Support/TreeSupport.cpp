@@ -3458,9 +3458,7 @@ SupportNode* TreeSupportData::create_node(const Point position, const int distan
 {
     // this function may be called from multiple threads, need to lock
     m_mutex.lock();
-    std::unique_ptr<SupportNode> node = std::make_unique<SupportNode>(position, distance_to_top, obj_layer_nr, support_roof_layers_below, to_buildplate, parent, print_z_, height_, dist_mm_to_top_, radius_);
-    SupportNode* raw_ptr = node.get();
-    contact_nodes.emplace_back(std::move(node));
+    SupportNode* raw_ptr = contact_nodes.create(size_t(std::max(obj_layer_nr, 0)), position, distance_to_top, obj_layer_nr, support_roof_layers_below, to_buildplate, parent, print_z_, height_, dist_mm_to_top_, radius_);
     m_mutex.unlock();
     if (parent)
         raw_ptr->movement = position - parent->position;
@@ -3470,7 +3468,50 @@ SupportNode* TreeSupportData::create_node(const Point position, const int distan
 void TreeSupportData::clear_nodes()
 {
     tbb::spin_mutex::scoped_lock guard(m_mutex);
-    contact_nodes.clear();
+    contact_nodes.release();
+}
+
+size_t TreeSupportData::nodes_count() const
+{
+    return contact_nodes.size();
+}
+
+size_t TreeSupportData::nodes_memory() const
+{
+    return contact_nodes.memory();
+}
+
+void SupportNodePool::release()
+{
+    for (Layer &layer : m_layers)
+        for (Chunk &chunk : layer.chunks) {
+            for (size_t i = 0; i < chunk.size; ++ i)
+                chunk.nodes[i].~SupportNode();
+            std::allocator<SupportNode>().deallocate(chunk.nodes, chunk.capacity);
+        }
+    // Free the layers too, not just the nodes.
+    m_layers = std::vector<Layer>();
+    m_size   = 0;
+}
+
+size_t SupportNodePool::layer_size(size_t layer_idx) const
+{
+    size_t size = 0;
+    if (layer_idx < m_layers.size())
+        for (const Chunk &chunk : m_layers[layer_idx].chunks)
+            size += chunk.size;
+    return size;
+}
+
+size_t SupportNodePool::memory() const
+{
+    size_t size = m_layers.capacity() * sizeof(Layer);
+    for (const Layer &layer : m_layers) {
+        size += layer.chunks.capacity() * sizeof(Chunk);
+        for (const Chunk &chunk : layer.chunks)
+            size += chunk.capacity * sizeof(SupportNode);
+    }
+    return size;
 }
 
 coordf_t TreeSupportData::ceil_radius(coordf_t radius) const
@@ -183,6 +183,91 @@ struct SupportNode
     }
 };
 
+/*!
+ * \brief Storage of the nodes of a tree support.
+ *
+ * The nodes are constructed in place in chunks of contiguous memory, one list of chunks per object layer,
+ * so that the nodes of a layer traversed together are close in memory and creating a node does not call the system allocator.
+ * The chunks of a layer grow geometrically from MIN_CHUNK_SIZE to MAX_CHUNK_SIZE nodes, thus layers with a few branches only
+ * do not reserve space for hundreds of nodes.
+ * The nodes live until the whole pool is released, thus the pointers linking the nodes of the tree stay valid.
+ *
+ * \warning Not thread safe, the caller has to synchronize creating the nodes.
+ */
+class SupportNodePool
+{
+public:
+    SupportNodePool() = default;
+    ~SupportNodePool() { release(); }
+
+    SupportNodePool(SupportNodePool&& rhs) noexcept : m_layers(std::move(rhs.m_layers)), m_size(rhs.m_size) { rhs.m_layers.clear(); rhs.m_size = 0; }
+    SupportNodePool& operator=(SupportNodePool&& rhs) noexcept
+    {
+        if (this != &rhs) {
+            release();
+            m_layers = std::move(rhs.m_layers);
+            m_size   = rhs.m_size;
+            rhs.m_layers.clear();
+            rhs.m_size = 0;
+        }
+        return *this;
+    }
+
+    SupportNodePool(const SupportNodePool&) = delete;
+    SupportNodePool& operator=(const SupportNodePool&) = delete;
+
+    template<typename... Args>
+    SupportNode* create(size_t layer_idx, Args&&... args)
+    {
+        if (layer_idx >= m_layers.size())
+            m_layers.resize(layer_idx + 1);
+        std::vector<Chunk> &chunks = m_layers[layer_idx].chunks;
+        if (chunks.empty() || chunks.back().size == chunks.back().capacity) {
+            const size_t capacity = chunks.empty() ? MIN_CHUNK_SIZE : std::min(chunks.back().capacity * 2, MAX_CHUNK_SIZE);
+            // Reserve before allocating the chunk, so that the chunk does not leak if the vector fails to grow.
+            if (chunks.size() == chunks.capacity())
+                chunks.reserve(std::max<size_t>(4, chunks.size() * 2));
+            chunks.push_back({ std::allocator<SupportNode>().allocate(capacity), capacity, 0 });
+        }
+        Chunk       &chunk = chunks.back();
+        SupportNode *node  = new (chunk.nodes + chunk.size) SupportNode(std::forward<Args>(args)...);
+        ++ chunk.size;
+        ++ m_size;
+        return node;
+    }
+
+    // Destroy all the nodes at once and free their memory.
+    void release();
+
+    // Number of nodes.
+    size_t size() const { return m_size; }
+    // Number of nodes of an object layer.
+    size_t layer_size(size_t layer_idx) const;
+    size_t num_layers() const { return m_layers.size(); }
+    // Bytes allocated for the nodes, not including the memory owned by the nodes.
+    size_t memory() const;
+
+private:
+    static constexpr size_t MIN_CHUNK_SIZE = 8;
+    static constexpr size_t MAX_CHUNK_SIZE = 256;
+
+    struct Chunk
+    {
+        SupportNode *nodes;
+        size_t       capacity;
+        // Number of nodes constructed in this chunk.
+        size_t       size;
+    };
+
+    struct Layer
+    {
+        std::vector<Chunk> chunks;
+    };
+
+    std::vector<Layer> m_layers;
+    size_t             m_size { 0 };
+};
+
 /*!
  * \brief Lazily generates tree guidance volumes.
  *
@@ -244,9 +329,12 @@ public:
     SupportNode* create_node(const Point position, const int distance_to_top, const int obj_layer_nr, const int support_roof_layers_below, const bool to_buildplate, SupportNode* parent,
         coordf_t     print_z_, coordf_t height_, coordf_t dist_mm_to_top_ = 0, coordf_t radius_ = 0);
     void clear_nodes();
+    // Number of nodes created and the bytes allocated for them.
+    size_t nodes_count() const;
+    size_t nodes_memory() const;
     std::vector<LayerHeightData> layer_heights;
 
-    std::vector<std::unique_ptr<SupportNode>> contact_nodes;
+    SupportNodePool contact_nodes;
     // ExPolygon                  m_machine_border;
 
 private:
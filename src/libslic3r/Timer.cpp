@@ -1,5 +1,12 @@
 #include "Timer.hpp"
+
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include <boost/log/trivial.hpp>
+#include <boost/nowide/fstream.hpp>
 
 using namespace std::chrono;
 
@@ -19,3 +26,130 @@ void TimeLimitAlarm::report_time_exceeded() const {
 }
 
 }
+
+namespace Slic3r::Timing {
+
+namespace TaskTrace {
+
+std::atomic<bool> g_enabled { false };
+
+struct Event
+{
+    const char *name;
+    int64_t     begin_us;
+    int64_t     end_us;
+};
+
+// Events of a single thread, owned by the registry to survive the thread.
+struct ThreadEvents
+{
+    int                 tid;
+    std::mutex          mutex;
+    std::vector<Event>  events;
+};
+
+struct Registry
+{
+    std::mutex                                  mutex;
+    std::string                                 path;
+    std::vector<std::unique_ptr<ThreadEvents>>  threads;
+    steady_clock::time_point                    origin { steady_clock::now() };
+    bool                                        save_at_exit_registered { false };
+};
+
+static Registry& registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+int64_t now_us()
+{
+    return duration_cast<microseconds>(steady_clock::now() - registry().origin).count();
+}
+
+void add_event(const char *name, int64_t begin_us, int64_t end_us)
+{
+    thread_local ThreadEvents *thread_events = nullptr;
+    if (thread_events == nullptr) {
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.threads.emplace_back(std::make_unique<ThreadEvents>());
+        thread_events = reg.threads.back().get();
+        thread_events->tid = int(reg.threads.size());
+    }
+    std::lock_guard<std::mutex> lock(thread_events->mutex);
+    thread_events->events.push_back({ name, begin_us, end_us });
+}
+
+static void append_json_string(std::string &out, const char *s)
+{
+    out += '"';
+    for (; *s; ++ s) {
+        if (*s == '"' || *s == '\\')
+            out += '\\';
+        out += *s;
+    }
+    out += '"';
+}
+
+// Enable the tracing from the environment at the start of the application.
+static const bool enabled_from_environment = [] {
+    if (const char *path = std::getenv("ORCA_TASK_TRACE"); path != nullptr && *path != 0)
+        task_trace_start(path);
+    return true;
+}();
+
+} // namespace TaskTrace
+
+void task_trace_start(const std::string &path)
+{
+    // Log first: the logging core shall be constructed before the exit handler is registered, so that it is destructed after the handler.
+    BOOST_LOG_TRIVIAL(info) << "Task tracing enabled, the trace will be saved to " << path;
+    TaskTrace::Registry &reg = TaskTrace::registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.path = path;
+        if (! reg.save_at_exit_registered) {
+            reg.save_at_exit_registered = true;
+            std::atexit([]() { task_trace_save(); });
+        }
+    }
+    TaskTrace::g_enabled.store(true, std::memory_order_relaxed);
+}
+
+bool task_trace_save()
+{
+    TaskTrace::Registry &reg = TaskTrace::registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    if (reg.path.empty())
+        return false;
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool        first = true;
+    size_t      num_events = 0;
+    for (const std::unique_ptr<TaskTrace::ThreadEvents> &thread : reg.threads) {
+        std::lock_guard<std::mutex> thread_lock(thread->mutex);
+        for (const TaskTrace::Event &event : thread->events) {
+            out += first ? "\n" : ",\n";
+            first = false;
+            out += "{\"name\":";
+            TaskTrace::append_json_string(out, event.name);
+            out += ",\"cat\":\"task\",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(thread->tid) +
+                   ",\"ts\":" + std::to_string(event.begin_us) + ",\"dur\":" + std::to_string(event.end_us - event.begin_us) + "}";
+        }
+        num_events += thread->events.size();
+    }
+    out += "\n]}\n";
+
+    boost::nowide::ofstream ofs(reg.path, std::ios::out | std::ios::trunc | std::ios::binary);
+    ofs << out;
+    if (! ofs.good()) {
+        BOOST_LOG_TRIVIAL(error) << "Failed saving the task trace to " << reg.path;
+        return false;
+    }
+    BOOST_LOG_TRIVIAL(info) << "Saved " << num_events << " task events from " << reg.threads.size() << " threads to " << reg.path;
+    return true;
+}
+
+} // namespace Slic3r::Timing
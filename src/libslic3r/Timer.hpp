@@ -3,6 +3,8 @@
 
 #include <string>
 #include <chrono>
+#include <atomic>
+#include <cstdint>
 
 namespace Slic3r {
 
@@ -85,8 +87,42 @@ namespace Timing {
         std::string_view    m_limit_exceeded_message;
     };
 
+    // Tracing of the parallel tasks: begin / end of the named TBB parallel_for bodies and parallel_pipeline filters
+    // with the thread executing them, saved in the Chrome trace event format to be opened by chrome://tracing or Perfetto.
+    // Enabled by the ORCA_TASK_TRACE=<file> environment variable or by task_trace_start(), the trace is saved
+    // at the exit of the application or by task_trace_save(). When disabled, TASK_TRACE_SCOPE costs a relaxed atomic load.
+    namespace TaskTrace {
+        extern std::atomic<bool> g_enabled;
+        inline bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+        // Microseconds since the start of the tracing.
+        int64_t     now_us();
+        // name must be a string literal, only the pointer is stored.
+        void        add_event(const char *name, int64_t begin_us, int64_t end_us);
+    }
+
+    // Start collecting the task events to be saved into path.
+    void task_trace_start(const std::string &path);
+    // Save the events collected so far, tracing continues.
+    bool task_trace_save();
+
+    class TaskTraceScope {
+    public:
+        explicit TaskTraceScope(const char *name) : m_name(TaskTrace::enabled() ? name : nullptr), m_begin_us(m_name ? TaskTrace::now_us() : 0) {}
+        ~TaskTraceScope() { if (m_name) TaskTrace::add_event(m_name, m_begin_us, TaskTrace::now_us()); }
+        TaskTraceScope(const TaskTraceScope&) = delete;
+        TaskTraceScope& operator=(const TaskTraceScope&) = delete;
+    private:
+        const char *m_name;
+        int64_t     m_begin_us;
+    };
+
 } // namespace Catch
 
 } // namespace Slic3r
 
+#define TASK_TRACE_CONCAT_IMPL(a, b) a##b
+#define TASK_TRACE_CONCAT(a, b) TASK_TRACE_CONCAT_IMPL(a, b)
+// Record the life time of this scope as a task event, see Timing::task_trace_start().
+#define TASK_TRACE_SCOPE(name) ::Slic3r::Timing::TaskTraceScope TASK_TRACE_CONCAT(task_trace_scope_, __LINE__)(name)
+
 #endif // libslic3r_Timer_hpp_
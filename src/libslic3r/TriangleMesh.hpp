@@ -11,6 +11,9 @@
 #include "Polygon.hpp"
 #include "ExPolygon.hpp"
 #include "Format/STL.hpp"
+
+#include <ankerl/unordered_dense.h>
+
 namespace Slic3r {
 
 class TriangleMesh;
@@ -214,6 +217,20 @@ int its_remove_degenerate_faces(indexed_triangle_set &its, bool shrink_to_fit =
 // Remove vertices, which none of the faces references. Return number of freed vertices.
 int its_compactify_vertices(indexed_triangle_set &its, bool shrink_to_fit = true);
 
+// Key of a vertex of a triangle soup, the coordinates are compared bitwise, as admesh matches the vertices of the facets exactly.
+// Used to merge the vertices while building an indexed_triangle_set from the facets, see VertexKeyHash.
+struct VertexKey
+{
+    uint32_t bits[3];
+    bool operator==(const VertexKey &rhs) const { return bits[0] == rhs.bits[0] && bits[1] == rhs.bits[1] && bits[2] == rhs.bits[2]; }
+};
+
+struct VertexKeyHash
+{
+    using is_avalanching = void;
+    uint64_t operator()(const VertexKey &key) const noexcept { return ankerl::unordered_dense::detail::wyhash::hash(key.bits, sizeof(key.bits)); }
+};
+
 // store part of index triangle set
 bool its_store_triangle(const indexed_triangle_set &its, const char *obj_filename, size_t triangle_index);
 bool its_store_triangles(const indexed_triangle_set &its, const char *obj_filename, const std::vector<size_t>& triangles);
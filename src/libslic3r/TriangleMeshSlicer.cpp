@@ -6,18 +6,33 @@
 #include "Utils.hpp"
 // BBS
 #include "MeshBoolean.hpp"
+#include "MonotonicArena.hpp"
 
 #include <algorithm>
 #include <cmath>
 #include <deque>
+#include <limits>
 #include <queue>
 #include <mutex>
 #include <utility>
 
 #include <boost/log/trivial.hpp>
 
+#include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 
+// Vector unit used to classify the triangles against the slicing planes, see SlicingSIMD.
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define SLIC3R_SLICING_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SLIC3R_SLICING_SIMD_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #include <arm_neon.h>
+    #define SLIC3R_SLICING_SIMD_NEON
+#endif
+
 #ifndef NDEBUG
 //    #define EXPENSIVE_DEBUG_CHECKS
 #endif // NDEBUG
@@ -152,6 +167,18 @@ enum class FacetSliceType {
     Cutting = 2
 };
 
+// Parameter of the intersection of the plane at slice_z with the edge from b (t = 0) to a (t = 1).
+static inline double edge_plane_parameter(const stl_vertex &a, const stl_vertex &b, float slice_z)
+{
+    return (double(slice_z) - double(b.z())) / (double(a.z()) - double(b.z()));
+}
+
+static inline void edge_plane_point(const stl_vertex &a, const stl_vertex &b, double t, Point &point)
+{
+    point.x() = coord_t(floor(double(b.x()) + (double(a.x()) - double(b.x())) * t + 0.5));
+    point.y() = coord_t(floor(double(b.y()) + (double(a.y()) - double(b.y())) * t + 0.5));
+}
+
 // Return true, if the facet has been sliced and line_out has been filled.
 static FacetSliceType slice_facet(
     // Z height of the slice in XY plane. Scaled or unscaled (same as vertices[].z()).
@@ -258,7 +285,7 @@ static FacetSliceType slice_facet(
                 std::swap(a, b);
             }
             IntersectionPoint &point = points[num_points];
-            double t = (double(slice_z) - double(b->z())) / (double(a->z()) - double(b->z()));
+            double t = edge_plane_parameter(*a, *b, slice_z);
             if (t <= 0.) {
                 if (point_on_layer == size_t(-1) || points[point_on_layer].point_id != a_id) {
                     point.x() = a->x();
@@ -274,8 +301,7 @@ static FacetSliceType slice_facet(
                     point.point_id = b_id;
                 }
             } else {
-                point.x() = coord_t(floor(double(b->x()) + (double(a->x()) - double(b->x())) * t + 0.5));
-                point.y() = coord_t(floor(double(b->y()) + (double(a->y()) - double(b->y())) * t + 0.5));
+                edge_plane_point(*a, *b, t, point);
                 point.edge_id = edge_id;
                 ++ num_points;
             }
@@ -472,39 +498,270 @@ static FacetSliceType slice_facet_for_cut_mesh(
     return FacetSliceType::NoSlice;
 }
 
+// Vector of single precision floats of the widest vector unit enabled for the build (AVX2, SSE2, NEON),
+// scalar if there is none. Comparisons return a bit mask, bit i set for lane i.
+namespace SlicingSIMD {
+#if defined(SLIC3R_SLICING_SIMD_AVX2)
+    struct Floats {
+        static constexpr const size_t size = 8;
+        __m256 v;
+        static Floats load(const float *p) { return { _mm256_loadu_ps(p) }; }
+        static Floats set1(float f) { return { _mm256_set1_ps(f) }; }
+        void          store(float *p) const { _mm256_storeu_ps(p, v); }
+    };
+    inline Floats   min(Floats a, Floats b) { return { _mm256_min_ps(a.v, b.v) }; }
+    inline Floats   max(Floats a, Floats b) { return { _mm256_max_ps(a.v, b.v) }; }
+    inline uint32_t lt_mask(Floats a, Floats b) { return uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ))); }
+    inline uint32_t eq_mask(Floats a, Floats b) { return uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ))); }
+#elif defined(SLIC3R_SLICING_SIMD_SSE2)
+    struct Floats {
+        static constexpr const size_t size = 4;
+        __m128 v;
+        static Floats load(const float *p) { return { _mm_loadu_ps(p) }; }
+        static Floats set1(float f) { return { _mm_set1_ps(f) }; }
+        void          store(float *p) const { _mm_storeu_ps(p, v); }
+    };
+    inline Floats   min(Floats a, Floats b) { return { _mm_min_ps(a.v, b.v) }; }
+    inline Floats   max(Floats a, Floats b) { return { _mm_max_ps(a.v, b.v) }; }
+    inline uint32_t lt_mask(Floats a, Floats b) { return uint32_t(_mm_movemask_ps(_mm_cmplt_ps(a.v, b.v))); }
+    inline uint32_t eq_mask(Floats a, Floats b) { return uint32_t(_mm_movemask_ps(_mm_cmpeq_ps(a.v, b.v))); }
+#elif defined(SLIC3R_SLICING_SIMD_NEON)
+    struct Floats {
+        static constexpr const size_t size = 4;
+        float32x4_t v;
+        static Floats load(const float *p) { return { vld1q_f32(p) }; }
+        static Floats set1(float f) { return { vdupq_n_f32(f) }; }
+        void          store(float *p) const { vst1q_f32(p, v); }
+    };
+    inline Floats   min(Floats a, Floats b) { return { vminq_f32(a.v, b.v) }; }
+    inline Floats   max(Floats a, Floats b) { return { vmaxq_f32(a.v, b.v) }; }
+    inline uint32_t movemask(uint32x4_t m)
+    {
+        static const uint32_t bits[4] = { 1, 2, 4, 8 };
+        return vaddvq_u32(vandq_u32(m, vld1q_u32(bits)));
+    }
+    inline uint32_t lt_mask(Floats a, Floats b) { return movemask(vcltq_f32(a.v, b.v)); }
+    inline uint32_t eq_mask(Floats a, Floats b) { return movemask(vceqq_f32(a.v, b.v)); }
+#else
+    struct Floats {
+        static constexpr const size_t size = 1;
+        float v;
+        static Floats load(const float *p) { return { *p }; }
+        static Floats set1(float f) { return { f }; }
+        void          store(float *p) const { *p = v; }
+    };
+    inline Floats   min(Floats a, Floats b) { return { std::min(a.v, b.v) }; }
+    inline Floats   max(Floats a, Floats b) { return { std::max(a.v, b.v) }; }
+    inline uint32_t lt_mask(Floats a, Floats b) { return a.v < b.v; }
+    inline uint32_t eq_mask(Floats a, Floats b) { return a.v == b.v; }
+#endif
+} // namespace SlicingSIMD
+
+// Z extents of n triangles, the Z coordinates of their vertices stored in z0, z1, z2.
+static inline void triangle_z_extents(const float *z0, const float *z1, const float *z2, size_t n, float *min_z, float *max_z)
+{
+    using namespace SlicingSIMD;
+    size_t i = 0;
+    for (; i + Floats::size <= n; i += Floats::size) {
+        const Floats a = Floats::load(z0 + i);
+        const Floats b = Floats::load(z1 + i);
+        const Floats c = Floats::load(z2 + i);
+        min(a, min(b, c)).store(min_z + i);
+        max(a, max(b, c)).store(max_z + i);
+    }
+    for (; i < n; ++ i) {
+        min_z[i] = fminf(z0[i], fminf(z1[i], z2[i]));
+        max_z[i] = fmaxf(z0[i], fmaxf(z1[i], z2[i]));
+    }
+}
+
+// Classification of the vertices of a triangle against up to 32 slicing planes, bit i for plane i.
+struct PlaneClassification
+{
+    // A vertex lies on the plane.
+    uint32_t on_vertex { 0 };
+    // Edge k (from vertex k to vertex k + 1) crosses the plane, its vertices lie strictly on opposite sides of the plane.
+    uint32_t crossing[3] { 0, 0, 0 };
+};
+
+static inline PlaneClassification classify_planes(const stl_vertex *vertices, const float *zs, size_t n)
+{
+    using namespace SlicingSIMD;
+    assert(n <= 32);
+    PlaneClassification out;
+    const Floats z[3] = { Floats::set1(vertices[0].z()), Floats::set1(vertices[1].z()), Floats::set1(vertices[2].z()) };
+    size_t i = 0;
+    for (; i + Floats::size <= n; i += Floats::size) {
+        const Floats plane = Floats::load(zs + i);
+        uint32_t below[3], above[3];
+        for (int k = 0; k < 3; ++ k) {
+            below[k] = lt_mask(z[k], plane);
+            above[k] = lt_mask(plane, z[k]);
+        }
+        out.on_vertex |= (eq_mask(z[0], plane) | eq_mask(z[1], plane) | eq_mask(z[2], plane)) << i;
+        for (int k = 0; k < 3; ++ k) {
+            const int l = (k + 1) % 3;
+            out.crossing[k] |= ((below[k] & above[l]) | (below[l] & above[k])) << i;
+        }
+    }
+    for (; i < n; ++ i) {
+        const float plane = zs[i];
+        if (vertices[0].z() == plane || vertices[1].z() == plane || vertices[2].z() == plane)
+            out.on_vertex |= 1u << i;
+        for (int k = 0; k < 3; ++ k) {
+            const float za = vertices[k].z();
+            const float zb = vertices[(k + 1) % 3].z();
+            if ((za < plane && zb > plane) || (zb < plane && za > plane))
+                out.crossing[k] |= 1u << i;
+        }
+    }
+    return out;
+}
+
+// Fast path of slice_facet() for a plane, which does not touch any vertex of the facet, thus it crosses exactly two edges.
+// Produces the same line as slice_facet(). Returns false if an intersection snapped to a vertex due to rounding,
+// such a rare case is left to slice_facet().
+static inline bool slice_facet_general(
+    float                                slice_z,
+    const stl_vertex                    *vertices,
+    const stl_triangle_vertex_indices   &indices,
+    const Vec3i32                       &edge_ids,
+    const int                            idx_vertex_lowest,
+    // Bit k set if edge k crosses the plane.
+    const uint32_t                       crossing,
+    IntersectionLine                    &line_out)
+{
+    IntersectionPoint points[2];
+    size_t            num_points = 0;
+    for (int j = 0; j < 3; ++ j) {
+        const int k = (idx_vertex_lowest + j) % 3;
+        if ((crossing & (1u << k)) == 0)
+            continue;
+        const int         l    = (k + 1) % 3;
+        const stl_vertex *a    = vertices + k;
+        const stl_vertex *b    = vertices + l;
+        // Sort the edge to give a consistent answer.
+        if (indices[k] > indices[l])
+            std::swap(a, b);
+        const double t = edge_plane_parameter(*a, *b, slice_z);
+        if (t <= 0. || t >= 1. || num_points == 2)
+            return false;
+        IntersectionPoint &point = points[num_points ++];
+        edge_plane_point(*a, *b, t, point);
+        point.edge_id = edge_ids(k);
+    }
+    if (num_points != 2)
+        return false;
+    line_out.edge_type  = IntersectionLine::FacetEdgeType::General;
+    line_out.a          = static_cast<const Point&>(points[1]);
+    line_out.b          = static_cast<const Point&>(points[0]);
+    line_out.a_id       = -1;
+    line_out.b_id       = -1;
+    line_out.edge_a_id  = points[1].edge_id;
+    line_out.edge_b_id  = points[0].edge_id;
+    return true;
+}
+
+// Number of faces sliced at once by slice_facets_at_zs().
+static constexpr const size_t slice_block_faces = 8192;
+
+// Lines of a block of faces at the slicing planes [layer_min, layer_max) touched by the block, sorted by the slicing planes:
+// lines of plane i are stored at [layer_begin[i - layer_min], layer_begin[i - layer_min + 1]).
+// The arrays indexed by the planes span only the planes of the block, thus their size does not grow with the number of blocks.
+struct SliceBlockLines
+{
+    IntersectionLines       lines;
+    uint32_t                layer_min { 0 };
+    uint32_t                layer_max { 0 };
+    std::vector<uint32_t>   layer_begin;
+    // Where to copy the lines of each plane into the lines of all blocks.
+    std::vector<size_t>     layer_dest;
+};
+
+// Slice the faces [face_begin, face_end) at all zs. The Z extents of the whole block of triangles are calculated with SIMD first,
+// then each triangle is classified against all the planes it spans, up to 32 planes at once. Only the planes touching a vertex
+// are sliced by the generic slice_facet().
 template<typename TransformVertex>
-void slice_facet_at_zs(
+void slice_facets_at_zs(
     // Scaled or unscaled vertices. transform_vertex_fn may scale zs.
     const std::vector<Vec3f>                         &mesh_vertices,
     const TransformVertex                            &transform_vertex_fn,
-    const stl_triangle_vertex_indices                &indices,
-    const Vec3i32                                      &edge_ids,
+    const std::vector<stl_triangle_vertex_indices>   &mesh_indices,
+    const std::vector<Vec3i32>                       &face_edge_ids,
     // Scaled or unscaled zs. If vertices have their zs scaled or transform_vertex_fn scales them, then zs have to be scaled as well.
     const std::vector<float>                         &zs,
-    std::vector<IntersectionLines>                   &lines,
-    std::array<std::mutex, 64>                       &lines_mutex)
+    const size_t                                      face_begin,
+    const size_t                                      face_end,
+    // Temporaries of the block are allocated here.
+    MonotonicArena                                   &arena,
+    SliceBlockLines                                  &out)
 {
-    stl_vertex vertices[3] { transform_vertex_fn(mesh_vertices[indices(0)]), transform_vertex_fn(mesh_vertices[indices(1)]), transform_vertex_fn(mesh_vertices[indices(2)]) };
-
-    // find facet extents
-    const float min_z = fminf(vertices[0].z(), fminf(vertices[1].z(), vertices[2].z()));
-    const float max_z = fmaxf(vertices[0].z(), fmaxf(vertices[1].z(), vertices[2].z()));
-
-    // find layer extents
-    auto min_layer = std::lower_bound(zs.begin(), zs.end(), min_z); // first layer whose slice_z is >= min_z
-    auto max_layer = std::upper_bound(min_layer, zs.end(), max_z); // first layer whose slice_z is > max_z
-    int  idx_vertex_lowest = (vertices[1].z() == min_z) ? 1 : ((vertices[2].z() == min_z) ? 2 : 0);
+    const size_t             num_faces = face_end - face_begin;
+    ArenaVector<stl_vertex>  vertices(num_faces * 3, ArenaAllocator<stl_vertex>(arena));
+    // Z of the 1st, 2nd and 3rd vertices, min and max Z of the faces.
+    ArenaVector<float>       z(num_faces * 5, ArenaAllocator<float>(arena));
+    float                  *z0 = z.data(), *z1 = z0 + num_faces, *z2 = z1 + num_faces, *min_z = z2 + num_faces, *max_z = min_z + num_faces;
+    for (size_t i = 0; i < num_faces; ++ i) {
+        const stl_triangle_vertex_indices &indices = mesh_indices[face_begin + i];
+        stl_vertex                        *v       = vertices.data() + i * 3;
+        for (int k = 0; k < 3; ++ k)
+            v[k] = transform_vertex_fn(mesh_vertices[indices(k)]);
+        z0[i] = v[0].z();
+        z1[i] = v[1].z();
+        z2[i] = v[2].z();
+    }
+    triangle_z_extents(z0, z1, z2, num_faces, min_z, max_z);
 
-    for (auto it = min_layer; it != max_layer; ++ it) {
-        IntersectionLine il;
+    ArenaVector<IntersectionLine> lines { ArenaAllocator<IntersectionLine>(arena) };
+    ArenaVector<uint32_t>         line_layers { ArenaAllocator<uint32_t>(arena) };
+    uint32_t                      layer_min = std::numeric_limits<uint32_t>::max();
+    uint32_t                      layer_max = 0;
+    for (size_t i = 0; i < num_faces; ++ i) {
         // Ignore horizontal triangles. Any valid horizontal triangle must have a vertical triangle connected, otherwise the part has zero volume.
-        if (min_z != max_z && slice_facet(*it, vertices, indices, edge_ids, idx_vertex_lowest, false, il) == FacetSliceType::Slicing) {
-            assert(il.edge_type != IntersectionLine::FacetEdgeType::Horizontal);
-            size_t slice_id = it - zs.begin();
-            boost::lock_guard<std::mutex> l(lines_mutex[slice_id % lines_mutex.size()]);
-            lines[slice_id].emplace_back(il);
+        if (min_z[i] == max_z[i])
+            continue;
+        // find layer extents
+        auto min_layer = std::lower_bound(zs.begin(), zs.end(), min_z[i]); // first layer whose slice_z is >= min_z
+        auto max_layer = std::upper_bound(min_layer, zs.end(), max_z[i]); // first layer whose slice_z is > max_z
+        if (min_layer == max_layer)
+            continue;
+        layer_min = std::min(layer_min, uint32_t(min_layer - zs.begin()));
+        layer_max = std::max(layer_max, uint32_t(max_layer - zs.begin()));
+        const stl_vertex                  *v                 = vertices.data() + i * 3;
+        const stl_triangle_vertex_indices &indices           = mesh_indices[face_begin + i];
+        const Vec3i32                     &edge_ids          = face_edge_ids[face_begin + i];
+        const int                          idx_vertex_lowest = (v[1].z() == min_z[i]) ? 1 : ((v[2].z() == min_z[i]) ? 2 : 0);
+        for (auto it = min_layer; it != max_layer;) {
+            const size_t              n     = std::min<size_t>(32, max_layer - it);
+            const PlaneClassification planes = classify_planes(v, &*it, n);
+            for (size_t j = 0; j < n; ++ j, ++ it) {
+                IntersectionLine il;
+                const uint32_t   crossing = ((planes.crossing[0] >> j) & 1) | (((planes.crossing[1] >> j) & 1) << 1) | (((planes.crossing[2] >> j) & 1) << 2);
+                if ((((planes.on_vertex >> j) & 1) == 0 && slice_facet_general(*it, v, indices, edge_ids, idx_vertex_lowest, crossing, il)) ||
+                    slice_facet(*it, v, indices, edge_ids, idx_vertex_lowest, false, il) == FacetSliceType::Slicing) {
+                    assert(il.edge_type != IntersectionLine::FacetEdgeType::Horizontal);
+                    lines.emplace_back(il);
+                    line_layers.emplace_back(uint32_t(it - zs.begin()));
+                }
+            }
         }
     }
+
+    if (lines.empty())
+        return;
+
+    // Counting sort of the lines by their slicing planes.
+    out.layer_min = layer_min;
+    out.layer_max = layer_max;
+    out.layer_begin.assign(layer_max - layer_min + 1, 0);
+    for (uint32_t layer : line_layers)
+        ++ out.layer_begin[layer - layer_min + 1];
+    for (size_t i = 1; i < out.layer_begin.size(); ++ i)
+        out.layer_begin[i] += out.layer_begin[i - 1];
+    out.lines.resize(lines.size());
+    ArenaVector<uint32_t> next(out.layer_begin.begin(), out.layer_begin.end() - 1, ArenaAllocator<uint32_t>(arena));
+    for (size_t i = 0; i < lines.size(); ++ i)
+        out.lines[next[line_layers[i] - layer_min] ++] = lines[i];
 }
 
 template<typename TransformVertex, typename ThrowOnCancel>
@@ -516,15 +773,48 @@ static inline std::vector<IntersectionLines> slice_make_lines(
     const std::vector<float>                        &zs,
     const ThrowOnCancel                              throw_on_cancel_fn)
 {
-    std::vector<IntersectionLines>  lines(zs.size(), IntersectionLines());
-    std::array<std::mutex, 64>      lines_mutex;
+    // Each block of faces collects its lines into its own arena, thus the threads do not need to synchronize.
+    std::vector<SliceBlockLines> blocks((indices.size() + slice_block_faces - 1) / slice_block_faces);
+    // The temporaries of the blocks processed by a thread reuse the memory of the thread's arena.
+    tbb::enumerable_thread_specific<MonotonicArena> arenas;
     tbb::parallel_for(
-        tbb::blocked_range<int>(0, int(indices.size())),
-        [&vertices, &transform_vertex_fn, &indices, &face_edge_ids, &zs, &lines, &lines_mutex, throw_on_cancel_fn](const tbb::blocked_range<int> &range) {
-            for (int face_idx = range.begin(); face_idx < range.end(); ++ face_idx) {
-                if ((face_idx & 0x0ffff) == 0)
-                    throw_on_cancel_fn();
-                slice_facet_at_zs(vertices, transform_vertex_fn, indices[face_idx], face_edge_ids[face_idx], zs, lines, lines_mutex);
+        tbb::blocked_range<size_t>(0, blocks.size(), 1),
+        [&vertices, &transform_vertex_fn, &indices, &face_edge_ids, &zs, &blocks, &arenas, throw_on_cancel_fn](const tbb::blocked_range<size_t> &range) {
+            MonotonicArena &arena = arenas.local();
+            for (size_t block_idx = range.begin(); block_idx < range.end(); ++ block_idx) {
+                throw_on_cancel_fn();
+                const size_t face_begin = block_idx * slice_block_faces;
+                slice_facets_at_zs(vertices, transform_vertex_fn, indices, face_edge_ids, zs, face_begin, std::min(face_begin + slice_block_faces, indices.size()), arena, blocks[block_idx]);
+                arena.reset();
+            }
+        }
+    );
+
+    // Concatenate the lines of the blocks in the order of the blocks, thus the result does not depend on scheduling of the threads.
+    // Only the planes touched by each block are visited.
+    std::vector<size_t> num_lines(zs.size(), 0);
+    for (SliceBlockLines &block : blocks) {
+        block.layer_dest.assign(block.layer_max - block.layer_min, 0);
+        for (uint32_t layer = block.layer_min; layer < block.layer_max; ++ layer) {
+            const uint32_t i = layer - block.layer_min;
+            block.layer_dest[i] = num_lines[layer];
+            num_lines[layer] += block.layer_begin[i + 1] - block.layer_begin[i];
+        }
+    }
+    std::vector<IntersectionLines> lines(zs.size(), IntersectionLines());
+    for (size_t layer = 0; layer < zs.size(); ++ layer)
+        lines[layer].resize(num_lines[layer]);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, blocks.size(), 1),
+        [&blocks, &lines](const tbb::blocked_range<size_t> &range) {
+            for (size_t block_idx = range.begin(); block_idx < range.end(); ++ block_idx) {
+                SliceBlockLines &block = blocks[block_idx];
+                for (uint32_t layer = block.layer_min; layer < block.layer_max; ++ layer) {
+                    const uint32_t i = layer - block.layer_min;
+                    std::copy(block.lines.begin() + block.layer_begin[i], block.lines.begin() + block.layer_begin[i + 1], lines[layer].begin() + block.layer_dest[i]);
+                }
+                // Release the memory of the block early.
+                block = SliceBlockLines();
             }
         }
     );
@@ -1057,11 +1347,11 @@ struct OpenPolyline {
 
 // called by make_loops() to connect sliced triangles into closed loops and open polylines by the triangle connectivity.
 // Only connects segments crossing triangles of the same orientation.
-static void chain_lines_by_triangle_connectivity(IntersectionLines &lines, Polygons &loops, std::vector<OpenPolyline> &open_polylines)
+static void chain_lines_by_triangle_connectivity(IntersectionLines &lines, Polygons &loops, std::vector<OpenPolyline> &open_polylines, MonotonicArena &arena)
 {
     // Build a map of lines by edge_a_id and a_id.
-    std::vector<IntersectionLine*> by_edge_a_id;
-    std::vector<IntersectionLine*> by_a_id;
+    ArenaVector<IntersectionLine*> by_edge_a_id { ArenaAllocator<IntersectionLine*>(arena) };
+    ArenaVector<IntersectionLine*> by_a_id { ArenaAllocator<IntersectionLine*>(arena) };
     by_edge_a_id.reserve(lines.size());
     by_a_id.reserve(lines.size());
     for (IntersectionLine &line : lines) {
@@ -1078,6 +1368,8 @@ static void chain_lines_by_triangle_connectivity(IntersectionLines &lines, Polyg
     std::sort(by_a_id.begin(), by_a_id.end(), by_vertex_lower);
     // Chain the segments with a greedy algorithm, collect the loops and unclosed polylines.
     IntersectionLines::iterator it_line_seed = lines.begin();
+    // The points of a loop are collected here first, then copied into a Polygon of the exact size.
+    ArenaVector<Point> loop_pts { ArenaAllocator<Point>(arena) };
     for (;;) {
         // take first spare line and start a new loop
         IntersectionLine *first_line = nullptr;
@@ -1090,7 +1382,7 @@ static void chain_lines_by_triangle_connectivity(IntersectionLines &lines, Polyg
         if (first_line == nullptr)
             break;
         first_line->set_skip();
-        Points loop_pts;
+        loop_pts.clear();
         loop_pts.emplace_back(first_line->a);
         IntersectionLine *last_line = first_line;
         
@@ -1134,7 +1426,7 @@ static void chain_lines_by_triangle_connectivity(IntersectionLines &lines, Polyg
                     (first_line->a_id      != -1 && first_line->a_id      == last_line->b_id)) {
                     // The current loop is complete. Add it to the output.
                     assert(first_line->a == last_line->b);
-                    loops.emplace_back(std::move(loop_pts));
+                    loops.emplace_back(Points(loop_pts.begin(), loop_pts.end()));
                     #ifdef SLIC3R_TRIANGLEMESH_DEBUG
                     printf("  Discovered %s polygon of %d points\n", (p.is_counter_clockwise() ? "ccw" : "cw"), (int)p.points.size());
                     #endif
@@ -1143,7 +1435,7 @@ static void chain_lines_by_triangle_connectivity(IntersectionLines &lines, Polyg
                     loop_pts.emplace_back(last_line->b);
                     open_polylines.emplace_back(OpenPolyline(
                         IntersectionReference(first_line->a_id, first_line->edge_a_id), 
-                        IntersectionReference(last_line->b_id, last_line->edge_b_id), std::move(loop_pts)));
+                        IntersectionReference(last_line->b_id, last_line->edge_b_id), Points(loop_pts.begin(), loop_pts.end())));
                 }
                 break;
             }
@@ -1382,7 +1674,9 @@ static void chain_open_polylines_close_gaps(std::vector<OpenPolyline> &open_poly
 
 static Polygons make_loops(
     // Lines will have their flags modified.
-    IntersectionLines   &lines)
+    IntersectionLines   &lines,
+    // Temporaries are allocated here.
+    MonotonicArena      &arena)
 {
     Polygons loops;
 #if 0
@@ -1412,7 +1706,7 @@ static Polygons make_loops(
 #endif /* SLIC3R_DEBUG_SLICE_PROCESSING */
 
     std::vector<OpenPolyline> open_polylines;
-    chain_lines_by_triangle_connectivity(lines, loops, open_polylines);
+    chain_lines_by_triangle_connectivity(lines, loops, open_polylines, arena);
 
 #ifdef SLIC3R_DEBUG_SLICE_PROCESSING
         {
@@ -1489,15 +1783,19 @@ static std::vector<Polygons> make_loops(
 {
     std::vector<Polygons> layers;
     layers.resize(lines.size());
+    // The temporaries of the layers chained by a thread reuse the memory of the thread's arena, all of it is released at once at the end.
+    tbb::enumerable_thread_specific<MonotonicArena> arenas;
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, lines.size()),
-        [&lines, &layers, &params, throw_on_cancel](const tbb::blocked_range<size_t> &range) {
+        [&lines, &layers, &params, &arenas, throw_on_cancel](const tbb::blocked_range<size_t> &range) {
+            MonotonicArena &arena = arenas.local();
             for (size_t line_idx = range.begin(); line_idx < range.end(); ++ line_idx) {
                 if ((line_idx & 0x0ffff) == 0)
                     throw_on_cancel();
 
                 Polygons &polygons = layers[line_idx];
-                polygons = make_loops(lines[line_idx]);
+                polygons = make_loops(lines[line_idx], arena);
+                arena.reset();
 
                 auto this_mode = line_idx < params.slicing_mode_normal_below_layer ? params.mode_below : params.mode;
                 if (! polygons.empty()) {
@@ -1549,12 +1847,15 @@ static std::vector<Polygons> make_slab_loops(
     assert(! lines.at_slice.empty() && lines.at_slice.size() == lines.between_slices.size());
     std::vector<Polygons> layers;
     layers.resize(lines.at_slice.size());
+    tbb::enumerable_thread_specific<MonotonicArena> arenas;
     tbb::parallel_for(
         tbb::blocked_range<int>(0, int(lines.at_slice.size())),
-        [&lines, num_edges, &layers, throw_on_cancel](const tbb::blocked_range<int> &range) {
+        [&lines, num_edges, &layers, &arenas, throw_on_cancel](const tbb::blocked_range<int> &range) {
+            MonotonicArena &arena = arenas.local();
             for (int line_idx = range.begin(); line_idx < range.end(); ++ line_idx) {
                 if ((line_idx & 0x0ffff) == 0)
                     throw_on_cancel();
+                arena.reset();
                 IntersectionLines in;
                 size_t nlines          = lines.between_slices[line_idx].size();
                 int    slice_below     = ProjectionFromTop ? line_idx : line_idx - 1;
@@ -1626,7 +1927,7 @@ static std::vector<Polygons> make_slab_loops(
 #endif /* SLIC3R_DEBUG_SLICE_PROCESSING */
                         Polygons &loops = layers[line_idx];
                         std::vector<OpenPolyline> open_polylines;
-                        chain_lines_by_triangle_connectivity(in, loops, open_polylines);
+                        chain_lines_by_triangle_connectivity(in, loops, open_polylines, arena);
 #ifdef SLIC3R_DEBUG_SLICE_PROCESSING
                         {
                             SVG svg(debug_out_path("make_slab_loops-out-%d-%d-%s.svg", iRun, line_idx, ProjectionFromTop ? "top" : "bottom").c_str(), bbox_svg);
@@ -1666,7 +1967,8 @@ static ExPolygons make_expolygons_simple(std::vector<IntersectionLine> &lines)
     ExPolygons slices;
     Polygons holes;
 
-    for (Polygon &loop : make_loops(lines))
+    MonotonicArena arena;
+    for (Polygon &loop : make_loops(lines, arena))
         if (loop.area() >= 0.)
             slices.emplace_back(std::move(loop));
         else
@@ -214,6 +214,13 @@ extern CopyFileResult copy_file(const std::string &from, const std::string &to,
 // Compares two files if identical.
 extern CopyFileResult check_copy(const std::string& origin, const std::string& copy);
 
+// Mark a file of a cache directory as recently used, so that trim_cache_dir() evicts it last.
+extern void touch_cache_file(const std::string &path);
+// Remove the least recently modified or touched files of a cache directory and of its subdirectories,
+// until their total size is at most max_size bytes. Temporary files (*.tmp) are left to the processes writing them,
+// unless they are older than a day and thus left behind by a crashed process. Returns the number of files removed.
+extern size_t trim_cache_dir(const std::string &dir, size_t max_size);
+
 // Ignore system and hidden files, which may be created by the DropBox synchronisation process.
 // https://github.com/prusa3d/PrusaSlicer/issues/1298
 extern bool is_plain_file(const boost::filesystem::directory_entry &path);
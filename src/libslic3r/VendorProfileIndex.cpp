@@ -0,0 +1,206 @@
+#include "VendorProfileIndex.hpp"
+
+#include "libslic3r.h"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+
+#include <boost/algorithm/hex.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <boost/uuid/detail/md5.hpp>
+
+namespace Slic3r {
+
+namespace fs = boost::filesystem;
+using nlohmann::json;
+
+// Increase when the layout of the stored index changes.
+static constexpr const int VENDOR_PROFILE_INDEX_VERSION = 2;
+
+VendorProfileIndex::VendorProfileIndex(std::string profiles_dir, std::string vendor_name, std::string cache_dir) :
+    m_profiles_dir(std::move(profiles_dir)), m_vendor_name(std::move(vendor_name)), m_cache_dir(std::move(cache_dir))
+{}
+
+static std::string md5_hex(const void *data, size_t size)
+{
+    using boost::uuids::detail::md5;
+    md5 md5_hash;
+    md5_hash.process_bytes(data, size);
+    md5::digest_type md5_digest{};
+    std::string      md5_digest_str;
+    md5_hash.get_digest(md5_digest);
+    boost::algorithm::hex(md5_digest, md5_digest + std::size(md5_digest), std::back_inserter(md5_digest_str));
+    return md5_digest_str;
+}
+
+// Hash of the content of the vendor root file, empty if it cannot be read.
+static std::string root_file_hash(const std::string &profiles_dir, const std::string &vendor_name)
+{
+    boost::nowide::ifstream ifs((fs::path(profiles_dir) / (vendor_name + ".json")).string(), std::ios::binary);
+    if (! ifs)
+        return std::string();
+    const std::string data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    return md5_hex(data.data(), data.size());
+}
+
+// Modification time of a directory with the resolution of the file system, so that a file added right after the index was stored is detected.
+static int64_t directory_mtime(const std::string &path)
+{
+    std::error_code ec;
+    const auto time = std::filesystem::last_write_time(std::filesystem::u8path(path), ec);
+    return ec ? 0 : int64_t(time.time_since_epoch().count());
+}
+
+json VendorProfileIndex::manifest(const std::string &profiles_dir, const std::string &vendor_name)
+{
+    json out;
+    out["root"] = root_file_hash(profiles_dir, vendor_name);
+    // Adding, removing or replacing a profile modifies its directory. Only the directories are visited, the files are not accessed.
+    json &dirs = out["dirs"] = json::object();
+    const fs::path vendor_dir = fs::path(profiles_dir) / vendor_name;
+    boost::system::error_code ec;
+    if (fs::is_directory(vendor_dir, ec)) {
+        dirs["."] = directory_mtime(vendor_dir.string());
+        std::error_code sec;
+        for (std::filesystem::recursive_directory_iterator it(std::filesystem::u8path(vendor_dir.string()), sec), end; ! sec && it != end; it.increment(sec))
+            if (it->is_directory(sec))
+                dirs[fs::path(it->path().u8string()).lexically_relative(vendor_dir).generic_string()] = directory_mtime(it->path().u8string());
+    }
+    return out;
+}
+
+bool VendorProfileIndex::manifest_valid(const std::string &profiles_dir, const std::string &vendor_name, const json &manifest)
+{
+    if (! manifest.is_object() || manifest.value("root", std::string()) != root_file_hash(profiles_dir, vendor_name))
+        return false;
+    auto dirs = manifest.find("dirs");
+    if (dirs == manifest.end() || ! dirs->is_object())
+        return false;
+    const fs::path vendor_dir = fs::path(profiles_dir) / vendor_name;
+    for (auto it = dirs->begin(); it != dirs->end(); ++ it)
+        if (! it.value().is_number_integer() || directory_mtime((vendor_dir / it.key()).string()) != it.value().get<int64_t>())
+            return false;
+    return true;
+}
+
+static fs::path index_path(const std::string &cache_dir, const std::string &vendor_name)
+{
+    return fs::path(cache_dir) / (vendor_name + ".msgpack");
+}
+
+bool VendorProfileIndex::load(const std::string &base_digest)
+{
+    m_loaded = false;
+    this->clear();
+    m_base_digest = base_digest;
+    m_manifest    = json();
+
+    const fs::path path = index_path(m_cache_dir, m_vendor_name);
+    boost::system::error_code ec;
+    if (fs::is_regular_file(path, ec)) {
+        try {
+            std::vector<uint8_t> data;
+            {
+                boost::nowide::ifstream ifs(path.string(), std::ios::binary);
+                data.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+            }
+            json j = json::from_msgpack(data);
+            if (j.value("version", 0) != VENDOR_PROFILE_INDEX_VERSION || j.value("app_version", std::string()) != SLIC3R_VERSION ||
+                j.value("base", std::string()) != m_base_digest || ! manifest_valid(m_profiles_dir, m_vendor_name, j["manifest"])) {
+                BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": profile index of vendor %1% is out of date") % m_vendor_name;
+            } else {
+                for (auto &[relative_path, document] : j["documents"].items())
+                    m_documents.emplace(relative_path, std::move(document));
+                if (auto it = j.find("discovered"); it != j.end() && it->is_array()) {
+                    for (const json &item : *it)
+                        m_discovered.emplace_back(item.at(0).get<std::string>(), item.at(1).get<std::string>());
+                    m_has_discovered = true;
+                }
+                if (auto it = j.find("resolved"); it != j.end() && it->is_object())
+                    m_resolved = std::move(*it);
+                m_manifest = std::move(j["manifest"]);
+                m_loaded   = true;
+            }
+        } catch (const std::exception &err) {
+            BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << boost::format(": failed loading profile index %1%, reason = %2%") % path.string() % err.what();
+            this->clear();
+        }
+    }
+    if (! m_loaded)
+        // Taken before the files are parsed, thus a file modified while being parsed invalidates the index stored by save().
+        m_manifest = manifest(m_profiles_dir, m_vendor_name);
+    const std::string manifest_str = m_manifest.dump();
+    m_manifest_digest = md5_hex(manifest_str.data(), manifest_str.size());
+    return m_loaded;
+}
+
+bool VendorProfileIndex::save() const
+{
+    if (m_loaded || m_manifest.is_null())
+        return false;
+
+    boost::system::error_code ec;
+    if (! fs::is_directory(m_cache_dir, ec) && ! fs::create_directories(m_cache_dir, ec)) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << boost::format(": can not create directory %1%, reason = %2%") % m_cache_dir % ec.message();
+        return false;
+    }
+
+    const fs::path path     = index_path(m_cache_dir, m_vendor_name);
+    const fs::path tmp_path = path.string() + ".tmp";
+    try {
+        json j;
+        j["version"]     = VENDOR_PROFILE_INDEX_VERSION;
+        j["app_version"] = SLIC3R_VERSION;
+        j["base"]        = m_base_digest;
+        j["manifest"]    = m_manifest;
+        json &documents = j["documents"] = json::object();
+        for (const auto &[relative_path, document] : m_documents)
+            documents[relative_path] = document;
+        if (m_has_discovered) {
+            json &discovered = j["discovered"] = json::array();
+            for (const auto &[name, subpath] : m_discovered)
+                discovered.push_back({ name, subpath });
+        }
+        if (! m_resolved.is_null())
+            j["resolved"] = m_resolved;
+        const std::vector<uint8_t> data = json::to_msgpack(j);
+        {
+            boost::nowide::ofstream ofs(tmp_path.string(), std::ios::binary | std::ios::trunc);
+            ofs.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+            if (! ofs.good())
+                throw Slic3r::FileIOError("write failed");
+        }
+    } catch (const std::exception &err) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << boost::format(": failed saving profile index %1%, reason = %2%") % path.string() % err.what();
+        fs::remove(tmp_path, ec);
+        return false;
+    }
+    // Replace the index atomically, another instance may be reading it.
+    fs::rename(tmp_path, path, ec);
+    if (ec) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << boost::format(": failed saving profile index %1%, reason = %2%") % path.string() % ec.message();
+        fs::remove(tmp_path, ec);
+        return false;
+    }
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": saved profile index of vendor %1% with %2% documents, resolved presets: %3%") % m_vendor_name % m_documents.size() % (m_resolved.is_null() ? "no" : "yes");
+    return true;
+}
+
+const json& VendorProfileIndex::document(const std::string &relative_path)
+{
+    if (auto it = m_documents.find(relative_path); it != m_documents.end())
+        return it->second;
+    // Not indexed yet, parse the text file the same way PresetBundle and ConfigBase did.
+    json j;
+    boost::nowide::ifstream ifs((fs::path(m_profiles_dir) / relative_path).string());
+    ifs >> j;
+    return m_documents.emplace(relative_path, std::move(j)).first->second;
+}
+
+} // namespace Slic3r
@@ -0,0 +1,81 @@
+#ifndef slic3r_VendorProfileIndex_hpp_
+#define slic3r_VendorProfileIndex_hpp_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace Slic3r {
+
+// Binary index of the system profiles of a single vendor, stored in the cache directory as MessagePack.
+// It holds the presets of the vendor with their inheritance already resolved, see PresetBundle::load_vendor_configs_from_json(),
+// the parsed json documents of the vendor root file and of the printer models, and the list of profiles discovered on disk
+// for vendors with an empty manifest (OrcaFilamentLibrary). If the presets could not be resolved losslessly, the documents
+// of all the sub-profiles are stored instead.
+//
+// The index is validated by a per-vendor manifest: the application version, the content hash of <vendor_name>.json
+// and the modification times of the directories of the vendor. Thus validating the index does not touch the several
+// hundred files of a vendor. The system profiles are installed and updated as a whole together with <vendor_name>.json,
+// a sub-profile edited in place without touching the vendor file is not detected.
+class VendorProfileIndex
+{
+public:
+    using Subfiles = std::vector<std::pair<std::string, std::string>>;
+
+    VendorProfileIndex() = default;
+    // profiles_dir contains <vendor_name>.json and the <vendor_name> directory, the index is stored into cache_dir.
+    VendorProfileIndex(std::string profiles_dir, std::string vendor_name, std::string cache_dir);
+
+    // Load the index if it is valid. Otherwise the index stays empty and it records the documents parsed
+    // by document() to be saved by save(). Safe to be called for multiple indices in parallel.
+    // base_digest is the manifest digest of the vendor the presets of this vendor may inherit from (OrcaFilamentLibrary),
+    // the resolved presets depend on it.
+    bool                    load(const std::string &base_digest = std::string());
+    // Save the recorded documents and resolved presets if the index was not loaded.
+    bool                    save() const;
+    bool                    loaded() const { return m_loaded; }
+    // Release the documents once the presets of the vendor were loaded.
+    void                    clear() { m_documents.clear(); m_discovered.clear(); m_has_discovered = false; m_resolved = nlohmann::json(); }
+    const std::string&      vendor_name() const { return m_vendor_name; }
+    // Digest of the manifest of the vendor files, valid after load().
+    const std::string&      manifest_digest() const { return m_manifest_digest; }
+
+    // Parsed json document of a file relative to profiles_dir, taken from the index if it was loaded, otherwise
+    // parsed from the file and recorded. Throws nlohmann::detail::parse_error if the file could not be parsed.
+    const nlohmann::json&   document(const std::string &relative_path);
+    // Don't store a document, which is not needed once the presets were resolved.
+    void                    erase_document(const std::string &relative_path) { m_documents.erase(relative_path); }
+
+    // Profiles discovered on disk by PresetBundle for a vendor with an empty manifest.
+    const Subfiles*         discovered_subfiles() const { return m_has_discovered ? &m_discovered : nullptr; }
+    void                    set_discovered_subfiles(const Subfiles &subfiles) { m_discovered = subfiles; m_has_discovered = true; }
+
+    // Presets of the vendor with their inheritance resolved, produced and consumed by PresetBundle.
+    const nlohmann::json*   resolved_presets() const { return m_resolved.is_null() ? nullptr : &m_resolved; }
+    void                    set_resolved_presets(nlohmann::json &&resolved) { m_resolved = std::move(resolved); }
+
+    // Manifest of the files of the vendor: hash of the vendor root file and the modification times of the vendor directories.
+    static nlohmann::json   manifest(const std::string &profiles_dir, const std::string &vendor_name);
+    // Check the manifest stored with an index against the files, only the directories listed in the manifest are accessed.
+    static bool             manifest_valid(const std::string &profiles_dir, const std::string &vendor_name, const nlohmann::json &manifest);
+
+private:
+    std::string                             m_profiles_dir;
+    std::string                             m_vendor_name;
+    std::string                             m_cache_dir;
+    std::string                             m_base_digest;
+    nlohmann::json                          m_manifest;
+    std::string                             m_manifest_digest;
+    bool                                    m_loaded { false };
+    std::map<std::string, nlohmann::json>   m_documents;
+    bool                                    m_has_discovered { false };
+    Subfiles                                m_discovered;
+    nlohmann::json                          m_resolved;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_VendorProfileIndex_hpp_
@@ -950,6 +950,62 @@ CopyFileResult check_copy(const std::string &origin, const std::string &copy)
     return (f1.eof() && f2.eof() && fsize == 0) ? SUCCESS : FAIL_FILES_DIFFERENT;
 }
 
+void touch_cache_file(const std::string &path)
+{
+    boost::system::error_code ec;
+    boost::filesystem::last_write_time(path, std::time(nullptr), ec);
+}
+
+size_t trim_cache_dir(const std::string &dir, size_t max_size)
+{
+    struct CacheFile
+    {
+        boost::filesystem::path path;
+        std::time_t             time;
+        uintmax_t               size;
+    };
+    const std::time_t                    now         = std::time(nullptr);
+    const std::time_t                    stale_time  = 24 * 60 * 60;
+    std::vector<CacheFile>               files;
+    std::vector<boost::filesystem::path> stale_files;
+    uintmax_t                            total_size  = 0;
+    size_t                               num_removed = 0;
+    boost::system::error_code ec;
+    for (boost::filesystem::recursive_directory_iterator it(dir, ec), end; ! ec && it != end; it.increment(ec)) {
+        boost::system::error_code file_ec;
+        if (! boost::filesystem::is_regular_file(it->status(file_ec)))
+            continue;
+        const std::time_t time = boost::filesystem::last_write_time(it->path(), file_ec);
+        const uintmax_t   size = boost::filesystem::file_size(it->path(), file_ec);
+        if (file_ec)
+            // Removed by another process in the meantime.
+            continue;
+        if (it->path().extension() == ".tmp") {
+            // Removed after the traversal, the iterator fails to advance past a removed entry.
+            if (now - time > stale_time)
+                stale_files.emplace_back(it->path());
+            continue;
+        }
+        files.push_back({ it->path(), time, size });
+        total_size += size;
+    }
+    for (const boost::filesystem::path &path : stale_files)
+        if (boost::filesystem::remove(path, ec))
+            ++ num_removed;
+    if (total_size > max_size) {
+        std::sort(files.begin(), files.end(), [](const CacheFile &l, const CacheFile &r) { return l.time < r.time; });
+        for (auto it = files.begin(); it != files.end() && total_size > max_size; ++ it)
+            // A file opened by another process may not be removable on Windows, it is evicted by a later trim.
+            if (boost::filesystem::remove(it->path, ec)) {
+                total_size -= it->size;
+                ++ num_removed;
+            }
+    }
+    if (num_removed > 0)
+        BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": removed %1% files from %2%, %3% bytes left") % num_removed % dir % total_size;
+    return num_removed;
+}
+
 // Ignore system and hidden files, which may be created by the DropBox synchronisation process.
 bool is_plain_file(const boost::filesystem::directory_entry &dir_entry)
 {
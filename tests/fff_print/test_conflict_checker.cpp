@@ -0,0 +1,112 @@
+#include <catch2/catch.hpp>
+
+#include <chrono>
+
+#include "libslic3r/libslic3r.h"
+#include "libslic3r/Print.hpp"
+#include "libslic3r/GCode/ConflictChecker.hpp"
+
+#include "test_data.hpp"
+
+using namespace Slic3r;
+using namespace Slic3r::Test;
+
+SCENARIO("ConflictChecker: intersection of lines", "[ConflictChecker]") {
+    int obj1 = 0, obj2 = 0;
+    GIVEN("Two crossing lines of different objects") {
+        LineWithIDs lines { { Line(Point::new_scale(0, 0), Point::new_scale(10, 10)), &obj1, erExternalPerimeter },
+                            { Line(Point::new_scale(0, 10), Point::new_scale(10, 0)), &obj2, erExternalPerimeter } };
+        THEN("a conflict between the two objects is found") {
+            ConflictComputeOpt res = ConflictChecker::find_inter_of_lines(lines);
+            REQUIRE(res.has_value());
+            REQUIRE(((res->_obj1 == &obj1 && res->_obj2 == &obj2) || (res->_obj1 == &obj2 && res->_obj2 == &obj1)));
+        }
+    }
+    GIVEN("Two crossing lines of the same object") {
+        LineWithIDs lines { { Line(Point::new_scale(0, 0), Point::new_scale(10, 10)), &obj1, erExternalPerimeter },
+                            { Line(Point::new_scale(0, 10), Point::new_scale(10, 0)), &obj1, erExternalPerimeter } };
+        THEN("no conflict is found") {
+            REQUIRE_FALSE(ConflictChecker::find_inter_of_lines(lines).has_value());
+        }
+    }
+    GIVEN("Two parallel lines of different objects sharing grid cells") {
+        LineWithIDs lines { { Line(Point::new_scale(0, 0.2), Point::new_scale(10, 0.2)), &obj1, erExternalPerimeter },
+                            { Line(Point::new_scale(0, 0.6), Point::new_scale(10, 0.6)), &obj2, erExternalPerimeter } };
+        THEN("no conflict is found") {
+            REQUIRE_FALSE(ConflictChecker::find_inter_of_lines(lines).has_value());
+        }
+    }
+}
+
+SCENARIO("ConflictChecker: objects of a plate", "[ConflictChecker]") {
+    GIVEN("Two overlapping objects") {
+        Print print;
+        Model model;
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({ { "enable_support", 0 } });
+        std::vector<TriangleMesh> meshes { mesh(TestMesh::cube_20x20x20), mesh(TestMesh::cube_20x20x20, Vec3d::Zero(), 0.5) };
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            ModelObject *object = model.add_object();
+            object->name = "object" + std::to_string(i);
+            object->add_volume(meshes[i]);
+            object->add_instance()->set_offset(Vec3d(100. + 10. * double(i), 100., 0.));
+            object->ensure_on_bed();
+        }
+        print.apply(model, config);
+        print.process();
+        THEN("the conflict is found on the first layer") {
+            ConflictResultOpt res = ConflictChecker::find_inter_of_lines_in_diff_objs(print.objects_mutable(), {});
+            REQUIRE(res.has_value());
+            REQUIRE(res->_height < 1.);
+        }
+    }
+    GIVEN("A full plate of arranged objects") {
+        Print print;
+        Model model;
+        std::vector<TriangleMesh> meshes;
+        for (size_t i = 0; i < 30; ++i)
+            meshes.emplace_back(mesh(i % 2 ? TestMesh::cube_20x20x20 : TestMesh::pyramid, Vec3d::Zero(), 0.5));
+        init_print(std::move(meshes), print, model, DynamicPrintConfig::full_print_config());
+        print.process();
+        THEN("no conflict is found") {
+            auto start = std::chrono::steady_clock::now();
+            ConflictResultOpt res = ConflictChecker::find_inter_of_lines_in_diff_objs(print.objects_mutable(), {});
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+            INFO("conflict check of " << print.objects().size() << " objects takes " << ms << " ms");
+            REQUIRE_FALSE(res.has_value());
+        }
+    }
+}
+
+SCENARIO("ConflictChecker: benchmark of a dense full plate", "[ConflictChecker][Benchmark][.]") {
+    // Cubes rotated by 45 degrees on a checkerboard lattice: the diagonal neighbors are 1.2 mm apart,
+    // while their bounding boxes overlap by half of their size. Thus no object is pruned by its bounding box
+    // and the lines of the neighbors share the rasterization grid cells without intersecting.
+    const double pitch = 15.;
+    Print print;
+    Model model;
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    config.set_deserialize_strict({ { "sparse_infill_density", "40%" }, { "brim_type", "no_brim" }, { "skirt_loops", 0 } });
+    for (size_t i = 0; i < 8; ++ i)
+        for (size_t j = i % 2; j < 8; j += 2) {
+            ModelObject *object = model.add_object();
+            object->name = "object" + std::to_string(model.objects.size());
+            object->add_volume(mesh(TestMesh::cube_20x20x20));
+            ModelInstance *instance = object->add_instance();
+            instance->set_rotation(Vec3d(0., 0., 0.25 * PI));
+            instance->set_offset(Vec3d(30. + pitch * double(i), 30. + pitch * double(j), 0.));
+            object->ensure_on_bed();
+        }
+    REQUIRE(model.objects.size() == 32);
+    const BoundingBoxf3 bbox0 = model.objects[0]->instance_bounding_box(0);
+    const BoundingBoxf3 bbox1 = model.objects[4]->instance_bounding_box(0);
+    REQUIRE(BoundingBoxf(to_2d(bbox0.min), to_2d(bbox0.max)).overlap(BoundingBoxf(to_2d(bbox1.min), to_2d(bbox1.max))));
+    print.apply(model, config);
+    print.process();
+
+    auto start = std::chrono::steady_clock::now();
+    ConflictResultOpt res = ConflictChecker::find_inter_of_lines_in_diff_objs(print.objects_mutable(), {});
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    WARN("conflict check of " << print.objects().size() << " objects, " << print.objects().front()->layers().size() << " layers takes " << ms << " ms");
+    REQUIRE_FALSE(res.has_value());
+}
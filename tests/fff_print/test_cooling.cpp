@@ -0,0 +1,213 @@
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <memory>
+#include <sstream>
+
+#include <tbb/global_control.h>
+#include <tbb/version.h>
+#if TBB_VERSION_MAJOR >= 2021
+#include <tbb/parallel_pipeline.h>
+using slic3r_tbb_filtermode = tbb::filter_mode;
+#else
+#include <tbb/pipeline.h>
+using slic3r_tbb_filtermode = tbb::filter;
+#endif
+
+#include "libslic3r/GCode.hpp"
+#include "libslic3r/GCode/CoolingBuffer.hpp"
+
+using namespace Slic3r;
+
+static std::unique_ptr<CoolingBuffer> make_cooling_buffer(GCode &gcodegen, const std::vector<unsigned int> &extruder_ids, bool relative_e = false)
+{
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    config.set_deserialize_strict({
+        { "slow_down_layer_time",   "15" },
+        { "fan_cooling_layer_time", "60" },
+        { "fan_min_speed",          "35" },
+        { "fan_max_speed",          "100" },
+        { "overhang_fan_speed",     "100" },
+        { "use_relative_e_distances", relative_e ? "1" : "0" }
+    });
+    PrintConfig print_config;
+    print_config.apply(config);
+    gcodegen.apply_print_config(print_config);
+    gcodegen.set_layer_count(10);
+    gcodegen.writer().set_extruders(extruder_ids);
+    gcodegen.writer().set_extruder(extruder_ids.front());
+    return std::make_unique<CoolingBuffer>(gcodegen);
+}
+
+// G-code of a layer with the markers of the cooling buffer, extruding a square of the given size and an overhang.
+// The first move of the layer only sets Z, thus its length depends on the position the previous layer ended with.
+// Every third layer resets the extruder axis, the layers end with a retraction only setting the extruder axis and the feed rate.
+static std::string layer_gcode(size_t layer_id, double size, int extruder, size_t repeat = 1)
+{
+    std::ostringstream out;
+    if (extruder >= 0)
+        out << "T" << extruder << "\n";
+    if (layer_id % 3 == 0)
+        out << "G92 E0\n";
+    out << "G1 Z" << 0.2 * double(layer_id + 1) << " F600\n";
+    for (size_t i = 0; i < repeat; ++ i) {
+        const double x = 50. + double(i % 50), y = 50. + double(i % 37);
+        out << "G1 F3000;_EXTRUDE_SET_SPEED\n"
+            << "G1 X" << x + size << " Y" << y << " E1\n"
+            << "G1 X" << x + size << " Y" << y + size << " E1\n"
+            << "G1 X" << x << " Y" << y + size << " E1\n"
+            << "G1 X" << x << " Y" << y << " E1\n"
+            << ";_EXTRUDE_END\n"
+            << ";_OVERHANG_FAN_START\n"
+            << "G1 F1200;_EXTRUDE_SET_SPEED\n"
+            << "G2 X" << x + size << " Y" << y << " I" << size * 0.5 << " J0 E0.5\n"
+            << ";_EXTRUDE_END\n"
+            << ";_OVERHANG_FAN_END\n";
+    }
+    out << "G1 E-0.8 F2400\n";
+    return out.str();
+}
+
+struct TestLayer
+{
+    std::string gcode;
+    size_t      layer_id;
+    bool        flush;
+};
+
+// Supporting layers are collected without flushing, the extruder changes in between the layers.
+static std::vector<TestLayer> test_layers(size_t num_layers, size_t repeat)
+{
+    std::vector<TestLayer> layers;
+    for (size_t i = 0; i < num_layers; ++ i)
+        layers.push_back({ layer_gcode(i, 5. + double(i % 7) * 10., i % 5 == 3 ? int(i / 5 % 2) : -1, repeat), i, i % 4 != 1 });
+    return layers;
+}
+
+static std::string process_serially(GCode &gcodegen, const std::vector<TestLayer> &layers)
+{
+    std::unique_ptr<CoolingBuffer> cooling_buffer = make_cooling_buffer(gcodegen, { 0, 1 });
+    std::string out;
+    for (const TestLayer &layer : layers)
+        out += cooling_buffer->process_layer(std::string(layer.gcode), layer.layer_id, layer.flush);
+    return out;
+}
+
+// Same pipeline as GCode::process_layers() runs.
+static std::string process_pipelined(GCode &gcodegen, const std::vector<TestLayer> &layers)
+{
+    std::unique_ptr<CoolingBuffer> cooling_buffer = make_cooling_buffer(gcodegen, { 0, 1 });
+    std::string out;
+    size_t      idx = 0;
+    struct Decoded
+    {
+        LayerGCode                      gcode;
+        CoolingBuffer::LayerStateUpdate update;
+        size_t                          layer_id;
+        bool                            flush;
+    };
+    tbb::parallel_pipeline(12,
+        tbb::make_filter<void, size_t>(slic3r_tbb_filtermode::serial_in_order, [&layers, &idx](tbb::flow_control &fc) -> size_t {
+            if (idx == layers.size()) {
+                fc.stop();
+                return 0;
+            }
+            return idx ++;
+        }) &
+        tbb::make_filter<size_t, Decoded>(slic3r_tbb_filtermode::parallel, [&layers, &cooling_buffer](size_t i) {
+            const TestLayer &layer = layers[i];
+            Decoded out { LayerGCode(std::string(layer.gcode)), {}, layer.layer_id, layer.flush };
+            out.update = cooling_buffer->layer_state_update(out.gcode);
+            return out;
+        }) &
+        tbb::make_filter<Decoded, CoolingBuffer::CollectedLayer>(slic3r_tbb_filtermode::serial_in_order, [&cooling_buffer](Decoded in) {
+            return cooling_buffer->collect_layer(std::move(in.gcode), in.update, in.layer_id, in.flush);
+        }) &
+        tbb::make_filter<CoolingBuffer::CollectedLayer, CoolingBuffer::CollectedLayer>(slic3r_tbb_filtermode::parallel, [&cooling_buffer](CoolingBuffer::CollectedLayer in) {
+            cooling_buffer->prepare_layer(in);
+            return in;
+        }) &
+        tbb::make_filter<CoolingBuffer::CollectedLayer, void>(slic3r_tbb_filtermode::serial_in_order, [&cooling_buffer, &out](CoolingBuffer::CollectedLayer in) {
+            out += cooling_buffer->apply_layer(std::move(in));
+        }));
+    return out;
+}
+
+SCENARIO("Cooling buffer processed in pipelined stages", "[Cooling]") {
+    GIVEN("Layers printed by two extruders, some of them collected without flushing") {
+        const std::vector<TestLayer> layers = test_layers(40, 1);
+        GCode gcodegen_serial;
+        GCode gcodegen_pipelined;
+        const std::string serial    = process_serially(gcodegen_serial, layers);
+        const std::string pipelined = process_pipelined(gcodegen_pipelined, layers);
+        THEN("The small layers are slowed down and cooled") {
+            REQUIRE(serial.find("M106") != std::string::npos);
+            REQUIRE(serial.find(";_EXTRUDE_SET_SPEED") == std::string::npos);
+            REQUIRE(serial.find("G1 F3000") == std::string::npos);
+        }
+        THEN("The pipelined stages produce the same G-code as processing the layers one by one") {
+            REQUIRE(pipelined == serial);
+        }
+    }
+}
+
+// Collects the layers the same way as the pipeline does and checks, that the position each collected G-code starts with, composed from
+// the LayerStateUpdates of the layers, matches the position tracked by parsing the G-code line by line up to there.
+static void check_tracked_position(const std::vector<TestLayer> &layers, bool relative_e)
+{
+    GCode                          gcodegen;
+    std::unique_ptr<CoolingBuffer> cooling_buffer = make_cooling_buffer(gcodegen, { 0, 1 }, relative_e);
+    std::vector<float>             parsed_pos;
+    size_t                         num_checked = 0;
+    for (const TestLayer &layer : layers) {
+        LayerGCode                            gcode(std::string(layer.gcode));
+        const CoolingBuffer::LayerStateUpdate update    = cooling_buffer->layer_state_update(gcode);
+        CoolingBuffer::CollectedLayer         collected = cooling_buffer->collect_layer(std::move(gcode), update, layer.layer_id, layer.flush);
+        if (! collected.flush)
+            continue;
+        cooling_buffer->prepare_layer(collected);
+        if (! parsed_pos.empty()) {
+            REQUIRE(collected.start_pos == parsed_pos);
+            ++ num_checked;
+        }
+        parsed_pos = collected.end_pos;
+        cooling_buffer->apply_layer(std::move(collected));
+    }
+    REQUIRE(num_checked > 10);
+}
+
+SCENARIO("Cooling buffer composes the position from layer to layer", "[Cooling]") {
+    // The layers contain arcs, G92 resets of the extruder axis and retractions.
+    const std::vector<TestLayer> layers = test_layers(40, 2);
+    GIVEN("Absolute extruder distances") {
+        THEN("The composed position matches the parsed position") {
+            check_tracked_position(layers, false);
+        }
+    }
+    GIVEN("Relative extruder distances") {
+        THEN("The composed position matches the parsed position") {
+            check_tracked_position(layers, true);
+        }
+    }
+}
+
+TEST_CASE("Scaling of the pipelined cooling buffer with the number of threads", "[Cooling][Benchmark][.]") {
+    const std::vector<TestLayer> layers = test_layers(1000, 200);
+    auto time_it = [](auto &&fn) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    std::string serial;
+    GCode       gcodegen_serial;
+    const double serial_secs = time_it([&]() { serial = process_serially(gcodegen_serial, layers); });
+    WARN("Serial: " << serial_secs << " s");
+    for (size_t threads : { 1, 2, 4, 8, 16 }) {
+        tbb::global_control control(tbb::global_control::max_allowed_parallelism, threads);
+        std::string pipelined;
+        GCode       gcodegen;
+        const double secs = time_it([&]() { pipelined = process_pipelined(gcodegen, layers); });
+        WARN(threads << " threads: " << secs << " s, speedup " << serial_secs / secs);
+        REQUIRE(pipelined == serial);
+    }
+}
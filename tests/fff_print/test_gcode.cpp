@@ -2,7 +2,11 @@
 
 #include <memory>
 
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+
 #include "libslic3r/GCode.hpp"
+#include "libslic3r/GCode/GCodeProcessorResultFile.hpp"
 
 using namespace Slic3r;
 
@@ -20,3 +24,230 @@ SCENARIO("Origin manipulation", "[GCode]") {
     	}
     }
 }
+
+SCENARIO("GCodeProcessorResult file round trip", "[GCode]") {
+    namespace fs = boost::filesystem;
+    const fs::path gcode_path  = fs::temp_directory_path() / fs::unique_path("gcode_result_%%%%-%%%%.gcode");
+    const std::string gcode_file  = gcode_path.string();
+    const std::string result_file = gcode_processor_result_path(gcode_file);
+    {
+        boost::nowide::ofstream out(gcode_file);
+        out << "G21\nG90\nM83\nG1 Z0.2 F600\nG1 X10 Y10 F3000\n;TYPE:Outer wall\n;WIDTH:0.45\n;HEIGHT:0.2\n"
+               "G1 X20 Y10 E1.0 F1200\nG2 X30 Y20 I0 J10 E1.5\nG1 X20 Y20 E0.5\nG1 E-0.8 F2100\n";
+    }
+    GCodeProcessor processor;
+    processor.process_file(gcode_file);
+    const GCodeProcessorResult &processed = processor.get_result();
+    const GCodeProcessorResultSource source { gcode_file, Vec2d::Zero(), false };
+    // Loading a stored result sets the global printer flag.
+    const bool is_bbl_printer = GCodeProcessor::s_IsBBLPrinter;
+
+    WHEN("the processed result is stored and loaded back") {
+        REQUIRE(store_gcode_processor_result(processed, source, result_file));
+        GCodeProcessorResult loaded;
+        REQUIRE(load_gcode_processor_result(result_file, source, loaded));
+        THEN("the moves and the statistics match") {
+            REQUIRE(loaded.moves.size() == processed.moves.size());
+            for (size_t i = 0; i < processed.moves.size(); ++ i) {
+                REQUIRE(loaded.moves[i].gcode_id == processed.moves[i].gcode_id);
+                REQUIRE(loaded.moves[i].type == processed.moves[i].type);
+                REQUIRE(loaded.moves[i].position == processed.moves[i].position);
+                REQUIRE(loaded.moves[i].feedrate == processed.moves[i].feedrate);
+                REQUIRE(loaded.moves[i].move_path_type == processed.moves[i].move_path_type);
+                REQUIRE(loaded.moves[i].interpolation_points == processed.moves[i].interpolation_points);
+            }
+            REQUIRE(loaded.lines_ends == processed.lines_ends);
+            REQUIRE(loaded.print_statistics.modes[0].time == processed.print_statistics.modes[0].time);
+            REQUIRE(loaded.print_statistics.total_volumes_per_extruder == processed.print_statistics.total_volumes_per_extruder);
+        }
+        THEN("the mapped columns can be accessed in place") {
+            MappedGCodeProcessorResult mapped;
+            REQUIRE(mapped.open(result_file, source));
+            const GCodeMovesColumnsView moves = mapped.moves();
+            REQUIRE(moves.size() == processed.moves.size());
+            REQUIRE(moves.position[moves.size() - 1] == processed.moves.back().position);
+        }
+    }
+    WHEN("the G-code is modified after the result was stored") {
+        REQUIRE(store_gcode_processor_result(processed, source, result_file));
+        {
+            boost::nowide::ofstream out(gcode_file, std::ios::app);
+            out << "G1 X0 Y0 F3000\n";
+        }
+        GCodeProcessorResult loaded;
+        THEN("the stored result is rejected") {
+            REQUIRE(! load_gcode_processor_result(result_file, source, loaded));
+        }
+    }
+    WHEN("the G-code is replaced by another one of the same size and time stamp") {
+        REQUIRE(store_gcode_processor_result(processed, source, result_file));
+        const std::time_t mtime = fs::last_write_time(gcode_path);
+        std::string gcode;
+        {
+            boost::nowide::ifstream in(gcode_file, std::ios::binary);
+            gcode.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        const size_t pos = gcode.find("X30");
+        REQUIRE(pos != std::string::npos);
+        gcode.replace(pos, 3, "X31");
+        {
+            boost::nowide::ofstream out(gcode_file, std::ios::binary | std::ios::trunc);
+            out << gcode;
+        }
+        fs::last_write_time(gcode_path, mtime);
+        GCodeProcessorResult loaded;
+        THEN("the stored result is rejected") {
+            REQUIRE(! load_gcode_processor_result(result_file, source, loaded));
+        }
+    }
+    WHEN("the same G-code is written again with a different time stamp") {
+        REQUIRE(store_gcode_processor_result(processed, source, result_file));
+        fs::last_write_time(gcode_path, fs::last_write_time(gcode_path) - 10);
+        GCodeProcessorResult loaded;
+        THEN("the stored result is reused") {
+            REQUIRE(load_gcode_processor_result(result_file, source, loaded));
+            REQUIRE(loaded.moves.size() == processed.moves.size());
+        }
+    }
+    WHEN("the result of a BBL printer is loaded") {
+        const GCodeProcessorResultSource bbl_source { gcode_file, Vec2d::Zero(), true };
+        REQUIRE(store_gcode_processor_result(processed, bbl_source, result_file));
+        GCodeProcessor::s_IsBBLPrinter = false;
+        GCodeProcessorResult loaded;
+        REQUIRE(load_gcode_processor_result(result_file, bbl_source, loaded));
+        THEN("the printer flag of the processor is restored") {
+            REQUIRE(GCodeProcessor::s_IsBBLPrinter);
+        }
+    }
+    WHEN("the result is requested for a different plate origin") {
+        REQUIRE(store_gcode_processor_result(processed, source, result_file));
+        GCodeProcessorResult loaded;
+        THEN("the stored result is rejected") {
+            REQUIRE(! load_gcode_processor_result(result_file, { gcode_file, Vec2d(100., 0.), false }, loaded));
+        }
+    }
+
+    GCodeProcessor::s_IsBBLPrinter = is_bbl_printer;
+    fs::remove(gcode_path);
+    fs::remove(result_file);
+}
+
+SCENARIO("GCodeProcessor parallel parsing", "[GCode]") {
+    namespace fs = boost::filesystem;
+    const fs::path    gcode_path = fs::temp_directory_path() / fs::unique_path("gcode_parallel_%%%%-%%%%.gcode");
+    const std::string gcode_file = gcode_path.string();
+    {
+        // Several blocks of the parallel reader, mixed line endings and line numbers.
+        boost::nowide::ofstream out(gcode_file, std::ios::binary);
+        out << "G21\r\nG90\r\nM83\nG1 Z0.2 F600\r\n;TYPE:Outer wall\n;WIDTH:0.45\n;HEIGHT:0.2\n";
+        for (int i = 0; i < 100000; ++ i) {
+            out << "N" << i << " G1 X" << (i % 100) << " Y" << (i % 77) << " E0.0" << (i % 9 + 1) << "\n";
+            if (i % 1000 == 0)
+                out << "G2 X10 Y20 I5 J5 E0.5\nG1 E-0.8 F2100\nG1 E0.8\n\n";
+        }
+        out << "G1 X0 Y0";
+    }
+    GCodeProcessor serial;
+    serial.enable_parallel_parsing(false);
+    serial.process_file(gcode_file);
+    GCodeProcessor parallel;
+    parallel.enable_parallel_parsing(true);
+    parallel.process_file(gcode_file);
+
+    THEN("the results match the serial parsing") {
+        const GCodeProcessorResult &expected = serial.get_result();
+        const GCodeProcessorResult &result   = parallel.get_result();
+        REQUIRE(result.moves.size() == expected.moves.size());
+        for (size_t i = 0; i < expected.moves.size(); ++ i) {
+            REQUIRE(result.moves[i].gcode_id == expected.moves[i].gcode_id);
+            REQUIRE(result.moves[i].position == expected.moves[i].position);
+            REQUIRE(result.moves[i].delta_extruder == expected.moves[i].delta_extruder);
+        }
+        REQUIRE(result.lines_ends == expected.lines_ends);
+        REQUIRE(result.print_statistics.modes[0].time == expected.print_statistics.modes[0].time);
+    }
+
+    fs::remove(gcode_path);
+}
+
+SCENARIO("LayerGCode decoding", "[GCode]") {
+    GIVEN("G-code of a layer with cooling markers") {
+        LayerGCode layer(std::string(
+            ";_EXTRUDE_SET_SPEED;_EXTERNAL_PERIMETER\n"
+            "G1 X10.5 Y-2 E.25 F1800 ;_EXTRUDE_SET_SPEED;_EXTERNAL_PERIMETER\n"
+            "G92 E0\n"
+            "G4 S1\n"
+            ";_EXTRUDE_END\n"
+            "\n"
+            "M106 S255 ; fan\n"
+            "G3 X1 Y1 I0.5 J-0.5 ;_WIPE"));
+        const std::vector<LayerGCode::Line> &lines = layer.lines();
+        THEN("all lines are found") {
+            REQUIRE(lines.size() == 8);
+            REQUIRE(layer.text(lines[1]) == "G1 X10.5 Y-2 E.25 F1800 ;_EXTRUDE_SET_SPEED;_EXTERNAL_PERIMETER");
+            REQUIRE(lines[1].next == lines[2].begin);
+            REQUIRE(lines[7].next == layer.gcode().size());
+        }
+        THEN("commands, axes and markers are decoded") {
+            REQUIRE(lines[0].command == LayerGCode::Command::None);
+            REQUIRE(lines[0].tags == (LayerGCode::TAG_EXTRUDE_SET_SPEED | LayerGCode::TAG_EXTERNAL_PERIMETER));
+            REQUIRE(lines[1].command == LayerGCode::Command::G1);
+            REQUIRE(lines[1].has(X));
+            REQUIRE(lines[1].value(X) == 10.5f);
+            REQUIRE(lines[1].value(Y) == -2.f);
+            REQUIRE(lines[1].value(E) == .25f);
+            REQUIRE(lines[1].value(F) == 1800.f);
+            REQUIRE(! lines[1].has(Z));
+            REQUIRE(lines[1].tags == (LayerGCode::TAG_EXTRUDE_SET_SPEED | LayerGCode::TAG_EXTERNAL_PERIMETER));
+            REQUIRE(lines[2].command == LayerGCode::Command::G92);
+            REQUIRE(lines[2].has(E));
+            REQUIRE(lines[3].command == LayerGCode::Command::G4);
+            REQUIRE(lines[4].tags == LayerGCode::TAG_EXTRUDE_END);
+            REQUIRE(lines[5].command == LayerGCode::Command::None);
+            REQUIRE(lines[6].command == LayerGCode::Command::Other);
+            REQUIRE(lines[6].tags == 0);
+            REQUIRE(lines[7].command == LayerGCode::Command::G3);
+            REQUIRE(lines[7].value(J) == -0.5f);
+            REQUIRE(lines[7].tags == LayerGCode::TAG_WIPE);
+        }
+        WHEN("the following layer is appended") {
+            LayerGCode next(std::string(" E1\nG1 X2\n"));
+            layer.append(std::move(next));
+            THEN("the unterminated last line is decoded again") {
+                REQUIRE(layer.lines().size() == 9);
+                REQUIRE(layer.text(layer.lines()[7]) == "G3 X1 Y1 I0.5 J-0.5 ;_WIPE E1");
+                REQUIRE(! layer.lines()[7].has(E));
+                REQUIRE(layer.lines()[8].value(X) == 2.f);
+                REQUIRE(layer.lines()[8].begin == layer.lines()[7].next);
+            }
+        }
+    }
+    GIVEN("G-code parsed the way CoolingBuffer did with boost::starts_with() and atof()") {
+        LayerGCode layer(std::string(
+            "  G1 X1 E1\n"
+            "G1\n"
+            "G1\tX1 E1\n"
+            "G10 X1\n"
+            "G1 X1.5mm Y E2 ;_WIPE Z5\n"
+            "G4\n"));
+        const std::vector<LayerGCode::Line> &lines = layer.lines();
+        REQUIRE(lines.size() == 6);
+        THEN("only commands at the start of a line followed by a space are recognized") {
+            REQUIRE(lines[0].command == LayerGCode::Command::Other);
+            REQUIRE(lines[1].command == LayerGCode::Command::Other);
+            REQUIRE(lines[2].command == LayerGCode::Command::Other);
+            REQUIRE(lines[3].command == LayerGCode::Command::Other);
+            REQUIRE(lines[4].command == LayerGCode::Command::G1);
+            REQUIRE(lines[5].command == LayerGCode::Command::Other);
+            REQUIRE(lines[0].axes_mask == 0);
+        }
+        THEN("the axes are parsed up to the comment by atof()") {
+            REQUIRE(lines[4].value(X) == 1.5f);
+            REQUIRE(lines[4].has(Y));
+            REQUIRE(lines[4].value(Y) == 0.f);
+            REQUIRE(lines[4].value(E) == 2.f);
+            REQUIRE(! lines[4].has(Z));
+            REQUIRE(lines[4].tags == LayerGCode::TAG_WIPE);
+        }
+    }
+}
@@ -3,6 +3,10 @@
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/Utils.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
 
 #include "test_data.hpp"
 
@@ -138,3 +142,212 @@ SCENARIO("Print: Brim generation", "[Print]") {
         }
     }
 }
+
+SCENARIO("Print: Persistent slice cache", "[Print]") {
+    GIVEN("20mm cube, default config and an empty slice cache directory") {
+        boost::filesystem::path cache_dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("slice_cache_%%%%-%%%%");
+        Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({ { "layer_height", 0.25 }, { "initial_layer_print_height", 0.25 } });
+
+        Slic3r::Print first_print;
+        Slic3r::Model first_model;
+        first_print.set_slice_cache_dir(cache_dir.string());
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, first_print, first_model, config);
+        first_print.process();
+        WHEN("The same object is sliced by another Print") {
+            Slic3r::Print second_print;
+            Slic3r::Model second_model;
+            second_print.set_slice_cache_dir(cache_dir.string());
+            Slic3r::Test::init_print({TestMesh::cube_20x20x20}, second_print, second_model, config);
+            second_print.process();
+            THEN("The first slicing misses and stores the object, the second one restores it") {
+                REQUIRE(first_print.slice_cache_statistics().misses == 1);
+                REQUIRE(first_print.slice_cache_statistics().stored == 1);
+                REQUIRE(second_print.slice_cache_statistics().hits == 1);
+                REQUIRE(second_print.slice_cache_statistics().misses == 0);
+            }
+            THEN("The restored layers match the sliced ones") {
+                const PrintObject &sliced   = *first_print.objects().front();
+                const PrintObject &restored = *second_print.objects().front();
+                REQUIRE(restored.layers().size() == sliced.layers().size());
+                for (size_t i = 0; i < sliced.layers().size(); ++ i) {
+                    REQUIRE(restored.layers()[i]->print_z == Approx(sliced.layers()[i]->print_z));
+                    REQUIRE(restored.layers()[i]->regions().front()->perimeters.items_count() == sliced.layers()[i]->regions().front()->perimeters.items_count());
+                }
+            }
+        }
+        WHEN("The object is sliced with a different infill density") {
+            config.set_deserialize_strict({ { "sparse_infill_density", "40%" } });
+            Slic3r::Print second_print;
+            Slic3r::Model second_model;
+            second_print.set_slice_cache_dir(cache_dir.string());
+            Slic3r::Test::init_print({TestMesh::cube_20x20x20}, second_print, second_model, config);
+            second_print.process();
+            THEN("The cache entry is not reused") {
+                REQUIRE(second_print.slice_cache_statistics().hits == 0);
+                REQUIRE(second_print.slice_cache_statistics().misses == 1);
+            }
+        }
+        WHEN("Another object is sliced with the cache size limited to nothing") {
+            Slic3r::Print second_print;
+            Slic3r::Model second_model;
+            second_print.set_slice_cache_dir(cache_dir.string());
+            second_print.set_slice_cache_max_size(0);
+            Slic3r::Test::init_print({TestMesh::_40x10}, second_print, second_model, config);
+            second_print.process();
+            THEN("The stored entries are evicted") {
+                REQUIRE(second_print.slice_cache_statistics().stored == 1);
+                REQUIRE(boost::filesystem::is_empty(cache_dir));
+            }
+        }
+        WHEN("A cache directory is trimmed to the size of its most recently used entry") {
+            const boost::filesystem::path trimmed_dir  = cache_dir / "trimmed";
+            const boost::filesystem::path old_file     = trimmed_dir / "tree_support" / "old.bin";
+            const boost::filesystem::path touched_file = trimmed_dir / "touched.json";
+            boost::filesystem::create_directories(old_file.parent_path());
+            for (const boost::filesystem::path &path : { old_file, touched_file }) {
+                boost::nowide::ofstream ofs(path.string());
+                ofs << std::string(1000, 'x');
+                boost::filesystem::last_write_time(path, std::time(nullptr) - 3600);
+            }
+            Slic3r::touch_cache_file(touched_file.string());
+            size_t removed = Slic3r::trim_cache_dir(trimmed_dir.string(), 1000);
+            THEN("Only the recently used entry is kept") {
+                REQUIRE(removed == 1);
+                REQUIRE(boost::filesystem::exists(touched_file));
+                REQUIRE(! boost::filesystem::exists(old_file));
+                REQUIRE(boost::filesystem::file_size(touched_file) == 1000);
+            }
+        }
+        boost::filesystem::remove_all(cache_dir);
+    }
+}
+
+SCENARIO("Print: Reusing the volume slices after a modifier was moved", "[Print]") {
+    GIVEN("20mm cube with two infill modifiers") {
+        Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({ { "layer_height", 0.25 }, { "initial_layer_print_height", 0.25 } });
+
+        Slic3r::Model model;
+        ModelObject *object = model.add_object();
+        object->add_volume(make_cube(20., 20., 20.));
+        ModelVolume *moved     = object->add_volume(make_cube(5., 5., 20.), ModelVolumeType::PARAMETER_MODIFIER);
+        ModelVolume *unchanged = object->add_volume(make_cube(5., 5., 20.), ModelVolumeType::PARAMETER_MODIFIER);
+        moved->set_offset(Vec3d(5., 5., 10.));
+        unchanged->set_offset(Vec3d(15., 15., 10.));
+        moved->config.set_key_value("sparse_infill_density", new ConfigOptionPercent(100));
+        unchanged->config.set_key_value("sparse_infill_density", new ConfigOptionPercent(100));
+        object->add_instance()->set_offset(Vec3d(100., 100., 0.));
+        object->ensure_on_bed();
+
+        Slic3r::Print print;
+        print.auto_assign_extruders(object);
+        print.apply(model, config);
+        print.set_status_silent();
+        print.process();
+        const size_t reused = print.slice_cache_statistics().volumes_reused;
+        const size_t sliced = print.slice_cache_statistics().volumes_sliced;
+        WHEN("One of the modifiers is moved and the object is sliced again") {
+            moved->set_offset(Vec3d(5., 15., 10.));
+            print.apply(model, config);
+            print.process();
+            THEN("The first slicing sliced all the volumes, the second one sliced just the moved modifier") {
+                REQUIRE(reused == 0);
+                REQUIRE(sliced == 3);
+                REQUIRE(print.slice_cache_statistics().volumes_reused - reused == 2);
+                REQUIRE(print.slice_cache_statistics().volumes_sliced - sliced == 1);
+            }
+            THEN("The slices match the slices of a Print which did not have the cache") {
+                Slic3r::Model fresh_model(model);
+                Slic3r::Print fresh_print;
+                fresh_print.auto_assign_extruders(fresh_model.objects.front());
+                fresh_print.apply(fresh_model, config);
+                fresh_print.set_status_silent();
+                fresh_print.process();
+                REQUIRE(fresh_print.slice_cache_statistics().volumes_reused == 0);
+                const PrintObject &resliced = *print.objects().front();
+                const PrintObject &fresh    = *fresh_print.objects().front();
+                REQUIRE(resliced.layers().size() == fresh.layers().size());
+                for (size_t i = 0; i < fresh.layers().size(); ++ i) {
+                    const Layer &l1 = *resliced.layers()[i];
+                    const Layer &l2 = *fresh.layers()[i];
+                    REQUIRE(l1.print_z == Approx(l2.print_z));
+                    REQUIRE(l1.lslices == l2.lslices);
+                    REQUIRE(l1.regions().size() == l2.regions().size());
+                    for (size_t region_id = 0; region_id < l2.regions().size(); ++ region_id)
+                        REQUIRE(to_expolygons(l1.regions()[region_id]->slices.surfaces) == to_expolygons(l2.regions()[region_id]->slices.surfaces));
+                }
+            }
+        }
+        WHEN("The Print does not keep the caches and a modifier is moved") {
+            print.set_keep_reslice_caches(false);
+            moved->set_offset(Vec3d(5., 15., 10.));
+            print.apply(model, config);
+            print.process();
+            THEN("All the volumes are sliced again") {
+                REQUIRE(print.slice_cache_statistics().volumes_reused - reused == 0);
+                REQUIRE(print.slice_cache_statistics().volumes_sliced - sliced == 3);
+            }
+        }
+    }
+}
+
+SCENARIO("Print: Replaying the layers after a cooling change", "[Print]") {
+    // The header contains the time of the export.
+    auto strip_header = [](std::string gcode) {
+        size_t pos = gcode.find("; generated by ");
+        if (pos != std::string::npos)
+            gcode.erase(pos, gcode.find('\n', pos) - pos);
+        return gcode;
+    };
+    GIVEN("20mm cube exported with the fan running at the maximum speed") {
+        Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({ { "fan_cooling_layer_time", "1000" }, { "fan_max_speed", "100" } });
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        const std::string first          = Slic3r::Test::gcode(print);
+        const size_t      layers_recorded = print.slice_cache_statistics().gcode_layers_recorded;
+        WHEN("The maximum fan speed is changed and the G-code is exported again") {
+            config.set_deserialize_strict({ { "fan_max_speed", "50" } });
+            print.apply(model, config);
+            const std::string replayed = Slic3r::Test::gcode(print);
+            Slic3r::Print fresh_print;
+            Slic3r::Model fresh_model;
+            Slic3r::Test::init_print({TestMesh::cube_20x20x20}, fresh_print, fresh_model, config);
+            const std::string generated = Slic3r::Test::gcode(fresh_print);
+            THEN("The layers recorded by the first export are replayed") {
+                REQUIRE(layers_recorded > 0);
+                REQUIRE(print.slice_cache_statistics().gcode_layers_replayed == layers_recorded);
+                REQUIRE(print.slice_cache_statistics().gcode_layers_recorded == 0);
+                REQUIRE(fresh_print.slice_cache_statistics().gcode_layers_replayed == 0);
+            }
+            THEN("The G-code matches the G-code generated from scratch") {
+                REQUIRE(strip_header(replayed) != strip_header(first));
+                REQUIRE(strip_header(replayed) == strip_header(generated));
+            }
+        }
+        WHEN("The wall count is changed and the G-code is exported again") {
+            config.set_deserialize_strict({ { "wall_loops", "4" } });
+            print.apply(model, config);
+            Slic3r::Test::gcode(print);
+            THEN("The layers are generated and recorded again") {
+                REQUIRE(print.slice_cache_statistics().gcode_layers_replayed == 0);
+                REQUIRE(print.slice_cache_statistics().gcode_layers_recorded > 0);
+            }
+        }
+    }
+    GIVEN("20mm cube of a Print, which does not keep the caches") {
+        Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        Slic3r::Print print;
+        Slic3r::Model model;
+        print.set_keep_reslice_caches(false);
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        const size_t memory = GCodeLayerResultCache::total_memory();
+        Slic3r::Test::gcode(print);
+        THEN("No layers are recorded") {
+            REQUIRE(print.slice_cache_statistics().gcode_layers_recorded == 0);
+            REQUIRE(GCodeLayerResultCache::total_memory() == memory);
+        }
+    }
+}
@@ -1,7 +1,17 @@
 #include <catch2/catch.hpp>
 
+#include <chrono>
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include <tbb/global_control.h>
+#include <tbb/parallel_for.h>
+
 #include "libslic3r/GCodeReader.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/Utils.hpp"
+#include "libslic3r/Support/TreeSupport.hpp"
 
 #include "test_data.hpp" // get access to init_print, etc
 
@@ -119,6 +129,245 @@ SCENARIO("SupportMaterial: support_layers_z and contact_distance", "[SupportMate
     }
 }
 
+SCENARIO("SupportMaterial: Persistent organic tree support collision cache", "[SupportMaterial]")
+{
+    GIVEN("An overhang supported by organic trees and an empty slice cache directory") {
+        boost::filesystem::path cache_dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("tree_support_cache_%%%%-%%%%");
+        Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({
+            { "enable_support",               1 },
+            { "support_type",                 "tree(auto)" },
+            { "support_style",                "organic" },
+            { "support_interface_top_layers", 2 }
+            });
+        auto count_files = [&cache_dir](const std::string &extension) {
+            size_t cnt = 0;
+            if (boost::filesystem::is_directory(cache_dir / "tree_support"))
+                for (const auto &entry : boost::filesystem::directory_iterator(cache_dir / "tree_support"))
+                    cnt += entry.path().extension() == extension;
+            return cnt;
+        };
+        auto support_extrusions = [](const Slic3r::Print &print) {
+            std::vector<size_t> out;
+            for (const SupportLayer *layer : print.objects().front()->support_layers())
+                out.emplace_back(layer->support_fills.items_count());
+            return out;
+        };
+
+        Slic3r::Print first_print;
+        Slic3r::Model first_model;
+        first_print.set_slice_cache_dir(cache_dir.string());
+        Slic3r::Test::init_print({ TestMesh::overhang }, first_print, first_model, config);
+        first_print.process();
+        THEN("The collisions and avoidances are calculated and persisted") {
+            REQUIRE(first_print.slice_cache_statistics().tree_support_areas_loaded == 0);
+            REQUIRE(first_print.slice_cache_statistics().tree_support_areas_computed > 0);
+            REQUIRE(count_files(".collision") == 1);
+            REQUIRE(count_files(".avoidance") == 1);
+        }
+        WHEN("The object is sliced again with different interface layers") {
+            config.set_deserialize_strict({ { "support_interface_top_layers", 3 } });
+            Slic3r::Print second_print;
+            Slic3r::Model second_model;
+            second_print.set_slice_cache_dir(cache_dir.string());
+            Slic3r::Test::init_print({ TestMesh::overhang }, second_print, second_model, config);
+            second_print.process();
+            Slic3r::Print fresh_print;
+            Slic3r::Model fresh_model;
+            Slic3r::Test::init_print({ TestMesh::overhang }, fresh_print, fresh_model, config);
+            fresh_print.process();
+            THEN("The persisted caches are reused") {
+                REQUIRE(second_print.slice_cache_statistics().misses == 1);
+                REQUIRE(second_print.slice_cache_statistics().tree_support_areas_loaded == first_print.slice_cache_statistics().tree_support_areas_computed);
+                REQUIRE(second_print.slice_cache_statistics().tree_support_areas_computed == 0);
+                REQUIRE(count_files(".collision") == 1);
+                REQUIRE(count_files(".avoidance") == 1);
+            }
+            THEN("The supports match the supports generated without the cache") {
+                REQUIRE(support_extrusions(second_print) == support_extrusions(fresh_print));
+            }
+        }
+        WHEN("The persisted caches are corrupt") {
+            for (const auto &entry : boost::filesystem::directory_iterator(cache_dir / "tree_support")) {
+                // Claim a huge number of entries followed by garbage.
+                boost::nowide::ofstream out(entry.path().string(), std::ios::out | std::ios::binary | std::ios::trunc);
+                const uint64_t num_entries = uint64_t(1) << 60;
+                out.write(reinterpret_cast<const char*>(&num_entries), sizeof(num_entries));
+                out << "garbage";
+            }
+            Slic3r::Print third_print;
+            Slic3r::Model third_model;
+            third_print.set_slice_cache_dir(cache_dir.string());
+            Slic3r::Test::init_print({ TestMesh::overhang }, third_print, third_model, config);
+            third_print.process();
+            THEN("The caches are ignored and calculated again") {
+                REQUIRE(third_print.slice_cache_statistics().tree_support_areas_loaded == 0);
+                REQUIRE(third_print.slice_cache_statistics().tree_support_areas_computed == first_print.slice_cache_statistics().tree_support_areas_computed);
+                REQUIRE(support_extrusions(third_print) == support_extrusions(first_print));
+            }
+        }
+        boost::filesystem::remove_all(cache_dir);
+    }
+}
+
+TEST_CASE("SupportMaterial: Scaling of organic tree supports with the number of threads", "[SupportMaterial][Benchmark][.]")
+{
+    auto process_secs = [](bool support) {
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({ TestMesh::sphere_50mm, TestMesh::ipadstand }, print, model, {
+            { "enable_support", support },
+            { "support_type",   "tree(auto)" },
+            { "support_style",  "organic" }
+            });
+        const auto start = std::chrono::steady_clock::now();
+        print.process();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    double secs_4_threads = 0.;
+    for (size_t threads : { 4, 8, 16, 32 }) {
+        tbb::global_control control(tbb::global_control::max_allowed_parallelism, threads);
+        // The support generation time is the difference to slicing without supports.
+        const double secs = process_secs(true) - process_secs(false);
+        if (threads == 4)
+            secs_4_threads = secs;
+        WARN(threads << " threads: tree supports generated in " << secs << " s, speedup over 4 threads " << secs_4_threads / secs);
+    }
+}
+
+SCENARIO("SupportMaterial: Tree support nodes are allocated from a pool", "[SupportMaterial]")
+{
+    GIVEN("An overhang supported by hybrid trees") {
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_and_process_print({ TestMesh::overhang }, print, {
+            { "enable_support", 1 },
+            { "support_type",   "tree(auto)" },
+            { "support_style",  "tree_hybrid" }
+            });
+        std::shared_ptr<TreeSupportData> ts_data = print.get_object(0)->alloc_tree_support_preview_cache();
+        THEN("The nodes are kept in the pool until it is released") {
+            REQUIRE(! print.objects().front()->support_layers().empty());
+            REQUIRE(ts_data->nodes_count() > 0);
+            REQUIRE(ts_data->nodes_memory() >= ts_data->nodes_count() * sizeof(SupportNode));
+            ts_data->clear_nodes();
+            REQUIRE(ts_data->nodes_count() == 0);
+            REQUIRE(ts_data->nodes_memory() == 0);
+        }
+    }
+}
+
+TEST_CASE("SupportMaterial: Tree support collision cache is filled and read concurrently", "[SupportMaterial]")
+{
+    using Cache = TreeSupport3D::TreeModelVolumes::RadiusLayerPolygonCache;
+    // Spanning several blocks of layers allocated by the cache.
+    const TreeSupport3D::LayerIndex num_layers   = 300;
+    const std::vector<coord_t>      radii        { 0, 100, 200, 400, 800 };
+    // The largest radius is calculated on the lower layers only.
+    const TreeSupport3D::LayerIndex last_layer_largest_radius = 150;
+    auto area = [](coord_t radius, TreeSupport3D::LayerIndex layer_idx) {
+        return Polygons{ Polygon{ { layer_idx, radius }, { layer_idx + 10, radius }, { layer_idx + 10, radius + 10 } } };
+    };
+    auto expected = [&](coord_t radius, TreeSupport3D::LayerIndex layer_idx) {
+        return layer_idx <= last_layer_largest_radius || radius != radii.back();
+    };
+
+    Cache             cache;
+    std::atomic<bool> consistent { true };
+    tbb::parallel_for(tbb::blocked_range<TreeSupport3D::LayerIndex>(0, 2 * num_layers, 1),
+        [&](const tbb::blocked_range<TreeSupport3D::LayerIndex> &range) {
+            for (TreeSupport3D::LayerIndex i = range.begin(); i < range.end(); ++ i) {
+                const TreeSupport3D::LayerIndex layer_idx = i / 2;
+                if (i % 2 == 0) {
+                    // Writer: insert the radii of a layer from the largest one.
+                    std::vector<std::pair<TreeSupport3D::TreeModelVolumes::RadiusLayerPair, Polygons>> data;
+                    for (auto it = radii.rbegin(); it != radii.rend(); ++ it)
+                        if (expected(*it, layer_idx))
+                            data.push_back({ { *it, layer_idx }, area(*it, layer_idx) });
+                    cache.insert(std::move(data));
+                } else {
+                    // Reader: the areas found on the neighbor layers being written must be complete.
+                    for (TreeSupport3D::LayerIndex l : { num_layers - 1 - layer_idx, layer_idx + 1 })
+                        for (coord_t radius : radii) {
+                            if (auto found = cache.getArea({ radius, l }); found && found->get() != area(radius, l))
+                                consistent = false;
+                            if (auto found = cache.get_lower_bound_area({ radius + 50, l }); found && (found->first > radius || found->second.get() != area(found->first, l)))
+                                consistent = false;
+                        }
+                }
+            }
+        });
+
+    REQUIRE(consistent);
+    REQUIRE(cache.size() == size_t(num_layers) * (radii.size() - 1) + size_t(last_layer_largest_radius + 1));
+    for (TreeSupport3D::LayerIndex layer_idx = 0; layer_idx < num_layers; ++ layer_idx)
+        for (coord_t radius : radii) {
+            auto found = cache.getArea({ radius, layer_idx });
+            REQUIRE(bool(found) == expected(radius, layer_idx));
+            if (found)
+                REQUIRE(found->get() == area(radius, layer_idx));
+            // The largest cached radius not larger than the requested one.
+            auto lower = cache.get_lower_bound_area({ radius + 50, layer_idx });
+            REQUIRE(lower);
+            REQUIRE(lower->first == (expected(radius, layer_idx) ? radius : radii[radii.size() - 2]));
+            REQUIRE(lower->second.get() == area(lower->first, layer_idx));
+        }
+    REQUIRE(! cache.get_lower_bound_area({ -1, 0 }));
+    REQUIRE(! cache.getArea({ radii.front(), num_layers }));
+    REQUIRE(! cache.get_lower_bound_area({ radii.front(), num_layers }));
+    REQUIRE(cache.getMaxCalculatedLayer(radii.front()) == num_layers - 1);
+    REQUIRE(cache.getMaxCalculatedLayer(radii.back()) == last_layer_largest_radius);
+    REQUIRE(cache.getMaxCalculatedLayer(radii.front() + 1) == -1);
+}
+
+TEST_CASE("SupportMaterial: Tree support nodes of scaled up overhangs", "[SupportMaterial][Benchmark][.]")
+{
+    for (float scale : { 1.f, 2.f, 4.f, 8.f }) {
+        TriangleMesh mesh = Slic3r::Test::mesh(TestMesh::overhang);
+        mesh.scale(scale);
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({ mesh }, print, model, {
+            { "enable_support", 1 },
+            { "support_type",   "tree(auto)" },
+            { "support_style",  "tree_hybrid" }
+            });
+        const auto start = std::chrono::steady_clock::now();
+        print.process();
+        const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::shared_ptr<TreeSupportData> ts_data = print.get_object(0)->alloc_tree_support_preview_cache();
+        const SupportNodePool           &nodes   = ts_data->contact_nodes;
+        WARN("Scale " << scale << ": processed in " << secs << " s, " << nodes.size() << " tree support nodes," << log_memory_info(true));
+
+        // Replay the creation of the same number of nodes per layer into a pool and into separately allocated nodes,
+        // the way TreeSupportData stored the nodes before the pool.
+        auto time_it = [](auto &&fn) {
+            const auto start = std::chrono::steady_clock::now();
+            fn();
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        };
+        size_t pool_memory = 0;
+        const double pool_secs = time_it([&nodes, &pool_memory]() {
+            SupportNodePool pool;
+            for (size_t layer_idx = 0; layer_idx < nodes.num_layers(); ++ layer_idx)
+                for (size_t i = 0; i < nodes.layer_size(layer_idx); ++ i)
+                    pool.create(layer_idx, Point(coord_t(i), coord_t(layer_idx)), 0, int(layer_idx), 0, true, nullptr, 0., 0.);
+            pool_memory = pool.memory();
+        });
+        size_t heap_memory = 0;
+        const double heap_secs = time_it([&nodes, &heap_memory]() {
+            std::vector<std::unique_ptr<SupportNode>> heap;
+            for (size_t layer_idx = 0; layer_idx < nodes.num_layers(); ++ layer_idx)
+                for (size_t i = 0; i < nodes.layer_size(layer_idx); ++ i)
+                    heap.emplace_back(std::make_unique<SupportNode>(Point(coord_t(i), coord_t(layer_idx)), 0, int(layer_idx), 0, true, nullptr, 0., 0.));
+            // Each node allocated separately costs a malloc chunk header and the rounding up to 16 bytes.
+            heap_memory = heap.capacity() * sizeof(std::unique_ptr<SupportNode>) + heap.size() * ((sizeof(SupportNode) + sizeof(size_t) + 15) / 16 * 16);
+        });
+        WARN("    pool: " << pool_secs << " s, " << format_memsize_MB(pool_memory) << "; separately allocated nodes: " << heap_secs << " s, "
+            << format_memsize_MB(heap_memory));
+    }
+}
+
 #if 0
 // Test 8.
 TEST_CASE("SupportMaterial: forced support is generated", "[SupportMaterial]")
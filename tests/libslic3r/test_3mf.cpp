@@ -2,12 +2,47 @@
 
 #include "libslic3r/Model.hpp"
 #include "libslic3r/Format/3mf.hpp"
+#include "libslic3r/Format/bbs_3mf.hpp"
 #include "libslic3r/Format/STL.hpp"
 
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/filesystem/operations.hpp>
 
+#include <chrono>
+#include <thread>
+
+#include <miniz.h>
+
 using namespace Slic3r;
 
+// Deflate level the metadata files of a 3MF archive were stored with, found by compressing them again at the candidate levels.
+// Returns -1 if none of the metadata files tells the levels apart.
+static int metadata_deflate_level(const std::string &path)
+{
+    int            level = -1;
+    mz_zip_archive archive;
+    mz_zip_zero_struct(&archive);
+    if (! mz_zip_reader_init_file(&archive, path.c_str(), 0))
+        return level;
+    for (mz_uint i = 0; i < mz_zip_reader_get_num_files(&archive) && level == -1; ++ i) {
+        mz_zip_archive_file_stat stat;
+        if (! mz_zip_reader_file_stat(&archive, i, &stat) || ! boost::algorithm::starts_with(stat.m_filename, "Metadata/") || stat.m_method != MZ_DEFLATED)
+            continue;
+        size_t size = 0;
+        void  *data = mz_zip_reader_extract_to_heap(&archive, i, &size, 0);
+        if (data == nullptr)
+            continue;
+        size_t fast_size = 0, default_size = 0;
+        mz_free(tdefl_compress_mem_to_heap(data, size, &fast_size, tdefl_create_comp_flags_from_zip_params(MZ_BEST_SPEED, -15, MZ_DEFAULT_STRATEGY)));
+        mz_free(tdefl_compress_mem_to_heap(data, size, &default_size, tdefl_create_comp_flags_from_zip_params(MZ_DEFAULT_LEVEL, -15, MZ_DEFAULT_STRATEGY)));
+        mz_free(data);
+        if (fast_size != default_size)
+            level = stat.m_comp_size == fast_size ? MZ_BEST_SPEED : stat.m_comp_size == default_size ? MZ_DEFAULT_LEVEL : -2;
+    }
+    mz_zip_reader_end(&archive);
+    return level;
+}
+
 SCENARIO("Reading 3mf file", "[3mf]") {
     GIVEN("umlauts in the path of the file") {
         Model model;
@@ -131,3 +166,243 @@ SCENARIO("2D convex hull of sinking object", "[3mf]") {
     }
 }
 
+
+SCENARIO("Export+Import of a split model with fast compression", "[3mf]") {
+    GIVEN("model with several objects") {
+        Model src_model;
+        for (int i = 0; i < 8; ++ i) {
+            ModelObject *object = src_model.add_object(("object" + std::to_string(i)).c_str(), "", TriangleMesh(its_make_sphere(5. + i, PI / 20.)));
+            object->add_instance()->set_offset({ 20. * i, 0., 0. });
+        }
+
+        WHEN("model is saved with the objects in separate files and loaded back") {
+            std::string        test_file = std::string(TEST_DATA_DIR) + "/test_3mf/split_model.3mf";
+            DynamicPrintConfig src_config;
+            StoreParams        store_params;
+            store_params.path     = test_file.c_str();
+            store_params.model    = &src_model;
+            store_params.config   = &src_config;
+            store_params.strategy = SaveStrategy::Silence | SaveStrategy::SplitModel | SaveStrategy::FastCompression | SaveStrategy::Zip64;
+            bool stored = store_bbs_3mf(store_params);
+
+            // The object files are written in the order of the objects independently of the threads compressing them.
+            const int deflate_level = metadata_deflate_level(test_file);
+            std::vector<std::string> object_files;
+            {
+                mz_zip_archive archive;
+                mz_zip_zero_struct(&archive);
+                if (mz_zip_reader_init_file(&archive, test_file.c_str(), 0)) {
+                    for (mz_uint i = 0; i < mz_zip_reader_get_num_files(&archive); ++ i) {
+                        mz_zip_archive_file_stat stat;
+                        if (mz_zip_reader_file_stat(&archive, i, &stat) && boost::algorithm::starts_with(stat.m_filename, "3D/Objects/"))
+                            object_files.emplace_back(stat.m_filename);
+                    }
+                    mz_zip_reader_end(&archive);
+                }
+            }
+
+            Model              dst_model;
+            DynamicPrintConfig dst_config;
+            PlateDataPtrs      plate_data;
+            std::vector<Preset*> project_presets;
+            bool               is_bbl_3mf = false;
+            Semver             file_version;
+            ConfigSubstitutionContext ctxt{ ForwardCompatibilitySubstitutionRule::Disable };
+            bool loaded = load_bbs_3mf(test_file.c_str(), &dst_config, &ctxt, &dst_model, &plate_data, &project_presets, &is_bbl_3mf, &file_version);
+            release_PlateData_list(plate_data);
+            boost::filesystem::remove(test_file);
+
+            THEN("the files are deflated with the fastest level") {
+                REQUIRE(deflate_level == MZ_BEST_SPEED);
+            }
+            THEN("the objects are stored in order and their meshes match") {
+                REQUIRE(stored);
+                REQUIRE(object_files.size() == src_model.objects.size());
+                for (size_t i = 0; i < object_files.size(); ++ i)
+                    REQUIRE(boost::algorithm::starts_with(object_files[i], "3D/Objects/object" + std::to_string(i) + "_"));
+                REQUIRE(loaded);
+                REQUIRE(dst_model.objects.size() == src_model.objects.size());
+                for (size_t i = 0; i < src_model.objects.size(); ++ i)
+                    REQUIRE(dst_model.objects[i]->volumes.front()->mesh().its.indices.size() == src_model.objects[i]->volumes.front()->mesh().its.indices.size());
+            }
+        }
+
+        WHEN("model is saved with the objects in separate files and one of the object files is corrupted") {
+            std::string        test_file    = std::string(TEST_DATA_DIR) + "/test_3mf/split_model_corrupt.3mf";
+            std::string        corrupt_file = std::string(TEST_DATA_DIR) + "/test_3mf/split_model_corrupt_object.3mf";
+            DynamicPrintConfig src_config;
+            StoreParams        store_params;
+            store_params.path     = test_file.c_str();
+            store_params.model    = &src_model;
+            store_params.config   = &src_config;
+            store_params.strategy = SaveStrategy::Silence | SaveStrategy::SplitModel | SaveStrategy::Zip64;
+            bool stored = store_bbs_3mf(store_params);
+
+            // Copy the archive, truncating the largest object file, which is parsed first while the other objects are being parsed.
+            bool corrupted = false;
+            {
+                mz_zip_archive src_archive, dst_archive;
+                mz_zip_zero_struct(&src_archive);
+                mz_zip_zero_struct(&dst_archive);
+                if (mz_zip_reader_init_file(&src_archive, test_file.c_str(), 0)) {
+                    if (mz_zip_writer_init_file(&dst_archive, corrupt_file.c_str(), 0)) {
+                        for (mz_uint i = 0; i < mz_zip_reader_get_num_files(&src_archive); ++ i) {
+                            mz_zip_archive_file_stat stat;
+                            if (! mz_zip_reader_file_stat(&src_archive, i, &stat))
+                                continue;
+                            if (boost::algorithm::starts_with(stat.m_filename, "3D/Objects/object7_")) {
+                                const std::string data = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<model unit=\"millimeter\"><resources><object id=\"1\"><mesh><vertices><vertex x=\"0\"";
+                                corrupted = mz_zip_writer_add_mem(&dst_archive, stat.m_filename, data.data(), data.size(), MZ_DEFAULT_LEVEL);
+                            } else
+                                mz_zip_writer_add_from_zip_reader(&dst_archive, &src_archive, i);
+                        }
+                        mz_zip_writer_finalize_archive(&dst_archive);
+                        mz_zip_writer_end(&dst_archive);
+                    }
+                    mz_zip_reader_end(&src_archive);
+                }
+            }
+            boost::filesystem::remove(test_file);
+
+            Model              dst_model;
+            DynamicPrintConfig dst_config;
+            PlateDataPtrs      plate_data;
+            std::vector<Preset*> project_presets;
+            bool               is_bbl_3mf = false;
+            Semver             file_version;
+            ConfigSubstitutionContext ctxt{ ForwardCompatibilitySubstitutionRule::Disable };
+            bool loaded = true;
+            try {
+                loaded = load_bbs_3mf(corrupt_file.c_str(), &dst_config, &ctxt, &dst_model, &plate_data, &project_presets, &is_bbl_3mf, &file_version);
+            } catch (const std::exception &) {
+                loaded = false;
+            }
+            release_PlateData_list(plate_data);
+            boost::filesystem::remove(corrupt_file);
+
+            THEN("the loading finishes and fails") {
+                REQUIRE(stored);
+                REQUIRE(corrupted);
+                REQUIRE_FALSE(loaded);
+            }
+        }
+
+        WHEN("model is saved with the objects in separate files without fast compression") {
+            std::string        test_file = std::string(TEST_DATA_DIR) + "/test_3mf/split_model_default.3mf";
+            DynamicPrintConfig src_config;
+            StoreParams        store_params;
+            store_params.path     = test_file.c_str();
+            store_params.model    = &src_model;
+            store_params.config   = &src_config;
+            store_params.strategy = SaveStrategy::Silence | SaveStrategy::SplitModel | SaveStrategy::Zip64;
+            bool stored = store_bbs_3mf(store_params);
+            const int deflate_level = metadata_deflate_level(test_file);
+            boost::filesystem::remove(test_file);
+
+            THEN("the files are deflated with the default level") {
+                REQUIRE(stored);
+                REQUIRE(deflate_level == MZ_DEFAULT_LEVEL);
+            }
+        }
+    }
+}
+
+SCENARIO("Hash of the backup mesh of an object", "[3mf]") {
+    GIVEN("an object with a single volume") {
+        Model        model;
+        ModelObject *object = model.add_object("backup_cube", "", TriangleMesh(its_make_cube(10., 10., 10.)));
+        object->add_instance();
+        ModelVolume *volume = object->volumes.front();
+        const uint64_t hash = backup_object_mesh_hash(*object);
+
+        THEN("the clone backed up by the backup thread has the same hash") {
+            Model clone_model;
+            REQUIRE(backup_object_mesh_hash(*clone_model.add_object(*object)) == hash);
+        }
+        THEN("moving the instance does not change the hash") {
+            object->instances.front()->set_offset(Vec3d(50., 0., 0.));
+            REQUIRE(backup_object_mesh_hash(*object) == hash);
+        }
+        THEN("changing the mesh changes the hash") {
+            volume->set_mesh(TriangleMesh(its_make_cube(10., 10., 11.)));
+            REQUIRE(backup_object_mesh_hash(*object) != hash);
+        }
+        THEN("changing the transformation of the volume changes the hash") {
+            volume->set_offset(Vec3d(1., 0., 0.));
+            REQUIRE(backup_object_mesh_hash(*object) != hash);
+        }
+        THEN("painting supports changes the hash") {
+            volume->supported_facets.set_triangle_from_string(0, "4");
+            REQUIRE(backup_object_mesh_hash(*object) != hash);
+        }
+        THEN("painting the seam changes the hash") {
+            volume->seam_facets.set_triangle_from_string(0, "4");
+            REQUIRE(backup_object_mesh_hash(*object) != hash);
+        }
+        THEN("painting the filaments changes the hash") {
+            volume->mmu_segmentation_facets.set_triangle_from_string(0, "8");
+            const uint64_t painted = backup_object_mesh_hash(*object);
+            REQUIRE(painted != hash);
+            volume->mmu_segmentation_facets.reset();
+            volume->mmu_segmentation_facets.set_triangle_from_string(0, "0C");
+            REQUIRE(backup_object_mesh_hash(*object) != painted);
+        }
+    }
+}
+
+// Wait for the backup thread, which delays writing an object by a few seconds.
+template<class Predicate> static bool wait_for_backup(Predicate predicate)
+{
+    for (int i = 0; i < 300; ++ i) {
+        run_backup_ui_tasks();
+        if (predicate())
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return false;
+}
+
+SCENARIO("Backup of the object meshes", "[3mf]") {
+    namespace fs = boost::filesystem;
+    const fs::path backup_dir = fs::temp_directory_path() / fs::unique_path("backup_mesh_%%%%-%%%%");
+    GIVEN("a model with two objects, which is backed up") {
+        Model model;
+        model.set_backup_path(backup_dir.string());
+        model.set_need_backup();
+        ModelObject *object = model.add_object("backup_cube", "", TriangleMesh(its_make_cube(10., 10., 10.)));
+        ModelObject *other  = model.add_object("backup_other", "", TriangleMesh(its_make_cube(5., 5., 5.)));
+        object->add_instance();
+        other->add_instance();
+        auto mesh_file = [&model](const ModelObject &object) {
+            return fs::path(model.get_backup_path()) / "3D" / "Objects" / (object.name + "_" + std::to_string(model.get_object_backup_id(object)) + ".model");
+        };
+        const fs::path object_file = mesh_file(*object);
+        const fs::path other_file  = mesh_file(*other);
+
+        save_object_mesh(*object);
+        REQUIRE(wait_for_backup([&object_file]() { return fs::exists(object_file); }));
+        const std::time_t old_time = fs::last_write_time(object_file) - 1000;
+        fs::last_write_time(object_file, old_time);
+
+        WHEN("the unchanged object is backed up again") {
+            save_object_mesh(*object);
+            // The tasks are processed in order, the other object is written after the object was processed again.
+            save_object_mesh(*other);
+            REQUIRE(wait_for_backup([&other_file]() { return fs::exists(other_file); }));
+            THEN("its backup mesh is not written again") {
+                REQUIRE(fs::last_write_time(object_file) == old_time);
+            }
+        }
+        WHEN("the object is painted and backed up again") {
+            object->volumes.front()->supported_facets.set_triangle_from_string(0, "4");
+            save_object_mesh(*object);
+            THEN("its backup mesh is written again") {
+                REQUIRE(wait_for_backup([&object_file, old_time]() { return fs::last_write_time(object_file) != old_time; }));
+            }
+        }
+    }
+    // The model removes its backup directory when destroyed.
+    wait_for_backup([&backup_dir]() { return ! fs::exists(backup_dir); });
+    boost::system::error_code ec;
+    fs::remove_all(backup_dir, ec);
+}
@@ -0,0 +1,139 @@
+#include <catch2/catch.hpp>
+#include <test_utils.hpp>
+
+#include <chrono>
+#include <list>
+
+#include "libslic3r/Arachne/WallToolPaths.hpp"
+#include "libslic3r/Arachne/SkeletalTrapezoidation.hpp"
+#include "libslic3r/Arachne/BeadingStrategy/BeadingStrategyFactory.hpp"
+#include "libslic3r/ClipperUtils.hpp"
+#include "libslic3r/Geometry.hpp"
+#include "libslic3r/TriangleMeshSlicer.hpp"
+
+using namespace Slic3r;
+
+static std::vector<ExPolygons> slice_model(const std::string &obj_filename, float layer_height)
+{
+    TriangleMesh mesh = load_model(obj_filename);
+    const BoundingBoxf3 bbox = mesh.bounding_box();
+    std::vector<float> zs;
+    for (float z = float(bbox.min.z()) + 0.5f * layer_height; z < float(bbox.max.z()); z += layer_height)
+        zs.emplace_back(z);
+    return slice_mesh_ex(mesh.its, zs);
+}
+
+// Generate the walls of all the layers, return the number of extrusion lines.
+// If check is set, the walls are checked against the outline of their layer.
+static size_t generate_walls(const std::vector<ExPolygons> &layers, size_t inset_count, bool check)
+{
+    const Arachne::WallToolPathsParams params    = arachne_params();
+    const coord_t                      width     = scaled<coord_t>(0.45);
+    size_t                             num_lines = 0;
+    for (const ExPolygons &layer : layers) {
+        const Polygons         outline = to_polygons(layer);
+        Arachne::WallToolPaths wall_tool_paths(outline, width, width, inset_count, 0, 0.2, params);
+        const std::vector<Arachne::VariableWidthLines> &toolpaths = wall_tool_paths.getToolPaths();
+        if (check) {
+            // The junctions are the centers of the beads, they lie inside the outline.
+            const ExPolygons outline_grown = offset_ex(layer, float(SCALED_EPSILON));
+            // The outer wall goes around each island.
+            if (! layer.empty()) {
+                REQUIRE(! toolpaths.empty());
+                REQUIRE(! toolpaths.front().empty());
+                REQUIRE(toolpaths.front().front().inset_idx == 0);
+            }
+            for (const Arachne::VariableWidthLines &lines : toolpaths)
+                for (const Arachne::ExtrusionLine &line : lines) {
+                    REQUIRE(line.inset_idx < 2 * inset_count);
+                    REQUIRE(line.size() >= 2);
+                    REQUIRE((! line.is_closed || line.junctions.front().p == line.junctions.back().p));
+                    for (const Arachne::ExtrusionJunction &junction : line.junctions) {
+                        REQUIRE(junction.w > 0);
+                        REQUIRE(junction.w <= 2 * width);
+                        REQUIRE(std::any_of(outline_grown.begin(), outline_grown.end(), [&junction](const ExPolygon &expoly) { return expoly.contains(junction.p); }));
+                    }
+                }
+        }
+        for (const Arachne::VariableWidthLines &lines : toolpaths)
+            num_lines += lines.size();
+    }
+    return num_lines;
+}
+
+TEST_CASE("Arachne walls of a sliced model", "[Arachne]") {
+    const std::vector<ExPolygons> layers = slice_model("extruder_idler.obj", 2.f);
+    REQUIRE(! layers.empty());
+    // At least an outer wall per island.
+    size_t num_islands = 0;
+    for (const ExPolygons &layer : layers)
+        num_islands += layer.size();
+    REQUIRE(generate_walls(layers, 3, true) >= num_islands);
+}
+
+// Node and edge count of the skeletal graph of each layer.
+static std::vector<std::pair<size_t, size_t>> skeletal_graph_sizes(const std::vector<ExPolygons> &layers, size_t inset_count)
+{
+    const Arachne::WallToolPathsParams params = arachne_params();
+    const coord_t                      width  = scaled<coord_t>(0.45);
+    std::vector<std::pair<size_t, size_t>> sizes;
+    for (const ExPolygons &layer : layers) {
+        const Polygons outline = union_(to_polygons(layer));
+        if (outline.empty())
+            continue;
+        const Arachne::BeadingStrategyPtr beading_strategy = Arachne::BeadingStrategyFactory::makeStrategy(
+            width, width, scaled<coord_t>(params.wall_transition_length), float(Geometry::deg2rad(params.wall_transition_angle)), true,
+            scaled<coord_t>(params.min_bead_width), scaled<coord_t>(params.min_feature_size), 0.5, 0.5, coord_t(2 * inset_count), 0,
+            params.wall_distribution_count);
+        Arachne::SkeletalTrapezoidation skeletal_trapezoidation(outline, *beading_strategy, beading_strategy->getTransitioningAngle(),
+            scaled<coord_t>(0.8), scaled<coord_t>(100.), scaled<coord_t>(params.wall_transition_filter_deviation), scaled<coord_t>(params.wall_transition_length));
+        sizes.emplace_back(skeletal_trapezoidation.graph.nodes.size(), skeletal_trapezoidation.graph.edges.size());
+    }
+    return sizes;
+}
+
+// Allocate the nodes and edges of the graphs of the given sizes one by one the way the graph is built from the Voronoi diagram,
+// then free each graph as a whole.
+template<typename Graph>
+static double time_graph_allocation(const std::vector<std::pair<size_t, size_t>> &sizes)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto &[num_nodes, num_edges] : sizes) {
+        Graph graph;
+        for (size_t i = 0; i < std::max(num_nodes, num_edges); ++ i) {
+            if (i < num_edges)
+                graph.edges.emplace_back(Arachne::SkeletalTrapezoidationEdge());
+            if (i < num_nodes)
+                graph.nodes.emplace_back(Arachne::SkeletalTrapezoidationJoint(), Point::Zero());
+        }
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The graph before its nodes and edges were allocated from an arena.
+struct SystemAllocatedGraph
+{
+    std::list<Arachne::STHalfEdge>     edges;
+    std::list<Arachne::STHalfEdgeNode> nodes;
+};
+
+TEST_CASE("Throughput of generating Arachne walls", "[Arachne][Benchmark][.]") {
+    for (const char *obj_filename : { "extruder_idler.obj", "frog_legs.obj", "ipadstand.obj", "cube_with_concave_hole_enlarged.obj" }) {
+        const std::vector<ExPolygons> layers = slice_model(obj_filename, 0.2f);
+        const auto   start     = std::chrono::steady_clock::now();
+        const size_t num_lines = generate_walls(layers, 5, false);
+        const double secs      = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        WARN(obj_filename << ": " << layers.size() << " layers, " << num_lines << " extrusion lines in " << secs << " s, "
+             << double(layers.size()) / secs << " layers/s");
+
+        // Before / after allocating the graph from an arena, on the graphs of the layers of the model.
+        const std::vector<std::pair<size_t, size_t>> sizes = skeletal_graph_sizes(layers, 5);
+        size_t num_elements = 0;
+        for (const auto &[num_nodes, num_edges] : sizes)
+            num_elements += num_nodes + num_edges;
+        const double system_secs = time_graph_allocation<SystemAllocatedGraph>(sizes);
+        const double arena_secs  = time_graph_allocation<Arachne::SkeletalTrapezoidationGraph>(sizes);
+        WARN(obj_filename << ": graph of " << num_elements << " nodes and edges allocated by the system allocator in " << system_secs << " s, "
+             << "from an arena in " << arena_secs << " s, speedup " << system_secs / arena_secs);
+    }
+}
@@ -0,0 +1,80 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/GCodeScanner.hpp"
+#include "libslic3r/GCodeReader.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Slic3r;
+
+static const char* find_any_of(const char *ptr, const char *end, const std::string &chars)
+{
+    for (; ptr != end; ++ ptr)
+        if (chars.find(*ptr) != std::string::npos)
+            return ptr;
+    return end;
+}
+
+TEST_CASE("GCodeScanner matches the scalar reference for all supported instruction sets", "[GCodeScanner]") {
+    using namespace GCodeScanner;
+    const ISA   initial_isa = active_isa();
+    // '\0' included on purpose, it terminates a G-code line but not a line of a file.
+    const char  alphabet[]  = "G1 X2.5;\t\r\nE\0";
+    const std::string eol(std::string("\r\n") + '\0');
+    const std::string gcode_eol = eol + ";";
+
+    for (ISA isa : { ISA::Scalar, ISA::SSE42, ISA::AVX2 }) {
+        if (set_isa(isa) != isa)
+            // Not supported by this CPU.
+            continue;
+        std::mt19937 rng(0);
+        for (int i = 0; i < 5000; ++ i) {
+            std::string text(rng() % 200, ' ');
+            for (char &c : text)
+                c = alphabet[rng() % (sizeof(alphabet) - 1)];
+            const char *begin = text.data();
+            const char *end   = begin + text.size();
+            REQUIRE(find_end_of_line(begin, end) == find_any_of(begin, end, eol));
+            REQUIRE(find_end_of_gcode_line(begin, end) == find_any_of(begin, end, gcode_eol));
+            REQUIRE(find_line_break(begin, end) == find_any_of(begin, end, "\r\n"));
+            REQUIRE(find_newline(begin, end) == find_any_of(begin, end, "\n"));
+
+            std::vector<const char*> words, expected_words;
+            const char *code_end          = for_each_word(begin, end, [&words](const char *word) { words.emplace_back(word); });
+            const char *expected_code_end = find_any_of(begin, end, gcode_eol);
+            bool        prev_whitespace   = true;
+            for (const char *c = begin; c != expected_code_end; ++ c) {
+                bool whitespace = *c == ' ' || *c == '\t';
+                if (! whitespace && prev_whitespace)
+                    expected_words.emplace_back(c);
+                prev_whitespace = whitespace;
+            }
+            REQUIRE(code_end == expected_code_end);
+            REQUIRE(words == expected_words);
+        }
+    }
+    set_isa(initial_isa);
+}
+
+TEST_CASE("GCodeReader decodes axes with the vectorized scanner", "[GCodeScanner]") {
+    GCodeReader reader;
+    // Longer than one 64 character block of the scanner.
+    reader.parse_line("G1 X10.5 Y-2 Z.3 E0.12345 F1800 ; a comment which is long enough to span several blocks Y99 X99", [](GCodeReader &, const GCodeReader::GCodeLine &line) {
+        REQUIRE(line.cmd_is("G1"));
+        REQUIRE(line.has_x());
+        REQUIRE(line.x() == Approx(10.5));
+        REQUIRE(line.y() == Approx(-2.));
+        REQUIRE(line.z() == Approx(0.3));
+        REQUIRE(line.e() == Approx(0.12345));
+        REQUIRE(line.f() == Approx(1800.));
+        REQUIRE(! line.has_unknown_axis());
+        REQUIRE(line.comment() == " a comment which is long enough to span several blocks Y99 X99");
+    });
+    reader.parse_line("G1\tX1 Xfoo Q5 Y2", [](GCodeReader &, const GCodeReader::GCodeLine &line) {
+        REQUIRE(line.x() == Approx(1.));
+        REQUIRE(line.y() == Approx(2.));
+        REQUIRE(line.has_unknown_axis());
+    });
+}
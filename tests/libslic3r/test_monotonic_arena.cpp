@@ -0,0 +1,49 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/MonotonicArena.hpp"
+
+#include <numeric>
+
+using namespace Slic3r;
+
+TEST_CASE("MonotonicArena allocations", "[MonotonicArena]") {
+    MonotonicArena arena(1024);
+
+    SECTION("allocations are aligned and do not overlap") {
+        char   *a = static_cast<char*>(arena.allocate(3, 1));
+        double *b = static_cast<double*>(arena.allocate(sizeof(double), alignof(double)));
+        REQUIRE(reinterpret_cast<uintptr_t>(b) % alignof(double) == 0);
+        REQUIRE(reinterpret_cast<char*>(b) >= a + 3);
+    }
+
+    SECTION("vectors grow over multiple blocks") {
+        ArenaVector<int> v { ArenaAllocator<int>(arena) };
+        for (int i = 0; i < 10000; ++ i)
+            v.emplace_back(i);
+        REQUIRE(std::accumulate(v.begin(), v.end(), 0LL) == 10000LL * 9999 / 2);
+        REQUIRE(arena.capacity() >= 10000 * sizeof(int));
+    }
+
+    SECTION("reset merges the blocks to serve the same allocations again") {
+        for (int i = 0; i < 100; ++ i)
+            arena.allocate(1000);
+        const size_t capacity = arena.capacity();
+        arena.reset();
+        REQUIRE(arena.capacity() == capacity);
+        for (int i = 0; i < 100; ++ i)
+            arena.allocate(1000);
+        REQUIRE(arena.capacity() == capacity);
+    }
+
+    SECTION("the last allocation is returned to the arena") {
+        void *a = arena.allocate(100, 8);
+        arena.deallocate(a, 100);
+        REQUIRE(arena.allocate(100, 8) == a);
+    }
+
+    SECTION("release frees all the memory") {
+        arena.allocate(5000);
+        arena.release();
+        REQUIRE(arena.capacity() == 0);
+    }
+}
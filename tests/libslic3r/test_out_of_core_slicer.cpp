@@ -0,0 +1,226 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/Geometry.hpp"
+#include "libslic3r/OutOfCoreSlicer.hpp"
+#include "libslic3r/TriangleMesh.hpp"
+#include "libslic3r/Format/STL.hpp"
+
+#include <sstream>
+
+#include <boost/filesystem/operations.hpp>
+
+#include <miniz.h>
+
+using namespace Slic3r;
+
+// Object with a mesh in the XML of a 3MF model file.
+static std::string threemf_mesh_object(int id, const indexed_triangle_set &its)
+{
+    std::ostringstream out;
+    // Enough digits for the floats to survive the round trip.
+    out.precision(9);
+    out << "<object id=\"" << id << "\" type=\"model\"><mesh><vertices>";
+    for (const stl_vertex &v : its.vertices)
+        out << "<vertex x=\"" << v.x() << "\" y=\"" << v.y() << "\" z=\"" << v.z() << "\"/>";
+    out << "</vertices><triangles>";
+    for (const stl_triangle_vertex_indices &f : its.indices)
+        out << "<triangle v1=\"" << f(0) << "\" v2=\"" << f(1) << "\" v3=\"" << f(2) << "\"/>";
+    out << "</triangles></mesh></object>";
+    return out.str();
+}
+
+// 3MF transform attribute: 4x3 matrix stored row by row, the points being row vectors.
+static std::string threemf_transform(const Transform3d &t)
+{
+    std::ostringstream out;
+    out.precision(17);
+    for (size_t c = 0; c < 4; ++ c)
+        for (size_t r = 0; r < 3; ++ r)
+            out << (c + r > 0 ? " " : "") << t(r, c);
+    return out.str();
+}
+
+static bool write_zip(const std::string &path, const std::vector<std::pair<std::string, std::string>> &files)
+{
+    mz_zip_archive archive;
+    mz_zip_zero_struct(&archive);
+    if (! mz_zip_writer_init_file(&archive, path.c_str(), 0))
+        return false;
+    bool ok = true;
+    for (const auto &[name, data] : files)
+        ok = ok && mz_zip_writer_add_mem(&archive, name.c_str(), data.data(), data.size(), MZ_DEFAULT_LEVEL);
+    ok = ok && mz_zip_writer_finalize_archive(&archive);
+    return mz_zip_writer_end(&archive) && ok;
+}
+
+static double total_area(const ExPolygons &expolygons)
+{
+    double area = 0;
+    for (const ExPolygon &expolygon : expolygons)
+        area += expolygon.area();
+    return area;
+}
+
+// Out-of-core slicing shall produce the same slices as slicing the whole mesh in memory, layer by layer in order.
+static void check_slices_match_in_core(const TriangleStream &triangles, const indexed_triangle_set &its, const std::vector<float> &zs,
+                                       const OutOfCoreSlicingParams &params)
+{
+    std::vector<ExPolygons> expected = slice_mesh_ex(its, zs, params);
+    size_t next_layer_id = 0;
+    slice_mesh_out_of_core(triangles, zs, params, [&](size_t layer_id, ExPolygons &&slices) {
+        REQUIRE(layer_id == next_layer_id ++);
+        REQUIRE(slices.size() == expected[layer_id].size());
+        REQUIRE(total_area(slices) == Approx(total_area(expected[layer_id])));
+    });
+    REQUIRE(next_layer_id == zs.size());
+}
+
+TEST_CASE("Out-of-core slicing matches in-core slicing", "[OutOfCoreSlicer]") {
+    indexed_triangle_set sphere = its_make_sphere(10., 2. * PI / 60.);
+    its_translate(sphere, Vec3f(0.f, 0.f, 10.f));
+    std::vector<float> zs;
+    for (float z = 0.1f; z < 20.f; z += 0.3f)
+        zs.emplace_back(z);
+
+    OutOfCoreSlicingParams params;
+    // Budget of a few layers only, so that the sphere is spilled into many buckets.
+    params.memory_budget = 64 * 1024;
+
+    SECTION("mesh in memory") {
+        check_slices_match_in_core(triangle_stream(sphere), sphere, zs, params);
+    }
+    SECTION("transformed mesh") {
+        params.trafo.rotate(Eigen::AngleAxisd(PI / 5., Vec3d::UnitX()));
+        params.trafo.pretranslate(Vec3d(5., -3., 2.));
+        check_slices_match_in_core(triangle_stream(sphere), sphere, zs, params);
+    }
+    SECTION("STL file") {
+        boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.stl");
+        TriangleMesh mesh(sphere);
+        REQUIRE(store_stl(path.string().c_str(), &mesh, true));
+        check_slices_match_in_core(triangle_stream_from_file(path.string()), sphere, zs, params);
+        boost::filesystem::remove(path);
+    }
+}
+
+TEST_CASE("Out-of-core slicing of a 3MF applies the components and the build items", "[OutOfCoreSlicer]") {
+    indexed_triangle_set sphere = its_make_sphere(5., 2. * PI / 40.);
+    indexed_triangle_set cube   = its_make_cube(6., 4., 8.);
+
+    // Object 2 is an assembly of the sphere of the root model and of the cube of another model file.
+    const Transform3d sphere_in_assembly = Geometry::translation_transform(Vec3d(10., 0., 6.));
+    const Transform3d cube_in_assembly   = Geometry::translation_transform(Vec3d(-5., 2., 1.)) * Eigen::AngleAxisd(PI / 6., Vec3d::UnitZ());
+    // The assembly is placed on the bed, the sphere is placed once more mirrored and rotated.
+    const Transform3d assembly_item      = Geometry::translation_transform(Vec3d(50., 40., 0.)) * Eigen::AngleAxisd(PI / 4., Vec3d::UnitX());
+    Transform3d       sphere_item        = Geometry::translation_transform(Vec3d(20., 60., 5.)) * Eigen::AngleAxisd(PI / 3., Vec3d::UnitY());
+    sphere_item.scale(Vec3d(-1., 1.5, 1.));
+
+    const std::string root_model =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<model unit=\"millimeter\" xmlns=\"http://schemas.microsoft.com/3dmanufacturing/core/2015/02\" "
+        "xmlns:p=\"http://schemas.microsoft.com/3dmanufacturing/production/2015/06\"><resources>" +
+        threemf_mesh_object(1, sphere) +
+        "<object id=\"2\" type=\"model\"><components>"
+        "<component objectid=\"1\" transform=\"" + threemf_transform(sphere_in_assembly) + "\"/>"
+        "<component p:path=\"/3D/Objects/cube.model\" objectid=\"1\" transform=\"" + threemf_transform(cube_in_assembly) + "\"/>"
+        "</components></object>" +
+        // Not placed by the build, thus not sliced.
+        threemf_mesh_object(3, cube) +
+        "</resources><build>"
+        "<item objectid=\"2\" transform=\"" + threemf_transform(assembly_item) + "\"/>"
+        "<item objectid=\"1\" transform=\"" + threemf_transform(sphere_item) + "\"/>"
+        "</build></model>";
+    const std::string cube_model =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<model unit=\"millimeter\" xmlns=\"http://schemas.microsoft.com/3dmanufacturing/core/2015/02\"><resources>" +
+        threemf_mesh_object(1, cube) +
+        "</resources></model>";
+
+    boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.3mf");
+    REQUIRE(write_zip(path.string(), { { "3D/3dmodel.model", root_model }, { "3D/Objects/cube.model", cube_model } }));
+
+    indexed_triangle_set expected;
+    auto add_instance = [&expected](const indexed_triangle_set &its, const Transform3d &trafo) {
+        TriangleMesh mesh(its);
+        mesh.transform(trafo, true);
+        its_merge(expected, mesh.its);
+    };
+    add_instance(sphere, assembly_item * sphere_in_assembly);
+    add_instance(cube,   assembly_item * cube_in_assembly);
+    add_instance(sphere, sphere_item);
+
+    size_t num_triangles = 0;
+    triangle_stream_from_file(path.string())([&num_triangles](const stl_vertex *) { ++ num_triangles; });
+    REQUIRE(num_triangles == expected.indices.size());
+
+    std::vector<float> zs;
+    for (float z = -10.f; z < 70.f; z += 0.5f)
+        zs.emplace_back(z);
+    OutOfCoreSlicingParams params;
+    params.memory_budget = 64 * 1024;
+    check_slices_match_in_core(triangle_stream_from_file(path.string()), expected, zs, params);
+    boost::filesystem::remove(path);
+}
+
+TEST_CASE("Out-of-core slicing of a 3MF skips the volumes which are not model parts", "[OutOfCoreSlicer]") {
+    indexed_triangle_set sphere = its_make_sphere(5., 2. * PI / 40.);
+    indexed_triangle_set cube   = its_make_cube(6., 4., 8.);
+    // Object 4 stores its volumes in a single mesh, the cube being a triangle range.
+    indexed_triangle_set sphere_and_cube = sphere;
+    its_merge(sphere_and_cube, cube);
+
+    const Transform3d cube_in_object = Geometry::translation_transform(Vec3d(-2., -2., -4.));
+    const Transform3d object3_item   = Geometry::translation_transform(Vec3d(50., 40., 5.));
+    const Transform3d object4_item   = Geometry::translation_transform(Vec3d(20., 60., 5.));
+
+    // Object 3 of Orca / Bambu Studio: a model part and a modifier, each a component.
+    const std::string root_model =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<model unit=\"millimeter\" xmlns=\"http://schemas.microsoft.com/3dmanufacturing/core/2015/02\" "
+        "xmlns:p=\"http://schemas.microsoft.com/3dmanufacturing/production/2015/06\"><resources>" +
+        threemf_mesh_object(1, sphere) +
+        "<object id=\"3\" type=\"model\"><components>"
+        "<component objectid=\"1\"/>"
+        "<component p:path=\"/3D/Objects/cube.model\" objectid=\"2\" transform=\"" + threemf_transform(cube_in_object) + "\"/>"
+        "</components></object>" +
+        threemf_mesh_object(4, sphere_and_cube) +
+        "</resources><build>"
+        "<item objectid=\"3\" transform=\"" + threemf_transform(object3_item) + "\"/>"
+        "<item objectid=\"4\" transform=\"" + threemf_transform(object4_item) + "\"/>"
+        "</build></model>";
+    const std::string cube_model =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<model unit=\"millimeter\" xmlns=\"http://schemas.microsoft.com/3dmanufacturing/core/2015/02\"><resources>" +
+        threemf_mesh_object(2, cube) +
+        "</resources></model>";
+    const std::string config =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?><config>"
+        "<object id=\"3\"><part id=\"1\" subtype=\"normal_part\"/><part id=\"2\" subtype=\"modifier_part\"/></object>"
+        "<object id=\"4\">"
+        "<volume firstid=\"0\" lastid=\"" + std::to_string(sphere.indices.size() - 1) + "\"><metadata type=\"volume\" key=\"volume_type\" value=\"ModelPart\"/></volume>"
+        "<volume firstid=\"" + std::to_string(sphere.indices.size()) + "\" lastid=\"" + std::to_string(sphere_and_cube.indices.size() - 1) + "\">"
+        "<metadata type=\"volume\" key=\"volume_type\" value=\"ParameterModifier\"/></volume>"
+        "</object></config>";
+
+    boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.3mf");
+    REQUIRE(write_zip(path.string(), { { "3D/3dmodel.model", root_model }, { "3D/Objects/cube.model", cube_model }, { "Metadata/model_settings.config", config } }));
+
+    indexed_triangle_set expected;
+    for (const Transform3d &trafo : { object3_item, object4_item }) {
+        TriangleMesh mesh(sphere);
+        mesh.transform(trafo, true);
+        its_merge(expected, mesh.its);
+    }
+
+    size_t num_triangles = 0;
+    triangle_stream_from_file(path.string())([&num_triangles](const stl_vertex *) { ++ num_triangles; });
+    REQUIRE(num_triangles == expected.indices.size());
+
+    std::vector<float> zs;
+    for (float z = 0.25f; z < 10.f; z += 0.5f)
+        zs.emplace_back(z);
+    OutOfCoreSlicingParams params;
+    params.memory_budget = 64 * 1024;
+    check_slices_match_in_core(triangle_stream_from_file(path.string()), expected, zs, params);
+    boost::filesystem::remove(path);
+}
@@ -0,0 +1,65 @@
+#include <catch2/catch.hpp>
+
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "libslic3r/PrintProfiler.hpp"
+
+using namespace Slic3r;
+
+SCENARIO("PrintProfiler records finished steps", "[PrintProfiler]")
+{
+    PrintProfiler profiler;
+    int print, object;
+    GIVEN("A Print step and a PrintObject step") {
+        profiler.step_started(&print, "psWipeTower");
+        profiler.step_started(&object, "posSlice");
+        profiler.step_finished(&object, "posSlice", "cube", 7, 42, 3);
+        profiler.step_finished(&print, "psWipeTower");
+        // Not started, thus not recorded.
+        profiler.step_finished(&print, "psSkirtBrim");
+        THEN("both steps are recorded in the order of their start") {
+            std::vector<PrintProfiler::StepRecord> records = profiler.records();
+            REQUIRE(records.size() == 2);
+            REQUIRE(records.front().step == "psWipeTower");
+            REQUIRE(records.back().step == "posSlice");
+            REQUIRE(records.back().layers == 42);
+            REQUIRE(records.back().wall_us >= 0);
+        }
+        THEN("the object step reports its object in json") {
+            nlohmann::json j = profiler.to_json();
+            REQUIRE(j.size() == 2);
+            REQUIRE_FALSE(j[0].contains("object"));
+            REQUIRE(j[1]["object"] == "cube");
+            REQUIRE(j[1]["object_id"] == 7);
+        }
+        THEN("the trace contains the process name and a complete event per step") {
+            nlohmann::json events;
+            profiler.append_trace_events(events, 2, "plate 2");
+            REQUIRE(events.size() == 3);
+            REQUIRE(events[0]["ph"] == "M");
+            REQUIRE(events[1]["ph"] == "X");
+            REQUIRE(events[2]["name"] == "posSlice cube");
+            REQUIRE(events[2]["pid"] == 2);
+        }
+    }
+}
+
+SCENARIO("PrintProfiler orders the steps by their start", "[PrintProfiler]")
+{
+    GIVEN("Many steps started within a short time and finished in the reverse order") {
+        PrintProfiler    profiler;
+        std::vector<int> objects(100);
+        for (int &object : objects)
+            profiler.step_started(&object, "posSlice");
+        for (auto it = objects.rbegin(); it != objects.rend(); ++ it)
+            profiler.step_finished(&*it, "posSlice", "object", size_t(&*it - objects.data()));
+        THEN("the records follow the order of the starts, even of the steps started within the same microsecond") {
+            std::vector<PrintProfiler::StepRecord> records = profiler.records();
+            REQUIRE(records.size() == objects.size());
+            for (size_t i = 0; i < records.size(); ++ i)
+                REQUIRE(records[i].object_id == i);
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#include <catch2/catch.hpp>
+
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include "libslic3r/SettingsFileCache.hpp"
+
+using namespace Slic3r;
+namespace fs = boost::filesystem;
+
+static void write_file(const fs::path &path, const std::string &data)
+{
+    boost::nowide::ofstream ofs(path.string(), std::ios::binary);
+    ofs << data;
+}
+
+static bool load_settings(SettingsFileCache &cache, const std::string &file, DynamicPrintConfig &config, std::map<std::string, std::string> &key_values)
+{
+    const std::string digest = SettingsFileCache::file_digest(file);
+    if (cache.load(file, digest, config, key_values))
+        return true;
+    std::string reason;
+    config.load_from_json(file, ForwardCompatibilitySubstitutionRule::Enable, key_values, reason);
+    REQUIRE(reason.empty());
+    cache.store(file, digest, config, key_values);
+    return false;
+}
+
+SCENARIO("SettingsFileCache keyed on the file content", "[SettingsFileCache]")
+{
+    const fs::path dir  = fs::temp_directory_path() / fs::unique_path("settings_file_cache_%%%%-%%%%");
+    fs::create_directories(dir);
+    const std::string file = (dir / "process.json").string();
+    write_file(file, R"({"name": "p", "from": "User", "layer_height": "0.2"})");
+
+    SettingsFileCache cache;
+    DynamicPrintConfig config;
+    std::map<std::string, std::string> key_values;
+    REQUIRE_FALSE(load_settings(cache, file, config, key_values));
+    REQUIRE(cache.size() == 1);
+
+    WHEN("the file is loaded again unchanged") {
+        DynamicPrintConfig cached;
+        std::map<std::string, std::string> cached_key_values;
+        THEN("the stored config is reused") {
+            REQUIRE(load_settings(cache, file, cached, cached_key_values));
+            REQUIRE(cached.opt_float("layer_height") == Approx(0.2));
+            REQUIRE(cached_key_values["name"] == "p");
+        }
+    }
+    WHEN("the file is rewritten with the same size and modification time") {
+        const std::time_t mtime = fs::last_write_time(file);
+        write_file(file, R"({"name": "p", "from": "User", "layer_height": "0.3"})");
+        fs::last_write_time(file, mtime);
+        REQUIRE(fs::file_size(file) == std::string(R"({"name": "p", "from": "User", "layer_height": "0.2"})").size());
+        DynamicPrintConfig reloaded;
+        std::map<std::string, std::string> reloaded_key_values;
+        THEN("the file is parsed again") {
+            REQUIRE_FALSE(load_settings(cache, file, reloaded, reloaded_key_values));
+            REQUIRE(reloaded.opt_float("layer_height") == Approx(0.3));
+            REQUIRE(cache.size() == 1);
+        }
+    }
+    WHEN("the file is removed") {
+        fs::remove(file);
+        DynamicPrintConfig missing;
+        std::map<std::string, std::string> missing_key_values;
+        THEN("the entry is dropped") {
+            REQUIRE(SettingsFileCache::file_digest(file).empty());
+            REQUIRE_FALSE(cache.load(file, SettingsFileCache::file_digest(file), missing, missing_key_values));
+            REQUIRE(cache.size() == 0);
+        }
+    }
+
+    fs::remove_all(dir);
+}
@@ -1,8 +1,13 @@
 #include <catch2/catch.hpp>
 
 #include "libslic3r/Model.hpp"
+#include "libslic3r/TriangleMesh.hpp"
 #include "libslic3r/Format/STL.hpp"
 
+#include <chrono>
+
+#include <boost/filesystem/operations.hpp>
+
 using namespace Slic3r;
 
 static inline std::string stl_path(const char* path)
@@ -55,3 +60,75 @@ SCENARIO("Reading an STL file", "[stl]") {
 		}
 	}
 }
+
+static std::string write_temp_stl(const indexed_triangle_set &its)
+{
+	std::string path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.stl")).string();
+	REQUIRE(its_write_stl_binary(path.c_str(), "", its));
+	return path;
+}
+
+SCENARIO("Reading a binary STL file by memory mapping", "[stl]") {
+	GIVEN("a closed mesh") {
+		indexed_triangle_set sphere = its_make_sphere(10., 2. * PI / 60.);
+		std::string path = write_temp_stl(sphere);
+		WHEN("STL file is read") {
+			indexed_triangle_set its;
+			REQUIRE(read_binary_stl_mapped(path.c_str(), its));
+			THEN("the mesh matches the mesh read by admesh") {
+				TriangleMesh mesh;
+				REQUIRE(mesh.ReadSTLFile(path.c_str(), true));
+				REQUIRE(its.indices.size() == mesh.its.indices.size());
+				REQUIRE(its.vertices.size() == mesh.its.vertices.size());
+				REQUIRE(its_num_open_edges(its) == 0);
+				REQUIRE(its_volume(its) == Approx(its_volume(mesh.its)));
+			}
+		}
+		WHEN("STL file is read with a header length shorter than the standard one") {
+			indexed_triangle_set its, its_negative;
+			REQUIRE(read_binary_stl_mapped(path.c_str(), its, nullptr, 0));
+			REQUIRE(read_binary_stl_mapped(path.c_str(), its_negative, nullptr, -1000));
+			THEN("the standard header length is used") {
+				REQUIRE(its.indices.size() == sphere.indices.size());
+				REQUIRE(its_negative.indices.size() == sphere.indices.size());
+				REQUIRE(its_volume(its) == Approx(its_volume(sphere)));
+			}
+		}
+		boost::filesystem::remove(path);
+	}
+	GIVEN("a mesh with degenerate facets") {
+		indexed_triangle_set cube = its_make_cube(20., 20., 20.);
+		cube.indices.emplace_back(0, 0, 1);
+		std::string path = write_temp_stl(cube);
+		THEN("the mesh is left to admesh to be repaired") {
+			indexed_triangle_set its;
+			REQUIRE_FALSE(read_binary_stl_mapped(path.c_str(), its));
+			Slic3r::Model model;
+			REQUIRE(Slic3r::load_stl(path.c_str(), &model));
+			REQUIRE(model.objects.front()->volumes.front()->mesh().its.indices.size() == 12);
+		}
+		boost::filesystem::remove(path);
+	}
+}
+
+TEST_CASE("Load time of a large binary STL file", "[stl][Benchmark][.]") {
+	// About 6M facets, 300MB.
+	indexed_triangle_set sphere = its_make_sphere(50., 2. * PI / 2450.);
+	std::string path = write_temp_stl(sphere);
+	sphere = indexed_triangle_set();
+	const double file_mb = double(boost::filesystem::file_size(path)) / (1024. * 1024.);
+
+	auto start = std::chrono::steady_clock::now();
+	TriangleMesh mesh_admesh;
+	REQUIRE(mesh_admesh.ReadSTLFile(path.c_str(), true));
+	const double secs_admesh = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	Slic3r::Model model;
+	REQUIRE(Slic3r::load_stl(path.c_str(), &model));
+	const double secs_mapped = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	WARN(file_mb << " MB, " << mesh_admesh.its.indices.size() << " facets: admesh " << secs_admesh << " s, memory mapped " << secs_mapped << " s");
+	REQUIRE(model.objects.front()->volumes.front()->mesh().its.indices.size() == mesh_admesh.its.indices.size());
+	boost::filesystem::remove(path);
+}
@@ -0,0 +1,72 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/TriangleMesh.hpp"
+#include "libslic3r/TriangleMeshSlicer.hpp"
+
+#include <chrono>
+#include <vector>
+
+using namespace Slic3r;
+
+static std::vector<float> slicing_zs(float bottom, float top, float layer_height)
+{
+    std::vector<float> zs;
+    for (float z = bottom; z < top; z += layer_height)
+        zs.emplace_back(z);
+    return zs;
+}
+
+static double total_area(const Polygons &polygons)
+{
+    double area = 0;
+    for (const Polygon &polygon : polygons)
+        area += polygon.area();
+    return area;
+}
+
+// The batched multi plane slicer shall produce the same contours as the single plane slicer.
+static void check_slices_match_single_plane(const indexed_triangle_set &its, const std::vector<float> &zs)
+{
+    MeshSlicingParams     params;
+    std::vector<Polygons> layers = slice_mesh(its, zs, params, []() {});
+    REQUIRE(layers.size() == zs.size());
+    for (size_t i = 0; i < zs.size(); ++ i) {
+        Polygons single = slice_mesh(its, zs[i], params);
+        REQUIRE(layers[i].size() == single.size());
+        REQUIRE(total_area(layers[i]) == Approx(total_area(single)));
+    }
+}
+
+TEST_CASE("Slicing at many planes matches slicing at a single plane", "[TriangleMeshSlicer]") {
+    SECTION("sphere") {
+        indexed_triangle_set sphere = its_make_sphere(10., 2. * PI / 60.);
+        its_translate(sphere, Vec3f(0.f, 0.f, 10.f));
+        check_slices_match_single_plane(sphere, slicing_zs(0.1f, 20.f, 0.3f));
+    }
+    SECTION("planes touching the vertices") {
+        indexed_triangle_set cube = its_make_cube(10., 10., 10.);
+        // The planes at the bottom, top and at the vertices of the slanted faces are sliced by the generic code path.
+        its_rotate_x(cube, float(PI / 4.));
+        check_slices_match_single_plane(cube, slicing_zs(-8.f, 16.f, 0.5f));
+    }
+    SECTION("several blocks of faces, each spanning a part of the planes") {
+        indexed_triangle_set sphere = its_make_sphere(10., 2. * PI / 200.);
+        its_translate(sphere, Vec3f(0.f, 0.f, 10.f));
+        REQUIRE(sphere.indices.size() > 3 * 8192);
+        // The planes above the sphere are not touched by any block.
+        check_slices_match_single_plane(sphere, slicing_zs(0.1f, 25.f, 0.3f));
+    }
+}
+
+TEST_CASE("Throughput of slicing a large mesh", "[TriangleMeshSlicer][Benchmark][.]") {
+    indexed_triangle_set sphere = its_make_sphere(50., 2. * PI / 1500.);
+    its_translate(sphere, Vec3f(0.f, 0.f, 50.f));
+    const std::vector<float> zs = slicing_zs(0.1f, 100.f, 0.2f);
+
+    const auto            start  = std::chrono::steady_clock::now();
+    std::vector<Polygons> layers = slice_mesh(sphere, zs, MeshSlicingParams(), []() {});
+    const double          secs   = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    WARN(sphere.indices.size() << " triangles sliced at " << zs.size() << " planes in " << secs << " s, "
+         << double(sphere.indices.size()) / secs * 1e-6 << " M triangles/s");
+    REQUIRE(layers.size() == zs.size());
+}
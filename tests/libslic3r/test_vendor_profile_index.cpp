@@ -0,0 +1,148 @@
+#include <catch2/catch.hpp>
+
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include "libslic3r/PresetBundle.hpp"
+#include "libslic3r/VendorProfileIndex.hpp"
+
+using namespace Slic3r;
+namespace fs = boost::filesystem;
+
+static void write_file(const fs::path &path, const std::string &data)
+{
+    fs::create_directories(path.parent_path());
+    boost::nowide::ofstream ofs(path.string());
+    ofs << data;
+}
+
+SCENARIO("VendorProfileIndex round trip", "[VendorProfileIndex]")
+{
+    const fs::path root         = fs::temp_directory_path() / fs::unique_path("vendor_profile_index_%%%%-%%%%");
+    const fs::path profiles_dir = root / "system";
+    const fs::path cache_dir    = root / "cache";
+    write_file(profiles_dir / "Vendor.json", R"({"name": "Vendor", "version": "1.0.0.0", "process_list": [{"name": "p", "sub_path": "process/p.json"}]})");
+    write_file(profiles_dir / "Vendor" / "process" / "p.json", R"({"name": "p", "layer_height": "0.2", "instantiation": "true"})");
+
+    GIVEN("No index stored yet") {
+        VendorProfileIndex index(profiles_dir.string(), "Vendor", cache_dir.string());
+        THEN("the index is not loaded") {
+            REQUIRE_FALSE(index.load());
+        }
+        WHEN("the documents are parsed and the index is saved") {
+            index.load();
+            const nlohmann::json process = index.document("Vendor/process/p.json");
+            index.document("Vendor.json");
+            index.set_discovered_subfiles({ { "p", "process/p.json" } });
+            REQUIRE(index.save());
+            THEN("a new index loads the same documents") {
+                VendorProfileIndex loaded(profiles_dir.string(), "Vendor", cache_dir.string());
+                REQUIRE(loaded.load());
+                REQUIRE(loaded.document("Vendor/process/p.json") == process);
+                REQUIRE(loaded.document("Vendor.json")["name"] == "Vendor");
+                REQUIRE(loaded.discovered_subfiles() != nullptr);
+                REQUIRE(loaded.discovered_subfiles()->size() == 1);
+            }
+            THEN("the index is invalidated by a modified vendor file") {
+                write_file(profiles_dir / "Vendor.json", R"({"name": "Vendor", "version": "1.0.0.1", "process_list": [{"name": "p", "sub_path": "process/p.json"}]})");
+                VendorProfileIndex stale(profiles_dir.string(), "Vendor", cache_dir.string());
+                REQUIRE_FALSE(stale.load());
+                REQUIRE(stale.document("Vendor.json")["version"] == "1.0.0.1");
+            }
+            THEN("the index is invalidated by a modified base vendor") {
+                VendorProfileIndex stale(profiles_dir.string(), "Vendor", cache_dir.string());
+                REQUIRE_FALSE(stale.load("0123456789ABCDEF"));
+            }
+            THEN("the index is invalidated by an added profile") {
+                write_file(profiles_dir / "Vendor" / "process" / "q.json", R"({"name": "q", "instantiation": "true"})");
+                VendorProfileIndex stale(profiles_dir.string(), "Vendor", cache_dir.string());
+                REQUIRE_FALSE(stale.load());
+            }
+        }
+    }
+
+    fs::remove_all(root);
+}
+
+SCENARIO("PresetBundle restores the resolved presets of a vendor", "[VendorProfileIndex]")
+{
+    const fs::path root         = fs::temp_directory_path() / fs::unique_path("vendor_profile_index_%%%%-%%%%");
+    const fs::path profiles_dir = root / "system";
+    const fs::path cache_dir    = root / "cache";
+    write_file(profiles_dir / "Vendor.json", R"({"name": "Vendor", "version": "1.0.0.0", "process_list": [
+        {"name": "fdm_process_common", "sub_path": "process/fdm_process_common.json"},
+        {"name": "0.20mm Standard @Vendor", "sub_path": "process/p.json"}]})");
+    write_file(profiles_dir / "Vendor" / "process" / "fdm_process_common.json",
+        R"({"type": "process", "name": "fdm_process_common", "instantiation": "false", "layer_height": "0.24", "wall_loops": "3"})");
+    write_file(profiles_dir / "Vendor" / "process" / "p.json",
+        R"({"type": "process", "name": "0.20mm Standard @Vendor", "inherits": "fdm_process_common", "instantiation": "true",
+            "setting_id": "GP1", "layer_height": "0.2"})");
+
+    auto load_bundle = [&profiles_dir](PresetBundle &bundle, VendorProfileIndex &index) {
+        bundle.load_vendor_configs_from_json(profiles_dir.string(), "Vendor", PresetBundle::LoadSystem,
+                                             ForwardCompatibilitySubstitutionRule::Disable, nullptr, &index);
+    };
+
+    GIVEN("A vendor loaded from the json files") {
+        PresetBundle       parsed;
+        VendorProfileIndex index(profiles_dir.string(), "Vendor", cache_dir.string());
+        REQUIRE_FALSE(index.load());
+        load_bundle(parsed, index);
+        THEN("the resolved presets are recorded") {
+            REQUIRE(index.resolved_presets() != nullptr);
+        }
+        WHEN("the index is stored and the vendor is loaded again") {
+            REQUIRE(index.save());
+            // The sub-profiles are not parsed once the presets were resolved, thus breaking them does not matter.
+            {
+                boost::nowide::ofstream ofs((profiles_dir / "Vendor" / "process" / "p.json").string(), std::ios::in | std::ios::out);
+                ofs << "{{{{";
+            }
+            PresetBundle       restored;
+            VendorProfileIndex loaded(profiles_dir.string(), "Vendor", cache_dir.string());
+            REQUIRE(loaded.load());
+            REQUIRE(loaded.resolved_presets() != nullptr);
+            load_bundle(restored, loaded);
+            THEN("the restored presets match the parsed ones") {
+                const Preset *expected = parsed.prints.find_preset("0.20mm Standard @Vendor", false);
+                const Preset *preset   = restored.prints.find_preset("0.20mm Standard @Vendor", false);
+                REQUIRE(expected != nullptr);
+                REQUIRE(preset != nullptr);
+                REQUIRE(preset->is_system);
+                REQUIRE(preset->config == expected->config);
+                REQUIRE(preset->config.opt_float("layer_height") == 0.2);
+                REQUIRE(preset->config.opt_int("wall_loops") == 3);
+                REQUIRE(preset->setting_id == "GP1");
+                REQUIRE(preset->alias == expected->alias);
+                REQUIRE(preset->renamed_from == expected->renamed_from);
+                REQUIRE(preset->vendor == &restored.vendors.at("Vendor"));
+                REQUIRE(restored.prints.find_preset("fdm_process_common", false) == nullptr);
+            }
+        }
+    }
+
+    GIVEN("A vendor with a value, which does not survive serialization") {
+        write_file(profiles_dir / "Vendor" / "process" / "p.json",
+            R"({"type": "process", "name": "0.20mm Standard @Vendor", "inherits": "fdm_process_common", "instantiation": "true",
+                "setting_id": "GP1", "layer_height": "0.123456789"})");
+        PresetBundle       parsed;
+        VendorProfileIndex index(profiles_dir.string(), "Vendor", cache_dir.string());
+        index.load();
+        load_bundle(parsed, index);
+        THEN("only the documents are stored") {
+            REQUIRE(index.resolved_presets() == nullptr);
+            REQUIRE(index.save());
+            PresetBundle       restored;
+            VendorProfileIndex loaded(profiles_dir.string(), "Vendor", cache_dir.string());
+            REQUIRE(loaded.load());
+            load_bundle(restored, loaded);
+            const Preset *preset = restored.prints.find_preset("0.20mm Standard @Vendor", false);
+            REQUIRE(preset != nullptr);
+            REQUIRE(preset->config.opt_float("layer_height") == 0.123456789);
+        }
+    }
+
+    fs::remove_all(root);
+}
@@ -0,0 +1,109 @@
+#include <catch2/catch.hpp>
+#include <test_utils.hpp>
+
+#include "libslic3r/Arachne/WallToolPathsCache.hpp"
+
+using namespace Slic3r;
+
+// L shaped outline with a narrow leg, so that Arachne produces variable width lines.
+static Polygons l_shape(const Point &offset)
+{
+    Polygon polygon { { 0, 0 }, { scaled<coord_t>(20.), 0 }, { scaled<coord_t>(20.), scaled<coord_t>(1.1) },
+                      { scaled<coord_t>(1.3), scaled<coord_t>(1.1) }, { scaled<coord_t>(1.3), scaled<coord_t>(15.) }, { 0, scaled<coord_t>(15.) } };
+    polygon.translate(offset);
+    return { polygon };
+}
+
+TEST_CASE("Arachne tool paths are shared by translated outlines", "[ArachneCache]") {
+    const Arachne::WallToolPathsParams params  = arachne_params();
+    const coord_t                      width   = scaled<coord_t>(0.45);
+    const Point                        offset  { scaled<coord_t>(37.), scaled<coord_t>(-12.) };
+    Arachne::WallToolPathsCache        cache;
+
+    const Arachne::WallToolPathsCache::Result first  = cache.generate(l_shape(Point::Zero()), width, width, 3, 0, 0.2, params);
+    const Arachne::WallToolPathsCache::Result second = cache.generate(l_shape(offset), width, width, 3, 0, 0.2, params);
+    REQUIRE(cache.misses() == 1);
+    REQUIRE(cache.hits() == 1);
+    REQUIRE(! first.toolpaths.empty());
+
+    SECTION("the cached tool paths are translated with the outline") {
+        REQUIRE(first.toolpaths.size() == second.toolpaths.size());
+        for (size_t i = 0; i < first.toolpaths.size(); ++ i) {
+            REQUIRE(first.toolpaths[i].size() == second.toolpaths[i].size());
+            for (size_t j = 0; j < first.toolpaths[i].size(); ++ j) {
+                const Arachne::ExtrusionLine &a = first.toolpaths[i][j];
+                const Arachne::ExtrusionLine &b = second.toolpaths[i][j];
+                REQUIRE(a.size() == b.size());
+                for (size_t k = 0; k < a.size(); ++ k) {
+                    REQUIRE(a.junctions[k].p + offset == b.junctions[k].p);
+                    REQUIRE(a.junctions[k].w == b.junctions[k].w);
+                }
+            }
+        }
+        Polygons inner_contour = first.inner_contour;
+        for (Polygon &polygon : inner_contour)
+            polygon.translate(offset);
+        REQUIRE(inner_contour == second.inner_contour);
+    }
+
+    SECTION("the cached tool paths match the tool paths generated without the cache") {
+        const Arachne::WallToolPathsCache::Result uncached = Arachne::generate_wall_toolpaths(nullptr, l_shape(Point::Zero()), width, width, 3, 0, 0.2, params);
+        // The outline starts at the origin, so the cached tool paths were generated without translation and they are identical,
+        // the tool paths taken from the cache for the translated outline are translated by the same offset.
+        REQUIRE(uncached.toolpaths.size() == first.toolpaths.size());
+        REQUIRE(uncached.toolpaths.size() == second.toolpaths.size());
+        for (size_t i = 0; i < uncached.toolpaths.size(); ++ i) {
+            REQUIRE(uncached.toolpaths[i].size() == first.toolpaths[i].size());
+            REQUIRE(uncached.toolpaths[i].size() == second.toolpaths[i].size());
+            for (size_t j = 0; j < uncached.toolpaths[i].size(); ++ j) {
+                const Arachne::ExtrusionLine &a = uncached.toolpaths[i][j];
+                const Arachne::ExtrusionLine &b = first.toolpaths[i][j];
+                const Arachne::ExtrusionLine &c = second.toolpaths[i][j];
+                REQUIRE(a.is_closed == b.is_closed);
+                REQUIRE(a.is_odd == b.is_odd);
+                REQUIRE(a.size() == b.size());
+                REQUIRE(a.size() == c.size());
+                for (size_t k = 0; k < a.size(); ++ k) {
+                    REQUIRE(a.junctions[k].p == b.junctions[k].p);
+                    REQUIRE(a.junctions[k].w == b.junctions[k].w);
+                    REQUIRE(a.junctions[k].p + offset == c.junctions[k].p);
+                    REQUIRE(a.junctions[k].w == c.junctions[k].w);
+                }
+            }
+        }
+        REQUIRE(uncached.inner_contour == first.inner_contour);
+    }
+
+    SECTION("the cached tool paths of the translated outline match the tool paths generated for it without the cache") {
+        // Generated for the translated outline in place, not at the origin, thus the positions may differ by the rounding
+        // of the Voronoi vertices and of the intermediate floating point calculations.
+        const Arachne::WallToolPathsCache::Result uncached  = Arachne::generate_wall_toolpaths(nullptr, l_shape(offset), width, width, 3, 0, 0.2, params);
+        const double                              tolerance = 10.;
+        REQUIRE(uncached.toolpaths.size() == second.toolpaths.size());
+        for (size_t i = 0; i < uncached.toolpaths.size(); ++ i) {
+            REQUIRE(uncached.toolpaths[i].size() == second.toolpaths[i].size());
+            for (size_t j = 0; j < uncached.toolpaths[i].size(); ++ j) {
+                const Arachne::ExtrusionLine &a = uncached.toolpaths[i][j];
+                const Arachne::ExtrusionLine &b = second.toolpaths[i][j];
+                REQUIRE(a.is_closed == b.is_closed);
+                REQUIRE(a.is_odd == b.is_odd);
+                REQUIRE(a.size() == b.size());
+                for (size_t k = 0; k < a.size(); ++ k) {
+                    REQUIRE((a.junctions[k].p - b.junctions[k].p).cast<double>().norm() <= tolerance);
+                    REQUIRE(std::abs(a.junctions[k].w - b.junctions[k].w) <= tolerance);
+                }
+            }
+        }
+        REQUIRE(uncached.inner_contour.size() == second.inner_contour.size());
+        for (size_t i = 0; i < uncached.inner_contour.size(); ++ i) {
+            REQUIRE(uncached.inner_contour[i].size() == second.inner_contour[i].size());
+            for (size_t j = 0; j < uncached.inner_contour[i].size(); ++ j)
+                REQUIRE((uncached.inner_contour[i][j] - second.inner_contour[i][j]).cast<double>().norm() <= tolerance);
+        }
+    }
+
+    SECTION("different parameters are not shared") {
+        cache.generate(l_shape(Point::Zero()), width, width, 2, 0, 0.2, params);
+        REQUIRE(cache.misses() == 2);
+    }
+}
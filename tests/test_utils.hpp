@@ -3,6 +3,7 @@
 
 #include <libslic3r/TriangleMesh.hpp>
 #include <libslic3r/Format/OBJ.hpp>
+#include <libslic3r/Arachne/WallToolPaths.hpp>
 
 #if defined(WIN32) || defined(_WIN32)
 #define PATH_SEPARATOR R"(\)"
@@ -20,4 +21,19 @@ inline Slic3r::TriangleMesh load_model(const std::string &obj_filename)
     return mesh;
 }
 
+// Arachne parameters of the default process profiles.
+inline Slic3r::Arachne::WallToolPathsParams arachne_params()
+{
+    Slic3r::Arachne::WallToolPathsParams params;
+    params.min_bead_width                   = 0.34f;
+    params.min_feature_size                 = 0.1f;
+    params.min_length_factor                = 0.5f;
+    params.wall_transition_length           = 0.4f;
+    params.wall_transition_angle            = 10.f;
+    params.wall_transition_filter_deviation = 0.1f;
+    params.wall_distribution_count          = 1;
+    params.is_top_or_bottom_layer           = false;
+    return params;
+}
+
 #endif // SLIC3R_TEST_UTILS